@@ -1,6 +1,7 @@
 #ifndef FREEROUTING_AUTOROUTE_AUTOROUTECONTROL_H
 #define FREEROUTING_AUTOROUTE_AUTOROUTECONTROL_H
 
+#include "geometry/IntBox.h"
 #include <vector>
 
 namespace freerouting {
@@ -45,6 +46,10 @@ public:
   // Defines for each layer if it may be used for routing
   std::vector<bool> layerActive;
 
+  // If not empty, layerActive is a restriction (see LayerAssignment) and
+  // this is the full set to search again with when nothing is found
+  std::vector<bool> fallbackLayerActive;
+
   // The currently used trace half widths on each layer
   std::vector<int> traceHalfWidth;
 
@@ -83,6 +88,36 @@ public:
   // Maximum iterations for A* search
   int maxIterations;
 
+  // Try the multi-resolution grid router when the maze search fails
+  bool gridFallbackEnabled;
+
+  // Run the grid router on a second thread at the same time as the maze
+  // search instead of after it. The first path found wins; if the other
+  // search also finishes within raceGraceMs the cheaper path is used.
+  bool raceSearches;
+  int raceGraceMs;
+
+  // Extra maze search cost for passing within proximityRange of other nets'
+  // copper: weight * (range - distance) per expansion; 0 disables
+  double proximityCostWeight;
+  int proximityRange;
+
+  // Reduce found paths to the fewest segments before inserting them
+  // (see PathSimplifier)
+  bool simplifyPaths;
+
+  // Start and end searches only on layers where the pins can be left, from
+  // the access point nearest the other end (see PinAccess)
+  bool usePinAccess;
+
+  // Answer conflict queries from the board's occupancy bitmap where it is
+  // conclusive (see OccupancyPyramid)
+  bool useOccupancyFilter;
+
+  // Region the layer choice looks at and the search tree holds items of;
+  // empty for the whole board (see RoutingSession)
+  IntBox searchWindow;
+
   // If true, the autoroute algorithm completes after the first drill
   bool isFanout;
 
@@ -145,6 +180,14 @@ public:
       ripupPassNo(0),
       pushAndShoveEnabled(true),  // Enable push-and-shove by default
       maxIterations(100000),  // Default 100k iterations
+      gridFallbackEnabled(true),
+      raceSearches(false),
+      raceGraceMs(5),
+      proximityCostWeight(0.0),
+      proximityRange(5000),  // 0.5mm
+      simplifyPaths(true),
+      usePinAccess(true),
+      useOccupancyFilter(true),
       isFanout(false),
       removeUnconnectedVias(true),
       netNo(-1),
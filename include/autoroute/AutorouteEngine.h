@@ -5,7 +5,10 @@
 #include "autoroute/CompleteFreeSpaceExpansionRoom.h"
 #include "autoroute/IncompleteFreeSpaceExpansionRoom.h"
 #include "autoroute/ExpansionRoomGenerator.h"
+#include "autoroute/MultiResolutionGridRouter.h"
+#include "autoroute/PathSimplifier.h"
 #include "board/RoutingBoard.h"
+#include "core/MemoryBudget.h"
 #include "datastructures/Stoppable.h"
 #include "datastructures/TimeLimit.h"
 #include <vector>
@@ -18,6 +21,8 @@ namespace freerouting {
 class Item;
 class Via;
 class ShapeSearchTree;
+class SearchCapture;
+class MazeSearchAlgo;
 
 // Temporary autoroute data stored on the RoutingBoard
 // Manages the routing process including expansion rooms and search state
@@ -107,8 +112,15 @@ public:
   // Complete neighbour rooms to ensure doors won't change during expansion
   void completeNeighbourRooms(ExpansionRoom* room);
 
-  // Initialize search tree with all board items
-  void initializeSearchTree();
+  // Initialize search tree with the board items in a window (all if empty)
+  void initializeSearchTree(const IntBox& window = IntBox());
+
+  // Record this engine's search into a capture (null to stop recording)
+  void setSearchCapture(SearchCapture* capture) { searchCapture = capture; }
+  SearchCapture* getSearchCapture() const { return searchCapture; }
+
+  // Segment counts of the paths this engine inserted
+  const PathSimplifier::Statistics& getPathStatistics() const { return pathStatistics; }
 
 private:
   int netNo; // Current net number
@@ -121,12 +133,37 @@ private:
 
   int expansionRoomInstanceCount;
 
+  // Optional recording of the search (see SearchCapture)
+  SearchCapture* searchCapture = nullptr;
+
+  PathSimplifier::Statistics pathStatistics;
+
   // Ripup tracking: maps item ID -> number of times it's been ripped up
   std::map<int, int> ripupCounts;
 
   // Cached room generators per net (for performance)
   std::map<int, std::unique_ptr<ExpansionRoomGenerator>> roomGenerators;
 
+  // The rooms and room generators as a cache in the memory budget; when
+  // picked for eviction they are dropped at the next initConnection()
+  class RoomCache : public MemoryBudget::Cache {
+  public:
+    explicit RoomCache(AutorouteEngine& owner) : engine(owner) {}
+    ~RoomCache() override { MemoryBudget::instance().remove(this); }
+
+    RoomCache(const RoomCache&) = delete;
+    RoomCache& operator=(const RoomCache&) = delete;
+
+    void evict() override;
+
+  private:
+    AutorouteEngine& engine;
+  };
+  RoomCache roomCache{*this};
+
+  // Report the room memory to the budget; a search took searchMs to grow it
+  void updateRoomMemory(double searchMs);
+
   // Remove all doors from a room
   void removeAllDoors(ExpansionRoom* room);
 
@@ -134,6 +171,27 @@ private:
   void calculateDoors(class ObstacleExpansionRoom* room);
 
   // Helper methods for routing
+  AutorouteResult createRouteFromPath(std::vector<IntPoint> points,
+                                      std::vector<int> layers,
+                                      const AutorouteControl& ctrl);
+  // Simplify a path before insertion if ctrl.simplifyPaths, and count its segments
+  void simplifyPath(std::vector<IntPoint>& points, std::vector<int>& layers,
+                    const AutorouteControl& ctrl);
+  MultiResolutionGridRouter makeGridFallbackRouter(const AutorouteControl& ctrl,
+                                                   const Stoppable* stoppable);
+  // Grid router end at an item; made on the calling thread, since it reads
+  // the board's pin access cache
+  MultiResolutionGridRouter::Endpoint gridEndpoint(Item* item, const AutorouteControl& ctrl);
+  bool findGridFallbackPath(const MultiResolutionGridRouter& router,
+                            const MultiResolutionGridRouter::Endpoint& start,
+                            const MultiResolutionGridRouter::Endpoint& goal,
+                            std::vector<IntPoint>& points, std::vector<int>& layers) const;
+  // Maze search here and grid router on a worker thread (ctrl.raceSearches);
+  // returns true if a path was found, gridWon tells which search it came from
+  bool raceSearches(MazeSearchAlgo& mazeSearch, const MultiResolutionGridRouter::Endpoint& start,
+                    const MultiResolutionGridRouter::Endpoint& goal,
+                    const AutorouteControl& ctrl, std::vector<IntPoint>& points,
+                    std::vector<int>& layers, bool& gridWon);
   AutorouteResult createDirectRoute(IntPoint start, IntPoint goal, int layer,
                                      const AutorouteControl& ctrl,
                                      int ripupCostLimit, std::vector<Item*>& rippedItems);
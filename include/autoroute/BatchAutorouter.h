@@ -4,10 +4,14 @@
 #include "autoroute/AutorouteControl.h"
 #include "autoroute/AutorouteEngine.h"
 #include "autoroute/AutorouteAttemptResult.h"
+#include "autoroute/LayerAssignment.h"
+#include "autoroute/SearchCapture.h"
 #include "datastructures/Stoppable.h"
 #include "datastructures/TimeLimit.h"
 #include "board/RoutingBoard.h"
 #include "cli/ProgressDisplay.h"
+#include <chrono>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -27,6 +31,50 @@ public:
     bool removeUnconnectedVias = true;  // Remove unused vias after routing
     bool withPreferredDirections = true;  // Use preferred trace directions
     int tracePullTightAccuracy = 500;     // Trace optimization accuracy
+
+    // Order in which nets of the same priority tier are routed
+    enum class ConnectionOrder {
+      NetSize,  // Smaller nets first, then by net number
+      Hilbert   // Group by layer, then by Hilbert index of the net's bbox center
+    };
+    ConnectionOrder connectionOrder = ConnectionOrder::NetSize;
+
+    // Maze search cost for running close to other nets' copper (0 = off)
+    double proximityCostWeight = 0.0;
+    int proximityRange = 5000;  // Distance where the cost reaches zero (0.5mm)
+
+    // Search costs (tunable; see RouterProfile and freerouting-autotune)
+    double viaCost = 100.0;             // Minimum via cost; cheap vias cost half
+    double traceCostPreferred = 1.0;    // Trace cost factor in a layer's preferred direction
+    double traceCostAgainst = 1.0;      // ... and against it (with withPreferredDirections)
+    int maxIterationsBase = 50000;      // Search limit: base + perConnection * sqrt(net connections)
+    int maxIterationsPerConnection = 5000;
+
+    // Run the maze search and the grid router concurrently, first path wins
+    // (see AutorouteControl::raceSearches); only for connections still
+    // unrouted after the first passes, where the serial order costs most
+    bool raceSearches = false;
+    int raceFromPass = 2;
+    int raceGraceMs = 5;
+
+    // Assign every connection a layer pair before each pass and search only
+    // those layers (plus the endpoints' own), all layers as the fallback
+    bool assignLayers = false;
+
+    // Insert routes with the fewest segments (see PathSimplifier)
+    bool simplifyPaths = true;
+
+    // Seed searches from precomputed pin access points (see PinAccess)
+    bool usePinAccess = true;
+
+    // Pre-filter conflict queries with an occupancy bitmap (see OccupancyPyramid)
+    bool useOccupancyFilter = true;
+
+    // Record one connection's search to a file (see SearchCapture)
+    int captureNetNo = -1;        // Net to capture (-1 = off)
+    int capturePass = 1;          // Pass in which to capture it
+    int captureConnection = 0;    // Which of the net's searches in that pass (0 = first)
+    std::string captureFile = "search.frsc";
   };
 
   // Statistics for a single routing pass
@@ -40,7 +88,23 @@ public:
     int incompleteConnections = 0;
     double passDurationMs = 0.0;
 
+    // Per-connection timing (one connection = one engine search)
+    int connectionsAttempted = 0;
+    double connectionTimeMs = 0.0;     // Sum over all connections
+    double maxConnectionTimeMs = 0.0;  // Slowest single connection
+
+    // Trace segments of the paths found, and of the routes inserted
+    int pathSegmentsFound = 0;
+    int pathSegmentsInserted = 0;
+
+    // Dangling traces and vias removed after passes
+    int tailsRemoved = 0;
+
     PassStatistics() = default;
+
+    double averageConnectionTimeMs() const {
+      return connectionsAttempted > 0 ? connectionTimeMs / connectionsAttempted : 0.0;
+    }
   };
 
   // Create batch autorouter for board with default config
@@ -78,6 +142,10 @@ public:
     progressDisplay = display;
   }
 
+  // Sort nets (net number, item IDs) into routing order: priority tier
+  // first, then the configured connection order within each tier
+  void sortNetsForRouting(std::vector<std::pair<int, std::vector<int>>>& nets) const;
+
 private:
   // Route a single item on specific net
   AutorouteAttemptResult autorouteItem(
@@ -98,6 +166,29 @@ private:
     const std::vector<Item*>& fromSet,
     const std::vector<Item*>& toSet) const;
 
+  // Add the time since start and the engine's path segments to the
+  // per-connection statistics
+  void recordConnectionTime(std::chrono::steady_clock::time_point start,
+                            const AutorouteEngine& engine);
+
+  // Copy the configured via and trace costs into a search control
+  void applyCostSettings(AutorouteControl& control) const;
+
+  // Power and ground nets are left to copper pours
+  bool isPowerNet(int netNo) const;
+
+  // Solve the layer assignment for the connections still unrouted
+  void assignLayers();
+
+  // Restrict a search to the connection's assigned layers, if it has any
+  void applyLayerAssignment(AutorouteControl& control, const Item* fromItem,
+                            const Item* toItem, int netNo) const;
+
+  // Capture for the next search of a net, or null if it is not the one
+  // configured; finishCapture() writes the file once the search is done
+  SearchCapture* beginCapture(int netNo, int passNo);
+  void finishCapture(SearchCapture* capture);
+
   // Get IDs of items that need routing (using IDs instead of pointers
   // to avoid invalidation when items_ vector is reallocated)
   std::vector<int> getAutorouteItemIds();
@@ -111,6 +202,12 @@ private:
   int currentPass;
   PassStatistics lastPassStats;
   ProgressDisplay* progressDisplay = nullptr;
+
+  LayerAssignment layerAssignment;
+
+  std::unique_ptr<SearchCapture> activeCapture;
+  int captureSearchesSeen = 0;
+  bool captureWritten = false;
 };
 
 } // namespace freerouting
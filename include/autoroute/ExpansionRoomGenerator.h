@@ -45,6 +45,9 @@ public:
   // Cleanup - delete all allocated rooms and doors
   void cleanup();
 
+  // Approximate memory held by the generated rooms and doors
+  size_t memoryBytes() const;
+
   // ========== Phase 3B: Room Shape Completion ==========
 
   /**
@@ -0,0 +1,142 @@
+#ifndef FREEROUTING_AUTOROUTE_LAYERASSIGNMENT_H
+#define FREEROUTING_AUTOROUTE_LAYERASSIGNMENT_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Board-wide choice of a layer pair for every connection, made before the
+// detailed search
+// Each connection is modelled as an L-shaped route over a coarse tile grid:
+// the horizontal leg on one layer and the vertical leg on another. With
+// preferred directions the horizontal layer is one whose preferred direction
+// is horizontal (even index, as in BatchAutorouter's trace costs) and the
+// vertical layer an odd one. Tile capacity is the number of tracks that fit,
+// less the share covered by existing copper.
+//
+// Pairs are found by negotiated congestion: every round, each connection
+// picks its cheapest pair and bend against the usage of all others (done in
+// parallel, since a round only reads the previous usage), then the usage is
+// rebuilt and overflowing tiles get more expensive for the next round. The
+// round with the least overflow is kept.
+class LayerAssignment {
+public:
+  struct Config {
+    int tileSize = 20000;           // Tile width (2mm)
+    int pitch = 4500;               // Track pitch: trace width + clearance
+    int maxRounds = 8;
+    double historyIncrement = 0.5;  // Added to an overflowing tile each round
+    double presentFactor = 2.0;     // Cost per track of overflow
+    double viaCost = 2.0;           // In tiles of detour, per via at an end
+    bool withPreferredDirections = true;
+  };
+
+  // A connection to assign; points are the centers of the two items
+  struct Connection {
+    int netNo;
+    int fromItemId;
+    int toItemId;
+    IntPoint from;
+    IntPoint to;
+    int fromFirstLayer;
+    int fromLastLayer;
+    int toFirstLayer;
+    int toLastLayer;
+  };
+
+  struct LayerPair {
+    int horizontal = -1;
+    int vertical = -1;
+
+    bool isValid() const { return horizontal >= 0 && vertical >= 0; }
+    bool contains(int layer) const { return layer == horizontal || layer == vertical; }
+  };
+
+  struct Statistics {
+    int connections = 0;
+    int candidatePairs = 0;
+    int rounds = 0;
+    int initialOverflow = 0;  // Track overflow after the first round
+    int finalOverflow = 0;    // ... and in the kept round
+    double solveMs = 0.0;
+  };
+
+  LayerAssignment() = default;
+  explicit LayerAssignment(const Config& cfg) : config_(cfg) {}
+
+  // Assign pairs for the connections; replaces any earlier result
+  // Does nothing (and isEmpty() stays true) with fewer than two routing layers
+  void solve(const RoutingBoard& board, const std::vector<Connection>& connections);
+
+  bool isEmpty() const { return byConnection_.empty(); }
+
+  // Pair for a connection (either item order), else the pair most of the
+  // net's connections got, else an invalid pair
+  LayerPair pairFor(int fromItemId, int toItemId, int netNo) const;
+
+  // Candidate layer pairs for the board's signal layers
+  static std::vector<LayerPair> candidatePairs(const RoutingBoard& board,
+                                               bool withPreferredDirections);
+
+  const Statistics& getStatistics() const { return stats_; }
+  const Config& getConfig() const { return config_; }
+
+private:
+  // One way to route a connection: pair index and bend
+  struct Choice {
+    int pair = -1;
+    bool horizontalFirst = true;
+  };
+
+  // A leg of the L over the tile grid: tiles from..to (inclusive) along a
+  // row (horizontal) or column at fixed
+  struct Leg {
+    bool horizontal;
+    int fixed;
+    int from;
+    int to;
+    bool empty;
+  };
+
+  void buildGrid(const RoutingBoard& board);
+  std::pair<Leg, Leg> legsOf(const Connection& connection, bool horizontalFirst) const;
+
+  // Call fn(tile index) for every tile and layer a choice's route occupies
+  template <typename Fn>
+  void forEachTile(const Connection& connection, const Choice& choice, Fn fn) const;
+
+  // Negotiated cost of a choice; ownTiles (sorted) are discounted from the
+  // usage, being the connection's own current route
+  double choiceCost(const Connection& connection, const Choice& choice,
+                    const std::vector<float>& usage, const std::vector<size_t>& ownTiles) const;
+  int overflow(const std::vector<float>& usage) const;
+
+  size_t tileIndex(int layer, int tx, int ty) const {
+    return (static_cast<size_t>(layer) * tilesY_ + ty) * tilesX_ + tx;
+  }
+  int tileX(int x) const;
+  int tileY(int y) const;
+
+  Config config_;
+  std::vector<LayerPair> pairs_;
+  IntBox bounds_;
+  int tilesX_ = 0;
+  int tilesY_ = 0;
+  int layerCount_ = 0;
+  std::vector<float> capacity_;  // Tracks per tile and layer
+  std::vector<float> history_;   // Accumulated congestion cost
+  std::map<std::pair<int, int>, LayerPair> byConnection_;  // Key: ordered item IDs
+  std::map<int, LayerPair> byNet_;
+  Statistics stats_;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_LAYERASSIGNMENT_H
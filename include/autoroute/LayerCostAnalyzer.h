@@ -3,6 +3,7 @@
 
 #include "board/RoutingBoard.h"
 #include "geometry/IntBox.h"
+#include <algorithm>
 #include <vector>
 
 namespace freerouting {
@@ -24,49 +25,25 @@ public:
   void analyze() {
     if (!board_) return;
 
-    // Reset counters
-    for (int i = 0; i < numLayers_; ++i) {
-      layerCosts_[i] = 0.0;
-      layerObstacleCounts_[i] = 0;
-      layerTraceLength_[i] = 0.0;
-    }
-
-    // Analyze all items on the board
+    reset();
     for (const auto& item : board_->getItems()) {
-      if (!item) continue;
-
-      int firstLayer = item->firstLayer();
-      int lastLayer = item->lastLayer();
-
-      // Count obstacles and trace length per layer
-      for (int layer = firstLayer; layer <= lastLayer; ++layer) {
-        if (layer < 0 || layer >= numLayers_) continue;
-
-        layerObstacleCounts_[layer]++;
-
-        // If it's a trace, add its length
-        if (const Trace* trace = dynamic_cast<const Trace*>(item.get())) {
-          if (trace->getLayer() == layer) {
-            layerTraceLength_[layer] += trace->getLength();
-          }
-        }
+      if (item) {
+        countItem(*item);
       }
     }
+    computeCosts(calculateBoardBounds());
+  }
 
-    // Calculate board area
-    IntBox boardBounds = calculateBoardBounds();
-    double boardArea = static_cast<double>(boardBounds.ur.x - boardBounds.ll.x) *
-                       static_cast<double>(boardBounds.ur.y - boardBounds.ll.y);
-    if (boardArea < 1.0) boardArea = 1.0;
-
-    // Compute normalized costs (0.0 = empty, 1.0+ = congested)
-    for (int layer = 0; layer < numLayers_; ++layer) {
-      // Cost is combination of obstacle density and trace length density
-      double obstacleDensity = layerObstacleCounts_[layer] / 100.0;  // Normalize by typical count
-      double traceDensity = layerTraceLength_[layer] / boardArea;
+  // Same as analyze() for the items in a region only, found through the
+  // board's spatial index, so the cost does not grow with the board
+  void analyzeRegion(const IntBox& region) {
+    if (!board_) return;
 
-      layerCosts_[layer] = obstacleDensity + traceDensity * 0.5;
+    reset();
+    for (Item* item : board_->getShapeTree().queryRegion(region)) {
+      countItem(*item);
     }
+    computeCosts(region);
   }
 
   // Get routing cost for a specific layer (lower is better)
@@ -142,6 +119,23 @@ public:
     return bestLayer;
   }
 
+  // Same as findBestLayerInRegion() through the board's spatial index
+  int findBestLayerNear(IntBox region) const {
+    if (!board_) return 0;
+
+    std::vector<int> regionalObstacles(numLayers_, 0);
+    for (Item* item : board_->getShapeTree().queryRegion(region)) {
+      for (int layer = item->firstLayer(); layer <= item->lastLayer(); ++layer) {
+        if (layer >= 0 && layer < numLayers_) {
+          regionalObstacles[layer]++;
+        }
+      }
+    }
+
+    auto best = std::min_element(regionalObstacles.begin(), regionalObstacles.end());
+    return static_cast<int>(best - regionalObstacles.begin());
+  }
+
   // Get layer utilization percentage (0-100+)
   double getLayerUtilization(int layer) const {
     if (layer < 0 || layer >= numLayers_) return 0.0;
@@ -155,6 +149,45 @@ private:
   std::vector<int> layerObstacleCounts_;     // Number of items per layer
   std::vector<double> layerTraceLength_;     // Total trace length per layer
 
+  void reset() {
+    for (int i = 0; i < numLayers_; ++i) {
+      layerCosts_[i] = 0.0;
+      layerObstacleCounts_[i] = 0;
+      layerTraceLength_[i] = 0.0;
+    }
+  }
+
+  // Count obstacles and trace length per layer
+  void countItem(const Item& item) {
+    for (int layer = item.firstLayer(); layer <= item.lastLayer(); ++layer) {
+      if (layer < 0 || layer >= numLayers_) continue;
+
+      layerObstacleCounts_[layer]++;
+
+      // If it's a trace, add its length
+      if (const Trace* trace = dynamic_cast<const Trace*>(&item)) {
+        if (trace->getLayer() == layer) {
+          layerTraceLength_[layer] += trace->getLength();
+        }
+      }
+    }
+  }
+
+  // Compute normalized costs (0.0 = empty, 1.0+ = congested)
+  void computeCosts(const IntBox& area) {
+    double boardArea = static_cast<double>(area.ur.x - area.ll.x) *
+                       static_cast<double>(area.ur.y - area.ll.y);
+    if (boardArea < 1.0) boardArea = 1.0;
+
+    for (int layer = 0; layer < numLayers_; ++layer) {
+      // Cost is combination of obstacle density and trace length density
+      double obstacleDensity = layerObstacleCounts_[layer] / 100.0;  // Normalize by typical count
+      double traceDensity = layerTraceLength_[layer] / boardArea;
+
+      layerCosts_[layer] = obstacleDensity + traceDensity * 0.5;
+    }
+  }
+
   IntBox calculateBoardBounds() const {
     IntBox bounds(INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN);
 
@@ -20,6 +20,9 @@ class ExpansionRoom;
 class ExpansionDoor;
 class ObstacleExpansionRoom;
 class Trace;
+class ProximityField;
+class PinAccess;
+class SearchCapture;
 
 // Simplified FloatLine forward declaration (defined in .cpp)
 struct FloatLine;
@@ -62,6 +65,15 @@ private:
   // Destination distance calculator for heuristics
   std::unique_ptr<DestinationDistance> destinationDistance;
 
+  // Obstacle-proximity cost field (null when the cost is disabled)
+  const ProximityField* proximityField;
+
+  // Search recording (null unless this connection is being captured)
+  SearchCapture* searchCapture;
+
+  // Pins' access points (null unless ctrl.usePinAccess)
+  PinAccess* pinAccess;
+
   // Priority queue for expansion - using custom wrapper class
   class MazeExpansionList {
   public:
@@ -86,6 +98,14 @@ private:
   bool init(const std::vector<Item*>& startItems,
             const std::vector<Item*>& destItems);
 
+  // Layers a search may start or end on at an item: those its pin can be
+  // left on, or just its first layer without an access analysis
+  std::vector<int> entryLayers(const Item& item) const;
+
+  // Where a search starting at an item on a layer enters the board: the
+  // access point nearest the target, or the item center
+  FloatPoint startEntry(const Item& item, int layer, IntPoint target) const;
+
   // Main expansion loop - port of Java occupy_next_element()
   bool occupyNextElement();
 
@@ -110,6 +130,9 @@ private:
   double calcFanoutViaRipupCostFactor(Trace* pTrace);
   bool enterThroughSmallDoor(MazeListElement* pListElement, Item* pIgnoreItem);
   bool checkLeavingRippedItem(MazeListElement* pListElement);
+
+  // Record a door section entering or leaving the expansion list
+  void captureDoor(bool expanded, const MazeListElement* pElement, int pLayer);
 };
 
 } // namespace freerouting
@@ -0,0 +1,108 @@
+#ifndef FREEROUTING_AUTOROUTE_MULTIRESOLUTIONGRIDROUTER_H
+#define FREEROUTING_AUTOROUTE_MULTIRESOLUTIONGRIDROUTER_H
+
+#include "autoroute/ObstaclePyramid.h"
+#include "autoroute/ProximityField.h"
+#include "core/LayerMask.h"
+#include "datastructures/Stoppable.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <vector>
+
+namespace freerouting {
+
+// Coarse-to-fine grid router over an ObstaclePyramid
+// Finds a path on a coarse level first (cost grows with the blocked fraction
+// of each cell), then searches only a corridor around that path on each
+// finer level down to trace pitch. Long connections touch few fine cells and
+// short ones go straight to the finest level.
+class MultiResolutionGridRouter {
+public:
+  // One end of a connection
+  struct Endpoint {
+    IntPoint point;   // Where the route attaches
+    IntBox box;       // Item area; its cells are always passable
+    int firstLayer;
+    int lastLayer;
+    LayerMask accessLayers = kAllLayers;  // Of those, the layers a route may attach on
+  };
+
+  struct Config {
+    double viaCost = 50000.0;        // Cost of a layer change (internal units)
+    double congestionWeight = 4.0;   // Extra cost factor for blocked fraction
+    int coarseTargetCells = 16;      // Coarsest level spans about this many cells
+    int windowMargin = 8;            // Cells around start/goal on the first level
+    int corridorRadius = 1;          // Coarse cells kept around the coarse path
+    int maxExpansions = 200000;      // Per-level search limit
+
+    // Optional cost for finest-level cells near other nets' copper
+    const ProximityField* proximity = nullptr;
+    double proximityWeight = 0.0;
+
+    // Layers the route may use (empty = all); endpoint cells stay passable
+    std::vector<bool> layerActive;
+
+    // Polled during the search; once set, findPath gives up (not found)
+    const Stoppable* stoppable = nullptr;
+  };
+
+  // Same shape as SimpleGridRouter::Result so callers can swap engines
+  struct Result {
+    bool found = false;
+    std::vector<IntPoint> pathPoints;
+    std::vector<int> pathLayers;
+    int levelsSearched = 0;
+    int cellsExpanded = 0;
+  };
+
+  explicit MultiResolutionGridRouter(const ObstaclePyramid& pyramid)
+    : pyramid_(pyramid), config_() {}
+
+  MultiResolutionGridRouter(const ObstaclePyramid& pyramid, const Config& cfg)
+    : pyramid_(pyramid), config_(cfg) {}
+
+  // Find a path for netNo from start to goal
+  Result findPath(const Endpoint& start, const Endpoint& goal, int netNo) const;
+
+  const Config& getConfig() const { return config_; }
+
+private:
+  // A cell on a level's search window
+  struct Cell {
+    int x;
+    int y;
+    int layer;
+  };
+
+  // Rectangular search window with an optional corridor mask
+  struct Window {
+    int x0, y0, x1, y1;
+    std::vector<unsigned char> mask;  // Empty = whole window allowed
+
+    int width() const { return x1 - x0 + 1; }
+    int height() const { return y1 - y0 + 1; }
+    bool allows(int x, int y) const {
+      if (x < x0 || x > x1 || y < y0 || y > y1) return false;
+      return mask.empty() || mask[static_cast<size_t>(y - y0) * width() + (x - x0)] != 0;
+    }
+  };
+
+  // A* on one level; returns the cell path (empty if none)
+  std::vector<Cell> searchLevel(int level, const Window& window,
+                                const Endpoint& start, const Endpoint& goal,
+                                int netNo, int& expansions) const;
+
+  // Corridor on level-1 around a path found on level
+  Window corridorBelow(int level, const std::vector<Cell>& path, int radius) const;
+
+  // Convert a level-0 cell path into route points, dropping collinear points
+  void buildRoute(const std::vector<Cell>& path, const Endpoint& start,
+                  const Endpoint& goal, Result& result) const;
+
+  const ObstaclePyramid& pyramid_;
+  Config config_;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_MULTIRESOLUTIONGRIDROUTER_H
@@ -0,0 +1,109 @@
+#ifndef FREEROUTING_AUTOROUTE_OBSTACLEPYRAMID_H
+#define FREEROUTING_AUTOROUTE_OBSTACLEPYRAMID_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <vector>
+#include <utility>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Multi-resolution occupancy raster of the board, one stack of levels per layer
+// Level 0 cells are one trace pitch wide; each coarser level halves the
+// resolution and stores how many level-0 cells below it are blocked.
+// Every cell also remembers which net owns its obstacles, so a single
+// pyramid answers queries for all nets and can be shared across connections.
+// Board changes only mark regions dirty; they are re-rasterized on refresh().
+class ObstaclePyramid {
+public:
+  static constexpr int kFree = -1;      // No obstacle in cell
+  static constexpr int kBlocked = -2;   // Obstacle for every net
+  static constexpr int kMaxLevels = 10;
+
+  // Build the pyramid for all items on the board
+  // cellSize: level-0 cell width (trace pitch)
+  // inflation: distance items are grown by (trace half width + clearance)
+  ObstaclePyramid(const RoutingBoard* board, int cellSize, int inflation);
+
+  int getCellSize() const { return cellSize_; }
+  int getInflation() const { return inflation_; }
+  int levelCount() const { return static_cast<int>(levels_.size()); }
+  int layerCount() const { return layerCount_; }
+  const IntBox& getBounds() const { return bounds_; }
+
+  // Cell width and grid size at a level
+  int levelCellSize(int level) const { return cellSize_ << level; }
+  int levelWidth(int level) const { return levels_[level].width; }
+  int levelHeight(int level) const { return levels_[level].height; }
+
+  // Cell containing a board point (clamped to the grid)
+  std::pair<int, int> cellOf(int level, IntPoint point) const;
+
+  // Board coordinates of a cell center
+  IntPoint cellCenter(int level, int cx, int cy) const;
+
+  // Fraction (0..1) of the level-0 cells inside a cell that block netNo
+  double blockedFraction(int level, int layer, int cx, int cy, int netNo) const;
+
+  // True if no level-0 cell inside the cell is usable by netNo
+  bool isFullyBlocked(int level, int layer, int cx, int cy, int netNo) const {
+    return blockedFraction(level, layer, cx, cy, netNo) >= 1.0;
+  }
+
+  // Mark a board region as changed (cheap; called on every item change)
+  void markDirty(const IntBox& region) { dirtyRegions_.push_back(region); }
+
+  bool hasDirtyRegions() const { return !dirtyRegions_.empty(); }
+
+  // Re-rasterize all dirty regions and propagate them up the levels
+  void refresh();
+
+  // Heap memory held by the levels
+  size_t memoryBytes() const {
+    size_t bytes = levels_.capacity() * sizeof(Level) + dirtyRegions_.capacity() * sizeof(IntBox);
+    for (const Level& level : levels_) {
+      bytes += level.blockedCount.capacity() * sizeof(u32) + level.owner.capacity() * sizeof(int);
+    }
+    return bytes;
+  }
+
+private:
+  struct Level {
+    int width = 0;
+    int height = 0;
+    std::vector<u32> blockedCount;  // [layer][y][x] level-0 cells blocked
+    std::vector<int> owner;         // [layer][y][x] kFree, kBlocked or net
+  };
+
+  const RoutingBoard* board_;
+  int cellSize_;
+  int inflation_;
+  int layerCount_;
+  IntBox bounds_;
+  std::vector<Level> levels_;
+  std::vector<IntBox> dirtyRegions_;
+
+  size_t cellIndex(const Level& level, int layer, int cx, int cy) const {
+    return (static_cast<size_t>(layer) * level.height + cy) * level.width + cx;
+  }
+
+  // Combine two owners: same net stays, different nets block everyone
+  static int mergeOwner(int a, int b) {
+    if (a == kFree) return b;
+    if (b == kFree) return a;
+    return a == b ? a : kBlocked;
+  }
+
+  // Re-rasterize level-0 cells [x0,x1] x [y0,y1] from the board
+  void rasterize(int x0, int y0, int x1, int y1);
+
+  // Rebuild cells [x0,x1] x [y0,y1] of a level from the level below
+  void aggregate(int level, int x0, int y0, int x1, int y1);
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_OBSTACLEPYRAMID_H
@@ -0,0 +1,137 @@
+#ifndef FREEROUTING_AUTOROUTE_OCCUPANCYPYRAMID_H
+#define FREEROUTING_AUTOROUTE_OCCUPANCYPYRAMID_H
+
+#include "core/Types.h"
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <atomic>
+#include <vector>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Conservative occupancy bitmap of the board, used to answer conflict
+// queries without the spatial index where the answer is obvious
+// Per layer and cell, level 0 records which net's copper comes within the
+// inflation distance of the cell (none, one net, or several), and which
+// net's copper covers the cell completely. Coarser levels halve the
+// resolution and merge the "comes near" owner of their four cells, so a
+// long query box that crosses open board is answered from a few cells.
+//
+// Answers are exact where they are given: Empty means no copper of another
+// net within the inflation of the queried box, Full means the queried point
+// lies inside copper of another net. Everything else is Mixed, and the
+// caller asks the spatial index. Unlike the obstacle pyramid, item changes
+// are applied at once (update()), since the queries it stands in for must
+// see every item.
+// Cells also record whether a trace keepout comes near, for the rule area
+// checks that go with the item queries. Rule areas are read when the
+// bitmap is built; once the board has a different number of them, every
+// point counts as near a keepout.
+class OccupancyPyramid {
+public:
+  enum class State {
+    Empty,  // Clear of other nets' copper
+    Full,   // Inside other nets' copper
+    Mixed   // Not known from the bitmap
+  };
+
+  struct Statistics {
+    u64 probes = 0;
+    u64 empty = 0;
+    u64 full = 0;
+
+    // Fraction of probes answered without the spatial index
+    double hitRate() const {
+      return probes > 0 ? static_cast<double>(empty + full) / static_cast<double>(probes) : 0.0;
+    }
+  };
+
+  static constexpr int kMaxLevels = 12;
+
+  // cellSize: level-0 cell width
+  // inflation: farthest copper a query may reach beyond its box
+  OccupancyPyramid(const RoutingBoard* board, int cellSize, int inflation);
+
+  int getCellSize() const { return cellSize_; }
+  int getInflation() const { return inflation_; }
+  int levelCount() const { return static_cast<int>(levels_.size()); }
+  const IntBox& getBounds() const { return bounds_; }
+
+  // State of a point for a trace of netNo that must keep reach away from
+  // other copper
+  State probePoint(IntPoint point, int layer, int netNo, int reach) const;
+
+  // Empty or Mixed for a box that must keep reach away from other copper
+  State probeBox(const IntBox& box, int layer, int netNo, int reach) const;
+
+  // True if no trace keepout on the layer comes near the point
+  bool isKeepoutFree(IntPoint point, int layer) const;
+
+  // Rasterize a region again after an item in it was added or removed
+  // The board's spatial index must already reflect the change
+  void update(const IntBox& region);
+
+  Statistics getStatistics() const;
+
+  // Heap memory held by the levels
+  size_t memoryBytes() const;
+
+private:
+  static constexpr int kFree = -1;     // No copper
+  static constexpr int kShared = -2;   // Copper of several nets, or of none
+
+  struct Level {
+    int width = 0;
+    int height = 0;
+    std::vector<int> nearOwner;  // [layer][y][x] kFree, kShared or net
+  };
+
+  size_t cellIndex(const Level& level, int layer, int cx, int cy) const {
+    return (static_cast<size_t>(layer) * level.height + cy) * level.width + cx;
+  }
+
+  // Combine two owners: same net stays, different nets are shared
+  static int mergeOwner(int a, int b) {
+    if (a == kFree) return b;
+    if (b == kFree) return a;
+    return a == b ? a : kShared;
+  }
+
+  // True if a cell's copper, if any, is all of netNo
+  static bool isClearFor(int owner, int netNo) {
+    return owner == kFree || owner == netNo;
+  }
+
+  // Level-0 cell column or row of a coordinate
+  int cellX(int x) const;
+  int cellY(int y) const;
+
+  // True if the cell and every cell below it down to level 0 within
+  // [x0,x1] x [y0,y1] (level-0 indices) is clear; budget bounds the visits
+  bool isRangeClear(int level, int layer, int cx, int cy, int x0, int y0, int x1, int y1,
+                    int netNo, int& budget) const;
+
+  void rasterize(int x0, int y0, int x1, int y1);
+  void aggregate(int level, int x0, int y0, int x1, int y1);
+  void rasterizeKeepouts();
+
+  const RoutingBoard* board_;
+  int cellSize_;
+  int inflation_;
+  int layerCount_;
+  IntBox bounds_;
+  std::vector<Level> levels_;
+  std::vector<int> fullOwner_;   // Level 0 only: [layer][y][x]
+  std::vector<u8> keepoutNear_;  // Level 0 only: [layer][y][x]
+  size_t ruleAreaCount_ = 0;     // Rule areas when keepouts were rasterized
+
+  mutable std::atomic<u64> probes_{0};
+  mutable std::atomic<u64> empty_{0};
+  mutable std::atomic<u64> full_{0};
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_OCCUPANCYPYRAMID_H
@@ -0,0 +1,70 @@
+#ifndef FREEROUTING_AUTOROUTE_PATHSIMPLIFIER_H
+#define FREEROUTING_AUTOROUTE_PATHSIMPLIFIER_H
+
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <vector>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Reduces a found path to as few trace segments as possible before it is
+// put on the board
+// Paths are given as the engine's points and layers: layers[0] is the start
+// layer, layers[i] the layer of the segment ending at points[i], and a layer
+// change means a via at the point before it.
+//
+// Two steps:
+// - Points in the middle of a straight run, and zero-length steps, are
+//   dropped. The copper is the same, so this needs no checks.
+// - Corners are cut: within each run on one layer, a point is skipped if the
+//   straight segment past it keeps clear of other nets' items. The items
+//   near a run are fetched from the board's spatial index once per run and
+//   every shortcut of the run is checked against that list. Items are taken
+//   as their bounding boxes grown by half width + clearance, as in
+//   AutorouteEngine's conflict check, so this never cuts closer than that.
+// Vias stay where they are.
+class PathSimplifier {
+public:
+  struct Statistics {
+    int segmentsIn = 0;    // Trace segments in the paths as found
+    int segmentsOut = 0;   // ... and as inserted
+    int cornersCut = 0;    // Points removed by a checked shortcut
+  };
+
+  // halfWidths are the trace half widths per layer
+  PathSimplifier(const RoutingBoard* board, int netNo, const std::vector<int>& halfWidths)
+    : board_(board), netNo_(netNo), halfWidths_(halfWidths) {}
+
+  // Simplify a path in place
+  void simplify(std::vector<IntPoint>& points, std::vector<int>& layers);
+
+  // Just the first step; needs no board
+  static void mergeCollinear(std::vector<IntPoint>& points, std::vector<int>& layers);
+
+  // Number of trace segments (steps to a different point) in a path
+  static int countSegments(const std::vector<IntPoint>& points);
+
+  const Statistics& getStatistics() const { return stats_; }
+
+private:
+  // Cut corners in the run points[first..last], all on one layer
+  void cutCorners(const std::vector<IntPoint>& points, size_t first, size_t last, int layer,
+                  std::vector<IntPoint>& outPoints, std::vector<int>& outLayers);
+
+  // Obstacle boxes on the layer around a region, grown by the margin
+  void collectObstacles(const IntBox& region, int layer, int margin);
+
+  bool isSegmentClear(IntPoint a, IntPoint b) const;
+
+  const RoutingBoard* board_;
+  int netNo_;
+  std::vector<int> halfWidths_;
+  std::vector<IntBox> obstacles_;  // For the run being simplified
+  Statistics stats_;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_PATHSIMPLIFIER_H
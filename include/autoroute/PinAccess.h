@@ -0,0 +1,118 @@
+#ifndef FREEROUTING_AUTOROUTE_PINACCESS_H
+#define FREEROUTING_AUTOROUTE_PINACCESS_H
+
+#include "core/LayerMask.h"
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace freerouting {
+
+class DrillItem;
+class Item;
+class Padstack;
+class RoutingBoard;
+
+// Where traces can leave each pin, given its neighbours and the clearance
+// For every pin (and via) a short stub is tried from the center in each of
+// the eight compass directions, on each layer of its padstack, to a point
+// one trace width plus clearance beyond the pad edge. A stub that keeps
+// clear of other nets' copper and of trace keepouts gives an access point.
+// The stub ends depend only on the pad's shape, so they are kept once per
+// padstack and pad extent; pads here are axis-aligned boxes, so the extent
+// stands for the orientation as well.
+//
+// All pins are analysed when the board's access cache is built. Item changes
+// only mark regions dirty; refresh() analyses again the pins whose stubs
+// could reach into them. Searches use the result to start and end only on
+// layers a pin can be left on, and to start from the access point nearest
+// the destination.
+class PinAccess {
+public:
+  struct AccessPoint {
+    IntPoint point;       // End of the stub, clear of other nets
+    IntVector direction;  // Compass step (-1, 0, 1 in x and y)
+    int layer;
+  };
+
+  struct Statistics {
+    int pins = 0;         // Pins with an analysis
+    int analyses = 0;     // Pin analyses done, including updates
+    int blockedPins = 0;  // Pins without any access point
+    int templates = 0;    // Distinct padstack and pad extent combinations
+  };
+
+  // halfWidth and clearance of the traces that leave the pins
+  PinAccess(const RoutingBoard* board, int halfWidth, int clearance);
+
+  int getHalfWidth() const { return halfWidth_; }
+  int getClearance() const { return clearance_; }
+
+  // Access points of a pin or via; analysed now if it was not before
+  const std::vector<AccessPoint>& get(const DrillItem& item);
+
+  // Layers with at least one access point (0 if the pin is boxed in)
+  LayerMask accessLayers(const DrillItem& item);
+
+  // Access point on a layer nearest to a target, or nullptr if none
+  const AccessPoint* nearest(const DrillItem& item, int layer, IntPoint target);
+
+  // Mark a board region as changed (cheap; called on every item change)
+  void markDirty(const IntBox& region) { dirtyRegions_.push_back(region); }
+
+  bool hasDirtyRegions() const { return !dirtyRegions_.empty(); }
+
+  // Forget a pin taken off the board
+  void remove(const Item* item) { pins_.erase(item); }
+
+  // Analyse again the pins near dirty regions
+  void refresh();
+
+  Statistics getStatistics() const;
+
+  // Heap memory held by the analyses
+  size_t memoryBytes() const;
+
+private:
+  // Stub end relative to the pad center
+  struct StubEnd {
+    IntVector offset;
+    IntVector direction;
+  };
+
+  struct PinEntry {
+    std::vector<AccessPoint> points;
+    LayerMask layers = 0;
+  };
+
+  // Stub ends for a pad, kept per padstack and pad extent
+  const std::vector<StubEnd>& stubEnds(const DrillItem& item);
+
+  // Try every stub of some pins against the board
+  // The index lookups of all stubs go in one batch query
+  void analyze(const std::vector<const DrillItem*>& items);
+
+  // True if another net's item is too close to a stub on a layer
+  bool blocksStub(const Item& other, IntPoint from, IntPoint to, int layer) const;
+
+  // True if a stub on a layer keeps clear of trace keepouts
+  bool isKeepoutClear(IntPoint from, IntPoint to, int layer, int netNo) const;
+
+  const RoutingBoard* board_;
+  int halfWidth_;
+  int clearance_;
+  int reach_;  // Farthest a stub check reaches from a pad center
+  std::map<std::tuple<const Padstack*, int, int>, std::vector<StubEnd>> stubEnds_;
+  // By item, not ID: the KiCad converter numbers items itself, so IDs the
+  // router hands out can repeat those of pins
+  std::unordered_map<const Item*, PinEntry> pins_;
+  std::vector<IntBox> dirtyRegions_;
+  int analyses_ = 0;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_PINACCESS_H
@@ -0,0 +1,112 @@
+#ifndef FREEROUTING_AUTOROUTE_PROXIMITYFIELD_H
+#define FREEROUTING_AUTOROUTE_PROXIMITYFIELD_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <vector>
+#include <utility>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Per-layer distance from every raster cell to the nearest copper
+// Computed as an exact Euclidean distance transform of the rasterized item
+// boxes: a vertical pass done as two sweeps over whole rows (vectorizable),
+// then a lower-envelope-of-parabolas pass along each row. Layers are
+// processed in parallel on large updates. The nearest obstacle's net is kept
+// with the distance, so a net is not pushed away from its own copper.
+// Distances are capped at the range; item changes only mark regions dirty
+// and refresh() recomputes the cells within range of them.
+class ProximityField {
+public:
+  static constexpr int kFree = -1;     // No copper in cell
+  static constexpr int kBlocked = -2;  // Copper of several nets / no net
+
+  // cellSize: raster resolution; range: distance beyond which cost is zero
+  ProximityField(const RoutingBoard* board, int cellSize, int range);
+
+  int getCellSize() const { return cellSize_; }
+  int getRange() const { return range_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int layerCount() const { return layerCount_; }
+  const IntBox& getBounds() const { return bounds_; }
+
+  // Distance (board units, capped at range) from a point to the nearest
+  // copper on a layer, and the net owning that copper
+  double distanceAt(IntPoint point, int layer) const;
+  int nearestOwnerAt(IntPoint point, int layer) const;
+
+  // Proximity cost at a point for a net: weight * (range - distance) when
+  // the nearest copper belongs to another net, zero otherwise
+  double costAt(IntPoint point, int layer, int netNo, double weight) const;
+
+  // Mark a board region on a layer range as changed (cheap; called on every
+  // item change)
+  void markDirty(const IntBox& region, int firstLayer, int lastLayer) {
+    dirtyRegions_.push_back({region, firstLayer, lastLayer});
+  }
+
+  bool hasDirtyRegions() const { return !dirtyRegions_.empty(); }
+
+  // Re-rasterize dirty regions and recompute distances within range of them
+  void refresh();
+
+  // Heap memory held by the layer rasters
+  size_t memoryBytes() const {
+    size_t bytes = layers_.capacity() * sizeof(LayerGrid) +
+                   dirtyRegions_.capacity() * sizeof(DirtyRegion);
+    for (const LayerGrid& grid : layers_) {
+      bytes += grid.owner.capacity() * sizeof(int) + grid.distance.capacity() * sizeof(float) +
+               grid.nearest.capacity() * sizeof(int);
+    }
+    return bytes;
+  }
+
+private:
+  // Rasters of one layer; left empty until the layer holds copper, so
+  // boards with many unused layers stay small
+  struct LayerGrid {
+    std::vector<int> owner;       // [y][x] copper owner
+    std::vector<float> distance;  // [y][x] capped distance in cells
+    std::vector<int> nearest;     // [y][x] owner of nearest copper
+  };
+
+  struct DirtyRegion {
+    IntBox box;
+    int firstLayer;
+    int lastLayer;
+  };
+
+  const RoutingBoard* board_;
+  int cellSize_;
+  int range_;
+  int rangeCells_;
+  int layerCount_;
+  int width_ = 0;
+  int height_ = 0;
+  IntBox bounds_;
+
+  std::vector<LayerGrid> layers_;
+  std::vector<DirtyRegion> dirtyRegions_;
+
+  size_t cellIndex(int cx, int cy) const {
+    return static_cast<size_t>(cy) * width_ + cx;
+  }
+
+  // Cell containing a point (clamped)
+  std::pair<int, int> cellOf(IntPoint point) const;
+
+  // Re-rasterize copper owners for cells [x0,x1] x [y0,y1] on a layer range;
+  // returns the layers that hold or held copper there
+  std::vector<int> rasterize(int x0, int y0, int x1, int y1, int firstLayer, int lastLayer);
+
+  // Recompute distances for cells [x0,x1] x [y0,y1] on one layer
+  void computeDistances(int layer, int x0, int y0, int x1, int y1);
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_PROXIMITYFIELD_H
@@ -0,0 +1,42 @@
+#ifndef FREEROUTING_AUTOROUTE_ROUTERPROFILE_H
+#define FREEROUTING_AUTOROUTE_ROUTERPROFILE_H
+
+#include "autoroute/BatchAutorouter.h"
+#include <string>
+
+namespace freerouting {
+
+// Tuned router parameters stored as a text file
+// One "key = value" per line, '#' starts a comment. Keys not present keep
+// the value already in the config, so a profile may set only some of them.
+// Written by freerouting-autotune and loaded with --profile.
+//
+//   max_passes = 8
+//   start_ripup_costs = 150
+//   via_cost = 60
+//   trace_cost_preferred = 1.0
+//   trace_cost_against = 1.5
+//   max_iterations_base = 40000
+//   max_iterations_per_connection = 5000
+//   proximity_cost_weight = 0
+//   proximity_range = 5000
+//   connection_order = size
+class RouterProfile {
+public:
+  // Apply profile text to a config; on error nothing is changed
+  static bool parse(const std::string& text, BatchAutorouter::Config& config,
+                    std::string& errorMsg);
+
+  // Profile text for a config; comment lines (without '#') go first
+  static std::string format(const BatchAutorouter::Config& config,
+                            const std::string& comment = "");
+
+  static bool loadFromFile(const std::string& filename, BatchAutorouter::Config& config,
+                           std::string& errorMsg);
+  static bool saveToFile(const std::string& filename, const BatchAutorouter::Config& config,
+                         const std::string& comment = "");
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_ROUTERPROFILE_H
@@ -0,0 +1,93 @@
+#ifndef FREEROUTING_AUTOROUTE_ROUTINGSESSION_H
+#define FREEROUTING_AUTOROUTE_ROUTINGSESSION_H
+
+#include "autoroute/AutorouteEngine.h"
+#include "board/RoutingBoard.h"
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <memory>
+#include <vector>
+
+namespace freerouting {
+
+class Item;
+
+// Library API for routing one connection at a time with low latency, for an
+// editor's "route this connection now"
+// The session keeps the board and one engine resident between calls, so the
+// board's spatial index, obstacle rasters and the engine's allocations stay
+// warm; edits update them incrementally. Per call, only the items in a
+// window around the connection are put in the engine's search tree, the
+// layer choice looks only at that window, and the search is bounded by an
+// iteration budget and a deadline. The route is then checked for clearance
+// against the items near it, and taken off again if it fails.
+class RoutingSession {
+public:
+  struct Options {
+    int margin = 50000;          // Search window around the two items (5mm)
+    int traceHalfWidth = 1250;   // 0.25mm traces
+    int maxIterations = 20000;   // Maze search budget
+    int timeLimitMs = 50;        // Deadline for the search (< 0 = none)
+    bool gridFallback = true;    // Try the grid router if the maze search fails
+    bool simplifyPaths = true;
+    bool rejectConflicts = true; // Remove a route that fails the clearance check
+  };
+
+  enum class Status {
+    Routed,
+    AlreadyConnected,
+    NotRouted,      // No path within the budget
+    Conflict,       // A path was found but failed the clearance check
+    InvalidItems    // An item does not exist or they are on different nets
+  };
+
+  struct Result {
+    Status status = Status::NotRouted;
+    std::vector<int> newItemIds;  // Traces and vias the route added
+    int conflicts = 0;            // Clearance violations next to the route
+    int windowItems = 0;          // Items the search saw
+    double searchMs = 0.0;
+    double validateMs = 0.0;
+    double totalMs = 0.0;
+  };
+
+  explicit RoutingSession(std::unique_ptr<RoutingBoard> board);
+
+  RoutingBoard& getBoard() { return *board_; }
+  const RoutingBoard& getBoard() const { return *board_; }
+
+  // Incremental edits; the item IDs of the board stay valid
+  int addItem(std::unique_ptr<Item> item);  // Returns the item's ID
+  bool removeItem(int itemId);
+  bool moveItem(int itemId, IntVector offset);  // Pins, vias and traces
+
+  // Route between two items of one net
+  Result routeConnection(int fromItemId, int toItemId, const Options& options);
+  Result routeConnection(int fromItemId, int toItemId) {
+    return routeConnection(fromItemId, toItemId, Options());
+  }
+
+  // Take a route off the board again (undo)
+  void removeRoute(const Result& result);
+
+  // Clearance violations between the items and copper of other nets near them
+  int countConflicts(const std::vector<int>& itemIds) const;
+
+  // The board's incomplete connections, brought up to date after edits
+  const std::vector<IncompleteConnection>& getIncompleteConnections();
+
+private:
+  std::unique_ptr<RoutingBoard> board_;
+  AutorouteEngine engine_;
+  bool connectionsDirty_ = true;  // Edits since the incomplete connections were computed
+
+  // Clearance check of one item against the board near it
+  int countConflicts(const Item& item) const;
+
+  // Called after every edit
+  void boardChanged();
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_ROUTINGSESSION_H
@@ -0,0 +1,75 @@
+#ifndef FREEROUTING_AUTOROUTE_ROUTINGWORKERPOOL_H
+#define FREEROUTING_AUTOROUTE_ROUTINGWORKERPOOL_H
+
+#include "autoroute/BatchAutorouter.h"
+#include "autoroute/TileJob.h"
+#include "core/Types.h"
+#include <sys/types.h>
+#include <vector>
+
+namespace freerouting {
+
+class BasicBoard;
+class Stoppable;
+
+// Routing worker processes, each connected to the coordinator by a Unix
+// domain socket
+// Workers are forked, so they start with the coordinator's board rules and
+// routing settings; after that they only see what arrives on the socket.
+// Each message is a frame: u32 little-endian length, then a TileJob (to a
+// worker) or TileOutcome (back) in their binary form. A worker routes one
+// job at a time and exits when its socket is closed.
+//
+// serve() is the whole worker side, so a worker can equally run on another
+// machine over any stream socket, given the same board rules.
+class RoutingWorkerPool {
+public:
+  RoutingWorkerPool(const BasicBoard* rules, const BatchAutorouter::Config& routing)
+    : rules_(rules), routing_(routing) {}
+  ~RoutingWorkerPool();
+
+  RoutingWorkerPool(const RoutingWorkerPool&) = delete;
+  RoutingWorkerPool& operator=(const RoutingWorkerPool&) = delete;
+
+  // Fork up to count workers; returns how many were started
+  int start(int count);
+
+  // Close the sockets and reap the workers
+  void stop();
+
+  int size() const { return static_cast<int>(workers_.size()); }
+
+  // Job bytes written to workers so far
+  size_t getBytesSent() const { return bytesSent_; }
+
+  // Route the jobs, each on the next idle worker
+  // Outcomes are in job order; a job that could not be completed (worker
+  // died, or stop requested before it was sent) has an empty outcome.
+  // Workers only see a job's own time limit, so once stoppable fires they
+  // get a second to send back what they have, and are then killed and
+  // their jobs left empty.
+  std::vector<TileOutcome> run(const std::vector<TileJob>& jobs, Stoppable* stoppable);
+
+  // Worker loop on a connected socket: route each job received and send
+  // back its outcome, until the socket is closed
+  static void serve(int fd, const BasicBoard& rules, const BatchAutorouter::Config& routing);
+
+  // Framing; false on error or end of stream
+  static bool writeFrame(int fd, const std::vector<u8>& payload);
+  static bool readFrame(int fd, std::vector<u8>& payload);
+
+private:
+  struct Worker {
+    pid_t pid;
+    int fd;
+  };
+
+  const BasicBoard* rules_;
+  BatchAutorouter::Config routing_;
+  std::vector<Worker> workers_;
+  size_t bytesSent_ = 0;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_ROUTINGWORKERPOOL_H
@@ -0,0 +1,96 @@
+#ifndef FREEROUTING_AUTOROUTE_SEARCHCAPTURE_H
+#define FREEROUTING_AUTOROUTE_SEARCHCAPTURE_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace freerouting {
+
+class RoutingBoard;
+
+// Recording of one connection's search for offline inspection
+// Holds a snapshot of the board's item boxes, every expansion room created,
+// every door queued and expanded with its expansion (cost so far) and
+// sorting (cost + distance estimate) values, and the final path. Written in
+// a compact little-endian binary format; see src/tools/capture_to_svg.cpp for
+// the renderer.
+class SearchCapture {
+public:
+  enum class Kind : u8 {
+    Obstacle = 1,      // Board item: tag = net number (-1 if none)
+    Room = 2,          // Free space room: tag = room id
+    ObstacleRoom = 3,  // Obstacle room entered by the search: tag = item id
+    DoorQueued = 4,    // Door section put on the expansion list: tag = door id
+    DoorExpanded = 5,  // Door section taken off the list and occupied: tag = door id
+    PathPoint = 6      // Path waypoint in start->destination order: tag = door id or -1
+  };
+
+  // How the connection was finally found
+  enum class Outcome : u8 {
+    NotFound = 0,
+    MazeSearch = 1,
+    GridFallback = 2
+  };
+
+  struct Record {
+    Kind kind;
+    i16 firstLayer;
+    i16 lastLayer;
+    IntBox box;             // Point records use a degenerate box
+    i32 tag;
+    f32 expansionValue = 0.0f;
+    f32 sortingValue = 0.0f;
+  };
+
+  static constexpr u32 kMagic = 0x43535246;  // "FRSC"
+  static constexpr u32 kVersion = 1;
+
+  SearchCapture() = default;
+
+  // Start a capture: records the board's item boxes as obstacles
+  void begin(const RoutingBoard& board, int netNo, int passNo);
+
+  void addRoom(const IntBox& box, int layer, int roomId);
+  void addObstacleRoom(const IntBox& box, int layer, int itemId);
+  void addDoor(Kind kind, const void* door, const IntBox& box, int layer,
+               double expansionValue, double sortingValue);
+  void addPathPoint(IntPoint point, int layer, const void* door = nullptr);
+  void clearPath();
+
+  void setOutcome(Outcome outcome) { outcome_ = outcome; }
+
+  int getNetNo() const { return netNo_; }
+  int getPassNo() const { return passNo_; }
+  int getLayerCount() const { return layerCount_; }
+  const IntBox& getBounds() const { return bounds_; }
+  Outcome getOutcome() const { return outcome_; }
+  const std::vector<Record>& getRecords() const { return records_; }
+  size_t count(Kind kind) const;
+
+  // Binary serialization
+  bool writeToFile(const std::string& filename) const;
+  static std::optional<SearchCapture> readFromFile(const std::string& filename);
+
+private:
+  int netNo_ = -1;
+  int passNo_ = 0;
+  int layerCount_ = 0;
+  IntBox bounds_;
+  Outcome outcome_ = Outcome::NotFound;
+  std::vector<Record> records_;
+
+  // Stable small ids for door objects, so path points can be matched with
+  // their expansion records
+  std::unordered_map<const void*, int> doorIds_;
+
+  int doorId(const void* door);
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_SEARCHCAPTURE_H
@@ -1,6 +1,7 @@
 #ifndef FREEROUTING_AUTOROUTE_SHAPESEARCHTREE_H
 #define FREEROUTING_AUTOROUTE_SHAPESEARCHTREE_H
 
+#include "core/LayerMask.h"
 #include "geometry/Shape.h"
 #include "geometry/IntBox.h"
 #include <vector>
@@ -51,12 +52,20 @@ public:
   // Insert an object into the tree
   void insert(SearchTreeObject* object);
 
+  // Insert many objects at once; into an empty tree this builds a balanced
+  // tree by splitting at the median, which one-by-one inserts of a sorted
+  // board would not give
+  void insertAll(const std::vector<SearchTreeObject*>& objects);
+
   // Find all objects whose shapes overlap with the query box on a given layer
+  // Every node knows the layers below it, so subtrees without the layer are
+  // skipped and the results need no further filtering
   // Java: overlapping_tree_entries()
   void overlappingEntries(const IntBox& queryBox, int layer,
                          std::vector<TreeEntry>& results) const;
 
   // Find all objects on any layer (layer = -1 means all layers)
+  // A multi-layer object is reported once per layer entry
   void overlappingEntries(const IntBox& queryBox,
                          std::vector<TreeEntry>& results) const;
 
@@ -64,12 +73,16 @@ public:
   void clear();
 
   // Get number of objects in tree
-  int size() const { return leafCount; }
+  int size() const { return objectCount; }
+
+  // Get number of entries (one per object shape) in tree
+  int entryCount() const { return leafCount; }
 
 private:
   // Tree node types
   struct TreeNode {
     IntBox boundingBox;
+    LayerMask layers = 0;  // Layers of the leaves below
     TreeNode* parent = nullptr;
 
     virtual ~TreeNode() = default;
@@ -86,17 +99,24 @@ private:
   struct Leaf : public TreeNode {
     SearchTreeObject* object = nullptr;
     int shapeIndex = 0;
+    int layer = 0;
 
     bool isLeaf() const override { return true; }
   };
 
   // Find overlapping leaves (internal helper)
-  void findOverlaps(TreeNode* node, const IntBox& queryBox,
+  void findOverlaps(TreeNode* node, const IntBox& queryBox, LayerMask layers,
                    std::vector<Leaf*>& leaves) const;
 
   // Insert a leaf into the tree
   void insertLeaf(Leaf* leaf);
 
+  // New leaves for every shape of an object
+  void makeLeaves(SearchTreeObject* object, std::vector<Leaf*>& leaves);
+
+  // Balanced subtree over leaves [first, last)
+  TreeNode* build(std::vector<Leaf*>::iterator first, std::vector<Leaf*>::iterator last);
+
   // Find position for new leaf using minimum area increase heuristic
   Leaf* positionLocate(TreeNode* node, Leaf* newLeaf);
 
@@ -105,6 +125,7 @@ private:
 
   TreeNode* root = nullptr;
   int leafCount = 0;
+  int objectCount = 0;
 };
 
 } // namespace freerouting
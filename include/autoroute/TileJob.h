@@ -0,0 +1,117 @@
+#ifndef FREEROUTING_AUTOROUTE_TILEJOB_H
+#define FREEROUTING_AUTOROUTE_TILEJOB_H
+
+#include "autoroute/BatchAutorouter.h"
+#include "core/Types.h"
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace freerouting {
+
+class BasicBoard;
+class Stoppable;
+struct TileOutcome;
+
+// A batch of connections to route inside a window, with a snapshot of the
+// board items in that window
+// This is the unit of work TiledAutorouter hands out, to a thread or to a
+// RoutingWorkerPool process. It is self-contained apart from the board rules
+// (layers, clearance matrix, nets) and routing settings, which a worker gets
+// once when it starts. Jobs and outcomes have a compact little-endian binary
+// form for sending over a socket.
+struct TileJob {
+  enum class ItemKind : u8 {
+    Pin = 1,
+    Via = 2,
+    Trace = 3
+  };
+
+  // One board item; which fields apply depends on the kind
+  struct ItemRecord {
+    ItemKind kind = ItemKind::Pin;
+    i32 id = 0;
+    IntPoint a;                 // Pin/via center, trace start
+    IntPoint b;                 // Trace end
+    i32 layer = 0;              // Trace layer
+    i32 halfWidth = 0;          // Trace half width
+    std::string padstackName;   // Pin and via padstack
+    i32 fromLayer = 0;
+    i32 toLayer = 0;
+    i32 pinNumber = 0;
+    i32 componentNumber = 0;
+    std::vector<i32> nets;
+    i32 clearanceClass = 0;
+    u8 fixedState = 0;
+    bool attachAllowed = false;
+  };
+
+  struct ConnectionRecord {
+    i32 fromItemId;
+    i32 toItemId;
+    i32 netNo;
+  };
+
+  static constexpr u32 kMagic = 0x4a545246;  // "FRTJ"
+  static constexpr u32 kVersion = 2;
+
+  u32 jobId = 0;
+  IntBox window;
+  i32 keepMargin = 0;   // New copper must stay this far inside the window
+  i32 lastItemId = 0;   // Highest item ID on the board when the snapshot was taken
+  i32 timeLimitMs = -1; // Routing time from when the job starts (< 0 = none)
+  std::vector<ItemRecord> items;
+  std::vector<ConnectionRecord> connections;
+
+  // Route the connections on a board holding only the snapshot
+  // rules supplies the layers, clearance matrix and nets. Routing stops at
+  // the job's time limit or when stoppable does, and what was routed by
+  // then is returned.
+  TileOutcome route(const BasicBoard& rules, const BatchAutorouter::Config& routing,
+                    Stoppable* stoppable) const;
+
+  std::vector<u8> encode() const;
+  static std::optional<TileJob> decode(const std::vector<u8>& data);
+};
+
+// What routing a TileJob produced
+struct TileOutcome {
+  struct RoutedTrace {
+    IntPoint start;
+    IntPoint end;
+    i32 layer;
+    i32 halfWidth;
+    std::vector<i32> nets;
+    i32 clearanceClass;
+  };
+
+  struct RoutedVia {
+    IntPoint center;
+    std::string padstackName;
+    i32 fromLayer;
+    i32 toLayer;
+    std::vector<i32> nets;
+    i32 clearanceClass;
+    bool attachAllowed;
+  };
+
+  static constexpr u32 kMagic = 0x4f545246;  // "FRTO"
+  static constexpr u32 kVersion = 1;
+
+  u32 jobId = 0;
+  std::vector<RoutedTrace> traces;     // Only nets whose copper stayed inside the window
+  std::vector<RoutedVia> vias;
+  std::vector<i32> routedConnections;  // Indices into the job's connections
+  std::vector<i32> removedItemIds;     // Snapshot items ripped up by the routes kept
+  i32 rejectedNets = 0;                // Nets whose copper left the window
+  u32 boardItems = 0;                  // Items on the job's board after routing
+
+  std::vector<u8> encode() const;
+  static std::optional<TileOutcome> decode(const std::vector<u8>& data);
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_TILEJOB_H
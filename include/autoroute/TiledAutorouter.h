@@ -0,0 +1,121 @@
+#ifndef FREEROUTING_AUTOROUTE_TILEDAUTOROUTER_H
+#define FREEROUTING_AUTOROUTE_TILEDAUTOROUTER_H
+
+#include "autoroute/BatchAutorouter.h"
+#include "autoroute/TileJob.h"
+#include "board/RoutingBoard.h"
+#include "datastructures/Stoppable.h"
+#include "cli/ProgressDisplay.h"
+#include "geometry/IntBox.h"
+#include <memory>
+#include <vector>
+
+namespace freerouting {
+
+// Domain-decomposition routing for large boards
+// The board is cut into square tiles. A connection whose endpoints lie well
+// inside one tile's window (the tile plus a halo around it) is routed on a
+// small board holding only the items in that window, with its own engine,
+// search tree and room generators, so memory per worker follows the tile
+// size rather than the board size. Tiles are routed in four waves by tile
+// parity: tiles of one wave are a whole tile apart, so their windows never
+// overlap and they run in parallel, while each later wave sees the copper
+// of the earlier ones. A tile's route is kept only if it stays far enough
+// inside the window that every item it must clear was on the tile board.
+//
+// Tiles are routed as TileJobs, in threads of this process or in worker
+// processes. Connections between tiles, and those a tile could not route,
+// are then routed on the full board by an ordinary BatchAutorouter
+// (stitching). Tiles may rip up copies of unfixed copper; the originals are
+// removed from the main board with the tile's routes, and the nets they
+// belonged to are stitched again.
+class TiledAutorouter {
+public:
+  struct Config {
+    int tileSize = 500000;  // Tile width (50mm)
+    int halo = 50000;       // Window margin around a tile (5mm); at most tileSize / 4
+    int threads = 0;        // Tiles routed at once (0 = hardware threads)
+
+    // Route tiles in this many forked processes instead of threads
+    // (0 = threads; see RoutingWorkerPool)
+    int workerProcesses = 0;
+
+    // Time allowed for the whole run, stitching included (0 = no limit)
+    // Worker processes get the time left with each job
+    int timeLimitMs = 0;
+
+    // Routing settings for the tiles and for stitching
+    BatchAutorouter::Config routing;
+  };
+
+  struct Statistics {
+    int tiles = 0;                 // Tiles with connections of their own
+    int tileConnections = 0;       // Connections given to a tile
+    int tileConnectionsRouted = 0; // ... and routed there and kept
+    int rejectedNets = 0;          // Tile routes dropped for leaving their window
+    int conflictNets = 0;          // ... or for touching copper added meanwhile
+    int rippedItems = 0;           // Main board items removed for tile routes
+    int workers = 0;               // Worker processes used (0 = threads)
+    size_t jobBytes = 0;           // Encoded size of all tile jobs sent to workers
+    int stitchConnections = 0;     // Connections left for stitching
+    size_t maxTileItems = 0;       // Items on the largest tile board
+    double tileMs = 0.0;
+    double stitchMs = 0.0;
+  };
+
+  TiledAutorouter(RoutingBoard* board, const Config& cfg);
+
+  // Route the board's incomplete connections (see updateIncompleteConnections)
+  // Returns true if the board is completely routed
+  bool run(Stoppable* stoppable);
+
+  const Statistics& getStatistics() const { return stats_; }
+
+  // Statistics of the stitching router's last pass
+  const BatchAutorouter::PassStatistics& getLastPassStats() const { return stitchStats_; }
+
+  // Optional; used for the stitching passes and tile summaries
+  void setProgressDisplay(ProgressDisplay* display) { progressDisplay_ = display; }
+
+private:
+  // A tile with the connections routed in it
+  struct Tile {
+    int tx;
+    int ty;
+    IntBox window;
+    std::vector<const IncompleteConnection*> connections;
+  };
+
+  // Tile windows and the connections that fit in one
+  std::vector<Tile> partition(const std::vector<const IncompleteConnection*>& connections) const;
+
+  // Snapshot of a tile's window and connections
+  // timeLimitMs: time the job may take (< 0 = no limit)
+  TileJob makeJob(const Tile& tile, u32 jobId, int timeLimitMs) const;
+
+  // Route a wave's jobs in threads of this process
+  std::vector<TileOutcome> runJobs(const std::vector<TileJob>& jobs, Stoppable* stoppable) const;
+
+  // Add a job's copper to the main board, remove the items it ripped up
+  // and mark its connections routed
+  // A net is skipped if its new copper would touch copper added to the
+  // board after the job's snapshot was taken; if the job ripped anything
+  // up, the whole job is
+  void merge(const Tile& tile, const TileJob& job, const TileOutcome& outcome);
+
+  // Largest clearance on any layer: how far inside its window a route must stay
+  int clearanceMargin() const;
+
+  // Settings for routing inside a tile
+  BatchAutorouter::Config tileRouting() const;
+
+  RoutingBoard* board_;
+  Config config_;
+  Statistics stats_;
+  BatchAutorouter::PassStatistics stitchStats_;
+  ProgressDisplay* progressDisplay_ = nullptr;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_TILEDAUTOROUTER_H
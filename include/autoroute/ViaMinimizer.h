@@ -0,0 +1,108 @@
+#ifndef FREEROUTING_AUTOROUTE_VIAMINIMIZER_H
+#define FREEROUTING_AUTOROUTE_VIAMINIMIZER_H
+
+#include "geometry/IntBox.h"
+#include "geometry/Vector2.h"
+#include <optional>
+#include <vector>
+
+namespace freerouting {
+
+class Item;
+class RoutingBoard;
+class Trace;
+class Via;
+
+// Post-route pass that removes vias by moving the copper between them onto
+// one layer
+// A candidate is a run of two or three unfixed vias of one net, joined by
+// plain trace chains (no branches, pins or other vias), where the copper
+// outside the run is on the same layer A at both ends:
+//
+//   A ... V1 =chain on B= V2 ... A              (pair)
+//   A ... V1 =chain on B= V2 =chain on C= V3 ... A   (triple)
+//
+// Moving the chains to A makes all the vias of the run unnecessary.
+//
+// Candidates are found and checked for clearance on A in parallel, since
+// that only reads the board. They are then applied one at a time, each
+// only if all its items are still there; one near a change already applied
+// in the round waits for the next round, which starts again from the board
+// as it is. Rounds repeat while vias go.
+// Clearance uses the spatial index with the same rules as the router:
+// the clearance between default classes, item bounding boxes for pins and
+// vias, and exact segment distance between traces.
+class ViaMinimizer {
+public:
+  struct Config {
+    int threads = 0;     // Candidate search threads (0 = hardware threads)
+    int maxRounds = 4;
+  };
+
+  struct Statistics {
+    int viasBefore = 0;      // Unfixed vias when the pass started
+    int candidates = 0;      // Runs found that could lose their vias (all rounds)
+    int conflicts = 0;       // ... rejected for clearance on the target layer
+    int viasRemoved = 0;
+    int tracesMoved = 0;
+    int rounds = 0;
+    double durationMs = 0.0;
+
+    double viasRemovedPerSecond() const {
+      return durationMs > 0.0 ? viasRemoved * 1000.0 / durationMs : 0.0;
+    }
+  };
+
+  explicit ViaMinimizer(RoutingBoard* board) : board_(board) {}
+  ViaMinimizer(RoutingBoard* board, const Config& config) : board_(board), config_(config) {}
+
+  // Remove what vias can go; returns the number removed
+  int run();
+
+  const Statistics& getStatistics() const { return stats_; }
+
+private:
+  // One run of vias that can go, with the traces to move
+  struct Change {
+    int netNo = 0;
+    int layer = 0;                 // Layer the chains move to
+    std::vector<const Via*> vias;  // Sorted by ID
+    std::vector<const Trace*> traces;
+    IntBox region;                 // Moved copper grown by its clearance
+  };
+
+  // Trace ends on one layer at a via's center; nullopt if the via touches
+  // anything else, so that removing it could break a connection
+  struct ViaLinks {
+    std::vector<std::vector<const Trace*>> byLayer;  // Per layer of the board
+  };
+  std::optional<ViaLinks> linksOf(const Via& via) const;
+
+  // Follow a chain of traces on its layer from a via to the via at the far
+  // end; nullopt if it branches or ends anywhere else
+  std::optional<const Via*> followChain(const Via& from, const Trace& first,
+                                        std::vector<const Trace*>& chain) const;
+
+  // Candidate runs starting at the via, with their chains as the first leg
+  void findChanges(const Via& via, std::vector<Change>& changes) const;
+
+  // True if the chains can be put on the change's layer
+  bool isClear(const Change& change) const;
+
+  // Whether a trace on the chain touches same-net copper other than its
+  // neighbours in the chain and the vias at the ends
+  bool touchesOthers(const Trace& trace, const std::vector<const Trace*>& chain,
+                     const std::vector<const Via*>& vias) const;
+
+  // Replace the chains and remove the vias; false (board unchanged) if
+  // an item has gone since the change was found
+  bool apply(const Change& change);
+
+  RoutingBoard* board_;
+  Config config_;
+  Statistics stats_;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_AUTOROUTE_VIAMINIMIZER_H
@@ -6,8 +6,12 @@
 #include "rules/ClearanceMatrix.h"
 #include "board/Item.h"
 #include "board/RuleArea.h"
+#include "core/Padstack.h"
 #include <memory>
 #include <vector>
+#include <map>
+#include <string>
+#include <tuple>
 #include <algorithm>
 
 namespace freerouting {
@@ -43,6 +47,14 @@ public:
     }
   }
 
+  // Add many items at once; null entries are skipped
+  void addItems(std::vector<std::unique_ptr<Item>> items) {
+    items_.reserve(items_.size() + items.size());
+    for (auto& item : items) {
+      addItem(std::move(item));
+    }
+  }
+
   // Remove an item from the board by ID
   bool removeItem(int itemId) {
     auto it = std::find_if(items_.begin(), items_.end(),
@@ -58,6 +70,33 @@ public:
     return false;
   }
 
+  // Remove this item from the board
+  // Callers holding the item use this rather than looking its ID up again
+  bool removeItem(const Item* item) {
+    auto it = std::find_if(items_.begin(), items_.end(),
+                           [item](const std::unique_ptr<Item>& owned) {
+                             return owned.get() == item;
+                           });
+
+    if (it != items_.end()) {
+      (*it)->setOnBoard(false);
+      items_.erase(it);
+      return true;
+    }
+    return false;
+  }
+
+  // This item if the board still holds it, else nullptr
+  // Compares addresses only, so a pointer kept from before a removal is
+  // never dereferenced
+  Item* findItem(const Item* item) {
+    auto it = std::find_if(items_.begin(), items_.end(),
+                           [item](const std::unique_ptr<Item>& owned) {
+                             return owned.get() == item;
+                           });
+    return (it != items_.end()) ? it->get() : nullptr;
+  }
+
   // Get item by ID
   Item* getItem(int itemId) {
     auto it = std::find_if(items_.begin(), items_.end(),
@@ -108,12 +147,35 @@ public:
     return nextItemId_++;
   }
 
+  // ID the next generateItemId() call will return
+  int peekNextItemId() const { return nextItemId_; }
+
+  // Make generateItemId() return IDs above lastUsedId
+  // Needed when items are added with IDs they had on another board
+  void reserveItemIds(int lastUsedId) {
+    nextItemId_ = std::max(nextItemId_, lastUsedId + 1);
+  }
+
   // Clear all items
   void clear() {
     items_.clear();
     nextItemId_ = 1;
   }
 
+  // Get the board-owned padstack with this name and layer range
+  // Drill items share padstacks instead of allocating one each; the
+  // padstack lives as long as the board
+  const Padstack* getPadstack(const std::string& name, int fromLayer, int toLayer) {
+    auto key = std::make_tuple(name, fromLayer, toLayer);
+    auto it = padstacks_.find(key);
+    if (it == padstacks_.end()) {
+      int number = static_cast<int>(padstacks_.size()) + 1;
+      it = padstacks_.emplace(key, std::make_unique<Padstack>(
+        name, number, fromLayer, toLayer, true /* attachAllowed */, false)).first;
+    }
+    return it->second.get();
+  }
+
   // Get nets (optional - for integration with net management)
   void setNets(const Nets* nets) { nets_ = nets; }
   const Nets* getNets() const { return nets_; }
@@ -205,6 +267,8 @@ private:
   LayerStructure layers_;
   const ClearanceMatrix* clearanceMatrix_;
   const Nets* nets_ = nullptr;
+  // Declared before items_ so drill items never outlive their padstacks
+  std::map<std::tuple<std::string, int, int>, std::unique_ptr<Padstack>> padstacks_;
   std::vector<std::unique_ptr<Item>> items_;
   std::vector<std::unique_ptr<RuleArea>> ruleAreas_;
   int nextItemId_;
@@ -0,0 +1,62 @@
+#ifndef FREEROUTING_BOARD_CONTACTINDEX_H
+#define FREEROUTING_BOARD_CONTACTINDEX_H
+
+#include "geometry/Vector2.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace freerouting {
+
+class Item;
+
+// Hash from (point, layer) to the items that make contact there
+// A trace makes contact at its two ends on its layer, a pin or via at its
+// center on each of its layers. Two items touch when they share a contact,
+// so connectivity, dangling ends and merge partners are found by looking
+// up an item's own contacts instead of scanning its net.
+// Kept up to date by the board on every item insert and remove.
+class ContactIndex {
+public:
+  struct Contact {
+    IntPoint point;
+    int layer;
+
+    bool operator==(const Contact& other) const = default;
+  };
+
+  void insert(Item* item);
+  void remove(Item* item);
+  void clear() { contacts_.clear(); }
+
+  // Items with a contact at a point on a layer
+  std::span<Item* const> at(IntPoint point, int layer) const;
+
+  // Where an item makes contact (empty for items without a center or ends)
+  static std::vector<Contact> contactsOf(const Item& item);
+
+  // Items of a net sharing a contact with an item, each once
+  std::vector<Item*> touching(const Item& item, int netNo) const;
+
+  // Contacts with items in the index
+  size_t size() const { return contacts_.size(); }
+
+private:
+  struct ContactHash {
+    size_t operator()(const Contact& contact) const {
+      // Coordinates are board units, so 32 bits each cover any board
+      size_t h = static_cast<size_t>(static_cast<uint32_t>(contact.point.x)) << 32 |
+                 static_cast<uint32_t>(contact.point.y);
+      return (h ^ static_cast<size_t>(contact.layer) * 0x9e3779b97f4a7c15ULL) * 0xff51afd7ed558ccdULL;
+    }
+  };
+
+  // Mostly one or two items per contact
+  std::unordered_map<Contact, std::vector<Item*>, ContactHash> contacts_;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_BOARD_CONTACTINDEX_H
@@ -6,6 +6,7 @@
 #include "geometry/IntBoxShape.h"
 #include "geometry/Vector2.h"
 #include "core/Types.h"
+#include "core/LayerMask.h"
 #include "autoroute/ItemAutorouteInfo.h"
 #include "autoroute/ShapeSearchTree.h"
 #include <vector>
@@ -135,12 +136,18 @@ public:
     return layer >= firstLayer() && layer <= lastLayer();
   }
 
+  // Layers this item is on as a bitmask
+  LayerMask layerMask() const {
+    return layerRangeMask(firstLayer(), lastLayer());
+  }
+
   // Create a copy of this item with a new ID
   virtual Item* copy(int newId) const = 0;
 
   // ========== SearchTreeObject Interface ==========
 
   // Get the tree shape for spatial indexing
+  // Every layer entry of a multi-layer item shares the one bounding box
   virtual const class Shape* getTreeShape(int shapeIndex) const override {
     (void)shapeIndex;
     // Create shape on demand from bounding box
@@ -151,18 +158,18 @@ public:
     return cachedShape_;
   }
 
-  // Get the layer of a specific shape index
+  // Get the layer of a specific shape index (one index per layer)
   virtual int getShapeLayer(int shapeIndex) const override {
-    (void)shapeIndex;
-    return firstLayer();
+    return firstLayer() + shapeIndex;
   }
 
   // Check if this item is a trace obstacle (already implemented above)
-  // virtual bool isTraceObstacle(int netNumber) const override - already defined
+  // virtual bool isTraceObstacle(int netNo) const override - already defined
 
-  // Number of shapes this item has
+  // Number of shapes this item has: one per layer, so through-hole pins
+  // and vias are found by queries on any of their layers
   virtual int treeShapeCount() const override {
-    return 1;  // Most items have 1 shape, vias may override
+    return std::max(1, layerCount());
   }
 
   // Comparison for sorting by ID
@@ -2,6 +2,7 @@
 #define FREEROUTING_BOARD_PIN_H
 
 #include "DrillItem.h"
+#include "core/SlabPool.h"
 
 namespace freerouting {
 
@@ -9,6 +10,9 @@ namespace freerouting {
 // Pins are the connection points on components (ICs, resistors, etc.)
 class Pin : public DrillItem {
 public:
+  // Storage comes from a per-type slab pool
+  FR_SLAB_ALLOCATED(Pin)
+
   // Create a new pin
   Pin(IntPoint center, int pinNumber, const Padstack* padstack,
       const std::vector<int>& nets, int clearanceClass, int id,
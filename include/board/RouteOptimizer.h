@@ -1,11 +1,13 @@
 #ifndef FREEROUTING_BOARD_ROUTEOPTIMIZER_H
 #define FREEROUTING_BOARD_ROUTEOPTIMIZER_H
 
+#include "board/ContactIndex.h"
 #include "board/Trace.h"
 #include "board/Via.h"
 #include "geometry/Vector2.h"
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
 
 namespace freerouting {
 
@@ -233,6 +235,36 @@ public:
     return pairs;
   }
 
+  // Find mergeable trace pairs using the board's contact index
+  // Traces only merge if they share an end, so each trace is compared with
+  // the traces at its two ends instead of with every other trace. Same
+  // pairs, in the same order, as the version above.
+  static std::vector<std::pair<int, int>> findMergeableTracePairs(
+      const std::vector<Trace*>& traces, const ContactIndex& contacts) {
+    std::unordered_map<const Item*, int> indexOf;
+    for (size_t i = 0; i < traces.size(); i++) {
+      indexOf.emplace(traces[i], static_cast<int>(i));
+    }
+
+    std::vector<std::pair<int, int>> pairs;
+    for (size_t i = 0; i < traces.size(); i++) {
+      const Trace* trace = traces[i];
+      for (IntPoint end : {trace->getStart(), trace->getEnd()}) {
+        for (const Item* other : contacts.at(end, trace->getLayer())) {
+          auto it = indexOf.find(other);
+          if (it != indexOf.end() && it->second > static_cast<int>(i) &&
+              trace->canMergeWith(*traces[static_cast<size_t>(it->second)])) {
+            pairs.push_back({static_cast<int>(i), it->second});
+          }
+        }
+      }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    return pairs;
+  }
+
   // Calculate wire length metric for route quality
   // Lower is better
   static double calculateWireLengthMetric(const std::vector<Trace*>& traces) {
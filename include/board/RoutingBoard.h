@@ -4,7 +4,14 @@
 #include "board/BasicBoard.h"
 #include "board/Item.h"
 #include "autoroute/IncompleteConnection.h"
+#include "autoroute/ObstaclePyramid.h"
+#include "autoroute/OccupancyPyramid.h"
+#include "autoroute/PinAccess.h"
+#include "autoroute/ProximityField.h"
+#include "board/ContactIndex.h"
+#include "core/MemoryBudget.h"
 #include "geometry/ShapeTree.h"
+#include <span>
 #include <vector>
 #include <memory>
 #include <map>
@@ -30,7 +37,7 @@ public:
   // Constructor
   RoutingBoard(const LayerStructure& layers, const ClearanceMatrix& clearanceMatrix)
     : BasicBoard(layers, clearanceMatrix),
-      shapeTree_(10000) {}  // 10000 unit cell size
+      shapeTree_(10000) {}  // 1mm cells until the index tunes itself to the items
 
   // Get shape tree for spatial queries during routing
   ShapeTree& getShapeTree() { return shapeTree_; }
@@ -43,22 +50,157 @@ public:
     Item* itemPtr = item.get();
     BasicBoard::addItem(std::move(item));
     shapeTree_.insert(itemPtr);
+    contactIndex_.insert(itemPtr);
+    if (occupancy_) {
+      occupancy_->update(itemPtr->getBoundingBox());
+    }
+    if (obstaclePyramid_) {
+      obstaclePyramid_->markDirty(itemPtr->getBoundingBox());
+    }
+    if (proximityField_) {
+      proximityField_->markDirty(itemPtr->getBoundingBox(), itemPtr->firstLayer(), itemPtr->lastLayer());
+    }
+    if (pinAccess_) {
+      pinAccess_->markDirty(itemPtr->getBoundingBox());
+    }
+  }
+
+  // Add many items, as when a board is loaded, with one build of the
+  // shape tree; caches built before are dropped and built again on use
+  void addItems(std::vector<std::unique_ptr<Item>> items) {
+    std::vector<Item*> added;
+    added.reserve(items.size());
+    for (const auto& item : items) {
+      if (item) {
+        added.push_back(item.get());
+      }
+    }
+
+    BasicBoard::addItems(std::move(items));
+    shapeTree_.insertAll(added);
+    for (Item* item : added) {
+      contactIndex_.insert(item);
+    }
+    obstaclePyramid_.reset();
+    proximityField_.reset();
+    pinAccess_.reset();
+    occupancy_.reset();
   }
 
   // Remove item and update shape tree
   bool removeItem(int itemId) {
-    Item* item = getItem(itemId);
+    return removeItem(getItem(itemId));
+  }
+
+  // Remove this item
+  bool removeItem(Item* item) {
     if (!item) return false;
 
     shapeTree_.remove(item);
-    return BasicBoard::removeItem(itemId);
+    contactIndex_.remove(item);
+    if (occupancy_) {
+      occupancy_->update(item->getBoundingBox());
+    }
+    if (obstaclePyramid_) {
+      obstaclePyramid_->markDirty(item->getBoundingBox());
+    }
+    if (proximityField_) {
+      proximityField_->markDirty(item->getBoundingBox(), item->firstLayer(), item->lastLayer());
+    }
+    if (pinAccess_) {
+      pinAccess_->markDirty(item->getBoundingBox());
+      pinAccess_->remove(item);
+    }
+    return BasicBoard::removeItem(static_cast<const Item*>(item));
   }
 
   // Clear all items and shape tree
   void clear() {
     BasicBoard::clear();
     shapeTree_.clear();
+    contactIndex_.clear();
     incompleteConnections_.clear();
+    obstaclePyramid_.reset();
+    proximityField_.reset();
+    pinAccess_.reset();
+    occupancy_.reset();
+  }
+
+  // Items by the points where they make contact (trace ends, pin and via
+  // centers), for connectivity without scanning a net
+  const ContactIndex& getContactIndex() const { return contactIndex_; }
+
+  // Get the shared multi-resolution obstacle raster used by grid routing
+  // Built on first use and kept up to date with item changes afterwards;
+  // rebuilt if a different cell size or inflation is requested, or after
+  // the memory budget evicted it
+  ObstaclePyramid& getObstaclePyramid(int cellSize, int inflation) {
+    if (!obstaclePyramid_ ||
+        obstaclePyramid_->getCellSize() != cellSize ||
+        obstaclePyramid_->getInflation() != inflation) {
+      obstaclePyramid_.emplace(this, cellSize, inflation);
+    } else {
+      obstaclePyramid_->refresh();
+      obstaclePyramid_.update();
+    }
+    return *obstaclePyramid_;
+  }
+
+  // Get the shared obstacle-proximity field used for maze search costs
+  // Same lifetime rules as the obstacle pyramid
+  ProximityField& getProximityField(int cellSize, int range) {
+    if (!proximityField_ ||
+        proximityField_->getCellSize() != cellSize ||
+        proximityField_->getRange() != range) {
+      proximityField_.emplace(this, cellSize, range);
+    } else {
+      proximityField_->refresh();
+      proximityField_.update();
+    }
+    return *proximityField_;
+  }
+
+  // Get the pins' access points for traces of a half width and clearance
+  // All pins are analysed on first use; same lifetime rules as above
+  PinAccess& getPinAccess(int halfWidth, int clearance) {
+    if (!pinAccess_ ||
+        pinAccess_->getHalfWidth() != halfWidth ||
+        pinAccess_->getClearance() != clearance) {
+      pinAccess_.emplace(this, halfWidth, clearance);
+    } else if (pinAccess_->hasDirtyRegions()) {
+      pinAccess_->refresh();
+      pinAccess_.update();
+    }
+    return *pinAccess_;
+  }
+
+  // The pin access cache if it is built (for statistics), else nullptr
+  const PinAccess* findPinAccess() const { return pinAccess_.get(); }
+
+  // Get the occupancy bitmap that answers obvious conflict queries
+  // Unlike the caches above it is updated on every item change, so it
+  // only needs building again for other parameters or after eviction
+  OccupancyPyramid& getOccupancy(int cellSize, int inflation) {
+    if (!occupancy_ ||
+        occupancy_->getCellSize() != cellSize ||
+        occupancy_->getInflation() != inflation) {
+      occupancy_.emplace(this, cellSize, inflation);
+    } else {
+      occupancy_.update();
+    }
+    return *occupancy_;
+  }
+
+  // The occupancy bitmap if it is built, else nullptr
+  const OccupancyPyramid* findOccupancy() const { return occupancy_.get(); }
+
+  // Drop the caches above if the memory budget picked them for eviction
+  // Searches hold on to them, so this is only called between connections
+  void releaseEvictedCaches() {
+    obstaclePyramid_.use();
+    proximityField_.use();
+    pinAccess_.use();
+    occupancy_.use();
   }
 
   // Incomplete connection management
@@ -180,6 +322,18 @@ public:
   // CRITICAL: Check if location has obstacles (actual spatial query, not just rule areas)
   // This is what was missing - checks for existing traces/vias/pads from other nets
   bool hasObstacleAt(IntPoint point, int layer, int netNo, int clearanceRequired) const {
+    // The occupancy bitmap settles most points without the index
+    if (occupancy_) {
+      switch (occupancy_->probePoint(point, layer, netNo, clearanceRequired)) {
+        case OccupancyPyramid::State::Full:
+          return true;
+        case OccupancyPyramid::State::Empty:
+          return !occupancy_->isKeepoutFree(point, layer) && isTraceProhibited(point, layer, netNo);
+        case OccupancyPyramid::State::Mixed:
+          break;
+      }
+    }
+
     // Create search box around point with clearance
     IntBox searchBox(
       point.x - clearanceRequired, point.y - clearanceRequired,
@@ -196,15 +350,57 @@ public:
     return isTraceProhibited(point, layer, netNo);
   }
 
+  // hasObstacleAt() for many points on one layer
+  // Points the occupancy bitmap doesn't settle are looked up in the index
+  // together, in Morton order; 1 for each point with an obstacle
+  std::vector<u8> hasObstaclesAt(std::span<const IntPoint> points, int layer, int netNo,
+                                 int clearanceRequired) const {
+    std::vector<u8> blocked(points.size(), 0);
+    std::vector<ShapeTree::Query> queries;
+    std::vector<size_t> queried;
+    for (size_t i = 0; i < points.size(); ++i) {
+      IntPoint point = points[i];
+      if (occupancy_) {
+        OccupancyPyramid::State state = occupancy_->probePoint(point, layer, netNo, clearanceRequired);
+        if (state == OccupancyPyramid::State::Full) {
+          blocked[i] = 1;
+          continue;
+        }
+        if (state == OccupancyPyramid::State::Empty) {
+          blocked[i] = !occupancy_->isKeepoutFree(point, layer) && isTraceProhibited(point, layer, netNo);
+          continue;
+        }
+      }
+      IntBox searchBox(
+        point.x - clearanceRequired, point.y - clearanceRequired,
+        point.x + clearanceRequired, point.y + clearanceRequired
+      );
+      queries.push_back(ShapeTree::traceObstacleQuery(netNo, searchBox, layer));
+      queried.push_back(i);
+    }
+
+    std::vector<u8> found = shapeTree_.hasTraceObstacles(queries);
+    for (size_t q = 0; q < queried.size(); ++q) {
+      IntPoint point = points[queried[q]];
+      blocked[queried[q]] = found[q] || isTraceProhibited(point, layer, netNo);
+    }
+    return blocked;
+  }
+
 private:
   ShapeTree shapeTree_;  // Spatial index for routing queries
+  ContactIndex contactIndex_;  // Items by contact point and layer
   std::vector<IncompleteConnection> incompleteConnections_;  // Connections to route
   std::shared_ptr<const std::vector<struct KiCadFootprint>> footprints_;  // Footprint graphics (courtyards, silkscreen)
+  BudgetedCache<ObstaclePyramid> obstaclePyramid_;  // Grid routing raster (lazy)
+  BudgetedCache<ProximityField> proximityField_;    // Maze search proximity cost (lazy)
+  BudgetedCache<PinAccess> pinAccess_;              // Pin access points (lazy)
+  BudgetedCache<OccupancyPyramid> occupancy_;       // Conflict pre-filter (lazy)
 
   // Find connected components within a set of items on the same net
   // Returns a vector of components, where each component is a vector of connected items
   std::vector<std::vector<Item*>> findConnectedComponents(
-      const std::vector<Item*>& netItems, int /* netNumber */) const {
+      const std::vector<Item*>& netItems, int netNumber) const {
 
     std::vector<std::vector<Item*>> components;
     std::set<Item*> visited;
@@ -225,7 +421,7 @@ private:
         component.push_back(current);
 
         // Find items physically connected to current
-        std::vector<Item*> neighbors = findPhysicallyConnected(current, netItems);
+        std::vector<Item*> neighbors = findPhysicallyConnected(current, netNumber);
         for (Item* neighbor : neighbors) {
           if (!visited.count(neighbor)) {
             visited.insert(neighbor);
@@ -242,43 +438,13 @@ private:
     return components;
   }
 
-  // Find items physically connected to the given item
-  // Two items are physically connected if:
-  // - They are traces sharing an endpoint
-  // - They are vias/pins at the same location
-  std::vector<Item*> findPhysicallyConnected(
-      Item* item, const std::vector<Item*>& candidates) const {
-
-    std::vector<Item*> connected;
-    if (!item) return connected;
-
-    // Get item's bounding box for spatial queries
-    IntBox itemBox = item->getBoundingBox();
-    IntPoint itemCenter((itemBox.ll.x + itemBox.ur.x) / 2,
-                        (itemBox.ll.y + itemBox.ur.y) / 2);
-
-    for (Item* candidate : candidates) {
-      if (candidate == item) continue;
-
-      IntBox candBox = candidate->getBoundingBox();
-      IntPoint candCenter((candBox.ll.x + candBox.ur.x) / 2,
-                          (candBox.ll.y + candBox.ur.y) / 2);
-
-      // Check if items overlap or are very close (tolerance for connection)
-      const int kConnectionTolerance = 100; // 0.01mm tolerance
-      int dx = (itemCenter.x > candCenter.x) ? (itemCenter.x - candCenter.x) : (candCenter.x - itemCenter.x);
-      int dy = (itemCenter.y > candCenter.y) ? (itemCenter.y - candCenter.y) : (candCenter.y - itemCenter.y);
-
-      if (dx <= kConnectionTolerance && dy <= kConnectionTolerance) {
-        // Items are at same location - check layer overlap
-        if (item->lastLayer() >= candidate->firstLayer() &&
-            item->firstLayer() <= candidate->lastLayer()) {
-          connected.push_back(candidate);
-        }
-      }
-    }
-
-    return connected;
+  // Find items of a net physically connected to the given item
+  // Two items are physically connected if they share a contact point on a
+  // layer: traces sharing an endpoint, a trace ending at a pin or via center,
+  // or pins and vias stacked at the same center
+  std::vector<Item*> findPhysicallyConnected(Item* item, int netNumber) const {
+    if (!item) return {};
+    return contactIndex_.touching(*item, netNumber);
   }
 
   // Find a pin (non-routable item) within a component to use as endpoint
@@ -2,6 +2,7 @@
 #define FREEROUTING_BOARD_RULEAREA_H
 
 #include "board/Item.h"
+#include "core/SlabPool.h"
 #include "geometry/IntBox.h"
 #include "geometry/Shape.h"
 #include "geometry/ComplexPolygon.h"
@@ -16,6 +17,9 @@ namespace freerouting {
 // This addresses KiCad's rule areas that the Java freerouting ignores
 class RuleArea : public Item {
 public:
+  // Storage comes from a per-type slab pool
+  FR_SLAB_ALLOCATED(RuleArea)
+
   // Types of restrictions a rule area can enforce
   enum class RestrictionType {
     Traces,       // Prohibit routing traces through area
@@ -2,6 +2,7 @@
 #define FREEROUTING_BOARD_TRACE_H
 
 #include "Item.h"
+#include "core/SlabPool.h"
 #include <vector>
 
 namespace freerouting {
@@ -13,6 +14,9 @@ namespace freerouting {
 // Full polyline support with multiple corners will be added in later phases
 class Trace : public Item {
 public:
+  // Storage comes from a per-type slab pool
+  FR_SLAB_ALLOCATED(Trace)
+
   // Create a new trace segment
   Trace(IntPoint start, IntPoint end, int layer, int halfWidth,
         const std::vector<int>& nets, int clearanceClass, int id,
@@ -2,6 +2,7 @@
 #define FREEROUTING_BOARD_VIA_H
 
 #include "DrillItem.h"
+#include "core/SlabPool.h"
 
 namespace freerouting {
 
@@ -9,6 +10,9 @@ namespace freerouting {
 // Vias connect traces between different layers
 class Via : public DrillItem {
 public:
+  // Storage comes from a per-type slab pool
+  FR_SLAB_ALLOCATED(Via)
+
   // Create a new via
   Via(IntPoint center, const Padstack* padstack,
       const std::vector<int>& nets, int clearanceClass, int id,
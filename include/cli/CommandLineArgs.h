@@ -13,11 +13,29 @@ struct CommandLineArgs {
   std::string outputFile;
 
   // Routing options
-  int maxPasses = 10;
+  int maxPasses = 0;   // 0 = default (10, or the profile's)
   int maxThreads = 0;  // 0 = auto-detect
   int timeLimit = 0;   // 0 = no limit (seconds)
   bool optimize = true;
+  bool simplifyPaths = true;  // Merge and straighten path segments before inserting routes
+  bool usePinAccess = true;   // Seed searches from precomputed pin access points
+  bool useOccupancyFilter = true;  // Pre-filter conflict queries with the occupancy bitmap
   bool removeExistingRoutes = false;  // Remove all traces/vias before routing
+  std::string connectionOrder;  // Net order within a priority tier: size or hilbert (empty = default)
+  double proximityWeight = -1.0;  // Obstacle-proximity cost weight (< 0 = router default)
+  std::string profileFile;  // Tuned router parameters (see RouterProfile); flags override it
+  bool raceSearches = false;  // Race maze search and grid router on connections that failed before
+  bool assignLayers = false;  // Layer-assignment pre-pass before each routing pass
+  double tileSizeMm = 0.0;    // Route in tiles of this size, then stitch (0 = whole board)
+  double tileHaloMm = 5.0;    // Margin around each tile seen by its router
+  int workerProcesses = 0;    // Route tiles in worker processes (0 = threads)
+  double maxMemoryMb = 0.0;   // Budget for rebuildable caches (0 = unlimited)
+
+  // Search capture (see SearchCapture): net, pass and search index within it
+  int captureNet = -1;  // -1 = off
+  int capturePass = 1;
+  int captureConnection = 0;
+  std::string captureFile = "search.frsc";
 
   // DRC options
   bool runDrc = true;
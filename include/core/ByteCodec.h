@@ -0,0 +1,77 @@
+#ifndef FREEROUTING_CORE_BYTECODEC_H
+#define FREEROUTING_CORE_BYTECODEC_H
+
+#include "Types.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace freerouting {
+
+// Fixed-width little-endian encoding, independent of host byte order
+// Used by the binary formats (search captures, tile jobs)
+
+template<typename T>
+void putValue(std::vector<u8>& out, T value) {
+  u64 bits = 0;
+  std::memcpy(&bits, &value, sizeof(T));
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out.push_back(static_cast<u8>(bits >> (8 * i)));
+  }
+}
+
+template<typename T>
+bool getValue(const std::vector<u8>& in, size_t& pos, T& value) {
+  if (pos + sizeof(T) > in.size()) {
+    return false;
+  }
+  u64 bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bits |= static_cast<u64>(in[pos + i]) << (8 * i);
+  }
+  std::memcpy(&value, &bits, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+// Strings and vectors of values: u32 count, then the elements
+inline void putString(std::vector<u8>& out, const std::string& value) {
+  putValue<u32>(out, static_cast<u32>(value.size()));
+  out.insert(out.end(), value.begin(), value.end());
+}
+
+inline bool getString(const std::vector<u8>& in, size_t& pos, std::string& value) {
+  u32 size = 0;
+  if (!getValue(in, pos, size) || size > in.size() - pos) {
+    return false;
+  }
+  value.assign(in.begin() + static_cast<std::ptrdiff_t>(pos),
+               in.begin() + static_cast<std::ptrdiff_t>(pos + size));
+  pos += size;
+  return true;
+}
+
+template<typename T>
+void putValues(std::vector<u8>& out, const std::vector<T>& values) {
+  putValue<u32>(out, static_cast<u32>(values.size()));
+  for (const T& value : values) {
+    putValue<T>(out, value);
+  }
+}
+
+template<typename T>
+bool getValues(const std::vector<u8>& in, size_t& pos, std::vector<T>& values) {
+  u32 count = 0;
+  if (!getValue(in, pos, count) || count > (in.size() - pos) / sizeof(T)) {
+    return false;
+  }
+  values.resize(count);
+  for (T& value : values) {
+    getValue(in, pos, value);
+  }
+  return true;
+}
+
+} // namespace freerouting
+
+#endif // FREEROUTING_CORE_BYTECODEC_H
@@ -0,0 +1,43 @@
+#ifndef FREEROUTING_CORE_LAYERMASK_H
+#define FREEROUTING_CORE_LAYERMASK_H
+
+#include "Types.h"
+
+namespace freerouting {
+
+// Set of board layers as a 64-bit mask (bit n = layer n)
+// Layer overlap tests become a single AND. Layers 63 and above share the
+// top bit, so on larger stacks a mask may report overlap that an exact range
+// compare would not, but it never misses a real overlap.
+using LayerMask = u64;
+
+constexpr int kLayerMaskBits = 64;
+constexpr LayerMask kAllLayers = ~LayerMask(0);
+
+// Mask with just one layer set
+constexpr LayerMask layerBit(int layer) {
+  if (layer < 0) return 0;
+  return LayerMask(1) << (layer < kLayerMaskBits ? layer : kLayerMaskBits - 1);
+}
+
+// Mask with layers firstLayer..lastLayer (inclusive) set
+constexpr LayerMask layerRangeMask(int firstLayer, int lastLayer) {
+  if (firstLayer < 0) firstLayer = 0;
+  if (firstLayer > lastLayer) return 0;
+  if (firstLayer >= kLayerMaskBits) firstLayer = kLayerMaskBits - 1;
+  if (lastLayer >= kLayerMaskBits) lastLayer = kLayerMaskBits - 1;
+
+  LayerMask upTo = lastLayer == kLayerMaskBits - 1
+    ? kAllLayers
+    : (LayerMask(1) << (lastLayer + 1)) - 1;
+  return upTo & ~((LayerMask(1) << firstLayer) - 1);
+}
+
+// True if two masks share a layer
+constexpr bool layersOverlap(LayerMask a, LayerMask b) {
+  return (a & b) != 0;
+}
+
+} // namespace freerouting
+
+#endif // FREEROUTING_CORE_LAYERMASK_H
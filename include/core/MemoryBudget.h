@@ -0,0 +1,249 @@
+#ifndef FREEROUTING_CORE_MEMORYBUDGET_H
+#define FREEROUTING_CORE_MEMORYBUDGET_H
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace freerouting {
+
+// Central account of the memory held by caches that can be rebuilt
+// Each cache reports its size and what it took to build, in milliseconds.
+// While the total is over the limit (--max-memory), caches are picked for
+// eviction by the least rebuild time per byte, scaled down by how long ago
+// they were last used (so the least recently used go first), until the rest
+// fits. The cache whose growth went over the limit is never picked.
+//
+// Eviction is cooperative: a picked cache is only marked, and is dropped by
+// its owner at its next use(). Owners call use() only where nothing can be
+// holding on to the cache (the board's rasters are used by pointer for a
+// whole connection, by the grid router on another thread in a search race),
+// so no cache is freed under a reader.
+//
+// With no limit (the default) caches are still counted, which gives the
+// peak for --verbose.
+class MemoryBudget {
+public:
+  // A cache that can be dropped and rebuilt on demand
+  class Cache {
+  public:
+    virtual ~Cache() = default;
+
+    // Free the memory; called from use() on the owner's side
+    virtual void evict() = 0;
+  };
+
+  struct Statistics {
+    size_t limitBytes = 0;    // 0 = unlimited
+    size_t usedBytes = 0;     // Held by registered caches now
+    size_t peakBytes = 0;
+    int evictions = 0;
+    size_t bytesEvicted = 0;
+  };
+
+  // Intentionally never destroyed: boards may still be released by other
+  // static destructors at exit
+  static MemoryBudget& instance() {
+    static MemoryBudget* budget = new MemoryBudget();
+    return *budget;
+  }
+
+  // Limit in bytes; 0 for none
+  void setLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limit_ = bytes;
+    trim(nullptr);
+  }
+
+  size_t getLimit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+  }
+
+  // Report a cache's size and rebuild time; registers it on first call
+  void update(Cache* cache, size_t bytes, double rebuildMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[cache];
+    used_ += bytes - entry.bytes;
+    if (entry.pending) {
+      pendingBytes_ += bytes - entry.bytes;
+    }
+    entry.bytes = bytes;
+    entry.rebuildMs = rebuildMs;
+    entry.lastUse = ++tick_;
+    peak_ = std::max(peak_, used_);
+    trim(cache);
+  }
+
+  // Safe point before a cache is used; drops it if it was picked for
+  // eviction and returns true, in which case the caller rebuilds it
+  bool use(Cache* cache) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(cache);
+      if (it == entries_.end()) {
+        return false;
+      }
+      if (!it->second.pending) {
+        it->second.lastUse = ++tick_;
+        return false;
+      }
+      ++evictions_;
+      bytesEvicted_ += it->second.bytes;
+      release(it);
+    }
+    cache->evict();
+    return true;
+  }
+
+  // Stop accounting for a cache (when it is freed by its owner)
+  void remove(Cache* cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(cache);
+    if (it != entries_.end()) {
+      release(it);
+    }
+  }
+
+  Statistics getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics stats;
+    stats.limitBytes = limit_;
+    stats.usedBytes = used_;
+    stats.peakBytes = peak_;
+    stats.evictions = evictions_;
+    stats.bytesEvicted = bytesEvicted_;
+    return stats;
+  }
+
+  // Start the peak and eviction counts again from the current use
+  void resetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peak_ = used_;
+    evictions_ = 0;
+    bytesEvicted_ = 0;
+  }
+
+  // Non-copyable
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+private:
+  struct Entry {
+    size_t bytes = 0;
+    double rebuildMs = 0.0;
+    unsigned long long lastUse = 0;
+    bool pending = false;  // Picked for eviction at the next use()
+  };
+
+  MemoryBudget() = default;
+
+  void release(std::unordered_map<Cache*, Entry>::iterator it) {
+    used_ -= it->second.bytes;
+    if (it->second.pending) {
+      pendingBytes_ -= it->second.bytes;
+    }
+    entries_.erase(it);
+  }
+
+  // Pick victims until what is not already picked fits the limit
+  void trim(Cache* growing) {
+    if (limit_ == 0 || used_ - pendingBytes_ <= limit_) {
+      return;
+    }
+
+    std::vector<std::pair<double, Entry*>> candidates;
+    for (auto& [cache, entry] : entries_) {
+      if (cache != growing && !entry.pending && entry.bytes > 0) {
+        double age = static_cast<double>(tick_ - entry.lastUse);
+        double value = entry.rebuildMs / static_cast<double>(entry.bytes) / (1.0 + age);
+        candidates.emplace_back(value, &entry);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (auto& [value, entry] : candidates) {
+      if (used_ - pendingBytes_ <= limit_) {
+        break;
+      }
+      entry->pending = true;
+      pendingBytes_ += entry->bytes;
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::unordered_map<Cache*, Entry> entries_;
+  size_t limit_ = 0;
+  size_t used_ = 0;
+  size_t pendingBytes_ = 0;
+  size_t peak_ = 0;
+  int evictions_ = 0;
+  size_t bytesEvicted_ = 0;
+  unsigned long long tick_ = 0;
+};
+
+// Owner of a lazily built object whose memory is accounted in the budget
+// T provides memoryBytes(). The time emplace() takes is the rebuild cost.
+// Not movable, since the budget keeps its address.
+template<typename T>
+class BudgetedCache : public MemoryBudget::Cache {
+public:
+  BudgetedCache() = default;
+  ~BudgetedCache() override { reset(); }
+
+  BudgetedCache(const BudgetedCache&) = delete;
+  BudgetedCache& operator=(const BudgetedCache&) = delete;
+
+  explicit operator bool() const { return object_ != nullptr; }
+  T* get() const { return object_.get(); }
+  T* operator->() const { return object_.get(); }
+  T& operator*() const { return *object_; }
+
+  // Safe point: drop the object now if it was picked for eviction
+  void use() {
+    if (object_) {
+      MemoryBudget::instance().use(this);
+    }
+  }
+
+  // Build the object, replacing any previous one
+  template<typename... ARGS>
+  T& emplace(ARGS&&... args) {
+    auto start = std::chrono::steady_clock::now();
+    object_.reset();
+    object_ = std::make_unique<T>(std::forward<ARGS>(args)...);
+    rebuildMs_ = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    update();
+    return *object_;
+  }
+
+  // Report the object's size again after it changed
+  void update() {
+    if (object_) {
+      MemoryBudget::instance().update(this, object_->memoryBytes(), rebuildMs_);
+    }
+  }
+
+  void reset() {
+    if (object_) {
+      MemoryBudget::instance().remove(this);
+      object_.reset();
+    }
+  }
+
+  void evict() override { object_.reset(); }
+
+private:
+  std::unique_ptr<T> object_;
+  double rebuildMs_ = 0.0;
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_CORE_MEMORYBUDGET_H
@@ -0,0 +1,85 @@
+#ifndef FREEROUTING_CORE_PARALLEL_H
+#define FREEROUTING_CORE_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace freerouting {
+
+// Threads to use for a requested count (0 or less = hardware threads)
+inline size_t threadCount(int requested = 0) {
+  return requested > 0 ? static_cast<size_t>(requested)
+                       : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run fn(i) for i in [0, count) on up to `threads` threads
+// Indices are handed out one at a time from a shared counter, so tasks of
+// uneven size spread over the threads, and the calling thread takes part.
+// fn may instead take (i, worker), worker in [0, min(threads, count)), to
+// collect results per thread without locking.
+//
+// If fn throws, no further indices are handed out, and the first exception
+// is rethrown on the calling thread once every thread has finished.
+template <typename Fn>
+void parallelFor(size_t count, size_t threads, Fn&& fn) {
+  auto call = [&fn](size_t i, size_t worker) {
+    if constexpr (std::is_invocable_v<Fn&, size_t, size_t>) {
+      fn(i, worker);
+    } else {
+      fn(i);
+    }
+  };
+
+  const size_t workers = std::min(threads, count);
+  if (workers <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      call(i, 0);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::mutex errorMutex;
+  std::exception_ptr error;
+  auto work = [&](size_t worker) {
+    try {
+      for (size_t i = next++; i < count; i = next++) {
+        call(i, worker);
+      }
+    } catch (...) {
+      next = count;
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(workers - 1);
+  for (size_t worker = 1; worker < workers; ++worker) {
+    try {
+      pool.emplace_back(work, worker);
+    } catch (const std::system_error&) {
+      break;  // Out of threads; the ones started take the rest
+    }
+  }
+  work(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace freerouting
+
+#endif // FREEROUTING_CORE_PARALLEL_H
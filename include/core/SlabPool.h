@@ -0,0 +1,302 @@
+#ifndef FREEROUTING_CORE_SLABPOOL_H
+#define FREEROUTING_CORE_SLABPOOL_H
+
+#include "Types.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace freerouting {
+
+// Type-segregated slab allocator for board items
+// Objects of one type are carved out of fixed-size slabs, so items of a
+// kind sit next to each other in memory. There is one pool per type for
+// the whole process, shared by every board; boards own their items through
+// std::unique_ptr as before and know nothing of the pool.
+//
+// Each thread allocates from a cache of its own without locking: freed
+// slots go on the thread's free list and are handed out again first, then
+// the thread bumps a pointer through a slab it was given. Only refills and
+// returns of whole batches take the pool's lock, so threads converting or
+// routing in parallel do not contend per item. A thread's cache goes back
+// to the pool when the thread exits.
+//
+// Slabs whose slots are all back in the pool are released, so the peak of
+// a short-lived board (a tile, a session) is not kept for the life of the
+// process. Slots still held by a thread's cache keep their slab.
+//
+// Used through class-specific operator new/delete (see Trace, Via, Pin,
+// RuleArea).
+template<typename T, size_t SlabObjects = 1024>
+class SlabPool {
+public:
+  // Allocate storage for one T; other sizes (derived classes) use the heap
+  static void* allocate(size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+    if (Cache* cache = threadCache()) {
+      return cache->allocate();
+    }
+    return instance().allocateShared();
+  }
+
+  // Return storage from allocate()
+  static void deallocate(void* ptr, size_t size) {
+    if (!ptr) return;
+    if (size != sizeof(T)) {
+      ::operator delete(ptr);
+      return;
+    }
+    Slot* slot = reinterpret_cast<Slot*>(ptr);
+    if (Cache* cache = threadCache()) {
+      cache->deallocate(slot);
+    } else {
+      instance().freeShared(slot);
+    }
+  }
+
+  // Statistics
+  static size_t liveCount() {
+    SlabPool& pool = instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    long live = pool.retiredLive;
+    for (const Cache* cache : pool.caches) {
+      live += cache->live.load(std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(live);
+  }
+
+  static size_t slabCount() {
+    SlabPool& pool = instance();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.slabs.size();
+  }
+
+  static constexpr size_t slabObjects() { return SlabObjects; }
+
+  // Non-copyable
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+private:
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // Slots a thread takes from the pool at a time; it gives them back once
+  // it holds twice as many
+  static constexpr size_t kBatch = std::max<size_t>(1, SlabObjects / 4);
+
+  // Free list of slots
+  struct SlotList {
+    Slot* head = nullptr;
+    size_t count = 0;
+
+    void push(Slot* slot) {
+      slot->next = head;
+      head = slot;
+      ++count;
+    }
+
+    Slot* pop() {
+      Slot* slot = head;
+      head = slot->next;
+      --count;
+      return slot;
+    }
+  };
+
+  // One thread's slots; only its own thread touches them, apart from live
+  // being read for statistics
+  struct Cache {
+    SlotList freeSlots;
+    Slot* bump = nullptr;
+    Slot* bumpEnd = nullptr;
+    std::atomic<long> live{0};  // Allocations minus frees on this thread
+
+    Cache() { instance().attach(*this); }
+
+    ~Cache() {
+      cacheDestroyed() = true;
+      instance().detach(*this);
+    }
+
+    void* allocate() {
+      live.store(live.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (!freeSlots.head && bump == bumpEnd) {
+        instance().refill(*this);
+      }
+      if (freeSlots.head) {
+        return freeSlots.pop()->storage;
+      }
+      return (bump++)->storage;
+    }
+
+    // A full list goes back to the pool; the slot freed last stays here,
+    // to be handed out next
+    void deallocate(Slot* slot) {
+      live.store(live.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+      if (freeSlots.count >= 2 * kBatch) {
+        instance().giveBack(*this);
+      }
+      freeSlots.push(slot);
+    }
+  };
+
+  SlabPool() = default;
+
+  // Intentionally never destroyed: items may still be released by other
+  // static destructors at exit
+  static SlabPool& instance() {
+    static SlabPool* pool = new SlabPool();
+    return *pool;
+  }
+
+  // Set once this thread's cache is gone (frees during thread exit)
+  static bool& cacheDestroyed() {
+    thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+  static Cache* threadCache() {
+    if (cacheDestroyed()) {
+      return nullptr;
+    }
+    thread_local Cache cache;
+    return &cache;
+  }
+
+  void attach(Cache& cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.push_back(&cache);
+  }
+
+  // Take back everything a cache holds, including the unused rest of its slab
+  void detach(Cache& cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.erase(std::find(caches.begin(), caches.end(), &cache));
+    retiredLive += cache.live.load(std::memory_order_relaxed);
+    while (cache.freeSlots.head) {
+      shared.push(cache.freeSlots.pop());
+    }
+    for (; cache.bump != cache.bumpEnd; ++cache.bump) {
+      shared.push(cache.bump);
+    }
+    trimIfWorthIt();
+  }
+
+  // A batch of free slots if the pool has any, else a new slab to bump through
+  void refill(Cache& cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (shared.head && cache.freeSlots.count < kBatch) {
+      cache.freeSlots.push(shared.pop());
+    }
+    if (cache.freeSlots.head) {
+      return;
+    }
+    cache.bump = addSlab();
+    cache.bumpEnd = cache.bump + SlabObjects;
+  }
+
+  void giveBack(Cache& cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (cache.freeSlots.head) {
+      shared.push(cache.freeSlots.pop());
+    }
+    trimIfWorthIt();
+  }
+
+  // Used once a thread's cache is gone
+  void* allocateShared() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++retiredLive;
+    if (!shared.head) {
+      Slot* slab = addSlab();
+      for (size_t i = 0; i < SlabObjects; ++i) {
+        shared.push(slab + i);
+      }
+    }
+    return shared.pop()->storage;
+  }
+
+  void freeShared(Slot* slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    --retiredLive;
+    shared.push(slot);
+  }
+
+  Slot* addSlab() {
+    slabs.push_back(std::make_unique<Slot[]>(SlabObjects));
+    return slabs.back().get();
+  }
+
+  // Release slabs with every slot in the shared list once at least half of
+  // all slots are free there; the next attempt waits for another slab's
+  // worth of frees, so a fragmented pool is not rescanned on every batch
+  void trimIfWorthIt() {
+    if (shared.count < trimAt || shared.count * 2 < slabs.size() * SlabObjects) {
+      return;
+    }
+
+    std::sort(slabs.begin(), slabs.end(), [](const auto& a, const auto& b) {
+      return std::less<const Slot*>()(a.get(), b.get());
+    });
+    auto slabOf = [this](const Slot* slot) {
+      auto it = std::upper_bound(slabs.begin(), slabs.end(), slot, [](const Slot* s, const auto& slab) {
+        return std::less<const Slot*>()(s, slab.get());
+      });
+      return static_cast<size_t>(it - slabs.begin()) - 1;
+    };
+
+    std::vector<size_t> freeSlots(slabs.size(), 0);
+    for (Slot* slot = shared.head; slot; slot = slot->next) {
+      ++freeSlots[slabOf(slot)];
+    }
+
+    SlotList kept;
+    for (Slot* slot = shared.head; slot;) {
+      Slot* next = slot->next;
+      if (freeSlots[slabOf(slot)] != SlabObjects) {
+        kept.push(slot);
+      }
+      slot = next;
+    }
+    shared = kept;
+
+    size_t out = 0;
+    for (size_t i = 0; i < slabs.size(); ++i) {
+      if (freeSlots[i] != SlabObjects) {
+        slabs[out++] = std::move(slabs[i]);
+      }
+    }
+    slabs.resize(out);
+    trimAt = std::max(2 * SlabObjects, shared.count + SlabObjects);
+  }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Slot[]>> slabs;
+  std::vector<Cache*> caches;
+  SlotList shared;                 // Free slots not held by any thread
+  size_t trimAt = 2 * SlabObjects;
+  long retiredLive = 0;            // Live count of exited threads and shared use
+};
+
+// Class-specific operator new/delete routing a board item type through its
+// SlabPool; place inside the class body
+#define FR_SLAB_ALLOCATED(Type)                                            \
+  static void* operator new(size_t size) {                                 \
+    return SlabPool<Type>::allocate(size);                                 \
+  }                                                                        \
+  static void operator delete(void* ptr, size_t size) {                    \
+    SlabPool<Type>::deallocate(ptr, size);                                 \
+  }
+
+} // namespace freerouting
+
+#endif // FREEROUTING_CORE_SLABPOOL_H
@@ -1,6 +1,9 @@
 #ifndef FREEROUTING_DATASTRUCTURES_STOPPABLE_H
 #define FREEROUTING_DATASTRUCTURES_STOPPABLE_H
 
+#include "datastructures/TimeLimit.h"
+#include <atomic>
+
 namespace freerouting {
 
 // Interface for operations that can be stopped/cancelled
@@ -20,24 +23,52 @@ protected:
 };
 
 // Simple implementation of Stoppable with a flag
+// The flag is atomic so a search on another thread may poll it
 class SimpleStoppable : public Stoppable {
 public:
   SimpleStoppable() : stopRequested(false) {}
 
   bool isStopRequested() const override {
-    return stopRequested;
+    return stopRequested.load(std::memory_order_relaxed);
   }
 
   void requestStop() override {
-    stopRequested = true;
+    stopRequested.store(true, std::memory_order_relaxed);
   }
 
   void reset() {
-    stopRequested = false;
+    stopRequested.store(false, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<bool> stopRequested;
+};
+
+// Stops at a deadline, or when the parent Stoppable (if any) does
+class DeadlineStoppable : public Stoppable {
+public:
+  // milliseconds < 0: no deadline
+  explicit DeadlineStoppable(int milliseconds, const Stoppable* parent = nullptr)
+    : limit_(milliseconds), parent_(parent) {}
+
+  bool isStopRequested() const override {
+    return stopRequested_.load(std::memory_order_relaxed) || limit_.isExceeded() ||
+           (parent_ && parent_->isStopRequested());
+  }
+
+  void requestStop() override {
+    stopRequested_.store(true, std::memory_order_relaxed);
+  }
+
+  // Time left until the deadline (-1 = no deadline)
+  long getRemainingMs() const {
+    return limit_.getRemainingMs();
   }
 
 private:
-  bool stopRequested;
+  TimeLimit limit_;
+  const Stoppable* parent_;
+  std::atomic<bool> stopRequested_{false};
 };
 
 } // namespace freerouting
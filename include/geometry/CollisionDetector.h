@@ -6,6 +6,7 @@
 #include "geometry/ConvexPolygon.h"
 #include "geometry/IntBox.h"
 #include "geometry/Vector2.h"
+#include <algorithm>
 #include <cmath>
 
 namespace freerouting {
@@ -104,22 +105,64 @@ public:
     return std::max(0.0, surfaceDist);
   }
 
-  // Check if line segment intersects box
+  // Check if line segment intersects box (both closed)
+  // Clips the segment against the box's slabs (Liang-Barsky)
   static bool segmentBoxIntersect(IntPoint a, IntPoint b, const IntBox& box) {
-    // If either endpoint is inside box, they intersect
-    if (box.contains(a) || box.contains(b)) {
-      return true;
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const double start[2] = {static_cast<double>(a.x), static_cast<double>(a.y)};
+    const double delta[2] = {static_cast<double>(b.x) - a.x, static_cast<double>(b.y) - a.y};
+    const double low[2] = {static_cast<double>(box.ll.x), static_cast<double>(box.ll.y)};
+    const double high[2] = {static_cast<double>(box.ur.x), static_cast<double>(box.ur.y)};
+
+    for (int axis = 0; axis < 2; ++axis) {
+      if (delta[axis] == 0.0) {
+        if (start[axis] < low[axis] || start[axis] > high[axis]) {
+          return false;
+        }
+        continue;
+      }
+      double enter = (low[axis] - start[axis]) / delta[axis];
+      double leave = (high[axis] - start[axis]) / delta[axis];
+      if (enter > leave) {
+        std::swap(enter, leave);
+      }
+      t0 = std::max(t0, enter);
+      t1 = std::min(t1, leave);
+      if (t0 > t1) {
+        return false;
+      }
     }
+    return true;
+  }
 
-    // Check if segment crosses any edge of box
-    // This is a simplified test using bounding boxes
-    int minX = std::min(a.x, b.x);
-    int maxX = std::max(a.x, b.x);
-    int minY = std::min(a.y, b.y);
-    int maxY = std::max(a.y, b.y);
+  // Calculate distance from point to line segment
+  static double pointSegmentDistance(IntPoint p, IntPoint a, IntPoint b) {
+    double abX = static_cast<double>(b.x) - a.x;
+    double abY = static_cast<double>(b.y) - a.y;
+    double apX = static_cast<double>(p.x) - a.x;
+    double apY = static_cast<double>(p.y) - a.y;
+    double lengthSq = abX * abX + abY * abY;
+    double t = lengthSq > 0.0 ? std::clamp((apX * abX + apY * abY) / lengthSq, 0.0, 1.0) : 0.0;
+    return std::hypot(apX - t * abX, apY - t * abY);
+  }
 
-    IntBox segmentBox(minX, minY, maxX, maxY);
-    return segmentBox.intersects(box);
+  // Calculate minimum distance between two line segments (0 if they cross)
+  static double segmentDistance(IntPoint a1, IntPoint a2, IntPoint b1, IntPoint b2) {
+    auto side = [](IntPoint p, IntPoint q, IntPoint r) {
+      i64 cross = static_cast<i64>(q.x - p.x) * (r.y - p.y) -
+                  static_cast<i64>(q.y - p.y) * (r.x - p.x);
+      return (cross > 0) - (cross < 0);
+    };
+    int d1 = side(b1, b2, a1);
+    int d2 = side(b1, b2, a2);
+    int d3 = side(a1, a2, b1);
+    int d4 = side(a1, a2, b2);
+    if (d1 * d2 < 0 && d3 * d4 < 0) {
+      return 0.0;
+    }
+    return std::min({pointSegmentDistance(a1, b1, b2), pointSegmentDistance(a2, b1, b2),
+                     pointSegmentDistance(b1, a1, a2), pointSegmentDistance(b2, a1, a2)});
   }
 
   // Check if line segment intersects circle
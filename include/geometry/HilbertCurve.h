@@ -0,0 +1,71 @@
+#ifndef FREEROUTING_GEOMETRY_HILBERTCURVE_H
+#define FREEROUTING_GEOMETRY_HILBERTCURVE_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <algorithm>
+
+namespace freerouting {
+
+// Hilbert space-filling curve
+// Sorting points by their curve index keeps points that are close on the
+// board close in the sequence, which improves cache reuse when work items
+// are processed in that order
+class HilbertCurve {
+public:
+  // Default curve order: 2^16 x 2^16 cells (sub-micron for typical boards)
+  static constexpr int kDefaultOrder = 16;
+
+  // Curve index of cell (x, y) on a 2^order x 2^order grid
+  // Coordinates outside the grid are clamped
+  static constexpr u64 index(u32 x, u32 y, int order = kDefaultOrder) {
+    const u32 n = 1u << order;
+    x = std::min(x, n - 1);
+    y = std::min(y, n - 1);
+
+    u64 d = 0;
+    for (u32 s = n >> 1; s > 0; s >>= 1) {
+      u32 rx = (x & s) ? 1 : 0;
+      u32 ry = (y & s) ? 1 : 0;
+      d += static_cast<u64>(s) * s * ((3 * rx) ^ ry);
+
+      // Rotate quadrant so the sub-curve has the canonical orientation
+      if (ry == 0) {
+        if (rx == 1) {
+          x = s - 1 - (x & (s - 1));
+          y = s - 1 - (y & (s - 1));
+        }
+        u32 t = x;
+        x = y;
+        y = t;
+      }
+    }
+    return d;
+  }
+
+  // Curve index of a board point, scaling the bounds onto the curve grid
+  // Points outside the bounds are clamped to the nearest edge
+  static constexpr u64 indexInBox(IntPoint p, const IntBox& bounds,
+                                  int order = kDefaultOrder) {
+    if (bounds.isEmpty()) {
+      return 0;
+    }
+
+    const u64 cells = (1ull << order) - 1;
+    const i64 spanX = std::max<i64>(1, static_cast<i64>(bounds.ur.x) - bounds.ll.x);
+    const i64 spanY = std::max<i64>(1, static_cast<i64>(bounds.ur.y) - bounds.ll.y);
+    const i64 span = std::max(spanX, spanY);  // Keep aspect ratio square
+
+    i64 dx = std::clamp<i64>(static_cast<i64>(p.x) - bounds.ll.x, 0, span);
+    i64 dy = std::clamp<i64>(static_cast<i64>(p.y) - bounds.ll.y, 0, span);
+
+    return index(static_cast<u32>(static_cast<u64>(dx) * cells / static_cast<u64>(span)),
+                 static_cast<u32>(static_cast<u64>(dy) * cells / static_cast<u64>(span)),
+                 order);
+  }
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_GEOMETRY_HILBERTCURVE_H
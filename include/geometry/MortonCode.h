@@ -0,0 +1,46 @@
+#ifndef FREEROUTING_GEOMETRY_MORTONCODE_H
+#define FREEROUTING_GEOMETRY_MORTONCODE_H
+
+#include "core/Types.h"
+#include "geometry/Vector2.h"
+#include "geometry/IntBox.h"
+#include <algorithm>
+
+namespace freerouting {
+
+// Morton (Z-order) code: the bits of x and y interleaved
+// Cheaper than the Hilbert index and, unlike it, nests exactly into
+// power-of-two grid cells: every aligned 2^k x 2^k block of points is one
+// contiguous run of codes. Sorting grid probes by it makes probes that fall
+// into the same index cell follow each other.
+class MortonCode {
+public:
+  // Code of (x, y): bit i of x goes to bit 2i, bit i of y to bit 2i + 1
+  static constexpr u64 index(u32 x, u32 y) {
+    return spread(x) | (spread(y) << 1);
+  }
+
+  // Code of a board point, relative to the lower left corner of bounds
+  // Points left of or below the bounds are clamped to its edge
+  static constexpr u64 indexInBox(IntPoint p, const IntBox& bounds) {
+    i64 dx = std::max<i64>(0, static_cast<i64>(p.x) - bounds.ll.x);
+    i64 dy = std::max<i64>(0, static_cast<i64>(p.y) - bounds.ll.y);
+    return index(static_cast<u32>(dx), static_cast<u32>(dy));
+  }
+
+private:
+  // Move bit i of v to bit 2i
+  static constexpr u64 spread(u32 v) {
+    u64 x = v;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+  }
+};
+
+} // namespace freerouting
+
+#endif // FREEROUTING_GEOMETRY_MORTONCODE_H
@@ -3,7 +3,10 @@
 
 #include "geometry/SpatialIndex.h"
 #include "board/Item.h"
+#include "board/DrillItem.h"
+#include "board/Trace.h"
 #include "geometry/IntBox.h"
+#include <span>
 #include <vector>
 
 namespace freerouting {
@@ -11,16 +14,43 @@ namespace freerouting {
 // Spatial search structure for board items
 // Combines spatial indexing with item-specific collision detection
 // This is the Phase 5 integration between geometry and board structures
+// The index keeps each item's net and kind next to its box, so the finders
+// below dereference only items that pass those tests. Items don't change
+// nets while on the board, and an item is a trace obstacle for exactly the
+// nets it is not on, so only items with several nets are asked directly.
 class ShapeTree {
 public:
-  // Create shape tree with given cell size
-  explicit ShapeTree(int cellSize = 10000)
-    : index(cellSize) {}
+  using Grid = SpatialIndex<Item>::Grid;
+  using Entry = SpatialIndex<Item>::Entry;
+  using Filter = SpatialIndex<Item>::Filter;
+  using NetTest = SpatialIndex<Item>::NetTest;
+  using Query = SpatialIndex<Item>::Query;
+
+  // Kind bits of the index entries
+  static constexpr u32 kTraces = 1;
+  static constexpr u32 kDrillItems = 2;  // Pins and vias
+  static constexpr u32 kOtherItems = 4;  // Areas, outlines
+
+  // Create shape tree with given (initial base) cell size
+  explicit ShapeTree(int cellSize = 10000, Grid grid = Grid::Hierarchical)
+    : index(cellSize, grid) {}
 
   // Insert item into the tree
   void insert(Item* item) {
     if (!item) return;
-    index.insert(item, item->getBoundingBox());
+    index.insert(item, item->getBoundingBox(), item->layerMask(), netOf(*item), kindOf(*item));
+  }
+
+  // Insert many items with one build of the index
+  void insertAll(const std::vector<Item*>& items) {
+    std::vector<SpatialIndex<Item>::Entry> entries;
+    entries.reserve(items.size());
+    for (Item* item : items) {
+      if (item) {
+        entries.push_back({item->getBoundingBox(), item->layerMask(), netOf(*item), kindOf(*item), item});
+      }
+    }
+    index.insertAll(std::move(entries));
   }
 
   // Remove item from the tree
@@ -34,6 +64,19 @@ public:
     return index.query(region);
   }
 
+  // Find all items in region on any of the given layers
+  std::vector<Item*> queryRegion(const IntBox& region, LayerMask layers) const {
+    return index.query(region, layers);
+  }
+
+  // Find the items of the given kinds in region on any of the given layers
+  std::vector<Item*> queryRegion(const IntBox& region, LayerMask layers, u32 kinds) const {
+    Filter filter;
+    filter.layers = layers;
+    filter.kinds = kinds;
+    return index.query(region, filter);
+  }
+
   // Find all items near a point
   std::vector<Item*> queryNear(IntPoint point, int distance) const {
     return index.queryNear(point, distance);
@@ -45,7 +88,8 @@ public:
   // - Doesn't share a net with the query item
   // - Has overlapping bounding box
   std::vector<Item*> findObstacles(const Item& queryItem) const {
-    std::vector<Item*> candidates = index.query(queryItem.getBoundingBox());
+    // Layer overlap is checked by the index
+    std::vector<Item*> candidates = index.query(queryItem.getBoundingBox(), queryItem.layerMask());
     std::vector<Item*> obstacles;
 
     for (Item* candidate : candidates) {
@@ -54,12 +98,6 @@ public:
         continue;
       }
 
-      // Check layer overlap
-      if (candidate->lastLayer() < queryItem.firstLayer() ||
-          candidate->firstLayer() > queryItem.lastLayer()) {
-        continue;
-      }
-
       // Check if it's an obstacle
       if (candidate->isObstacle(queryItem)) {
         obstacles.push_back(candidate);
@@ -72,50 +110,69 @@ public:
   // Find all obstacles for a trace on a specific net in a region
   std::vector<Item*> findTraceObstacles(int netNumber, const IntBox& region,
                                          int firstLayer, int lastLayer) const {
-    std::vector<Item*> candidates = index.query(region);
+    // Layer overlap and single nets are checked by the index
+    Filter filter;
+    filter.layers = layerRangeMask(firstLayer, lastLayer);
+    filter.net = netNumber;
+    filter.netTest = NetTest::Other;
     std::vector<Item*> obstacles;
-
-    for (Item* candidate : candidates) {
-      // Check layer overlap
-      if (candidate->lastLayer() < firstLayer ||
-          candidate->firstLayer() > lastLayer) {
-        continue;
+    index.forEachMatch(region, filter, [&](const Entry& entry) {
+      if (entry.net != SpatialIndex<Item>::kSeveralNets || entry.item->isTraceObstacle(netNumber)) {
+        obstacles.push_back(entry.item);
       }
+    });
+    return obstacles;
+  }
 
-      // Check if it's an obstacle for this net
-      if (candidate->isTraceObstacle(netNumber)) {
-        obstacles.push_back(candidate);
+  // Query for obstacles to a trace of a net in a region on one layer
+  static Query traceObstacleQuery(int netNumber, const IntBox& region, int layer) {
+    Query query{region, Filter()};
+    query.filter.layers = layerBit(layer);
+    query.filter.net = netNumber;
+    query.filter.netTest = NetTest::Other;
+    return query;
+  }
+
+  // Obstacles for many trace queries in one walk of the index
+  // fn(queryIndex, item) is called for each obstacle; returning true ends
+  // that query
+  template<typename FN>
+  void forEachTraceObstacle(std::span<const Query> queries, FN&& fn) const {
+    index.forEachMatch(queries, [&](size_t q, const Entry& entry) {
+      if (entry.net == SpatialIndex<Item>::kSeveralNets &&
+          !entry.item->isTraceObstacle(queries[q].filter.net)) {
+        return false;
       }
-    }
+      return fn(q, entry.item);
+    });
+  }
 
-    return obstacles;
+  // For each trace query, 1 if it has any obstacle
+  std::vector<u8> hasTraceObstacles(std::span<const Query> queries) const {
+    std::vector<u8> found(queries.size(), 0);
+    forEachTraceObstacle(queries, [&](size_t q, Item*) {
+      found[q] = 1;
+      return true;
+    });
+    return found;
   }
 
   // Find items on a specific layer in a region
   std::vector<Item*> findItemsOnLayer(int layer, const IntBox& region) const {
-    std::vector<Item*> candidates = index.query(region);
-    std::vector<Item*> result;
-
-    for (Item* candidate : candidates) {
-      if (candidate->isOnLayer(layer)) {
-        result.push_back(candidate);
-      }
-    }
-
-    return result;
+    return index.query(region, layerBit(layer));
   }
 
   // Find items belonging to a specific net
   std::vector<Item*> findItemsByNet(int netNumber, const IntBox& region) const {
-    std::vector<Item*> candidates = index.query(region);
+    Filter filter;
+    filter.net = netNumber;
+    filter.netTest = NetTest::Same;
     std::vector<Item*> result;
-
-    for (Item* candidate : candidates) {
-      if (candidate->containsNet(netNumber)) {
-        result.push_back(candidate);
+    index.forEachMatch(region, filter, [&](const Entry& entry) {
+      if (entry.net != SpatialIndex<Item>::kSeveralNets || entry.item->containsNet(netNumber)) {
+        result.push_back(entry.item);
       }
-    }
-
+    });
     return result;
   }
 
@@ -127,8 +184,26 @@ public:
   // Get statistics
   size_t cellCount() const { return index.cellCount(); }
   size_t itemReferenceCount() const { return index.itemReferenceCount(); }
+  size_t size() const { return index.size(); }
+  int getCellSize() const { return index.getCellSize(); }
+  int levelCount() const { return index.levelCount(); }
 
 private:
+  // Net for the index entry: the only one, 0 for none, or several
+  static i32 netOf(const Item& item) {
+    switch (item.netCount()) {
+      case 0: return 0;
+      case 1: return item.getNets()[0];
+      default: return SpatialIndex<Item>::kSeveralNets;
+    }
+  }
+
+  static u32 kindOf(const Item& item) {
+    if (dynamic_cast<const Trace*>(&item)) return kTraces;
+    if (dynamic_cast<const DrillItem*>(&item)) return kDrillItems;
+    return kOtherItems;
+  }
+
   SpatialIndex<Item> index;
 };
 
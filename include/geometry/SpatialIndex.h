@@ -2,45 +2,134 @@
 #define FREEROUTING_GEOMETRY_SPATIALINDEX_H
 
 #include "geometry/IntBox.h"
+#include "geometry/MortonCode.h"
 #include "geometry/Vector2.h"
+#include "core/LayerMask.h"
+#include "core/Types.h"
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <span>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace freerouting {
 
-// Simple grid-based spatial index for efficient collision detection
-// Divides space into cells and stores items by their bounding boxes
-// This is a simplified Phase 5 implementation - full R-tree will come later
+// Hierarchical grid spatial index for efficient collision detection
+// Level l has cells of baseCellSize << l. Each item goes to the finest level
+// whose cells are at least as large as the item, so it lands in at most 2x2
+// cells: long traces are not copied into a row of small cells, and small
+// items in dense regions are not piled into one large cell. Queries visit
+// every level that holds items.
+// Each cell entry records the item's box, layer mask, net and kind, so
+// queries reject non-overlapping, wrong-layer, wrong-net and wrong-kind
+// candidates without touching the item. A cell keeps each of these fields
+// in an array of its own, and the filter kernel tests four entries per
+// SSE2 compare (one at a time on targets without SSE2); only the survivors
+// are looked at one by one.
+// An item in several cells is reported only from the cell holding the lower
+// left corner of its overlap with the query region. Batches of queries are
+// answered in Morton order, reusing the cell last looked up on each level.
+//
+// With Grid::Hierarchical the base cell size follows the items: once the
+// index has grown to twice the size it was last tuned at, the base becomes
+// the median item extent (or the spacing of the items, if that is larger)
+// and the items are placed again. Grid::Fixed keeps
+// the given cell size and a single level (every item in every cell it
+// overlaps), for comparison.
 template<typename ITEM>
 class SpatialIndex {
 public:
-  // Create spatial index with given cell size
-  explicit SpatialIndex(int cellSizeValue = 10000)
-    : cellSize(cellSizeValue) {
+  enum class Grid { Hierarchical, Fixed };
+
+  // Net of an entry whose item has more than one net
+  static constexpr i32 kSeveralNets = -1;
+
+  // Cell entry: item plus the data needed to filter it
+  // net is the item's only net (0 for none, kSeveralNets for more than one);
+  // kind is one bit the caller chooses per type of item. Cells store the
+  // fields apart; an Entry is put together for each match reported.
+  struct Entry {
+    IntBox bounds;
+    LayerMask layers;
+    i32 net;
+    u32 kind;
+    ITEM* item;
+  };
+
+  // How a query tests entry nets against its net
+  enum class NetTest : u8 {
+    Any,    // Nets don't matter
+    Same,   // Items on the net
+    Other   // Items not on the net
+  };
+
+  // What a query wants of its candidates besides overlapping the region
+  // Entries with kSeveralNets pass either net test; callers that need the
+  // exact answer check those items themselves
+  struct Filter {
+    LayerMask layers = kAllLayers;
+    u32 kinds = ~u32(0);
+    i32 net = 0;
+    NetTest netTest = NetTest::Any;
+  };
+
+  // One query of a batch
+  struct Query {
+    IntBox region;
+    Filter filter;
+  };
+
+  static constexpr int kMaxLevels = 16;
+  static constexpr int kMinCellSize = 100;
+  static constexpr size_t kFirstTuneSize = 1024;
+
+  // Create spatial index with given (initial base) cell size
+  explicit SpatialIndex(int cellSizeValue = 10000, Grid gridValue = Grid::Hierarchical)
+    : cellSize(cellSizeValue), grid(gridValue) {
     if (cellSize <= 0) {
       cellSize = 10000;
     }
   }
 
-  // Insert item with its bounding box
-  void insert(ITEM* item, const IntBox& bounds) {
+  // Insert item with its bounding box, the layers it occupies, its net and
+  // its kind bit
+  void insert(ITEM* item, const IntBox& bounds, LayerMask layers = kAllLayers,
+              i32 net = 0, u32 kind = 1) {
     if (!item || bounds.isEmpty()) {
       return;
     }
 
-    // Calculate grid cells overlapped by bounds
-    int minCellX = bounds.ll.x / cellSize;
-    int minCellY = bounds.ll.y / cellSize;
-    int maxCellX = bounds.ur.x / cellSize;
-    int maxCellY = bounds.ur.y / cellSize;
+    place(Entry{bounds, layers, net, kind, item});
+    ++itemCount;
+    if (grid == Grid::Hierarchical && itemCount >= nextTuneSize) {
+      tune();
+    }
+  }
 
-    // Add item to all overlapping cells
-    for (int cy = minCellY; cy <= maxCellY; ++cy) {
-      for (int cx = minCellX; cx <= maxCellX; ++cx) {
-        CellKey key{cx, cy};
-        cells[key].push_back(item);
-      }
+  // Insert many items at once, as when a board is loaded
+  // The base cell size is tuned once for all items and every cell is
+  // built with its final size, instead of growing and re-placing the
+  // index as single inserts would
+  void insertAll(std::vector<Entry> entries) {
+    std::erase_if(entries, [](const Entry& entry) { return !entry.item || entry.bounds.isEmpty(); });
+    if (entries.empty()) {
+      return;
+    }
+
+    itemCount += entries.size();
+    if (grid == Grid::Hierarchical && itemCount >= kFirstTuneSize) {
+      std::vector<Entry> all = collectEntries();
+      all.insert(all.end(), entries.begin(), entries.end());
+      cellSize = tunedCellSize(all);
+      nextTuneSize = 2 * itemCount;
+      levels.clear();
+      build(all);
+    } else {
+      build(entries);
     }
   }
 
@@ -50,64 +139,82 @@ public:
       return;
     }
 
-    int minCellX = bounds.ll.x / cellSize;
-    int minCellY = bounds.ll.y / cellSize;
-    int maxCellX = bounds.ur.x / cellSize;
-    int maxCellY = bounds.ur.y / cellSize;
+    int level = levelFor(bounds);
+    if (level >= static_cast<int>(levels.size())) {
+      return;
+    }
+    auto& cells = levels[level];
+    bool removed = false;
 
     // Remove item from all overlapping cells
-    for (int cy = minCellY; cy <= maxCellY; ++cy) {
-      for (int cx = minCellX; cx <= maxCellX; ++cx) {
-        CellKey key{cx, cy};
-        auto it = cells.find(key);
-        if (it != cells.end()) {
-          auto& itemList = it->second;
-          itemList.erase(
-            std::remove(itemList.begin(), itemList.end(), item),
-            itemList.end()
-          );
-
-          // Remove empty cells
-          if (itemList.empty()) {
-            cells.erase(it);
-          }
+    forEachCell(level, bounds, [&](const CellKey& key) {
+      auto it = cells.find(key);
+      if (it != cells.end()) {
+        removed = it->second.erase(item) || removed;
+
+        // Remove empty cells
+        if (it->second.empty()) {
+          cells.erase(it);
         }
       }
+    });
+    if (removed && itemCount > 0) {
+      --itemCount;
     }
   }
 
   // Query items in region (returns all items whose bounding boxes overlap region)
   std::vector<ITEM*> query(const IntBox& region) const {
-    if (region.isEmpty()) {
-      return {};
-    }
+    return query(region, kAllLayers);
+  }
 
-    int minCellX = region.ll.x / cellSize;
-    int minCellY = region.ll.y / cellSize;
-    int maxCellX = region.ur.x / cellSize;
-    int maxCellY = region.ur.y / cellSize;
+  // Query items in region on any of the given layers
+  std::vector<ITEM*> query(const IntBox& region, LayerMask layers) const {
+    Filter filter;
+    filter.layers = layers;
+    return query(region, filter);
+  }
 
+  // Query items in region that pass a filter
+  std::vector<ITEM*> query(const IntBox& region, const Filter& filter) const {
     std::vector<ITEM*> result;
-    std::vector<ITEM*> seenItems;
-
-    // Collect items from all overlapping cells
-    for (int cy = minCellY; cy <= maxCellY; ++cy) {
-      for (int cx = minCellX; cx <= maxCellX; ++cx) {
-        CellKey key{cx, cy};
-        auto it = cells.find(key);
-        if (it != cells.end()) {
-          for (ITEM* item : it->second) {
-            // Avoid duplicates (item may be in multiple cells)
-            if (std::find(seenItems.begin(), seenItems.end(), item) == seenItems.end()) {
-              result.push_back(item);
-              seenItems.push_back(item);
-            }
-          }
-        }
-      }
+    forEachMatch(region, filter, [&](const Entry& entry) { result.push_back(entry.item); });
+    return result;
+  }
+
+  // Call fn with the entry of each item in region that passes a filter
+  template<typename FN>
+  void forEachMatch(const IntBox& region, const Filter& filter, FN&& fn) const {
+    visit(region, filter, nullptr, [&](const Entry& entry) {
+      fn(entry);
+      return false;
+    });
+  }
+
+  // Answer many queries in one walk of the index
+  // The queries are taken in Morton order of their region centers, so
+  // neighbouring queries look up the same cells one after the other, and
+  // the cell last found on each level is reused without a map lookup.
+  // fn(queryIndex, entry) is called for each match; returning true ends
+  // that query.
+  template<typename FN>
+  void forEachMatch(std::span<const Query> queries, FN&& fn) const {
+    std::vector<CachedCell> cache(levels.size());
+    for (u32 q : mortonOrder(queries)) {
+      visit(queries[q].region, queries[q].filter, &cache, [&](const Entry& entry) {
+        return fn(static_cast<size_t>(q), entry);
+      });
     }
+  }
 
-    return result;
+  // For each query, 1 if any item matches it
+  std::vector<u8> anyMatch(std::span<const Query> queries) const {
+    std::vector<u8> found(queries.size(), 0);
+    forEachMatch(queries, [&](size_t q, const Entry&) {
+      found[q] = 1;
+      return true;
+    });
+    return found;
   }
 
   // Query items near a point (within distance)
@@ -121,23 +228,42 @@ public:
 
   // Clear all items from index
   void clear() {
-    cells.clear();
+    levels.clear();
+    itemCount = 0;
+    nextTuneSize = kFirstTuneSize;
   }
 
   // Get number of cells in use
   size_t cellCount() const {
-    return cells.size();
+    size_t count = 0;
+    for (const auto& cells : levels) {
+      count += cells.size();
+    }
+    return count;
   }
 
   // Get total number of item references (counting duplicates across cells)
   size_t itemReferenceCount() const {
     size_t count = 0;
-    for (const auto& [key, items] : cells) {
-      count += items.size();
+    for (const auto& cells : levels) {
+      for (const auto& [key, cell] : cells) {
+        count += cell.size();
+      }
     }
     return count;
   }
 
+  // Number of items in the index
+  size_t size() const { return itemCount; }
+
+  // Cell size of level 0
+  int getCellSize() const { return cellSize; }
+
+  // Levels that hold items, counting the empty ones below them
+  int levelCount() const { return static_cast<int>(levels.size()); }
+
+  Grid getGrid() const { return grid; }
+
 private:
   struct CellKey {
     int x;
@@ -153,8 +279,427 @@ private:
     }
   };
 
+  // A cell's entries stored by field: column c holds field c of every
+  // entry, so the filter kernel loads one field of four entries at once
+  class Cell {
+  public:
+    enum Column { LlX, LlY, UrX, UrY, LayersLow, LayersHigh, Net, Kind, kColumns };
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+
+    const u32* column(Column c) const { return fields.data() + c * capacity; }
+
+    Entry operator[](size_t i) const {
+      const u32* f = fields.data();
+      return Entry{IntBox(static_cast<i32>(f[LlX * capacity + i]), static_cast<i32>(f[LlY * capacity + i]),
+                          static_cast<i32>(f[UrX * capacity + i]), static_cast<i32>(f[UrY * capacity + i])),
+                   (static_cast<LayerMask>(f[LayersHigh * capacity + i]) << 32) | f[LayersLow * capacity + i],
+                   static_cast<i32>(f[Net * capacity + i]), f[Kind * capacity + i], items[i]};
+    }
+
+    void reserve(size_t count) {
+      if (count <= capacity) {
+        return;
+      }
+      size_t grownCapacity = std::max({size_t(4), count, 2 * capacity});
+      std::vector<u32> grown(kColumns * grownCapacity);
+      for (size_t c = 0; c < kColumns; ++c) {
+        std::copy_n(fields.data() + c * capacity, size(), grown.data() + c * grownCapacity);
+      }
+      fields = std::move(grown);
+      capacity = grownCapacity;
+      items.reserve(capacity);
+    }
+
+    void push_back(const Entry& entry) {
+      reserve(size() + 1);
+      set(size(), entry);
+      items.push_back(entry.item);
+    }
+
+    // Remove the entries of an item; false if it had none
+    bool erase(const ITEM* item) {
+      size_t kept = 0;
+      for (size_t i = 0; i < size(); ++i) {
+        if (items[i] != item) {
+          for (size_t c = 0; c < kColumns; ++c) {
+            fields[c * capacity + kept] = fields[c * capacity + i];
+          }
+          items[kept++] = items[i];
+        }
+      }
+      if (kept == size()) {
+        return false;
+      }
+      items.resize(kept);
+      return true;
+    }
+
+  private:
+    void set(size_t i, const Entry& entry) {
+      u32* f = fields.data();
+      f[LlX * capacity + i] = static_cast<u32>(entry.bounds.ll.x);
+      f[LlY * capacity + i] = static_cast<u32>(entry.bounds.ll.y);
+      f[UrX * capacity + i] = static_cast<u32>(entry.bounds.ur.x);
+      f[UrY * capacity + i] = static_cast<u32>(entry.bounds.ur.y);
+      f[LayersLow * capacity + i] = static_cast<u32>(entry.layers);
+      f[LayersHigh * capacity + i] = static_cast<u32>(entry.layers >> 32);
+      f[Net * capacity + i] = static_cast<u32>(entry.net);
+      f[Kind * capacity + i] = entry.kind;
+    }
+
+    std::vector<u32> fields;  // kColumns columns of capacity values
+    std::vector<ITEM*> items;
+    size_t capacity = 0;
+  };
+
+  using Cells = std::map<CellKey, Cell>;
+
+  static constexpr size_t kBlockSize = 64;
+
+  // Cell a batch query looked up last on a level (cell null if empty)
+  struct CachedCell {
+    CellKey key{0, 0};
+    const Cell* cell = nullptr;
+    bool valid = false;
+  };
+
+  // A query's region and filter in the form the kernel compares against
+  struct Probe {
+    IntBox region;
+    LayerMask layers;
+    u32 kinds;
+    i32 net;
+    bool anyNet;      // Every net passes
+    bool sameNet;     // Entries on the net (or on several) pass
+    bool otherNet;    // Entries not only on the net pass
+  };
+
+  static Probe makeProbe(const IntBox& region, const Filter& filter) {
+    Probe probe{region, filter.layers, filter.kinds, filter.net, false, false, false};
+    switch (filter.netTest) {
+      case NetTest::Any:
+        probe.anyNet = true;
+        break;
+      case NetTest::Same:
+        // No item is on a net below 1
+        probe.sameNet = filter.net > 0;
+        break;
+      case NetTest::Other:
+        probe.anyNet = filter.net <= 0;
+        probe.otherNet = true;
+        break;
+    }
+    return probe;
+  }
+
+  // Cell at a level, or null; through the cache if there is one
+  const Cell* findCell(int level, const CellKey& key, CachedCell* cached) const {
+    if (cached && cached->valid && cached->key == key) {
+      return cached->cell;
+    }
+    const auto& cells = levels[level];
+    auto it = cells.find(key);
+    const Cell* cell = it != cells.end() ? &it->second : nullptr;
+    if (cached) {
+      *cached = CachedCell{key, cell, true};
+    }
+    return cell;
+  }
+
+  // Query indices sorted by the Morton code of their region centers
+  static std::vector<u32> mortonOrder(std::span<const Query> queries) {
+    IntBox bounds = IntBox::empty();
+    for (const Query& query : queries) {
+      bounds = bounds.unionWith(query.region);
+    }
+    std::vector<std::pair<u64, u32>> codes;
+    codes.reserve(queries.size());
+    for (u32 q = 0; q < queries.size(); ++q) {
+      const IntBox& region = queries[q].region;
+      IntPoint center(static_cast<int>((static_cast<i64>(region.ll.x) + region.ur.x) / 2),
+                      static_cast<int>((static_cast<i64>(region.ll.y) + region.ur.y) / 2));
+      codes.emplace_back(MortonCode::indexInBox(center, bounds), q);
+    }
+    std::sort(codes.begin(), codes.end());
+    std::vector<u32> order;
+    order.reserve(codes.size());
+    for (const auto& [code, q] : codes) {
+      order.push_back(q);
+    }
+    return order;
+  }
+
+  // Call fn(entry) for each match of a query until it returns true
+  // Returns true if fn ended the query
+  template<typename FN>
+  bool visit(const IntBox& region, const Filter& filter, std::vector<CachedCell>* cache, FN&& fn) const {
+    if (region.isEmpty() || filter.layers == 0 || filter.kinds == 0) {
+      return false;
+    }
+
+    const Probe probe = makeProbe(region, filter);
+    for (int level = 0; level < static_cast<int>(levels.size()); ++level) {
+      const auto& cells = levels[level];
+      if (cells.empty()) {
+        continue;
+      }
+
+      auto collect = [&](const CellKey& key, const Cell& cell) {
+        for (size_t first = 0; first < cell.size(); first += kBlockSize) {
+          size_t count = std::min(kBlockSize, cell.size() - first);
+          u64 keep = filterBlock(cell, first, count, probe);
+          while (keep != 0) {
+            const Entry entry = cell[first + std::countr_zero(keep)];
+            keep &= keep - 1;
+
+            // Report once, from the cell with the overlap's lower left corner
+            IntPoint corner(std::max(entry.bounds.ll.x, region.ll.x),
+                            std::max(entry.bounds.ll.y, region.ll.y));
+            if (cellOf(level, corner) == key && fn(entry)) {
+              return true;
+            }
+          }
+        }
+        return false;
+      };
+
+      // A region wider than the occupied cells is cheaper to answer by
+      // walking the cells than by looking up every cell in its range
+      CellKey lo = cellOf(level, region.ll);
+      CellKey hi = cellOf(level, region.ur);
+      i64 rangeCells = (static_cast<i64>(hi.x) - lo.x + 1) * (static_cast<i64>(hi.y) - lo.y + 1);
+      if (rangeCells > static_cast<i64>(cells.size())) {
+        for (const auto& [key, cell] : cells) {
+          if (key.x >= lo.x && key.x <= hi.x && key.y >= lo.y && key.y <= hi.y && collect(key, cell)) {
+            return true;
+          }
+        }
+      } else {
+        CachedCell* cached = cache ? &(*cache)[level] : nullptr;
+        for (int cy = lo.y; cy <= hi.y; ++cy) {
+          for (int cx = lo.x; cx <= hi.x; ++cx) {
+            CellKey key{cx, cy};
+            const Cell* cell = findCell(level, key, cached);
+            if (cell && collect(key, *cell)) {
+              return true;
+            }
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  // Bit i is set if entry first + i of the cell overlaps the region and
+  // passes the filter; count is at most kBlockSize
+  static u64 filterBlock(const Cell& cell, size_t first, size_t count, const Probe& probe) {
+    const u32* llX = cell.column(Cell::LlX) + first;
+    const u32* llY = cell.column(Cell::LlY) + first;
+    const u32* urX = cell.column(Cell::UrX) + first;
+    const u32* urY = cell.column(Cell::UrY) + first;
+    const u32* layersLow = cell.column(Cell::LayersLow) + first;
+    const u32* layersHigh = cell.column(Cell::LayersHigh) + first;
+    const u32* nets = cell.column(Cell::Net) + first;
+    const u32* kinds = cell.column(Cell::Kind) + first;
+
+    u64 keep = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Four entries per compare; a lane is all ones where the test holds
+    const __m128i regionLlX = _mm_set1_epi32(probe.region.ll.x);
+    const __m128i regionLlY = _mm_set1_epi32(probe.region.ll.y);
+    const __m128i regionUrX = _mm_set1_epi32(probe.region.ur.x);
+    const __m128i regionUrY = _mm_set1_epi32(probe.region.ur.y);
+    const __m128i probeLayersLow = _mm_set1_epi32(static_cast<int>(static_cast<u32>(probe.layers)));
+    const __m128i probeLayersHigh = _mm_set1_epi32(static_cast<int>(static_cast<u32>(probe.layers >> 32)));
+    const __m128i probeKinds = _mm_set1_epi32(static_cast<int>(probe.kinds));
+    const __m128i probeNet = _mm_set1_epi32(probe.net);
+    const __m128i severalNets = _mm_set1_epi32(kSeveralNets);
+    const __m128i anyNet = _mm_set1_epi32(probe.anyNet ? -1 : 0);
+    const __m128i sameNet = _mm_set1_epi32(probe.sameNet ? -1 : 0);
+    const __m128i otherNet = _mm_set1_epi32(probe.otherNet ? -1 : 0);
+    const __m128i zero = _mm_setzero_si128();
+    auto load = [&i](const u32* column) {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    };
+    for (; i + 4 <= count; i += 4) {
+      __m128i outside = _mm_or_si128(
+        _mm_or_si128(_mm_cmpgt_epi32(load(llX), regionUrX), _mm_cmpgt_epi32(load(llY), regionUrY)),
+        _mm_or_si128(_mm_cmpgt_epi32(regionLlX, load(urX)), _mm_cmpgt_epi32(regionLlY, load(urY))));
+      __m128i offLayers = _mm_cmpeq_epi32(
+        _mm_or_si128(_mm_and_si128(load(layersLow), probeLayersLow), _mm_and_si128(load(layersHigh), probeLayersHigh)),
+        zero);
+      __m128i otherKind = _mm_cmpeq_epi32(_mm_and_si128(load(kinds), probeKinds), zero);
+      __m128i net = load(nets);
+      __m128i onNet = _mm_cmpeq_epi32(net, probeNet);
+      __m128i netPasses = _mm_or_si128(
+        anyNet,
+        _mm_or_si128(_mm_and_si128(sameNet, _mm_or_si128(onNet, _mm_cmpeq_epi32(net, severalNets))),
+                     _mm_andnot_si128(onNet, otherNet)));
+      __m128i kept = _mm_andnot_si128(_mm_or_si128(outside, _mm_or_si128(offLayers, otherKind)), netPasses);
+      keep |= static_cast<u64>(_mm_movemask_ps(_mm_castsi128_ps(kept))) << i;
+    }
+#endif
+    for (; i < count; ++i) {
+      bool overlaps = (static_cast<i32>(llX[i]) <= probe.region.ur.x) & (static_cast<i32>(urX[i]) >= probe.region.ll.x) &
+                      (static_cast<i32>(llY[i]) <= probe.region.ur.y) & (static_cast<i32>(urY[i]) >= probe.region.ll.y);
+      LayerMask layers = (static_cast<LayerMask>(layersHigh[i]) << 32) | layersLow[i];
+      bool onLayer = (layers & probe.layers) != 0;
+      bool ofKind = (kinds[i] & probe.kinds) != 0;
+      i32 net = static_cast<i32>(nets[i]);
+      bool onNet = net == probe.net;
+      bool several = net == kSeveralNets;
+      bool netPasses = probe.anyNet | (probe.sameNet & (onNet | several)) | (probe.otherNet & !onNet);
+      keep |= static_cast<u64>(overlaps & onLayer & ofKind & netPasses) << i;
+    }
+    return keep;
+  }
+
+  // Finest level whose cells are at least as large as the box
+  int levelFor(const IntBox& bounds) const {
+    if (grid == Grid::Fixed) {
+      return 0;
+    }
+    i64 extent = std::max(static_cast<i64>(bounds.ur.x) - bounds.ll.x,
+                          static_cast<i64>(bounds.ur.y) - bounds.ll.y);
+    int level = 0;
+    while (level < kMaxLevels - 1 && (static_cast<i64>(cellSize) << level) < extent) {
+      ++level;
+    }
+    return level;
+  }
+
+  // Cell of a point at a level; rounds towards negative infinity
+  CellKey cellOf(int level, IntPoint point) const {
+    i64 size = static_cast<i64>(cellSize) << level;
+    auto floorDiv = [size](i64 a) {
+      i64 q = a / size;
+      return static_cast<int>(a % size != 0 && a < 0 ? q - 1 : q);
+    };
+    return CellKey{floorDiv(point.x), floorDiv(point.y)};
+  }
+
+  template<typename FN>
+  void forEachCell(int level, const IntBox& box, FN&& fn) const {
+    CellKey lo = cellOf(level, box.ll);
+    CellKey hi = cellOf(level, box.ur);
+    for (int cy = lo.y; cy <= hi.y; ++cy) {
+      for (int cx = lo.x; cx <= hi.x; ++cx) {
+        fn(CellKey{cx, cy});
+      }
+    }
+  }
+
+  void place(const Entry& entry) {
+    int level = levelFor(entry.bounds);
+    if (level >= static_cast<int>(levels.size())) {
+      levels.resize(level + 1);
+    }
+    auto& cells = levels[level];
+    forEachCell(level, entry.bounds, [&](const CellKey& key) {
+      cells[key].push_back(entry);
+    });
+  }
+
+  // Every item once: from the cell of its lower left corner
+  std::vector<Entry> collectEntries() const {
+    std::vector<Entry> entries;
+    entries.reserve(itemCount);
+    for (int level = 0; level < static_cast<int>(levels.size()); ++level) {
+      for (const auto& [key, cell] : levels[level]) {
+        for (size_t i = 0; i < cell.size(); ++i) {
+          Entry entry = cell[i];
+          if (cellOf(level, entry.bounds.ll) == key) {
+            entries.push_back(entry);
+          }
+        }
+      }
+    }
+    return entries;
+  }
+
+  // Cells as large as the typical item, but no smaller than the area per
+  // item, so sparse boards don't pay for many empty cells per query
+  int tunedCellSize(const std::vector<Entry>& entries) const {
+    if (entries.empty()) {
+      return cellSize;
+    }
+    std::vector<int> extents;
+    extents.reserve(entries.size());
+    IntBox extent = IntBox::empty();
+    for (const Entry& entry : entries) {
+      extents.push_back(entry.bounds.maxDimension());
+      extent = extent.unionWith(entry.bounds);
+    }
+    auto median = extents.begin() + extents.size() / 2;
+    std::nth_element(extents.begin(), median, extents.end());
+    double areaPerItem = extent.area() / static_cast<double>(entries.size());
+    return std::max({kMinCellSize, *median, static_cast<int>(std::sqrt(areaPerItem))});
+  }
+
+  // Add entries with each touched cell sized once and appended in key order
+  void build(const std::vector<Entry>& entries) {
+    struct Placement {
+      int level;
+      CellKey key;
+      u32 entry;
+    };
+    std::vector<Placement> placements;
+    placements.reserve(entries.size());
+    for (u32 i = 0; i < entries.size(); ++i) {
+      int level = levelFor(entries[i].bounds);
+      forEachCell(level, entries[i].bounds, [&](const CellKey& key) {
+        placements.push_back(Placement{level, key, i});
+      });
+    }
+    std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+      if (a.level != b.level) return a.level < b.level;
+      if (!(a.key == b.key)) return a.key < b.key;
+      return a.entry < b.entry;
+    });
+
+    for (size_t begin = 0; begin < placements.size();) {
+      size_t end = begin + 1;
+      while (end < placements.size() && placements[end].level == placements[begin].level &&
+             placements[end].key == placements[begin].key) {
+        ++end;
+      }
+      int level = placements[begin].level;
+      if (level >= static_cast<int>(levels.size())) {
+        levels.resize(level + 1);
+      }
+      auto& cell = levels[level].try_emplace(levels[level].end(), placements[begin].key)->second;
+      cell.reserve(cell.size() + (end - begin));
+      for (size_t i = begin; i < end; ++i) {
+        cell.push_back(entries[placements[i].entry]);
+      }
+      begin = end;
+    }
+  }
+
+  // Base cell size from the items' extents and spacing, then place every
+  // item again
+  void tune() {
+    nextTuneSize = 2 * itemCount;
+
+    std::vector<Entry> entries = collectEntries();
+    int tuned = tunedCellSize(entries);
+    if (tuned == cellSize) {
+      return;
+    }
+
+    cellSize = tuned;
+    levels.clear();
+    build(entries);
+  }
+
   int cellSize;
-  std::map<CellKey, std::vector<ITEM*>> cells;
+  Grid grid;
+  std::vector<Cells> levels;  // Cells by level, finest first
+  size_t itemCount = 0;
+  size_t nextTuneSize = kFirstTuneSize;
 };
 
 } // namespace freerouting
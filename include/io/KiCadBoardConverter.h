@@ -8,11 +8,14 @@
 #include "board/Component.h"
 #include "board/Pin.h"
 #include "core/Padstack.h"
+#include "core/Parallel.h"
 #include "rules/ClearanceMatrix.h"
 #include "rules/Nets.h"
 #include "geometry/Vector2.h"
+#include <algorithm>
 #include <memory>
 #include <cmath>
+#include <vector>
 
 namespace freerouting {
 
@@ -49,52 +52,23 @@ public:
 
   // Create RoutingBoard from KiCadPcb
   // Returns a pair of (board, clearanceMatrix) because board stores a pointer to the matrix
+  // The footprints are copied for the renderer; pass the PCB as a shared
+  // pointer to share them instead
   static std::pair<std::unique_ptr<RoutingBoard>, std::unique_ptr<ClearanceMatrix>>
   createRoutingBoard(const KiCadPcb& kicadPcb) {
-    // Create clearance matrix (must outlive board since board stores a pointer)
-    int defaultClearance = mmToUnits(0.2);
-    auto clearanceMatrix = std::make_unique<ClearanceMatrix>(
-      ClearanceMatrix::createDefault(kicadPcb.layers, defaultClearance));
-
-    // Create routing board
-    auto board = std::make_unique<RoutingBoard>(kicadPcb.layers, *clearanceMatrix);
-
-    // Create nets collection and add to board
-    // Note: We're leaking this for now - TODO: fix ownership model
-    auto nets = new Nets();
-    for (const auto& net : kicadPcb.nets) {
-      nets->addNet(net);
-    }
-    board->setNets(nets);
-
-    // Convert and add segments (traces)
-    int itemId = 1;
-    for (const auto& segment : kicadPcb.segments) {
-      auto trace = convertSegmentToTrace(segment, itemId++, board.get());
-      if (trace) {
-        board->addItem(std::move(trace));
-      }
-    }
-
-    // Convert and add vias
-    for (const auto& via : kicadPcb.vias) {
-      auto viaItem = convertViaToItem(via, itemId++, board.get());
-      if (viaItem) {
-        board->addItem(std::move(viaItem));
-      }
-    }
-
-    // Convert and add footprint pads as pins
-    int componentNumber = 1;
-    for (const auto& footprint : kicadPcb.footprints) {
-      convertFootprintPads(footprint, componentNumber++, itemId, board.get());
-    }
-
-    // Store footprints for visualization (courtyards, silkscreen)
-    auto footprintsPtr = std::make_shared<std::vector<KiCadFootprint>>(kicadPcb.footprints);
-    board->setFootprints(footprintsPtr);
+    auto result = convertItems(kicadPcb);
+    result.first->setFootprints(std::make_shared<std::vector<KiCadFootprint>>(kicadPcb.footprints));
+    return result;
+  }
 
-    return {std::move(board), std::move(clearanceMatrix)};
+  // Create RoutingBoard from a shared KiCadPcb; the board keeps the PCB's
+  // footprints alive for the renderer instead of copying them
+  static std::pair<std::unique_ptr<RoutingBoard>, std::unique_ptr<ClearanceMatrix>>
+  createRoutingBoard(std::shared_ptr<const KiCadPcb> kicadPcb) {
+    auto result = convertItems(*kicadPcb);
+    result.first->setFootprints(
+      std::shared_ptr<const std::vector<KiCadFootprint>>(kicadPcb, &kicadPcb->footprints));
+    return result;
   }
 
   // Convert RoutingBoard back to KiCadPcb (update segments and vias)
@@ -138,6 +112,84 @@ public:
   }
 
 private:
+  // Below this many items conversion is cheaper than starting threads
+  static constexpr size_t kParallelItems = 4096;
+
+  // Segments per conversion task
+  static constexpr size_t kSegmentChunk = 1024;
+
+  // Board with nets and every segment, via and pad of the PCB
+  // Items are numbered segments first, then vias, then pads footprint by
+  // footprint. Each is converted straight into its slot of one array, in
+  // parallel chunks of segments and vias and per footprint, and the board
+  // takes them all with one build of its shape tree.
+  static std::pair<std::unique_ptr<RoutingBoard>, std::unique_ptr<ClearanceMatrix>>
+  convertItems(const KiCadPcb& kicadPcb) {
+    // Create clearance matrix (must outlive board since board stores a pointer)
+    int defaultClearance = mmToUnits(0.2);
+    auto clearanceMatrix = std::make_unique<ClearanceMatrix>(
+      ClearanceMatrix::createDefault(kicadPcb.layers, defaultClearance));
+
+    // Create routing board
+    auto board = std::make_unique<RoutingBoard>(kicadPcb.layers, *clearanceMatrix);
+
+    // Create nets collection and add to board
+    // Note: We're leaking this for now - TODO: fix ownership model
+    auto nets = new Nets();
+    for (const auto& net : kicadPcb.nets) {
+      nets->addNet(net);
+    }
+    board->setNets(nets);
+
+    // Padstacks are created here, in item order, so the tasks below only
+    // look them up
+    for (const auto& via : kicadPcb.vias) {
+      board->getPadstack("via", via.layersFrom, via.layersTo);
+    }
+    std::vector<size_t> firstPad(kicadPcb.footprints.size() + 1, 0);
+    for (size_t i = 0; i < kicadPcb.footprints.size(); ++i) {
+      for (const auto& pad : kicadPcb.footprints[i].pads) {
+        board->getPadstack("pad", pad.layer, pad.layer);
+      }
+      firstPad[i + 1] = firstPad[i] + kicadPcb.footprints[i].pads.size();
+    }
+
+    const size_t segmentCount = kicadPcb.segments.size();
+    const size_t viaCount = kicadPcb.vias.size();
+    const size_t segmentTasks = (segmentCount + kSegmentChunk - 1) / kSegmentChunk;
+    const size_t viaTasks = (viaCount + kSegmentChunk - 1) / kSegmentChunk;
+    const size_t viaBase = segmentCount;
+    const size_t padBase = segmentCount + viaCount;
+    std::vector<std::unique_ptr<Item>> items(padBase + firstPad.back());
+
+    // Item IDs are slot + 1
+    const size_t tasks = segmentTasks + viaTasks + kicadPcb.footprints.size();
+    parallelFor(tasks, items.size() < kParallelItems ? 1 : threadCount(), [&](size_t task) {
+      if (task < segmentTasks) {
+        size_t end = std::min(segmentCount, (task + 1) * kSegmentChunk);
+        for (size_t i = task * kSegmentChunk; i < end; ++i) {
+          items[i] = convertSegmentToTrace(kicadPcb.segments[i], static_cast<int>(i + 1), board.get());
+        }
+      } else if (task < segmentTasks + viaTasks) {
+        size_t chunk = task - segmentTasks;
+        size_t end = std::min(viaCount, (chunk + 1) * kSegmentChunk);
+        for (size_t i = chunk * kSegmentChunk; i < end; ++i) {
+          items[viaBase + i] = convertViaToItem(kicadPcb.vias[i], static_cast<int>(viaBase + i + 1), board.get());
+        }
+      } else {
+        size_t footprint = task - segmentTasks - viaTasks;
+        convertFootprintPads(kicadPcb.footprints[footprint], static_cast<int>(footprint + 1),
+                             padBase + firstPad[footprint], items, board.get());
+      }
+    });
+
+    // Routed copper is numbered after the converted items
+    const int lastItemId = static_cast<int>(items.size());
+    board->addItems(std::move(items));
+    board->reserveItemIds(lastItemId);
+    return {std::move(board), std::move(clearanceMatrix)};
+  }
+
   // Convert KiCad segment to Trace
   static std::unique_ptr<Trace> convertSegmentToTrace(
       const KiCadSegment& segment, int itemId, BasicBoard* board) {
@@ -169,17 +221,8 @@ private:
       nets.push_back(kicadVia.netNumber);
     }
 
-    // Create a simple padstack for the via
-    // Note: We allocate this on the heap and never delete it (memory leak)
-    // TODO: Proper padstack lifetime management
-    Padstack* padstack = new Padstack(
-      "via_" + std::to_string(itemId),  // name
-      itemId,                            // number
-      kicadVia.layersFrom,              // fromLayer
-      kicadVia.layersTo,                // toLayer
-      true,                              // attachAllowed
-      false                              // placedAbsolute
-    );
+    // Vias with the same layer range share a board-owned padstack
+    const Padstack* padstack = board->getPadstack("via", kicadVia.layersFrom, kicadVia.layersTo);
 
     return std::make_unique<Via>(
       center, padstack, nets, 0 /* clearanceClass */, itemId,
@@ -187,16 +230,17 @@ private:
     );
   }
 
-  // Convert footprint pads to pins
+  // Convert footprint pads to pins, into consecutive slots from firstSlot
   static void convertFootprintPads(const KiCadFootprint& footprint,
-                                    int componentNumber, int& itemId,
+                                    int componentNumber, size_t firstSlot,
+                                    std::vector<std::unique_ptr<Item>>& items,
                                     BasicBoard* board) {
     int pinNumber = 0;
+    size_t slot = firstSlot;
     for (const auto& pad : footprint.pads) {
-      auto pin = convertPadToPin(pad, footprint, componentNumber, pinNumber++, itemId++, board);
-      if (pin) {
-        board->addItem(std::move(pin));
-      }
+      items[slot] = convertPadToPin(pad, footprint, componentNumber, pinNumber++,
+                                    static_cast<int>(slot + 1), board);
+      ++slot;
     }
   }
 
@@ -218,17 +262,9 @@ private:
       nets.push_back(pad.netNumber);
     }
 
-    // Create a simple padstack for the pad
-    // Note: We allocate this on the heap and never delete it (memory leak)
-    // TODO: Proper padstack lifetime management
-    Padstack* padstack = new Padstack(
-      "pad_" + std::to_string(itemId),  // name
-      itemId,                            // number
-      pad.layer,                         // fromLayer (for now assume single layer)
-      pad.layer,                         // toLayer
-      true,                              // attachAllowed
-      false                              // placedAbsolute
-    );
+    // Pads on the same layer share a board-owned padstack
+    // (for now assume single layer)
+    const Padstack* padstack = board->getPadstack("pad", pad.layer, pad.layer);
 
     return std::make_unique<Pin>(
       center, pinNumber, padstack, nets, 0 /* clearanceClass */, itemId,
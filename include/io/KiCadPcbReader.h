@@ -8,29 +8,50 @@
 #include <optional>
 #include <fstream>
 #include <sstream>
+#include <string_view>
 
 namespace freerouting {
 
+// How much of a KiCad file to load
+enum class KiCadLoadProfile {
+  Full,        // Everything the reader understands, including footprint graphics
+  RoutingOnly  // Copper, nets and rules only; graphics, text bodies, 3D models
+               // and unhandled top-level blocks are skipped without building nodes
+};
+
 // Reader for KiCad .kicad_pcb files
 // Parses S-expression format into KiCadPcb structure
 class KiCadPcbReader {
 public:
   // Read from file
-  static std::optional<KiCadPcb> readFromFile(const std::string& filename) {
-    std::ifstream file(filename);
+  static std::optional<KiCadPcb> readFromFile(const std::string& filename,
+                                              KiCadLoadProfile profile = KiCadLoadProfile::Full) {
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
       return std::nullopt;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return readFromString(buffer.str());
+    // Read straight into one buffer instead of going through a stringstream
+    // copy; boards run to several MB
+    std::string content;
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if (size > 0) {
+      content.resize(static_cast<size_t>(size));
+      file.seekg(0, std::ios::beg);
+      file.read(content.data(), size);
+      content.resize(static_cast<size_t>(file.gcount()));
+    }
+    return readFromString(content, profile);
   }
 
   // Read from string
-  static std::optional<KiCadPcb> readFromString(const std::string& content) {
+  static std::optional<KiCadPcb> readFromString(const std::string& content,
+                                                KiCadLoadProfile profile = KiCadLoadProfile::Full) {
     SExprLexer lexer(content);
-    SExprParser parser(lexer);
+    SExprParser parser = profile == KiCadLoadProfile::RoutingOnly
+      ? SExprParser(lexer, routingSkipFilter)
+      : SExprParser(lexer);
 
     auto root = parser.parse();
     if (!root || !root->isListWithKeyword("kicad_pcb")) {
@@ -45,6 +66,36 @@ public:
   }
 
 private:
+  // Skip filter for KiCadLoadProfile::RoutingOnly
+  // Top-level blocks parseKiCadPcb() does not handle (gr_*, zone, dimension,
+  // title_block, ...) are skipped whole. Inside footprints the graphics and
+  // 3D models go too; fp_text keeps its type and string, which is all the
+  // writer needs for reference/value.
+  static SExprSkip routingSkipFilter(std::string_view kw, int depth) {
+    if (depth == 1) {
+      if (kw == "version" || kw == "generator" || kw == "general" ||
+          kw == "paper" || kw == "layers" || kw == "setup" ||
+          kw == "net" || kw == "net_class" || kw == "segment" ||
+          kw == "via" || kw == "footprint" || kw == "module") {
+        return SExprSkip::None;
+      }
+      return SExprSkip::Whole;
+    }
+
+    if (depth >= 2) {
+      if (kw == "fp_text") {
+        return SExprSkip::HeadOnly;
+      }
+      if (kw.starts_with("fp_") || kw.starts_with("gr_") ||
+          kw == "model" || kw == "property" || kw == "zone" ||
+          kw == "stackup" || kw == "pcbplotparams") {
+        return SExprSkip::Whole;
+      }
+    }
+
+    return SExprSkip::None;
+  }
+
   // Parse top-level kicad_pcb node
   static bool parseKiCadPcb(const SExprNode& node, KiCadPcb& pcb) {
     if (!node.isList() || node.childCount() == 0) {
@@ -2,9 +2,14 @@
 #define FREEROUTING_IO_SEXPRLEXER_H
 
 #include "core/Types.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
 #include <string>
 #include <string_view>
-#include <cctype>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace freerouting {
 
@@ -19,72 +24,108 @@ enum class SExprTokenType {
 };
 
 // Single token from S-expression
+// offset is where the token starts in the input; SExprLexer::location()
+// turns it into a line and column when a message needs one
 struct SExprToken {
   SExprTokenType type;
   std::string value;
-  int line;
-  int column;
+  size_t offset;
 
-  SExprToken(SExprTokenType t, std::string v, int l, int c)
-    : type(t), value(std::move(v)), line(l), column(c) {}
+  SExprToken(SExprTokenType t, std::string v, size_t o)
+    : type(t), value(std::move(v)), offset(o) {}
 
   SExprToken()
-    : type(SExprTokenType::EndOfFile), value(""), line(0), column(0) {}
+    : type(SExprTokenType::EndOfFile), value(""), offset(0) {}
 };
 
 // Lexer for S-expression tokenization
 // Converts input text into sequence of tokens
+// Scanning works like the first stage of simdjson: each 64-byte block of
+// the input is classified once, 16 bytes at a time with SSE2 where the
+// target has it, into bit masks of whitespace, of delimiters (whitespace,
+// parens, quote, '#') and of quotes and backslashes. Skipping whitespace,
+// finding the end of an atom or string and skipping a list are then a
+// count-trailing-zeros on the masks instead of a test per character. A
+// block is classified when the lexer first reaches it, so the index takes
+// constant memory however large the input.
+// Line and column are not tracked while scanning; location() counts the
+// lines up to an offset when asked.
 class SExprLexer {
 public:
+  struct Location {
+    int line;
+    int column;
+  };
+
   explicit SExprLexer(std::string_view input)
-    : input_(input), pos_(0), line_(1), column_(1) {}
+    : input_(input), pos_(0) {}
 
   // Get next token from input
   SExprToken nextToken() {
     skipWhitespaceAndComments();
 
     if (pos_ >= input_.size()) {
-      return SExprToken(SExprTokenType::EndOfFile, "", line_, column_);
+      return SExprToken(SExprTokenType::EndOfFile, "", input_.size());
     }
 
-    int tokenLine = line_;
-    int tokenColumn = column_;
+    size_t start = pos_;
     char ch = input_[pos_];
 
     // Left parenthesis
     if (ch == '(') {
-      advance();
-      return SExprToken(SExprTokenType::LeftParen, "(", tokenLine, tokenColumn);
+      pos_++;
+      return SExprToken(SExprTokenType::LeftParen, "(", start);
     }
 
     // Right parenthesis
     if (ch == ')') {
-      advance();
-      return SExprToken(SExprTokenType::RightParen, ")", tokenLine, tokenColumn);
+      pos_++;
+      return SExprToken(SExprTokenType::RightParen, ")", start);
     }
 
     // Quoted string
     if (ch == '"') {
-      return readString(tokenLine, tokenColumn);
+      return readString(start);
     }
 
-    // Number or symbol
-    if (std::isdigit(ch) || ch == '-' || ch == '+' || ch == '.') {
-      // Try to read as number first
-      std::string token = readAtom();
+    // Number or symbol: everything up to the next delimiter
+    pos_ = nextDelimiter(pos_);
+    std::string_view atom = input_.substr(start, pos_ - start);
+    if ((isDigit(ch) || ch == '-' || ch == '+' || ch == '.') && isNumber(atom)) {
+      return SExprToken(SExprTokenType::Number, std::string(atom), start);
+    }
 
-      // Check if it's a valid number
-      if (isNumber(token)) {
-        return SExprToken(SExprTokenType::Number, token, tokenLine, tokenColumn);
-      }
+    // Symbol (identifier)
+    return SExprToken(SExprTokenType::Symbol, std::string(atom), start);
+  }
 
-      // Otherwise it's a symbol
-      return SExprToken(SExprTokenType::Symbol, token, tokenLine, tokenColumn);
+  // Skip to just past the ')' closing the list(s) currently open
+  // openLists: number of lists entered whose ')' has not been read yet.
+  // Jumps between parens, quotes and comments on the block masks, only
+  // tracking paren depth; no tokens are produced for the skipped text.
+  void skipBalanced(int openLists = 1) {
+    size_t p = pos_;
+    int depth = openLists;
+
+    while (depth > 0) {
+      p = nextStructural(p);
+      if (p >= input_.size()) {
+        break;
+      }
+      char ch = input_[p++];
+      if (ch == '(') {
+        depth++;
+      } else if (ch == ')') {
+        depth--;
+      } else if (ch == '"') {
+        p = skipString(p);
+      } else {
+        // '#': comment to end of line
+        p = std::min(input_.find('\n', p), input_.size());
+      }
     }
 
-    // Symbol (identifier)
-    std::string symbol = readAtom();
-    return SExprToken(SExprTokenType::Symbol, symbol, tokenLine, tokenColumn);
+    pos_ = std::min(p, input_.size());
   }
 
   // Peek at current character without consuming
@@ -93,110 +134,214 @@ public:
     return input_[pos_];
   }
 
+  // Byte offset of the next character to read
+  size_t getOffset() const { return pos_; }
+
+  // Line and column (both from 1) of a byte offset
+  // Counts lines from the last offset asked for if it is not past this one
+  Location location(size_t offset) const {
+    offset = std::min(offset, input_.size());
+    if (offset < lineCacheOffset_) {
+      lineCacheOffset_ = 0;
+      lineCacheLine_ = 1;
+      lineCacheStart_ = 0;
+    }
+    for (size_t p = lineCacheOffset_; p < offset;) {
+      size_t newline = input_.find('\n', p);
+      if (newline == std::string_view::npos || newline >= offset) {
+        break;
+      }
+      lineCacheLine_++;
+      lineCacheStart_ = newline + 1;
+      p = newline + 1;
+    }
+    lineCacheOffset_ = offset;
+    return Location{lineCacheLine_, static_cast<int>(offset - lineCacheStart_) + 1};
+  }
+
   // Get current line number
-  int getLine() const { return line_; }
+  int getLine() const { return location(pos_).line; }
 
   // Get current column number
-  int getColumn() const { return column_; }
+  int getColumn() const { return location(pos_).column; }
 
 private:
+  static constexpr size_t kBlockSize = 64;
+
+  // Bit i of each mask describes byte i of the block
+  // Bytes past the end of the input count as delimiters
+  struct BlockMasks {
+    u64 whitespace = 0;
+    u64 delimiter = 0;  // Whitespace, parens, quote, '#'
+    u64 quote = 0;      // Quote or backslash
+  };
+
   std::string_view input_;
   size_t pos_;
-  int line_;
-  int column_;
-
-  // Advance position by one character
-  void advance() {
-    if (pos_ < input_.size()) {
-      if (input_[pos_] == '\n') {
-        line_++;
-        column_ = 1;
-      } else {
-        column_++;
-      }
-      pos_++;
-    }
+  size_t maskBlock_ = std::numeric_limits<size_t>::max();  // Block in masks_
+  BlockMasks masks_;
+  mutable size_t lineCacheOffset_ = 0;  // Offset location() counted to
+  mutable int lineCacheLine_ = 1;
+  mutable size_t lineCacheStart_ = 0;   // Start of that offset's line
+
+  static constexpr bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
   }
 
-  // Skip whitespace and comments (# to end of line)
-  void skipWhitespaceAndComments() {
-    while (pos_ < input_.size()) {
-      char ch = input_[pos_];
+  // Masks of the block holding an offset
+  const BlockMasks& blockMasks(size_t block) {
+    if (block != maskBlock_) {
+      maskBlock_ = block;
+      masks_ = classify(block * kBlockSize);
+    }
+    return masks_;
+  }
 
-      // Skip whitespace
-      if (std::isspace(ch)) {
-        advance();
-        continue;
+  BlockMasks classify(size_t start) const {
+    size_t count = std::min(kBlockSize, input_.size() - start);
+    BlockMasks masks;
+#if defined(__SSE2__)
+    if (count == kBlockSize) {
+      const __m128i space = _mm_set1_epi8(' ');
+      const __m128i belowTab = _mm_set1_epi8('\t' - 1);
+      const __m128i aboveReturn = _mm_set1_epi8('\r' + 1);
+      const __m128i open = _mm_set1_epi8('(');
+      const __m128i close = _mm_set1_epi8(')');
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i hash = _mm_set1_epi8('#');
+      const __m128i backslash = _mm_set1_epi8('\\');
+      for (size_t i = 0; i < kBlockSize; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input_.data() + start + i));
+        // '\t' to '\r' are 9..13; bytes of 128 and up compare as negative
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                  _mm_and_si128(_mm_cmpgt_epi8(v, belowTab), _mm_cmplt_epi8(v, aboveReturn)));
+        __m128i isQuote = _mm_cmpeq_epi8(v, quote);
+        __m128i delim = _mm_or_si128(_mm_or_si128(ws, isQuote),
+                                     _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, open), _mm_cmpeq_epi8(v, close)),
+                                                  _mm_cmpeq_epi8(v, hash)));
+        masks.whitespace |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(ws))) << i;
+        masks.delimiter |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(delim))) << i;
+        masks.quote |= static_cast<u64>(static_cast<u32>(
+                         _mm_movemask_epi8(_mm_or_si128(isQuote, _mm_cmpeq_epi8(v, backslash))))) << i;
       }
+      return masks;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+      char ch = input_[start + i];
+      bool ws = ch == ' ' || (ch >= '\t' && ch <= '\r');
+      bool delim = ws || ch == '(' || ch == ')' || ch == '"' || ch == '#';
+      masks.whitespace |= static_cast<u64>(ws) << i;
+      masks.delimiter |= static_cast<u64>(delim) << i;
+      masks.quote |= static_cast<u64>(ch == '"' || ch == '\\') << i;
+    }
+    if (count < kBlockSize) {
+      masks.delimiter |= ~u64(0) << count;
+    }
+    return masks;
+  }
 
-      // Skip line comments (# to end of line)
-      if (ch == '#') {
-        while (pos_ < input_.size() && input_[pos_] != '\n') {
-          advance();
-        }
-        continue;
+  // First offset at or after p whose bit is set in the mask select picks
+  // from each block; input_.size() if there is none
+  template<typename SELECT>
+  size_t nextSet(size_t p, SELECT&& select) {
+    while (p < input_.size()) {
+      size_t block = p / kBlockSize;
+      u64 bits = select(blockMasks(block)) & (~u64(0) << (p % kBlockSize));
+      if (bits != 0) {
+        return std::min(block * kBlockSize + std::countr_zero(bits), input_.size());
       }
-
-      break;
+      p = (block + 1) * kBlockSize;
     }
+    return input_.size();
   }
 
-  // Read quoted string
-  SExprToken readString(int tokenLine, int tokenColumn) {
-    FR_ASSERT(input_[pos_] == '"');
-    advance();  // Skip opening quote
+  size_t nextNonWhitespace(size_t p) {
+    return nextSet(p, [](const BlockMasks& m) { return ~m.whitespace; });
+  }
 
-    std::string result;
-    while (pos_ < input_.size() && input_[pos_] != '"') {
-      char ch = input_[pos_];
+  size_t nextDelimiter(size_t p) {
+    return nextSet(p, [](const BlockMasks& m) { return m.delimiter; });
+  }
 
-      // Handle escape sequences
-      if (ch == '\\' && pos_ + 1 < input_.size()) {
-        advance();
-        char next = input_[pos_];
-        switch (next) {
-          case 'n': result += '\n'; break;
-          case 't': result += '\t'; break;
-          case 'r': result += '\r'; break;
-          case '"': result += '"'; break;
-          case '\\': result += '\\'; break;
-          default: result += next; break;
-        }
-        advance();
-      } else {
-        result += ch;
-        advance();
+  // Parens, quotes and comment starts
+  size_t nextStructural(size_t p) {
+    return nextSet(p, [](const BlockMasks& m) { return m.delimiter & ~m.whitespace; });
+  }
+
+  size_t nextQuoteOrBackslash(size_t p) {
+    return nextSet(p, [](const BlockMasks& m) { return m.quote; });
+  }
+
+  // Offset just past the quote closing a string whose text starts at p
+  size_t skipString(size_t p) {
+    while (p < input_.size()) {
+      p = nextQuoteOrBackslash(p);
+      if (p >= input_.size()) {
+        break;
+      }
+      if (input_[p] == '"') {
+        return p + 1;
       }
+      p += 2;  // Backslash and the character it escapes
     }
+    return input_.size();
+  }
 
-    if (pos_ < input_.size() && input_[pos_] == '"') {
-      advance();  // Skip closing quote
+  // Skip whitespace and comments (# to end of line)
+  void skipWhitespaceAndComments() {
+    while (true) {
+      pos_ = nextNonWhitespace(pos_);
+      if (pos_ >= input_.size() || input_[pos_] != '#') {
+        break;
+      }
+      pos_ = std::min(input_.find('\n', pos_), input_.size());
     }
-
-    return SExprToken(SExprTokenType::String, result, tokenLine, tokenColumn);
   }
 
-  // Read unquoted atom (symbol or number)
-  std::string readAtom() {
-    std::string result;
+  // Read quoted string
+  // Text between escapes is copied a run at a time
+  SExprToken readString(size_t start) {
+    FR_ASSERT(input_[pos_] == '"');
+    size_t p = pos_ + 1;  // Skip opening quote
 
-    while (pos_ < input_.size()) {
-      char ch = input_[pos_];
+    std::string result;
+    while (p < input_.size()) {
+      size_t stop = nextQuoteOrBackslash(p);
+      result.append(input_.substr(p, stop - p));
+      p = stop;
+      if (p >= input_.size() || input_[p] == '"') {
+        break;
+      }
 
-      // Stop at delimiters
-      if (std::isspace(ch) || ch == '(' || ch == ')' || ch == '"' || ch == '#') {
+      // Handle escape sequences
+      if (p + 1 >= input_.size()) {
+        result += '\\';
+        p++;
         break;
       }
+      char next = input_[p + 1];
+      switch (next) {
+        case 'n': result += '\n'; break;
+        case 't': result += '\t'; break;
+        case 'r': result += '\r'; break;
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        default: result += next; break;
+      }
+      p += 2;
+    }
 
-      result += ch;
-      advance();
+    if (p < input_.size() && input_[p] == '"') {
+      p++;  // Skip closing quote
     }
+    pos_ = p;
 
-    return result;
+    return SExprToken(SExprTokenType::String, std::move(result), start);
   }
 
   // Check if string is a valid number
-  bool isNumber(const std::string& str) const {
+  static bool isNumber(std::string_view str) {
     if (str.empty()) return false;
 
     size_t i = 0;
@@ -213,7 +358,7 @@ private:
     bool hasDecimal = false;
 
     while (i < str.size()) {
-      if (std::isdigit(str[i])) {
+      if (isDigit(str[i])) {
         hasDigit = true;
         i++;
       } else if (str[i] == '.' && !hasDecimal) {
@@ -225,7 +370,7 @@ private:
         if (i < str.size() && (str[i] == '+' || str[i] == '-')) {
           i++;
         }
-        while (i < str.size() && std::isdigit(str[i])) {
+        while (i < str.size() && isDigit(str[i])) {
           i++;
         }
         break;
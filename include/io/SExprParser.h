@@ -3,7 +3,9 @@
 
 #include "SExprLexer.h"
 #include "core/Types.h"
+#include <functional>
 #include <memory>
+#include <string_view>
 #include <vector>
 #include <variant>
 
@@ -130,6 +132,17 @@ private:
   SExprAtom value_;                                    // For atom nodes
 };
 
+// What to build for a list, decided from its keyword
+enum class SExprSkip {
+  None,      // Parse normally
+  Whole,     // Skip the list entirely; no node is created
+  HeadOnly   // Keep the leading atoms, skip nested lists
+};
+
+// Decides per list from its keyword (first atom) and nesting depth
+// (0 = top-level expression)
+using SExprSkipFilter = std::function<SExprSkip(std::string_view keyword, int depth)>;
+
 // Parser for S-expressions
 // Converts tokens into an AST (Abstract Syntax Tree)
 class SExprParser {
@@ -139,8 +152,15 @@ public:
     advance();
   }
 
+  // Parser building only part of the tree: lists rejected by the filter are
+  // passed over by the lexer's byte scan without tokenizing their contents
+  SExprParser(SExprLexer& lexer, SExprSkipFilter filter)
+    : lexer_(lexer), currentToken_(), filter_(std::move(filter)) {
+    advance();
+  }
+
   // Parse next S-expression
-  // Returns nullptr on EOF
+  // Returns nullptr on EOF or when the skip filter drops the expression
   std::unique_ptr<SExprNode> parse() {
     if (currentToken_.type == SExprTokenType::EndOfFile) {
       return nullptr;
@@ -170,6 +190,8 @@ public:
 private:
   SExprLexer& lexer_;
   SExprToken currentToken_;
+  SExprSkipFilter filter_;
+  int depth_ = 0;
 
   // Advance to next token
   void advance() {
@@ -177,12 +199,42 @@ private:
   }
 
   // Parse list: ( ... )
+  // Returns nullptr if the skip filter drops the list
   std::unique_ptr<SExprNode> parseList() {
     FR_ASSERT(currentToken_.type == SExprTokenType::LeftParen);
     advance();  // Skip '('
 
+    SExprSkip skip = SExprSkip::None;
+    if (filter_ && currentToken_.type == SExprTokenType::Symbol) {
+      skip = filter_(currentToken_.value, depth_);
+    }
+
+    if (skip == SExprSkip::Whole) {
+      // Keyword already read; scan past the matching ')'
+      lexer_.skipBalanced();
+      advance();
+      return nullptr;
+    }
+
     auto list = SExprNode::createList();
 
+    if (skip == SExprSkip::HeadOnly) {
+      while (currentToken_.type != SExprTokenType::LeftParen &&
+             currentToken_.type != SExprTokenType::RightParen &&
+             currentToken_.type != SExprTokenType::EndOfFile) {
+        list->addChild(parseAtom());
+      }
+      if (currentToken_.type == SExprTokenType::LeftParen) {
+        // Inside the nested list just opened and still inside this one
+        lexer_.skipBalanced(2);
+        advance();
+      } else if (currentToken_.type == SExprTokenType::RightParen) {
+        advance();
+      }
+      return list;
+    }
+
+    depth_++;
     while (currentToken_.type != SExprTokenType::RightParen &&
            currentToken_.type != SExprTokenType::EndOfFile) {
       auto child = parse();
@@ -190,6 +242,7 @@ private:
         list->addChild(std::move(child));
       }
     }
+    depth_--;
 
     if (currentToken_.type == SExprTokenType::RightParen) {
       advance();  // Skip ')'
@@ -1,8 +1,10 @@
 #include "autoroute/AutorouteEngine.h"
 #include "autoroute/ExpansionDoor.h"
 #include "autoroute/MazeSearchAlgo.h"
+#include "autoroute/SearchCapture.h"
 #include "autoroute/PushAndShove.h"
 #include "autoroute/LayerCostAnalyzer.h"
+#include "autoroute/MultiResolutionGridRouter.h"
 #include "autoroute/ExpansionRoomGenerator.h"
 #include "autoroute/ObstacleExpansionRoom.h"
 #include "autoroute/SortedRoomNeighbours.h"
@@ -13,10 +15,62 @@
 #include "board/Via.h"
 #include "core/Padstack.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace freerouting {
 
+namespace {
+
+// Stop flag shared by the two searches of a race; also honours the
+// Stoppable of the caller
+class RaceStoppable : public Stoppable {
+public:
+  explicit RaceStoppable(const Stoppable* parent) : parent_(parent) {}
+
+  bool isStopRequested() const override {
+    return stopRequested_.load(std::memory_order_relaxed) ||
+           (parent_ && parent_->isStopRequested());
+  }
+
+  void requestStop() override {
+    stopRequested_.store(true, std::memory_order_relaxed);
+  }
+
+private:
+  const Stoppable* parent_;
+  std::atomic<bool> stopRequested_{false};
+};
+
+// Length of a path with each layer change counted as viaCost
+double pathCost(const std::vector<IntPoint>& points, const std::vector<int>& layers,
+                double viaCost) {
+  double cost = 0.0;
+  for (size_t i = 1; i < points.size(); ++i) {
+    double dx = static_cast<double>(points[i].x) - points[i - 1].x;
+    double dy = static_cast<double>(points[i].y) - points[i - 1].y;
+    cost += std::sqrt(dx * dx + dy * dy);
+    if (layers[i] != layers[i - 1]) {
+      cost += viaCost;
+    }
+  }
+  return cost;
+}
+
+} // namespace
+
 void AutorouteEngine::initConnection(int netNumber, Stoppable* stoppable, TimeLimit* limit) {
+  // Nothing holds the rooms or the board's rasters between connections, so
+  // this is where caches picked by the memory budget go
+  MemoryBudget::instance().use(&roomCache);
+  if (board) {
+    board->releaseEvictedCaches();
+  }
+
   if (maintainDatabase && netNumber != netNo) {
     // Invalidate net-dependent complete expansion rooms
     auto it = completeExpansionRooms.begin();
@@ -66,6 +120,17 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
     return AutorouteResult::AlreadyConnected;
   }
 
+  // Cells one trace pitch wide; copper grows by half width plus the widest
+  // layer clearance, so every conflict query of this connection fits
+  if (ctrl.useOccupancyFilter) {
+    int halfWidth = ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[0];
+    int clearance = 0;
+    for (int layer = 0; layer < board->getLayers().count(); ++layer) {
+      clearance = std::max(clearance, board->getClearanceMatrix().getValue(1, 1, layer, true));
+    }
+    board->getOccupancy(2 * halfWidth + clearance, halfWidth + clearance);
+  }
+
   // Get start and goal points (use bounding box centers)
   IntBox startBox = startSet[0]->getBoundingBox();
   IntBox goalBox = destSet[0]->getBoundingBox();
@@ -97,7 +162,11 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
   );
 
   LayerCostAnalyzer layerAnalyzer(board);
-  layerAnalyzer.analyze();
+  if (ctrl.searchWindow.isEmpty()) {
+    layerAnalyzer.analyze();
+  } else {
+    layerAnalyzer.analyzeRegion(ctrl.searchWindow);
+  }
 
   // Calculate route distance to determine if it's worth using alternative layers
   int dx = std::abs(start.x - goal.x);
@@ -106,7 +175,9 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
   constexpr double kLongRouteThreshold = 5000000.0;  // 0.5mm - routes longer than this consider alt layers
 
   // Find best layer in the routing region
-  int bestLayer = layerAnalyzer.findBestLayerInRegion(routingRegion);
+  int bestLayer = ctrl.searchWindow.isEmpty()
+    ? layerAnalyzer.findBestLayerInRegion(routingRegion)
+    : layerAnalyzer.findBestLayerNear(routingRegion);
   double startLayerCost = layerAnalyzer.getLayerCost(startLayer);
   double bestLayerCost = layerAnalyzer.getLayerCost(bestLayer);
 
@@ -123,7 +194,7 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
     // Use the less congested layer even if it requires vias
     routingLayer = bestLayer;
 
-    static int altLayerCount = 0;
+    static std::atomic<int> altLayerCount = 0;
     if (altLayerCount < 5) {
       std::cerr << "INFO: Routing on alternative layer " << routingLayer
                 << " instead of " << startLayer
@@ -135,45 +206,95 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
 
   // Use the proper maze search algorithm (expansion rooms) from Java freerouting
   // This naturally handles multi-layer routing with vias
+  auto searchStart = std::chrono::steady_clock::now();
   auto mazeSearch = MazeSearchAlgo::getInstance(startSet, destSet, this, ctrl);
 
   if (!mazeSearch) {
     return AutorouteResult::Failed;
   }
 
-  auto result = mazeSearch->findConnection();
+  MazeSearchAlgo::Result result;
+  bool gridPath = false;
+
+  if (ctrl.raceSearches && ctrl.gridFallbackEnabled) {
+    result.found = raceSearches(*mazeSearch, gridEndpoint(startSet[0], ctrl),
+                                gridEndpoint(destSet[0], ctrl), ctrl,
+                                result.pathPoints, result.pathLayers, gridPath);
+  } else {
+    result = mazeSearch->findConnection();
+
+    if (!result.found && ctrl.gridFallbackEnabled) {
+      // Maze search failed - try the coarse-to-fine grid router next
+      result.found = findGridFallbackPath(makeGridFallbackRouter(ctrl, stoppableThread),
+                                          gridEndpoint(startSet[0], ctrl),
+                                          gridEndpoint(destSet[0], ctrl),
+                                          result.pathPoints, result.pathLayers);
+      gridPath = result.found;
+    }
+  }
+  updateRoomMemory(std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - searchStart).count());
+
+  if (searchCapture && result.found) {
+    if (!gridPath) {
+      searchCapture->setOutcome(SearchCapture::Outcome::MazeSearch);
+    } else {
+      searchCapture->setOutcome(SearchCapture::Outcome::GridFallback);
+      searchCapture->clearPath();
+      for (size_t i = 0; i < result.pathPoints.size(); ++i) {
+        searchCapture->addPathPoint(result.pathPoints[i], result.pathLayers[i]);
+      }
+    }
+  }
+
+  if (!result.found && !ctrl.fallbackLayerActive.empty()) {
+    // Nothing on the assigned layers; search all of them before the
+    // direct route, with a fresh room database
+    AutorouteControl unrestricted = ctrl;
+    unrestricted.layerActive = ctrl.fallbackLayerActive;
+    unrestricted.fallbackLayerActive.clear();
+    mazeSearch.reset();
+    clear();
+    clearRoomGenerators();
+    initConnection(netNo, stoppableThread, timeLimit);
+    initializeSearchTree(ctrl.searchWindow);
+    return autorouteConnection(startSet, destSet, unrestricted, rippedItems);
+  }
 
   if (!result.found) {
     // Maze search failed - try direct route as last resort
     return createDirectRoute(start, goal, routingLayer, ctrl, ripupCostLimit, rippedItems);
   }
 
-  // Maze search succeeded! Now create traces and vias from the path
-  if (result.pathPoints.empty() || result.pathLayers.empty()) {
+  // A path was found - create traces and vias along it
+  return createRouteFromPath(std::move(result.pathPoints), std::move(result.pathLayers), ctrl);
+}
+
+// Helper: Create traces and vias along a routed path
+AutorouteEngine::AutorouteResult AutorouteEngine::createRouteFromPath(
+    std::vector<IntPoint> points, std::vector<int> layers,
+    const AutorouteControl& ctrl) {
+
+  if (points.empty() || layers.empty()) {
     return AutorouteResult::Failed;
   }
+  simplifyPath(points, layers, ctrl);
 
   // Create traces segment by segment, inserting vias when layer changes
   std::vector<int> nets{netNo};
-  int prevLayer = result.pathLayers[0];
-  IntPoint prevPoint = result.pathPoints[0];
+  int prevLayer = layers[0];
+  IntPoint prevPoint = points[0];
 
-  for (size_t i = 1; i < result.pathPoints.size(); ++i) {
-    IntPoint currPoint = result.pathPoints[i];
-    int currLayer = result.pathLayers[i];
+  for (size_t i = 1; i < points.size(); ++i) {
+    IntPoint currPoint = points[i];
+    int currLayer = layers[i];
 
     // If layer changed, insert via
     if (currLayer != prevLayer) {
       // Create via at the transition point
       int viaItemId = board->generateItemId();
-      Padstack* viaPadstack = new Padstack(
-        "via_" + std::to_string(viaItemId),
-        viaItemId,
-        std::min(prevLayer, currLayer),
-        std::max(prevLayer, currLayer),
-        true,   // attachAllowed
-        false   // placedAbsolute
-      );
+      const Padstack* viaPadstack = board->getPadstack(
+        "via", std::min(prevLayer, currLayer), std::max(prevLayer, currLayer));
 
       auto via = std::make_unique<Via>(
         prevPoint, viaPadstack, nets, ctrl.traceClearanceClassNo, viaItemId,
@@ -202,6 +323,158 @@ AutorouteEngine::AutorouteResult AutorouteEngine::autorouteConnection(
   return AutorouteResult::Routed;
 }
 
+// Helper: Merge straight runs and cut corners that have clearance, so the
+// route goes on the board as few items
+void AutorouteEngine::simplifyPath(std::vector<IntPoint>& points, std::vector<int>& layers,
+                                   const AutorouteControl& ctrl) {
+  if (!ctrl.simplifyPaths) {
+    int segments = PathSimplifier::countSegments(points);
+    pathStatistics.segmentsIn += segments;
+    pathStatistics.segmentsOut += segments;
+    return;
+  }
+
+  PathSimplifier simplifier(board, netNo, ctrl.traceHalfWidth);
+  simplifier.simplify(points, layers);
+
+  const PathSimplifier::Statistics& stats = simplifier.getStatistics();
+  pathStatistics.segmentsIn += stats.segmentsIn;
+  pathStatistics.segmentsOut += stats.segmentsOut;
+  pathStatistics.cornersCut += stats.cornersCut;
+}
+
+// Helper: Coarse-to-fine grid search on the board's shared obstacle pyramid
+// The board's pyramid and proximity field are brought up to date here, so
+// the router itself only reads them and may run on another thread
+MultiResolutionGridRouter AutorouteEngine::makeGridFallbackRouter(
+    const AutorouteControl& ctrl, const Stoppable* stoppable) {
+
+  // Level-0 cells are one trace pitch wide; items grow by half width + clearance
+  int halfWidth = ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[0];
+  int clearance = board->getClearanceMatrix().getValue(1, 1, 0, true);
+  int pitch = 2 * halfWidth + clearance;
+  ObstaclePyramid& pyramid = board->getObstaclePyramid(pitch, halfWidth + clearance);
+
+  MultiResolutionGridRouter::Config config;
+  config.viaCost = 10.0 * pitch;  // A via is worth about ten cells of detour
+  config.maxExpansions = ctrl.maxIterations;
+  if (ctrl.proximityCostWeight > 0.0 && ctrl.proximityRange > 0) {
+    config.proximity = &board->getProximityField(halfWidth, ctrl.proximityRange);
+    config.proximityWeight = ctrl.proximityCostWeight;
+  }
+  config.stoppable = stoppable;
+  if (std::find(ctrl.layerActive.begin(), ctrl.layerActive.end(), false) != ctrl.layerActive.end()) {
+    config.layerActive = ctrl.layerActive;
+  }
+
+  return MultiResolutionGridRouter(pyramid, config);
+}
+
+MultiResolutionGridRouter::Endpoint AutorouteEngine::gridEndpoint(
+    Item* item, const AutorouteControl& ctrl) {
+
+  IntBox box = item->getBoundingBox();
+  IntPoint center((box.ll.x + box.ur.x) / 2, (box.ll.y + box.ur.y) / 2);
+  MultiResolutionGridRouter::Endpoint endpoint{center, box, item->firstLayer(), item->lastLayer()};
+
+  // A pin boxed in on every layer keeps them all; ripup may free one
+  const auto* drillItem = dynamic_cast<const DrillItem*>(item);
+  if (ctrl.usePinAccess && drillItem) {
+    int halfWidth = ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[0];
+    int clearance = board->getClearanceMatrix().getValue(1, 1, 0, true);
+    LayerMask access = board->getPinAccess(halfWidth, clearance).accessLayers(*drillItem);
+    if (access != 0) {
+      endpoint.accessLayers = access;
+    }
+  }
+  return endpoint;
+}
+
+bool AutorouteEngine::findGridFallbackPath(
+    const MultiResolutionGridRouter& router,
+    const MultiResolutionGridRouter::Endpoint& start,
+    const MultiResolutionGridRouter::Endpoint& goal,
+    std::vector<IntPoint>& points, std::vector<int>& layers) const {
+
+  auto gridResult = router.findPath(start, goal, netNo);
+  if (!gridResult.found) {
+    return false;
+  }
+
+  points = std::move(gridResult.pathPoints);
+  layers = std::move(gridResult.pathLayers);
+  return true;
+}
+
+// The maze search keeps running on this thread (its element pool is thread
+// local); the grid router only reads the board and its prepared pyramid.
+// Whichever finishes first with a path stops the other through the shared
+// RaceStoppable, unless the other also finishes within the grace period.
+bool AutorouteEngine::raceSearches(
+    MazeSearchAlgo& mazeSearch, const MultiResolutionGridRouter::Endpoint& start,
+    const MultiResolutionGridRouter::Endpoint& goal,
+    const AutorouteControl& ctrl, std::vector<IntPoint>& points,
+    std::vector<int>& layers, bool& gridWon) {
+
+  RaceStoppable raceStop(stoppableThread);
+  MultiResolutionGridRouter router = makeGridFallbackRouter(ctrl, &raceStop);
+
+  const auto grace = std::chrono::milliseconds(ctrl.raceGraceMs);
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool mazeDone = false;
+  bool gridDone = false;
+  bool gridFound = false;
+  std::vector<IntPoint> gridPoints;
+  std::vector<int> gridLayers;
+
+  std::thread gridThread([&] {
+    bool found = findGridFallbackPath(router, start, goal, gridPoints, gridLayers);
+    std::unique_lock<std::mutex> lock(mutex);
+    gridDone = true;
+    gridFound = found;
+    finished.notify_all();
+    if (found) {
+      finished.wait_for(lock, grace, [&] { return mazeDone; });
+      raceStop.requestStop();
+    }
+  });
+
+  Stoppable* callerStop = stoppableThread;
+  stoppableThread = &raceStop;
+  MazeSearchAlgo::Result mazeResult = mazeSearch.findConnection();
+  stoppableThread = callerStop;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    mazeDone = true;
+    finished.notify_all();
+    if (mazeResult.found) {
+      finished.wait_for(lock, grace, [&] { return gridDone; });
+      raceStop.requestStop();
+    }
+  }
+  gridThread.join();
+
+  double viaCost = router.getConfig().viaCost;
+  gridWon = gridFound &&
+            (!mazeResult.found ||
+             pathCost(gridPoints, gridLayers, viaCost) <
+             pathCost(mazeResult.pathPoints, mazeResult.pathLayers, viaCost));
+
+  if (gridWon) {
+    points = std::move(gridPoints);
+    layers = std::move(gridLayers);
+    return true;
+  }
+  if (mazeResult.found) {
+    points = std::move(mazeResult.pathPoints);
+    layers = std::move(mazeResult.pathLayers);
+    return true;
+  }
+  return false;
+}
+
 // Helper: Create direct route (fallback when pathfinding fails)
 AutorouteEngine::AutorouteResult AutorouteEngine::createDirectRoute(
     IntPoint start, IntPoint goal, int layer, const AutorouteControl& ctrl,
@@ -265,13 +538,18 @@ AutorouteEngine::AutorouteResult AutorouteEngine::createDirectRoute(
 
 // Helper: Create traces from path points
 AutorouteEngine::AutorouteResult AutorouteEngine::createTracesFromPath(
-    const std::vector<IntPoint>& points, int layer, const AutorouteControl& ctrl,
+    const std::vector<IntPoint>& pathPoints, int layer, const AutorouteControl& ctrl,
     int ripupCostLimit, std::vector<Item*>& rippedItems) {
 
-  if (points.size() < 2) {
+  if (pathPoints.size() < 2) {
     return AutorouteResult::NotRouted;
   }
 
+  // Fewer segments also means fewer conflict checks below
+  std::vector<IntPoint> points = pathPoints;
+  std::vector<int> layers(points.size(), layer);
+  simplifyPath(points, layers, ctrl);
+
   // Get trace half-width from control
   int halfWidth = ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[layer];
   std::vector<int> nets{netNo};
@@ -365,15 +643,9 @@ AutorouteEngine::AutorouteResult AutorouteEngine::tryRouteWithViaAt(
     std::vector<int> nets{netNo};
     int viaId = board->generateItemId();
 
-    // Create padstack for via (simplified - fixed layers from/to)
-    Padstack* padstack = new Padstack(
-      "via_" + std::to_string(viaId),
-      viaId,
-      std::min(startLayer, destLayer),  // fromLayer
-      std::max(startLayer, destLayer),  // toLayer
-      true,   // attachAllowed
-      false   // placedAbsolute
-    );
+    // Shared padstack for the layer range (simplified - fixed layers from/to)
+    const Padstack* padstack = board->getPadstack(
+      "via", std::min(startLayer, destLayer), std::max(startLayer, destLayer));
 
     auto via = std::make_unique<Via>(
       viaLocation, padstack, nets, ctrl.viaClearanceClass, viaId,
@@ -445,40 +717,21 @@ std::vector<Item*> AutorouteEngine::findConflictingItems(
     traceBox.ur.y + requiredClearance
   );
 
-  // Query the shape tree for potential conflicts
-  const auto& items = board->getShapeTree().queryRegion(queryBox);
-
-  // Check each item for actual conflicts
-  for (Item* item : items) {
-    if (!item) continue;
-
-    // Skip items on different layers
-    if (item->lastLayer() < layer || item->firstLayer() > layer) {
-      continue;
-    }
-
-    // Skip items on the same net (they're not obstacles)
-    const auto& itemNets = item->getNets();
-    if (std::find(itemNets.begin(), itemNets.end(), netNo) != itemNets.end()) {
-      continue;
-    }
-
-    // NOTE: We do NOT skip fixed items here - they are obstacles that must be
-    // respected. The ripupConflicts() function will handle them (and fail to
-    // ripup them, preventing the trace from being placed).
-
-    // Check if bounding boxes overlap (accounting for clearance)
-    // Note: We already expanded traceBox by requiredClearance when querying
-    // the shape tree, so we just need to check if the expanded box (queryBox)
-    // intersects with the item's bounding box
-    IntBox itemBox = item->getBoundingBox();
-
-    // Check if expanded box overlaps with item
-    if (queryBox.intersects(itemBox)) {
-      conflicts.push_back(item);
-    }
+  // Nothing of another net near the whole box: no need for the index
+  if (const OccupancyPyramid* occupancy = board->findOccupancy();
+      occupancy && occupancy->probeBox(traceBox, layer, netNo, requiredClearance) ==
+                     OccupancyPyramid::State::Empty) {
+    return conflicts;
   }
 
+  // Items of other nets on this layer whose boxes reach into the clearance
+  // zone; the index rejects same-net and non-overlapping items from its
+  // records, without touching them
+  // NOTE: We do NOT skip fixed items here - they are obstacles that must be
+  // respected. The ripupConflicts() function will handle them (and fail to
+  // ripup them, preventing the trace from being placed).
+  conflicts = board->getShapeTree().findTraceObstacles(netNo, queryBox, layer, layer);
+
   return conflicts;
 }
 
@@ -703,6 +956,11 @@ CompleteFreeSpaceExpansionRoom* AutorouteEngine::completeExpansionRoom(
   auto* completePtr = completeRoom.get();
   completeExpansionRooms.push_back(std::move(completeRoom));
 
+  if (searchCapture && completePtr->getShape()) {
+    searchCapture->addRoom(completePtr->getShape()->getBoundingBox(),
+                           completePtr->getLayer(), expansionRoomInstanceCount);
+  }
+
   // Remove the incomplete room (after we're done using it)
   removeIncompleteExpansionRoom(incompleteRoom);
 
@@ -753,6 +1011,20 @@ void AutorouteEngine::clearRoomGenerators() {
   roomGenerators.clear();
 }
 
+void AutorouteEngine::RoomCache::evict() {
+  engine.clear();
+  engine.clearRoomGenerators();
+}
+
+void AutorouteEngine::updateRoomMemory(double searchMs) {
+  size_t bytes = completeExpansionRooms.size() * sizeof(CompleteFreeSpaceExpansionRoom) +
+                 incompleteExpansionRooms.size() * sizeof(IncompleteFreeSpaceExpansionRoom);
+  for (const auto& [net, generator] : roomGenerators) {
+    bytes += generator->memoryBytes();
+  }
+  MemoryBudget::instance().update(&roomCache, bytes, searchMs);
+}
+
 void AutorouteEngine::completeNeighbourRooms(ExpansionRoom* room) {
   // Complete all neighbour rooms to ensure doors don't change during expansion
   // Java: AutorouteEngine.complete_neighbour_rooms()
@@ -814,7 +1086,7 @@ void AutorouteEngine::calculateDoors(ObstacleExpansionRoom* room) {
   (void)result;
 }
 
-void AutorouteEngine::initializeSearchTree() {
+void AutorouteEngine::initializeSearchTree(const IntBox& window) {
   // Java: AutorouteEngine constructor inserts all board items into search tree
   // This is critical for door generation to work - rooms need to find items
   // to create obstacle rooms and doors
@@ -832,13 +1104,22 @@ void AutorouteEngine::initializeSearchTree() {
 
   // Insert ALL board items into search tree (pads, pins, vias, traces)
   // Everything is a potential obstacle or target for routing
-  const auto& items = board->getItems();
-
-  for (const auto& itemPtr : items) {
-    if (itemPtr) {
-      autorouteSearchTree->insert(itemPtr.get());
+  // Built in one go so the tree comes out balanced
+  std::vector<SearchTreeObject*> objects;
+  if (!window.isEmpty()) {
+    for (Item* item : board->getShapeTree().queryRegion(window)) {
+      objects.push_back(item);
+    }
+  } else {
+    const auto& items = board->getItems();
+    objects.reserve(items.size());
+    for (const auto& itemPtr : items) {
+      if (itemPtr) {
+        objects.push_back(itemPtr.get());
+      }
     }
   }
+  autorouteSearchTree->insertAll(objects);
 }
 
 } // namespace freerouting
@@ -4,10 +4,14 @@
 #include "autoroute/MSTRouter.h"
 #include "board/Item.h"
 #include "board/Trace.h"
+#include "board/Via.h"
+#include "geometry/CollisionDetector.h"
+#include "geometry/HilbertCurve.h"
 #include <algorithm>
 #include <cmath>
 #include <set>
 #include <map>
+#include <unordered_set>
 
 namespace freerouting {
 
@@ -36,6 +40,7 @@ bool BatchAutorouter::runBatchLoop(Stoppable* stoppableThread) {
 
 bool BatchAutorouter::autoroutePass(int passNumber, Stoppable* stoppableThread) {
   this->stoppable = stoppableThread;
+  auto passStart = std::chrono::steady_clock::now();
 
   // Get IDs of items that need routing
   std::vector<int> itemIdsToRoute = getAutorouteItemIds();
@@ -48,6 +53,10 @@ bool BatchAutorouter::autoroutePass(int passNumber, Stoppable* stoppableThread)
     lastPassStats.itemsFailed = 0;
     lastPassStats.itemsSkipped = 0;
     lastPassStats.incompleteConnections = 0;
+    lastPassStats.passDurationMs = 0.0;
+    lastPassStats.connectionsAttempted = 0;
+    lastPassStats.connectionTimeMs = 0.0;
+    lastPassStats.maxConnectionTimeMs = 0.0;
     if (progressDisplay) {
       progressDisplay->message("All connections routed!", true);
     }
@@ -61,6 +70,9 @@ bool BatchAutorouter::autoroutePass(int passNumber, Stoppable* stoppableThread)
   lastPassStats.itemsFailed = 0;
   lastPassStats.itemsSkipped = 0;
   lastPassStats.itemsRipped = 0;
+  lastPassStats.connectionsAttempted = 0;
+  lastPassStats.connectionTimeMs = 0.0;
+  lastPassStats.maxConnectionTimeMs = 0.0;
 
   if (progressDisplay) {
     progressDisplay->startPass(passNumber);
@@ -83,32 +95,13 @@ bool BatchAutorouter::autoroutePass(int passNumber, Stoppable* stoppableThread)
   }
 
   // Sort nets by complexity (simple nets first for better board utilization)
-  // Priority: 2-pad nets → 3-5 pad nets → larger nets
   std::vector<std::pair<int, std::vector<int>>> sortedNets(
     itemIdsByNet.begin(), itemIdsByNet.end());
+  sortNetsForRouting(sortedNets);
 
-  std::sort(sortedNets.begin(), sortedNets.end(),
-    [](const auto& a, const auto& b) {
-      size_t sizeA = a.second.size();
-      size_t sizeB = b.second.size();
-
-      // Priority categories: 2-pad (highest), 3-5 pad (medium), >5 pad (lowest)
-      auto getPriority = [](size_t size) {
-        if (size <= 2) return 0;  // Highest priority
-        if (size <= 5) return 1;  // Medium priority
-        return 2;                 // Lowest priority
-      };
-
-      int priorityA = getPriority(sizeA);
-      int priorityB = getPriority(sizeB);
-
-      if (priorityA != priorityB) {
-        return priorityA < priorityB;  // Lower number = higher priority
-      }
-
-      // Within same priority, route smaller nets first
-      return sizeA < sizeB;
-    });
+  if (config.assignLayers) {
+    assignLayers();
+  }
 
   // Route each net in optimal order
   for (const auto& netPair : sortedNets) {
@@ -216,6 +209,9 @@ bool BatchAutorouter::autoroutePass(int passNumber, Stoppable* stoppableThread)
     removeTails();
   }
 
+  lastPassStats.passDurationMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - passStart).count();
+
   // Check if we should continue routing:
   // - Continue if we routed anything this pass (made progress)
   // - Stop if we didn't route anything (no progress)
@@ -240,25 +236,9 @@ AutorouteAttemptResult BatchAutorouter::autorouteItem(
   }
 
   // Check if this is a power/ground net - skip for now (needs special handling)
-  const Nets* nets = board->getNets();
-  if (nets) {
-    const Net* net = nets->getNet(netNo);
-    if (net) {
-      std::string netName = net->getName();
-      // Skip power/ground nets (common patterns)
-      if (netName == "GND" || netName == "GNDA" || netName == "GNDD" ||
-          netName == "VCC" || netName == "VDD" || netName == "VSS" ||
-          netName == "VBUS" ||
-          netName.find("GND") != std::string::npos ||
-          netName.find("+3V") != std::string::npos ||
-          netName.find("+5V") != std::string::npos ||
-          netName.find("+12V") != std::string::npos ||
-          netName.find("-12V") != std::string::npos ||
-          netName.find("VA") != std::string::npos) {
-        return AutorouteAttemptResult(AutorouteAttemptState::Skipped,
-          "Power/ground net (needs copper pour)");
-      }
-    }
+  if (isPowerNet(netNo)) {
+    return AutorouteAttemptResult(AutorouteAttemptState::Skipped,
+      "Power/ground net (needs copper pour)");
   }
 
   // Find incomplete connections for this item and net
@@ -306,9 +286,12 @@ AutorouteAttemptResult BatchAutorouter::autorouteItem(
   }
 
   // Use AutorouteEngine for pathfinding with obstacle avoidance
+  auto connectionStart = std::chrono::steady_clock::now();
   AutorouteEngine engine(board);
   engine.initConnection(netNo, nullptr, nullptr);
   engine.initializeSearchTree();  // Populate search tree with board items (after initConnection clears it)
+  SearchCapture* capture = beginCapture(netNo, ripupPassNo);
+  engine.setSearchCapture(capture);
 
   // Create AutorouteControl with routing parameters
   AutorouteControl control(board->getLayers().count());
@@ -323,6 +306,15 @@ AutorouteAttemptResult BatchAutorouter::autorouteItem(
   control.ripupAllowed = true;
   control.ripupCosts = config.startRipupCosts * std::max(1, ripupPassNo);  // Increase cost with passes
   control.ripupPassNo = ripupPassNo;
+  control.proximityCostWeight = config.proximityCostWeight;
+  control.proximityRange = config.proximityRange;
+  control.raceSearches = config.raceSearches && ripupPassNo >= config.raceFromPass;
+  control.raceGraceMs = config.raceGraceMs;
+  control.simplifyPaths = config.simplifyPaths;
+  control.usePinAccess = config.usePinAccess;
+  control.useOccupancyFilter = config.useOccupancyFilter;
+  applyCostSettings(control);
+  applyLayerAssignment(control, item, targetItem, netNo);
 
   // Adjust iteration limit based on net complexity (count connections on this net)
   int netConnectionCount = 0;
@@ -332,10 +324,11 @@ AutorouteAttemptResult BatchAutorouter::autorouteItem(
     }
   }
 
-  // Dynamic iteration limit: base 50k + 5k per connection (sqrt scaling for large nets)
-  // For GND with ~282 connections: 50k + 5k*sqrt(282) ≈ 50k + 84k = 134k
-  // For simple 2-pad net: 50k + 5k*sqrt(1) = 55k
-  control.maxIterations = 50000 + static_cast<int>(5000 * std::sqrt(std::max(1, netConnectionCount)));
+  // Dynamic iteration limit: base + per connection (sqrt scaling for large nets)
+  // With the default 50k + 5k: GND with ~282 connections gets
+  // 50k + 5k*sqrt(282) ≈ 134k, a simple 2-pad net 50k + 5k*sqrt(1) = 55k
+  control.maxIterations = config.maxIterationsBase +
+    static_cast<int>(config.maxIterationsPerConnection * std::sqrt(std::max(1, netConnectionCount)));
 
   // Prepare start and destination sets
   std::vector<Item*> startSet{item};
@@ -343,6 +336,8 @@ AutorouteAttemptResult BatchAutorouter::autorouteItem(
 
   // Call the pathfinding algorithm
   auto result = engine.autorouteConnection(startSet, destSet, control, rippedItems);
+  recordConnectionTime(connectionStart, engine);
+  finishCapture(capture);
 
   // Mark connection as routed if successful
   if (result == AutorouteEngine::AutorouteResult::Routed) {
@@ -377,25 +372,9 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
   }
 
   // Check if this is a power/ground net - skip for now
-  const Nets* nets = board->getNets();
-  if (nets) {
-    const Net* net = nets->getNet(netNo);
-    if (net) {
-      std::string netName = net->getName();
-      // Skip power/ground nets (common patterns)
-      if (netName == "GND" || netName == "GNDA" || netName == "GNDD" ||
-          netName == "VCC" || netName == "VDD" || netName == "VSS" ||
-          netName == "VBUS" ||
-          netName.find("GND") != std::string::npos ||
-          netName.find("+3V") != std::string::npos ||
-          netName.find("+5V") != std::string::npos ||
-          netName.find("+12V") != std::string::npos ||
-          netName.find("-12V") != std::string::npos ||
-          netName.find("VA") != std::string::npos) {
-        return AutorouteAttemptResult(AutorouteAttemptState::Skipped,
-          "Power/ground net (needs copper pour)");
-      }
-    }
+  if (isPowerNet(netNo)) {
+    return AutorouteAttemptResult(AutorouteAttemptState::Skipped,
+      "Power/ground net (needs copper pour)");
   }
 
   // Build MST for this net, but store INDICES not pointers
@@ -453,9 +432,12 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
     }
 
     // Use AutorouteEngine for pathfinding
+    auto connectionStart = std::chrono::steady_clock::now();
     AutorouteEngine engine(board);
     engine.initConnection(netNo, nullptr, nullptr);
     engine.initializeSearchTree();  // Populate search tree with board items (after initConnection clears it)
+    SearchCapture* capture = beginCapture(netNo, ripupPassNo);
+    engine.setSearchCapture(capture);
 
     // Create AutorouteControl with routing parameters
     AutorouteControl control(board->getLayers().count());
@@ -469,6 +451,14 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
     control.ripupAllowed = true;
     control.ripupCosts = config.startRipupCosts * std::max(1, ripupPassNo);
     control.ripupPassNo = ripupPassNo;
+    control.proximityCostWeight = config.proximityCostWeight;
+    control.proximityRange = config.proximityRange;
+    control.raceSearches = config.raceSearches && ripupPassNo >= config.raceFromPass;
+    control.raceGraceMs = config.raceGraceMs;
+    control.simplifyPaths = config.simplifyPaths;
+    control.usePinAccess = config.usePinAccess;
+    control.useOccupancyFilter = config.useOccupancyFilter;
+    applyCostSettings(control);
 
     // Dynamic iteration limit based on net complexity
     const auto& connections = board->getIncompleteConnections();
@@ -478,7 +468,8 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
         netConnectionCount++;
       }
     }
-    control.maxIterations = 50000 + static_cast<int>(5000 * std::sqrt(std::max(1, netConnectionCount)));
+    control.maxIterations = config.maxIterationsBase +
+      static_cast<int>(config.maxIterationsPerConnection * std::sqrt(std::max(1, netConnectionCount)));
 
     // Get FRESH pointers right before routing (critical!)
     // Don't use stored pointers as they may have been invalidated by previous routing
@@ -489,6 +480,7 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
       failedEdges++;
       continue;
     }
+    applyLayerAssignment(control, fromItem, toItem, netNo);
 
     // Route this edge
     std::vector<Item*> startSet{fromItem};
@@ -496,6 +488,8 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
     std::vector<Item*> rippedItems;
 
     auto result = engine.autorouteConnection(startSet, destSet, control, rippedItems);
+    recordConnectionTime(connectionStart, engine);
+    finishCapture(capture);
 
     if (result == AutorouteEngine::AutorouteResult::Routed ||
         result == AutorouteEngine::AutorouteResult::AlreadyConnected) {
@@ -519,6 +513,249 @@ AutorouteAttemptResult BatchAutorouter::autorouteNetWithMST(
   }
 }
 
+void BatchAutorouter::sortNetsForRouting(
+    std::vector<std::pair<int, std::vector<int>>>& nets) const {
+
+  // Priority categories: 2-pad (highest), 3-5 pad (medium), >5 pad (lowest)
+  auto getPriority = [](size_t size) {
+    if (size <= 2) return 0;  // Highest priority
+    if (size <= 5) return 1;  // Medium priority
+    return 2;                 // Lowest priority
+  };
+
+  if (config.connectionOrder == Config::ConnectionOrder::NetSize || !board) {
+    std::stable_sort(nets.begin(), nets.end(),
+      [&getPriority](const auto& a, const auto& b) {
+        size_t sizeA = a.second.size();
+        size_t sizeB = b.second.size();
+
+        int priorityA = getPriority(sizeA);
+        int priorityB = getPriority(sizeB);
+
+        if (priorityA != priorityB) {
+          return priorityA < priorityB;  // Lower number = higher priority
+        }
+
+        // Within same priority, route smaller nets first
+        return sizeA < sizeB;
+      });
+    return;
+  }
+
+  // Hilbert ordering: consecutive nets are spatially close, so the search
+  // tree nodes, rooms and drill pages touched by one connection are still
+  // warm in cache for the next one
+  struct LocalityKey {
+    int priority;
+    int layer;      // Layer most of the net's items start on
+    u64 curveIndex; // Hilbert index of the net's bbox center
+  };
+
+  const int layerCount = std::max(1, board->getLayers().count());
+  std::vector<IntBox> netBoxes(nets.size());
+  std::vector<int> netLayers(nets.size(), 0);
+  IntBox bounds = IntBox::empty();
+
+  for (size_t i = 0; i < nets.size(); ++i) {
+    std::vector<int> layerVotes(layerCount, 0);
+    IntBox netBox = IntBox::empty();
+
+    for (int itemId : nets[i].second) {
+      Item* item = board->getItem(itemId);
+      if (!item) continue;
+
+      netBox = netBox.unionWith(item->getBoundingBox());
+      int layer = std::clamp(item->firstLayer(), 0, layerCount - 1);
+      ++layerVotes[layer];
+    }
+
+    netBoxes[i] = netBox;
+    netLayers[i] = static_cast<int>(
+      std::max_element(layerVotes.begin(), layerVotes.end()) - layerVotes.begin());
+    bounds = bounds.unionWith(netBox);
+  }
+
+  std::vector<std::pair<LocalityKey, size_t>> keyed;
+  keyed.reserve(nets.size());
+  for (size_t i = 0; i < nets.size(); ++i) {
+    u64 curveIndex = 0;
+    if (!netBoxes[i].isEmpty()) {
+      FloatPoint c = netBoxes[i].center();
+      curveIndex = HilbertCurve::indexInBox(
+        IntPoint(static_cast<int>(c.x), static_cast<int>(c.y)), bounds);
+    }
+    keyed.push_back({{getPriority(nets[i].second.size()), netLayers[i], curveIndex}, i});
+  }
+
+  std::stable_sort(keyed.begin(), keyed.end(),
+    [](const auto& a, const auto& b) {
+      if (a.first.priority != b.first.priority) {
+        return a.first.priority < b.first.priority;
+      }
+      if (a.first.layer != b.first.layer) {
+        return a.first.layer < b.first.layer;
+      }
+      return a.first.curveIndex < b.first.curveIndex;
+    });
+
+  std::vector<std::pair<int, std::vector<int>>> ordered;
+  ordered.reserve(nets.size());
+  for (const auto& entry : keyed) {
+    ordered.push_back(std::move(nets[entry.second]));
+  }
+  nets = std::move(ordered);
+}
+
+void BatchAutorouter::recordConnectionTime(std::chrono::steady_clock::time_point start,
+                                           const AutorouteEngine& engine) {
+  double elapsedMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+
+  ++lastPassStats.connectionsAttempted;
+  lastPassStats.connectionTimeMs += elapsedMs;
+  lastPassStats.maxConnectionTimeMs = std::max(lastPassStats.maxConnectionTimeMs, elapsedMs);
+  lastPassStats.pathSegmentsFound += engine.getPathStatistics().segmentsIn;
+  lastPassStats.pathSegmentsInserted += engine.getPathStatistics().segmentsOut;
+}
+
+void BatchAutorouter::applyCostSettings(AutorouteControl& control) const {
+  control.minNormalViaCost = config.viaCost;
+  control.minCheapViaCost = config.viaCost / 2.0;
+
+  // With preferred directions, even layers run horizontal and odd layers
+  // vertical; against the preferred direction costs traceCostAgainst
+  for (int i = 0; i < control.layerCount; ++i) {
+    if (!config.withPreferredDirections) {
+      control.traceCosts[i] = AutorouteControl::ExpansionCostFactor(
+        config.traceCostPreferred, config.traceCostPreferred);
+    } else if (i % 2 == 0) {
+      control.traceCosts[i] = AutorouteControl::ExpansionCostFactor(
+        config.traceCostPreferred, config.traceCostAgainst);
+    } else {
+      control.traceCosts[i] = AutorouteControl::ExpansionCostFactor(
+        config.traceCostAgainst, config.traceCostPreferred);
+    }
+  }
+}
+
+bool BatchAutorouter::isPowerNet(int netNo) const {
+  const Nets* nets = board->getNets();
+  if (!nets) {
+    return false;
+  }
+  const Net* net = nets->getNet(netNo);
+  if (!net) {
+    return false;
+  }
+
+  // Common power/ground name patterns
+  std::string netName = net->getName();
+  return netName == "GND" || netName == "GNDA" || netName == "GNDD" ||
+         netName == "VCC" || netName == "VDD" || netName == "VSS" ||
+         netName == "VBUS" ||
+         netName.find("GND") != std::string::npos ||
+         netName.find("+3V") != std::string::npos ||
+         netName.find("+5V") != std::string::npos ||
+         netName.find("+12V") != std::string::npos ||
+         netName.find("-12V") != std::string::npos ||
+         netName.find("VA") != std::string::npos;
+}
+
+void BatchAutorouter::assignLayers() {
+  auto center = [](const IntBox& box) {
+    return IntPoint((box.ll.x + box.ur.x) / 2, (box.ll.y + box.ur.y) / 2);
+  };
+
+  std::vector<LayerAssignment::Connection> connections;
+  for (const auto& conn : board->getIncompleteConnections()) {
+    const Item* from = conn.getFromItem();
+    const Item* to = conn.getToItem();
+    if (conn.isRouted() || !from || !to || isPowerNet(conn.getNetNumber())) {
+      continue;
+    }
+    connections.push_back({conn.getNetNumber(), from->getId(), to->getId(),
+                           center(from->getBoundingBox()), center(to->getBoundingBox()),
+                           from->firstLayer(), from->lastLayer(),
+                           to->firstLayer(), to->lastLayer()});
+  }
+
+  // Same track pitch as the grid router: default trace width plus clearance
+  LayerAssignment::Config assignmentConfig;
+  assignmentConfig.pitch = 2 * 1250 + board->getClearanceMatrix().getValue(1, 1, 0, true);
+  assignmentConfig.withPreferredDirections = config.withPreferredDirections;
+  layerAssignment = LayerAssignment(assignmentConfig);
+  layerAssignment.solve(*board, connections);
+
+  if (progressDisplay && !layerAssignment.isEmpty()) {
+    const auto& stats = layerAssignment.getStatistics();
+    progressDisplay->message("Layer assignment: " + std::to_string(stats.connections) +
+      " connections, " + std::to_string(stats.candidatePairs) + " layer pairs, overflow " +
+      std::to_string(stats.initialOverflow) + " -> " + std::to_string(stats.finalOverflow) +
+      " in " + std::to_string(stats.rounds) + " rounds");
+  }
+}
+
+void BatchAutorouter::applyLayerAssignment(AutorouteControl& control, const Item* fromItem,
+                                           const Item* toItem, int netNo) const {
+  if (!config.assignLayers || layerAssignment.isEmpty()) {
+    return;
+  }
+  LayerAssignment::LayerPair pair =
+    layerAssignment.pairFor(fromItem->getId(), toItem->getId(), netNo);
+  if (!pair.isValid()) {
+    return;
+  }
+
+  std::vector<bool> active(control.layerCount, false);
+  active[pair.horizontal] = true;
+  active[pair.vertical] = true;
+
+  // An endpoint on neither layer escapes on its own layer nearest the pair
+  for (const Item* item : {fromItem, toItem}) {
+    int first = std::max(0, item->firstLayer());
+    int last = std::min(control.layerCount - 1, item->lastLayer());
+    bool touchesPair = (pair.horizontal >= first && pair.horizontal <= last) ||
+                       (pair.vertical >= first && pair.vertical <= last);
+    if (touchesPair) continue;
+    active[std::clamp(std::min(pair.horizontal, pair.vertical), first, last)] = true;
+  }
+
+  for (int i = 0; i < control.layerCount; ++i) {
+    active[i] = active[i] && control.layerActive[i];
+  }
+  control.fallbackLayerActive = control.layerActive;
+  control.layerActive = active;
+}
+
+SearchCapture* BatchAutorouter::beginCapture(int netNo, int passNo) {
+  if (captureWritten || netNo != config.captureNetNo || passNo != config.capturePass) {
+    return nullptr;
+  }
+  if (captureSearchesSeen++ != config.captureConnection) {
+    return nullptr;
+  }
+
+  activeCapture = std::make_unique<SearchCapture>();
+  activeCapture->begin(*board, netNo, passNo);
+  return activeCapture.get();
+}
+
+void BatchAutorouter::finishCapture(SearchCapture* capture) {
+  if (!capture || capture != activeCapture.get()) {
+    return;
+  }
+
+  captureWritten = true;
+  if (capture->writeToFile(config.captureFile)) {
+    if (progressDisplay) {
+      progressDisplay->message("Search capture written to " + config.captureFile, true);
+    }
+  } else {
+    std::cerr << "Warning: Failed to write search capture " << config.captureFile << std::endl;
+  }
+  activeCapture.reset();
+}
+
 double BatchAutorouter::calculateAirlineDistance(
     const std::vector<Item*>& fromSet,
     const std::vector<Item*>& toSet) const {
@@ -567,14 +804,106 @@ std::vector<int> BatchAutorouter::getAutorouteItemIds() {
   return result;
 }
 
+// A trace end that touches no other copper of its net, or a via joined to
+// its net on fewer than two layers, carries no current; removing one can
+// leave the item before it dangling, so its neighbours are checked again.
+// Contacts are looked up in the board's contact index; only points it has
+// nothing at fall back to the spatial index, for traces that end on a
+// pad or via off center or in the middle of another trace.
 void BatchAutorouter::removeTails() {
-  // TODO: Full implementation requires:
-  // 1. Find all trace segments with only one connection (tails)
-  // 2. Find all unconnected vias
-  // 3. Remove these items from the board
-  // 4. Optimize remaining connections
+  const ContactIndex& contacts = board->getContactIndex();
+
+  auto touchesCopper = [&](const Item* self, IntPoint point, int layer, int netNo) {
+    for (const Item* other : contacts.at(point, layer)) {
+      if (other != self && other->containsNet(netNo)) {
+        return true;
+      }
+    }
+    for (const Item* other : board->getShapeTree().findItemsByNet(netNo, IntBox::fromPoint(point))) {
+      if (other == self || layer < other->firstLayer() || layer > other->lastLayer()) {
+        continue;
+      }
+      const Trace* trace = dynamic_cast<const Trace*>(other);
+      if (!trace ||
+          CollisionDetector::pointSegmentDistance(point, trace->getStart(), trace->getEnd()) <=
+            trace->getHalfWidth()) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // A trace joins a via wherever it reaches the via's pad, not only at
+  // its center; other copper of the net overlapping the pad joins it too
+  auto joinsVia = [&](const Via* via, int layer, int netNo) {
+    for (const Item* other : contacts.at(via->getCenter(), layer)) {
+      if (other != via && other->containsNet(netNo)) {
+        return true;
+      }
+    }
+    const IntBox pad = via->getBoundingBox();
+    for (const Item* other : board->getShapeTree().findItemsByNet(netNo, pad)) {
+      if (other == via || layer < other->firstLayer() || layer > other->lastLayer()) {
+        continue;
+      }
+      const Trace* trace = dynamic_cast<const Trace*>(other);
+      if (!trace || CollisionDetector::segmentBoxIntersect(trace->getStart(), trace->getEnd(),
+                                                           pad.expand(trace->getHalfWidth()))) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  auto isTail = [&](const Item* item) {
+    const int netNo = item->getNets().front();
+    if (const Trace* trace = dynamic_cast<const Trace*>(item)) {
+      return !touchesCopper(trace, trace->getStart(), trace->getLayer(), netNo) ||
+             !touchesCopper(trace, trace->getEnd(), trace->getLayer(), netNo);
+    }
+    const Via* via = static_cast<const Via*>(item);
+    int joinedLayers = 0;
+    for (int layer = via->firstLayer(); layer <= via->lastLayer() && joinedLayers < 2; ++layer) {
+      if (joinsVia(via, layer, netNo)) {
+        ++joinedLayers;
+      }
+    }
+    return joinedLayers < 2;
+  };
+
+  auto isRemovable = [](const Item* item) {
+    return item->getFixedState() == FixedState::NotFixed && item->netCount() == 1 &&
+           (dynamic_cast<const Trace*>(item) || dynamic_cast<const Via*>(item));
+  };
+
+  std::vector<Item*> pending;
+  std::unordered_set<Item*> queued;
+  for (const auto& item : board->getItems()) {
+    if (isRemovable(item.get())) {
+      pending.push_back(item.get());
+      queued.insert(item.get());
+    }
+  }
+
+  int removed = 0;
+  while (!pending.empty()) {
+    Item* item = pending.back();
+    pending.pop_back();
+    if (queued.erase(item) == 0 || !isTail(item)) {
+      continue;
+    }
+
+    std::vector<Item*> neighbours = contacts.touching(*item, item->getNets().front());
+    board->removeItem(item);
+    ++removed;
+    for (Item* neighbour : neighbours) {
+      if (isRemovable(neighbour) && queued.insert(neighbour).second) {
+        pending.push_back(neighbour);
+      }
+    }
+  }
 
-  // Stub for now
+  lastPassStats.tailsRemoved += removed;
 }
 
 } // namespace freerouting
@@ -32,6 +32,11 @@ void ExpansionRoomGenerator::cleanup() {
   allDoors_.clear();
 }
 
+size_t ExpansionRoomGenerator::memoryBytes() const {
+  return allRooms_.size() * sizeof(FreeSpaceExpansionRoom) +
+         allDoors_.size() * sizeof(ExpansionDoor);
+}
+
 std::vector<IntBox> ExpansionRoomGenerator::generateGridCells(int layer, int gridSize) {
   std::vector<IntBox> cells;
 
@@ -80,12 +85,16 @@ bool ExpansionRoomGenerator::isFreeSpace(const IntBox& box, int layer) {
   const int samples = 2;
   int dx = (box.ur.x - box.ll.x) / (samples + 1);
   int dy = (box.ur.y - box.ll.y) / (samples + 1);
+  const OccupancyPyramid* occupancy = board_->findOccupancy();
 
   for (int sy = 1; sy <= samples; ++sy) {
     for (int sx = 1; sx <= samples; ++sx) {
       IntPoint p(box.ll.x + sx * dx, box.ll.y + sy * dy);
 
-      // Check if prohibited for this net
+      // Check if prohibited for this net (no keepout near: can't be)
+      if (occupancy && occupancy->isKeepoutFree(p, layer)) {
+        continue;
+      }
       if (board_->isTraceProhibited(p, layer, netNo_)) {
         return false;
       }
@@ -0,0 +1,292 @@
+#include "autoroute/LayerAssignment.h"
+#include "board/RoutingBoard.h"
+#include "core/Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace freerouting {
+
+namespace {
+
+// Below this many connections a round is cheaper than starting threads
+constexpr size_t kParallelConnections = 256;
+
+bool spans(int first, int last, int layer) {
+  return layer >= first && layer <= last;
+}
+
+} // namespace
+
+std::vector<LayerAssignment::LayerPair> LayerAssignment::candidatePairs(
+    const RoutingBoard& board, bool withPreferredDirections) {
+
+  const LayerStructure& layers = board.getLayers();
+  std::vector<int> signal;
+  for (int i = 0; i < layers.count(); ++i) {
+    if (layers[i].isSignal) {
+      signal.push_back(i);
+    }
+  }
+
+  std::vector<LayerPair> pairs;
+  if (withPreferredDirections) {
+    for (int h : signal) {
+      if (h % 2 != 0) continue;
+      for (int v : signal) {
+        if (v % 2 != 0) {
+          pairs.push_back({h, v});
+        }
+      }
+    }
+  }
+  if (pairs.empty()) {
+    // No direction split possible (or wanted): any two signal layers
+    for (size_t a = 0; a < signal.size(); ++a) {
+      for (size_t b = a + 1; b < signal.size(); ++b) {
+        pairs.push_back({signal[a], signal[b]});
+      }
+    }
+  }
+  return pairs;
+}
+
+int LayerAssignment::tileX(int x) const {
+  return std::clamp((x - bounds_.ll.x) / config_.tileSize, 0, tilesX_ - 1);
+}
+
+int LayerAssignment::tileY(int y) const {
+  return std::clamp((y - bounds_.ll.y) / config_.tileSize, 0, tilesY_ - 1);
+}
+
+void LayerAssignment::buildGrid(const RoutingBoard& board) {
+  bounds_ = IntBox::empty();
+  for (const auto& item : board.getItems()) {
+    IntBox box = item->getBoundingBox();
+    bounds_.ll.x = std::min(bounds_.ll.x, box.ll.x);
+    bounds_.ll.y = std::min(bounds_.ll.y, box.ll.y);
+    bounds_.ur.x = std::max(bounds_.ur.x, box.ur.x);
+    bounds_.ur.y = std::max(bounds_.ur.y, box.ur.y);
+  }
+
+  const i64 tile = config_.tileSize;
+  tilesX_ = static_cast<int>(std::max<i64>(1, (static_cast<i64>(bounds_.ur.x) - bounds_.ll.x) / tile + 1));
+  tilesY_ = static_cast<int>(std::max<i64>(1, (static_cast<i64>(bounds_.ur.y) - bounds_.ll.y) / tile + 1));
+  layerCount_ = board.getLayers().count();
+
+  const float tracks = static_cast<float>(config_.tileSize) / static_cast<float>(std::max(1, config_.pitch));
+  capacity_.assign(static_cast<size_t>(layerCount_) * tilesX_ * tilesY_, tracks);
+  history_.assign(capacity_.size(), 0.0f);
+
+  // Existing copper takes its share of every tile it covers
+  const double tileArea = static_cast<double>(tile) * tile;
+  for (const auto& item : board.getItems()) {
+    IntBox box = item->getBoundingBox();
+    int tx0 = tileX(box.ll.x), tx1 = tileX(box.ur.x);
+    int ty0 = tileY(box.ll.y), ty1 = tileY(box.ur.y);
+    int first = std::max(0, item->firstLayer());
+    int last = std::min(layerCount_ - 1, item->lastLayer());
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+      for (int tx = tx0; tx <= tx1; ++tx) {
+        i64 x0 = std::max<i64>(box.ll.x, bounds_.ll.x + tx * tile);
+        i64 x1 = std::min<i64>(box.ur.x, bounds_.ll.x + (tx + 1) * tile);
+        i64 y0 = std::max<i64>(box.ll.y, bounds_.ll.y + ty * tile);
+        i64 y1 = std::min<i64>(box.ur.y, bounds_.ll.y + (ty + 1) * tile);
+        double covered = static_cast<double>(std::max<i64>(0, x1 - x0)) *
+                         static_cast<double>(std::max<i64>(0, y1 - y0)) / tileArea;
+        float taken = static_cast<float>(covered) * tracks;
+        for (int layer = first; layer <= last; ++layer) {
+          float& cap = capacity_[tileIndex(layer, tx, ty)];
+          cap = std::max(0.0f, cap - taken);
+        }
+      }
+    }
+  }
+}
+
+std::pair<LayerAssignment::Leg, LayerAssignment::Leg> LayerAssignment::legsOf(
+    const Connection& connection, bool horizontalFirst) const {
+
+  int fx = tileX(connection.from.x), fy = tileY(connection.from.y);
+  int tx = tileX(connection.to.x), ty = tileY(connection.to.y);
+
+  // The first leg includes the corner tile, the second starts after it
+  if (horizontalFirst) {
+    int step = ty > fy ? 1 : -1;
+    return {Leg{true, fy, fx, tx, false}, Leg{false, tx, fy + step, ty, fy == ty}};
+  }
+  int step = tx > fx ? 1 : -1;
+  return {Leg{false, fx, fy, ty, false}, Leg{true, ty, fx + step, tx, fx == tx}};
+}
+
+template <typename Fn>
+void LayerAssignment::forEachTile(const Connection& connection, const Choice& choice, Fn fn) const {
+  const LayerPair& pair = pairs_[choice.pair];
+  auto [first, second] = legsOf(connection, choice.horizontalFirst);
+  for (const Leg& leg : {first, second}) {
+    if (leg.empty) continue;
+    int layer = leg.horizontal ? pair.horizontal : pair.vertical;
+    int step = leg.to >= leg.from ? 1 : -1;
+    for (int i = leg.from; ; i += step) {
+      fn(leg.horizontal ? tileIndex(layer, i, leg.fixed) : tileIndex(layer, leg.fixed, i));
+      if (i == leg.to) break;
+    }
+  }
+}
+
+double LayerAssignment::choiceCost(const Connection& connection, const Choice& choice,
+                                   const std::vector<float>& usage,
+                                   const std::vector<size_t>& ownTiles) const {
+  double cost = 0.0;
+  forEachTile(connection, choice, [&](size_t index) {
+    double used = usage[index];
+    if (std::binary_search(ownTiles.begin(), ownTiles.end(), index)) {
+      used -= 1.0;
+    }
+    double over = std::max(0.0, used + 1.0 - capacity_[index]);
+    cost += (1.0 + history_[index]) * (1.0 + config_.presentFactor * over);
+  });
+
+  // Vias where the route leaves the start item, at the bend and where it
+  // reaches the destination item
+  const LayerPair& pair = pairs_[choice.pair];
+  auto [first, second] = legsOf(connection, choice.horizontalFirst);
+  int firstLayer = first.horizontal ? pair.horizontal : pair.vertical;
+  int lastLayer = second.empty ? firstLayer : (second.horizontal ? pair.horizontal : pair.vertical);
+  if (!spans(connection.fromFirstLayer, connection.fromLastLayer, firstLayer)) {
+    cost += config_.viaCost;
+  }
+  if (firstLayer != lastLayer) {
+    cost += config_.viaCost;
+  }
+  if (!spans(connection.toFirstLayer, connection.toLastLayer, lastLayer)) {
+    cost += config_.viaCost;
+  }
+  return cost;
+}
+
+int LayerAssignment::overflow(const std::vector<float>& usage) const {
+  double total = 0.0;
+  for (size_t i = 0; i < usage.size(); ++i) {
+    total += std::max(0.0f, usage[i] - capacity_[i]);
+  }
+  return static_cast<int>(std::lround(total));
+}
+
+void LayerAssignment::solve(const RoutingBoard& board, const std::vector<Connection>& connections) {
+  auto start = std::chrono::steady_clock::now();
+  byConnection_.clear();
+  byNet_.clear();
+  stats_ = Statistics();
+  stats_.connections = static_cast<int>(connections.size());
+
+  pairs_ = candidatePairs(board, config_.withPreferredDirections);
+  stats_.candidatePairs = static_cast<int>(pairs_.size());
+  if (pairs_.empty() || connections.empty()) {
+    return;
+  }
+
+  buildGrid(board);
+
+  const size_t count = connections.size();
+  const int options = static_cast<int>(pairs_.size()) * 2;
+  std::vector<Choice> current(count);
+  std::vector<Choice> best;
+  std::vector<float> usage(capacity_.size(), 0.0f);
+  int bestOverflow = std::numeric_limits<int>::max();
+
+  for (int round = 0; round < config_.maxRounds; ++round) {
+    std::vector<Choice> next = current;
+
+    // Each connection against everyone else's previous choice
+    parallelFor(count, count < kParallelConnections ? 1 : threadCount(), [&](size_t i) {
+      const Connection& connection = connections[i];
+      std::vector<size_t> ownTiles;
+      if (round > 0) {
+        // Only connections through overflowing tiles move, and only half
+        // of them per round so that they don't all jump the same way
+        if ((i + static_cast<size_t>(round)) % 2 != 0) return;
+        bool congested = false;
+        forEachTile(connection, current[i], [&](size_t index) {
+          ownTiles.push_back(index);
+          congested = congested || usage[index] > capacity_[index];
+        });
+        if (!congested) return;
+        std::sort(ownTiles.begin(), ownTiles.end());
+      }
+
+      double bestCost = std::numeric_limits<double>::max();
+      Choice bestChoice = current[i];
+      for (int option = 0; option < options; ++option) {
+        Choice choice{option / 2, option % 2 == 0};
+        double cost = choiceCost(connection, choice, usage, ownTiles);
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestChoice = choice;
+        }
+      }
+      next[i] = bestChoice;
+    });
+
+    current = std::move(next);
+    std::fill(usage.begin(), usage.end(), 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+      forEachTile(connections[i], current[i], [&](size_t index) { usage[index] += 1.0f; });
+    }
+
+    int roundOverflow = overflow(usage);
+    ++stats_.rounds;
+    if (round == 0) {
+      stats_.initialOverflow = roundOverflow;
+    }
+    if (roundOverflow < bestOverflow) {
+      bestOverflow = roundOverflow;
+      best = current;
+    }
+    if (roundOverflow == 0) {
+      break;
+    }
+
+    for (size_t i = 0; i < usage.size(); ++i) {
+      if (usage[i] > capacity_[i]) {
+        history_[i] += static_cast<float>(config_.historyIncrement);
+      }
+    }
+  }
+
+  stats_.finalOverflow = bestOverflow;
+
+  std::map<int, std::vector<int>> netVotes;
+  for (size_t i = 0; i < count; ++i) {
+    const Connection& connection = connections[i];
+    const LayerPair& pair = pairs_[best[i].pair];
+    byConnection_[{std::min(connection.fromItemId, connection.toItemId),
+                   std::max(connection.fromItemId, connection.toItemId)}] = pair;
+    auto& votes = netVotes[connection.netNo];
+    votes.resize(pairs_.size(), 0);
+    ++votes[best[i].pair];
+  }
+  for (const auto& [netNo, votes] : netVotes) {
+    auto top = std::max_element(votes.begin(), votes.end());
+    byNet_[netNo] = pairs_[static_cast<size_t>(top - votes.begin())];
+  }
+
+  stats_.solveMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+LayerAssignment::LayerPair LayerAssignment::pairFor(int fromItemId, int toItemId, int netNo) const {
+  auto it = byConnection_.find({std::min(fromItemId, toItemId), std::max(fromItemId, toItemId)});
+  if (it != byConnection_.end()) {
+    return it->second;
+  }
+  auto net = byNet_.find(netNo);
+  if (net != byNet_.end()) {
+    return net->second;
+  }
+  return LayerPair();
+}
+
+} // namespace freerouting
@@ -9,6 +9,9 @@
 #include "autoroute/ExpansionDrill.h"
 #include "autoroute/DrillPage.h"
 #include "autoroute/ExpansionRoomGenerator.h"
+#include "autoroute/PinAccess.h"
+#include "autoroute/ProximityField.h"
+#include "autoroute/SearchCapture.h"
 #include "geometry/IntBoxShape.h"
 #include "board/Item.h"
 #include "board/RoutingBoard.h"
@@ -17,6 +20,7 @@
 #include "board/Trace.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <random>
 #include <vector>
 
@@ -114,6 +118,9 @@ std::unique_ptr<MazeSearchAlgo> MazeSearchAlgo::getInstance(
 MazeSearchAlgo::MazeSearchAlgo(AutorouteEngine* engine, const AutorouteControl& ctrl)
   : autorouteEngine(engine),
     control(ctrl),
+    proximityField(nullptr),
+    searchCapture(engine ? engine->getSearchCapture() : nullptr),
+    pinAccess(nullptr),
     destinationDoor(nullptr),
     sectionNoOfDestinationDoor(0) {
 
@@ -124,6 +131,48 @@ MazeSearchAlgo::MazeSearchAlgo(AutorouteEngine* engine, const AutorouteControl&
     ctrl.minNormalViaCost,
     ctrl.minCheapViaCost
   );
+
+  // Cost field at trace half width resolution, shared across searches
+  if (ctrl.proximityCostWeight > 0.0 && ctrl.proximityRange > 0 && engine && engine->board) {
+    int cellSize = std::max(1, ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[0]);
+    proximityField = &engine->board->getProximityField(cellSize, ctrl.proximityRange);
+  }
+
+  // Access points for the traces of this search
+  if (ctrl.usePinAccess && engine && engine->board) {
+    int halfWidth = ctrl.traceHalfWidth.empty() ? 1250 : ctrl.traceHalfWidth[0];
+    int clearance = engine->board->getClearanceMatrix().getValue(1, 1, 0, true);
+    pinAccess = &engine->board->getPinAccess(halfWidth, clearance);
+  }
+}
+
+std::vector<int> MazeSearchAlgo::entryLayers(const Item& item) const {
+  std::vector<int> layers;
+  const auto* drillItem = dynamic_cast<const DrillItem*>(&item);
+  if (pinAccess && drillItem) {
+    LayerMask mask = pinAccess->accessLayers(*drillItem);
+    for (int layer = item.firstLayer(); layer <= item.lastLayer(); ++layer) {
+      bool active = layer >= static_cast<int>(control.layerActive.size()) || control.layerActive[layer];
+      if (active && (mask & layerBit(layer))) {
+        layers.push_back(layer);
+      }
+    }
+  }
+  if (layers.empty()) {
+    layers.push_back(item.firstLayer());
+  }
+  return layers;
+}
+
+FloatPoint MazeSearchAlgo::startEntry(const Item& item, int layer, IntPoint target) const {
+  const auto* drillItem = dynamic_cast<const DrillItem*>(&item);
+  if (pinAccess && drillItem) {
+    if (const PinAccess::AccessPoint* access = pinAccess->nearest(*drillItem, layer, target)) {
+      return access->point.toDouble();
+    }
+  }
+  IntBox box = item.getBoundingBox();
+  return FloatPoint((box.ll.x + box.ur.x) / 2.0, (box.ll.y + box.ur.y) / 2.0);
 }
 
 bool MazeSearchAlgo::init(
@@ -147,18 +196,26 @@ bool MazeSearchAlgo::init(
   for (Item* item : destItems) {
     item->getAutorouteInfo().setStartInfo(false);
 
-    // Add item bounding box to destination distance calculator
+    // Add item bounding box to destination distance calculator, on each
+    // layer the item can be reached on
     IntBox bbox = item->getBoundingBox();
-    int layer = item->firstLayer();
-
-    destinationDistance->join(bbox, layer);
+    for (int layer : entryLayers(*item)) {
+      destinationDistance->join(bbox, layer);
+    }
   }
+  IntBox destBox = destItems[0]->getBoundingBox();
+  IntPoint destCenter((destBox.ll.x + destBox.ur.x) / 2, (destBox.ll.y + destBox.ur.y) / 2);
 
   // Initialize expansion from start items
   // Java: MazeSearchAlgo.init() lines 1168-1235
 
-  // Create incomplete expansion rooms for each start item
-  std::vector<IncompleteFreeSpaceExpansionRoom*> startRooms;
+  // Create incomplete expansion rooms for each start item, one per layer
+  // it can be left on, each with the point the search enters it from
+  struct StartRoom {
+    IncompleteFreeSpaceExpansionRoom* room;
+    FloatPoint entry;
+  };
+  std::vector<StartRoom> startRooms;
 
   for (Item* item : startItems) {
     if (this->autorouteEngine->isStopRequested()) {
@@ -167,53 +224,54 @@ bool MazeSearchAlgo::init(
 
     // For each item, create an incomplete room
     // Java gets trace_connection_shape from item, we use bounding box for Phase 1
-    int layer = item->firstLayer();
     IntBox itemBox = item->getBoundingBox();
 
-    // PHASE 3C: Create actual room shapes for proper maze search
-    // Create containedShape from item bounding box (what must stay in the room)
-    const Shape* containedShape = new IntBoxShape(itemBox);
+    for (int layer : entryLayers(*item)) {
+      // PHASE 3C: Create actual room shapes for proper maze search
+      // Create containedShape from item bounding box (what must stay in the room)
+      const Shape* containedShape = new IntBoxShape(itemBox);
 
-    // Create initial room shape (large area that will be restricted by obstacles)
-    // Use ExpansionRoomGenerator to create a properly sized initial room
-    int netNumber = this->autorouteEngine->getNetNo();
-    ExpansionRoomGenerator* roomGen = this->autorouteEngine->getRoomGenerator(netNumber);
-    const Shape* roomShape = nullptr;
+      // Create initial room shape (large area that will be restricted by obstacles)
+      // Use ExpansionRoomGenerator to create a properly sized initial room
+      int netNumber = this->autorouteEngine->getNetNo();
+      ExpansionRoomGenerator* roomGen = this->autorouteEngine->getRoomGenerator(netNumber);
+      const Shape* roomShape = nullptr;
 
-    if (roomGen) {
-      TileShape* tileShape = roomGen->createInitialRoomShape(layer, itemBox, dynamic_cast<const TileShape*>(containedShape));
-      roomShape = static_cast<const Shape*>(tileShape);  // Safe cast - TileShape now inherits from Shape
-    }
+      if (roomGen) {
+        TileShape* tileShape = roomGen->createInitialRoomShape(layer, itemBox, dynamic_cast<const TileShape*>(containedShape));
+        roomShape = static_cast<const Shape*>(tileShape);  // Safe cast - TileShape now inherits from Shape
+      }
 
-    // Add the incomplete room with the generated shapes
-    IncompleteFreeSpaceExpansionRoom* startRoom =
-      this->autorouteEngine->addIncompleteExpansionRoom(roomShape, layer, containedShape);
+      // Add the incomplete room with the generated shapes
+      IncompleteFreeSpaceExpansionRoom* startRoom =
+        this->autorouteEngine->addIncompleteExpansionRoom(roomShape, layer, containedShape);
 
-    if (startRoom) {
-      startRooms.push_back(startRoom);
+      if (startRoom) {
+        startRooms.push_back({startRoom, startEntry(*item, layer, destCenter)});
+      }
     }
   }
 
   // Complete the start rooms - this triggers calculateDoors() which creates target doors
-  std::vector<CompleteFreeSpaceExpansionRoom*> completedStartRooms;
+  std::vector<std::pair<CompleteFreeSpaceExpansionRoom*, FloatPoint>> completedStartRooms;
 
-  for (IncompleteFreeSpaceExpansionRoom* room : startRooms) {
+  for (const StartRoom& start : startRooms) {
     if (this->autorouteEngine->isStopRequested()) {
       return false;
     }
 
     CompleteFreeSpaceExpansionRoom* completed =
-      this->autorouteEngine->completeExpansionRoom(room);
+      this->autorouteEngine->completeExpansionRoom(start.room);
 
     if (completed) {
-      completedStartRooms.push_back(completed);
+      completedStartRooms.emplace_back(completed, start.entry);
     }
   }
 
   // Add target doors from completed start rooms to the expansion list
   bool startOk = false;
 
-  for (CompleteFreeSpaceExpansionRoom* room : completedStartRooms) {
+  for (const auto& [room, entry] : completedStartRooms) {
     const auto& targetDoors = room->getTargetDoors();
 
     for (TargetItemExpansionDoor* door : targetDoors) {
@@ -227,16 +285,10 @@ bool MazeSearchAlgo::init(
       }
 
       // Create initial maze list element for this door
-      // Java calculates center of gravity and sorting value based on distance
-      // For Phase 1, use simple defaults
-
-      FloatPoint doorCenter(0.0, 0.0);  // TODO: Calculate actual center
-
-      // Convert FloatPoint to IntPoint for distance calculation
-      IntPoint doorCenterInt(static_cast<int>(doorCenter.x), static_cast<int>(doorCenter.y));
+      // Java calculates center of gravity and sorting value based on distance;
+      // expansion starts at the room's entry point
 
-      double sortingValue = this->destinationDistance->calculate(
-        doorCenterInt, room->getLayer());
+      double sortingValue = this->destinationDistance->calculate(entry, room->getLayer());
 
       MazeListElement* listElement = MazeListElement::obtain(
         door,                              // door
@@ -246,13 +298,14 @@ bool MazeSearchAlgo::init(
         0,                                 // expansion value
         sortingValue,                      // sorting value
         room,                              // room
-        doorCenter,                        // shape entry (FloatPoint)
+        entry,                             // shape entry (FloatPoint)
         false,                             // room ripped
         MazeSearchElement::Adjustment::None, // adjustment
         false                              // already checked
       );
 
       mazeExpansionList.add(listElement);
+      captureDoor(false, listElement, room->getLayer());
       startOk = true;
     }
   }
@@ -352,11 +405,14 @@ MazeSearchAlgo::Result MazeSearchAlgo::findConnection() {
   for (const auto& elem : backtrackPath) {
     pathPoints.push_back(elem.waypoint);
     pathLayers.push_back(elem.layer);
+    if (searchCapture) {
+      searchCapture->addPathPoint(elem.waypoint, elem.layer, elem.door);
+    }
   }
 
   // If we got an empty path, fall back to simple 2-point
   if (pathPoints.empty() && !this->startItems.empty() && !this->destItems.empty()) {
-    static int fallbackCount = 0;
+    static std::atomic<int> fallbackCount = 0;
     if (fallbackCount < 3) {
       std::cerr << "WARNING: Backtracking failed, using 2-point fallback (destinationDoor="
                 << (this->destinationDoor ? "set" : "null") << ")" << std::endl;
@@ -424,6 +480,11 @@ bool MazeSearchAlgo::occupyNextElement() {
     return false;
   }
 
+  if (searchCapture) {
+    int layer = listElement->nextRoom ? listElement->nextRoom->getLayer() : -1;
+    captureDoor(true, listElement, layer);
+  }
+
   currDoorSection->backtrackDoor = listElement->backtrackDoor;
   currDoorSection->sectionNoOfBacktrackDoor = listElement->sectionNoOfBacktrackDoor;
   currDoorSection->roomRipped = listElement->roomRipped;
@@ -551,6 +612,10 @@ bool MazeSearchAlgo::expandToRoomDoors(MazeListElement* pListElement) {
       }
     }
   } else if (obstacleRoom != nullptr) {
+    if (searchCapture && obstacleRoom->getItem()) {
+      searchCapture->addObstacleRoom(obstacleRoom->getItem()->getBoundingBox(), layerNo,
+                                     obstacleRoom->getItem()->getId());
+    }
     if (!pListElement->alreadyChecked) {
       bool roomRippable = false;
       if (this->control.ripupAllowed) {
@@ -652,6 +717,18 @@ bool MazeSearchAlgo::expandToDoorSection(ExpandableObject* pDoor, int pSectionNo
     weightedDist *= avgCost;
   }
 
+  // Prefer doors away from other nets' copper; the door center is where the
+  // path waypoint ends up (shape entries are still points, see above)
+  if (proximityField) {
+    const Shape* doorShape = pDoor->getShape();
+    if (doorShape && !doorShape->isEmpty()) {
+      IntBox bbox = doorShape->getBoundingBox();
+      IntPoint doorCenter((bbox.ll.x + bbox.ur.x) / 2, (bbox.ll.y + bbox.ur.y) / 2);
+      weightedDist += proximityField->costAt(doorCenter, layer, autorouteEngine->getNetNo(),
+                                             control.proximityCostWeight);
+    }
+  }
+
   double expansionValue = pFromElement->expansionValue + pAddCosts + weightedDist;
   double sortingValue = expansionValue + destinationDistance->calculate(shapeEntryMiddle, layer);
 
@@ -665,6 +742,7 @@ bool MazeSearchAlgo::expandToDoorSection(ExpandableObject* pDoor, int pSectionNo
   );
 
   mazeExpansionList.add(newElement);
+  captureDoor(false, newElement, layer);
   return true;
 }
 
@@ -894,4 +972,29 @@ void MazeSearchAlgo::expandToDrillsOfPage(MazeListElement* pFromElement) {
   (void)pFromElement;
 }
 
+// Door position for the capture: the door shape's box, or the target
+// item's box for target doors; pLayer < 0 takes the target item's layer
+void MazeSearchAlgo::captureDoor(bool expanded, const MazeListElement* pElement, int pLayer) {
+  if (!searchCapture || !pElement || !pElement->door) {
+    return;
+  }
+
+  IntBox box;
+  auto* targetDoor = dynamic_cast<TargetItemExpansionDoor*>(pElement->door);
+  if (targetDoor && targetDoor->item) {
+    box = targetDoor->item->getBoundingBox();
+    if (pLayer < 0) {
+      pLayer = targetDoor->item->firstLayer();
+    }
+  } else if (const Shape* doorShape = pElement->door->getShape()) {
+    box = doorShape->getBoundingBox();
+  } else {
+    return;
+  }
+
+  searchCapture->addDoor(expanded ? SearchCapture::Kind::DoorExpanded : SearchCapture::Kind::DoorQueued,
+                         pElement->door, box, pLayer,
+                         pElement->expansionValue, pElement->sortingValue);
+}
+
 } // namespace freerouting
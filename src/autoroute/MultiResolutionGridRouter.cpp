@@ -0,0 +1,301 @@
+#include "autoroute/MultiResolutionGridRouter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace freerouting {
+
+MultiResolutionGridRouter::Result MultiResolutionGridRouter::findPath(
+    const Endpoint& start, const Endpoint& goal, int netNo) const {
+
+  Result result;
+  if (pyramid_.levelCount() == 0) {
+    return result;
+  }
+
+  // Coarsest level where the connection still spans a useful number of cells
+  i64 span = std::max(std::abs(static_cast<i64>(goal.point.x) - start.point.x),
+                      std::abs(static_cast<i64>(goal.point.y) - start.point.y));
+  int top = 0;
+  while (top + 1 < pyramid_.levelCount() &&
+         span / pyramid_.levelCellSize(top + 1) >= config_.coarseTargetCells) {
+    ++top;
+  }
+
+  // Connection box plus a margin, clamped to the grid; the margin covers the
+  // same board area on every level
+  IntBox area = IntBox::fromPoints(start.point, goal.point);
+  auto fullWindow = [&](int level) {
+    auto [ax0, ay0] = pyramid_.cellOf(level, area.ll);
+    auto [ax1, ay1] = pyramid_.cellOf(level, area.ur);
+    int margin = config_.windowMargin << (top - level);
+    Window window;
+    window.x0 = std::max(0, ax0 - margin);
+    window.y0 = std::max(0, ay0 - margin);
+    window.x1 = std::min(pyramid_.levelWidth(level) - 1, ax1 + margin);
+    window.y1 = std::min(pyramid_.levelHeight(level) - 1, ay1 + margin);
+    return window;
+  };
+
+  Window window = fullWindow(top);
+  std::vector<Cell> path;
+  std::vector<Cell> coarserPath;
+
+  for (int level = top; level >= 0; --level) {
+    path = searchLevel(level, window, start, goal, netNo, result.cellsExpanded);
+    ++result.levelsSearched;
+
+    if (path.empty() && level < top) {
+      // The corridor was too tight (a partly blocked coarse cell hid a
+      // wall); widen it once, then search the whole window on this level
+      window = corridorBelow(level + 1, coarserPath, config_.corridorRadius * 3);
+      path = searchLevel(level, window, start, goal, netNo, result.cellsExpanded);
+      if (path.empty()) {
+        path = searchLevel(level, fullWindow(level), start, goal, netNo, result.cellsExpanded);
+      }
+    }
+
+    if (path.empty()) {
+      return result;
+    }
+
+    if (level > 0) {
+      window = corridorBelow(level, path, config_.corridorRadius);
+      coarserPath = path;
+    }
+  }
+
+  buildRoute(path, start, goal, result);
+  result.found = true;
+  return result;
+}
+
+std::vector<MultiResolutionGridRouter::Cell> MultiResolutionGridRouter::searchLevel(
+    int level, const Window& window, const Endpoint& start, const Endpoint& goal,
+    int netNo, int& expansions) const {
+
+  const int layers = pyramid_.layerCount();
+  const int width = window.width();
+  const int height = window.height();
+  const double cellSize = pyramid_.levelCellSize(level);
+  const size_t cellCount = static_cast<size_t>(width) * height * layers;
+
+  // Endpoint areas: cells covered by the item box are always passable
+  auto endpointCells = [&](const Endpoint& endpoint) {
+    auto [x0, y0] = pyramid_.cellOf(level, endpoint.box.isEmpty() ? endpoint.point : endpoint.box.ll);
+    auto [x1, y1] = pyramid_.cellOf(level, endpoint.box.isEmpty() ? endpoint.point : endpoint.box.ur);
+    return Window{x0, y0, x1, y1, {}};
+  };
+  const Window startArea = endpointCells(start);
+  const Window goalArea = endpointCells(goal);
+  auto inArea = [](const Window& area, const Endpoint& endpoint, int x, int y, int layer) {
+    return layer >= endpoint.firstLayer && layer <= endpoint.lastLayer && area.allows(x, y);
+  };
+
+  // Traversal cost factor of a cell, or negative if it can't be entered
+  auto cellCost = [&](int x, int y, int layer) -> double {
+    if (!window.allows(x, y)) return -1.0;
+    if (inArea(startArea, start, x, y, layer) || inArea(goalArea, goal, x, y, layer)) {
+      return 1.0;
+    }
+    if (!config_.layerActive.empty() && !config_.layerActive[layer]) return -1.0;
+    double fraction = pyramid_.blockedFraction(level, layer, x, y, netNo);
+    if (level == 0 ? fraction > 0.0 : fraction >= 1.0) return -1.0;
+    double factor = 1.0 + config_.congestionWeight * fraction;
+    if (level == 0 && config_.proximity) {
+      factor += config_.proximity->costAt(pyramid_.cellCenter(0, x, y), layer, netNo,
+                                          config_.proximityWeight) / cellSize;
+    }
+    return factor;
+  };
+
+  auto index = [&](int x, int y, int layer) {
+    return (static_cast<size_t>(layer) * height + (y - window.y0)) * width + (x - window.x0);
+  };
+
+  auto [goalX, goalY] = pyramid_.cellOf(level, goal.point);
+  auto heuristic = [&](int x, int y) {
+    double dx = std::abs(x - goalX);
+    double dy = std::abs(y - goalY);
+    return cellSize * (std::max(dx, dy) + (std::sqrt(2.0) - 1.0) * std::min(dx, dy));
+  };
+
+  std::vector<double> gCost(cellCount, std::numeric_limits<double>::infinity());
+  std::vector<int> parent(cellCount, -1);
+  std::vector<unsigned char> closed(cellCount, 0);
+
+  using QueueEntry = std::pair<double, size_t>;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open;
+
+  auto [startX, startY] = pyramid_.cellOf(level, start.point);
+  for (int layer = std::max(0, start.firstLayer); layer <= std::min(layers - 1, start.lastLayer); ++layer) {
+    if (!window.allows(startX, startY)) break;
+    if (!(start.accessLayers & layerBit(layer))) continue;
+    size_t idx = index(startX, startY, layer);
+    gCost[idx] = 0.0;
+    open.push({heuristic(startX, startY), idx});
+  }
+
+  static constexpr int kDirs[8][2] = {
+    {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+  };
+
+  int localExpansions = 0;
+  size_t goalIdx = cellCount;
+
+  while (!open.empty() && localExpansions < config_.maxExpansions) {
+    auto [f, idx] = open.top();
+    open.pop();
+    (void)f;
+    if (closed[idx]) continue;
+    if ((localExpansions & 1023) == 0 && config_.stoppable && config_.stoppable->isStopRequested()) {
+      break;
+    }
+    closed[idx] = 1;
+    ++localExpansions;
+
+    int layer = static_cast<int>(idx / (static_cast<size_t>(width) * height));
+    int rest = static_cast<int>(idx % (static_cast<size_t>(width) * height));
+    int x = window.x0 + rest % width;
+    int y = window.y0 + rest / width;
+
+    if (x == goalX && y == goalY && layer >= goal.firstLayer && layer <= goal.lastLayer &&
+        (goal.accessLayers & layerBit(layer))) {
+      goalIdx = idx;
+      break;
+    }
+
+    double g = gCost[idx];
+
+    for (int d = 0; d < 8; ++d) {
+      int nx = x + kDirs[d][0];
+      int ny = y + kDirs[d][1];
+      double factor = cellCost(nx, ny, layer);
+      if (factor < 0.0) continue;
+
+      bool diagonal = d >= 4;
+      // Don't cut corners past blocked fine cells
+      if (diagonal && level == 0 &&
+          (cellCost(x + kDirs[d][0], y, layer) < 0.0 || cellCost(x, y + kDirs[d][1], layer) < 0.0)) {
+        continue;
+      }
+
+      size_t nIdx = index(nx, ny, layer);
+      if (closed[nIdx]) continue;
+
+      double step = cellSize * (diagonal ? std::sqrt(2.0) : 1.0) * factor;
+      if (g + step < gCost[nIdx]) {
+        gCost[nIdx] = g + step;
+        parent[nIdx] = static_cast<int>(idx);
+        open.push({g + step + heuristic(nx, ny), nIdx});
+      }
+    }
+
+    // Layer changes (vias) at the same cell
+    for (int other = 0; other < layers; ++other) {
+      if (other == layer || cellCost(x, y, other) < 0.0) continue;
+
+      size_t nIdx = index(x, y, other);
+      if (closed[nIdx]) continue;
+
+      double cost = g + config_.viaCost;
+      if (cost < gCost[nIdx]) {
+        gCost[nIdx] = cost;
+        parent[nIdx] = static_cast<int>(idx);
+        open.push({cost + heuristic(x, y), nIdx});
+      }
+    }
+  }
+
+  expansions += localExpansions;
+
+  std::vector<Cell> path;
+  if (goalIdx == cellCount) {
+    return path;
+  }
+
+  for (int idx = static_cast<int>(goalIdx); idx >= 0; idx = parent[idx]) {
+    int layer = idx / (width * height);
+    int rest = idx % (width * height);
+    path.push_back({window.x0 + rest % width, window.y0 + rest / width, layer});
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+MultiResolutionGridRouter::Window MultiResolutionGridRouter::corridorBelow(
+    int level, const std::vector<Cell>& path, int radius) const {
+
+  const int fineLevel = level - 1;
+  const int maxX = pyramid_.levelWidth(fineLevel) - 1;
+  const int maxY = pyramid_.levelHeight(fineLevel) - 1;
+
+  Window window{maxX, maxY, 0, 0, {}};
+  for (const Cell& cell : path) {
+    window.x0 = std::min(window.x0, std::max(0, 2 * (cell.x - radius)));
+    window.y0 = std::min(window.y0, std::max(0, 2 * (cell.y - radius)));
+    window.x1 = std::max(window.x1, std::min(maxX, 2 * (cell.x + radius) + 1));
+    window.y1 = std::max(window.y1, std::min(maxY, 2 * (cell.y + radius) + 1));
+  }
+  if (window.x0 > window.x1 || window.y0 > window.y1) {
+    return window;
+  }
+
+  window.mask.assign(static_cast<size_t>(window.width()) * window.height(), 0);
+  for (const Cell& cell : path) {
+    int x0 = std::max(window.x0, 2 * (cell.x - radius));
+    int y0 = std::max(window.y0, 2 * (cell.y - radius));
+    int x1 = std::min(window.x1, 2 * (cell.x + radius) + 1);
+    int y1 = std::min(window.y1, 2 * (cell.y + radius) + 1);
+    for (int y = y0; y <= y1; ++y) {
+      std::fill_n(window.mask.begin() + static_cast<size_t>(y - window.y0) * window.width() + (x0 - window.x0),
+                  x1 - x0 + 1, 1);
+    }
+  }
+  return window;
+}
+
+void MultiResolutionGridRouter::buildRoute(const std::vector<Cell>& path,
+                                           const Endpoint& start, const Endpoint& goal,
+                                           Result& result) const {
+  std::vector<IntPoint> points;
+  std::vector<int> layers;
+
+  auto append = [&](IntPoint point, int layer) {
+    if (!points.empty() && points.back() == point && layers.back() == layer) {
+      return;
+    }
+    points.push_back(point);
+    layers.push_back(layer);
+  };
+
+  append(start.point, path.front().layer);
+  for (const Cell& cell : path) {
+    append(pyramid_.cellCenter(0, cell.x, cell.y), cell.layer);
+  }
+  append(goal.point, path.back().layer);
+
+  // Drop interior points on straight same-layer runs
+  for (size_t i = 0; i < points.size(); ++i) {
+    size_t n = result.pathPoints.size();
+    if (n >= 2 &&
+        result.pathLayers[n - 2] == result.pathLayers[n - 1] &&
+        result.pathLayers[n - 1] == layers[i] &&
+        result.pathPoints[n - 1] != points[i]) {
+      IntPoint a = result.pathPoints[n - 2];
+      IntPoint b = result.pathPoints[n - 1];
+      IntPoint c = points[i];
+      i64 cross = static_cast<i64>(b.x - a.x) * (c.y - b.y) -
+                  static_cast<i64>(b.y - a.y) * (c.x - b.x);
+      if (cross == 0) {
+        result.pathPoints[n - 1] = c;
+        continue;
+      }
+    }
+    result.pathPoints.push_back(points[i]);
+    result.pathLayers.push_back(layers[i]);
+  }
+}
+
+} // namespace freerouting
@@ -0,0 +1,203 @@
+#include "autoroute/ObstaclePyramid.h"
+#include "board/RoutingBoard.h"
+#include <algorithm>
+
+namespace freerouting {
+
+namespace {
+
+// Floor division that rounds towards negative infinity
+i64 floorDiv(i64 a, i64 b) {
+  i64 q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+} // namespace
+
+ObstaclePyramid::ObstaclePyramid(const RoutingBoard* board, int cellSize, int inflation)
+  : board_(board),
+    cellSize_(std::max(1, cellSize)),
+    inflation_(std::max(0, inflation)),
+    layerCount_(board ? std::max(1, board->getLayers().count()) : 1) {
+
+  // Bounds cover every item plus its inflation and a small routing margin
+  bounds_ = IntBox::empty();
+  if (board_) {
+    for (const auto& item : board_->getItems()) {
+      bounds_ = bounds_.unionWith(item->getBoundingBox());
+    }
+  }
+  if (bounds_.isEmpty()) {
+    bounds_ = IntBox(0, 0, cellSize_, cellSize_);
+  }
+  bounds_ = bounds_.expand(inflation_ + 4 * cellSize_);
+
+  // Level 0 at trace pitch, then halve until the grid is a few cells wide
+  int width = static_cast<int>((static_cast<i64>(bounds_.width()) + cellSize_ - 1) / cellSize_);
+  int height = static_cast<int>((static_cast<i64>(bounds_.height()) + cellSize_ - 1) / cellSize_);
+
+  do {
+    Level level;
+    level.width = std::max(1, width);
+    level.height = std::max(1, height);
+    size_t cells = static_cast<size_t>(layerCount_) * level.width * level.height;
+    level.blockedCount.assign(cells, 0);
+    level.owner.assign(cells, kFree);
+    levels_.push_back(std::move(level));
+
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+  } while (static_cast<int>(levels_.size()) < kMaxLevels &&
+           std::max(levels_.back().width, levels_.back().height) > 4);
+
+  markDirty(bounds_);
+  refresh();
+}
+
+std::pair<int, int> ObstaclePyramid::cellOf(int level, IntPoint point) const {
+  const Level& l = levels_[level];
+  i64 size = levelCellSize(level);
+  i64 cx = floorDiv(static_cast<i64>(point.x) - bounds_.ll.x, size);
+  i64 cy = floorDiv(static_cast<i64>(point.y) - bounds_.ll.y, size);
+  return {static_cast<int>(std::clamp<i64>(cx, 0, l.width - 1)),
+          static_cast<int>(std::clamp<i64>(cy, 0, l.height - 1))};
+}
+
+IntPoint ObstaclePyramid::cellCenter(int level, int cx, int cy) const {
+  i64 size = levelCellSize(level);
+  return IntPoint(static_cast<int>(bounds_.ll.x + cx * size + size / 2),
+                  static_cast<int>(bounds_.ll.y + cy * size + size / 2));
+}
+
+double ObstaclePyramid::blockedFraction(int level, int layer, int cx, int cy, int netNo) const {
+  const Level& l = levels_[level];
+  size_t idx = cellIndex(l, layer, cx, cy);
+  u32 count = l.blockedCount[idx];
+  if (count == 0 || l.owner[idx] == netNo) {
+    return 0.0;
+  }
+
+  // Cells on the right/top edge may cover fewer level-0 cells
+  const Level& fine = levels_[0];
+  int x0 = cx << level;
+  int y0 = cy << level;
+  int x1 = std::min(fine.width, (cx + 1) << level);
+  int y1 = std::min(fine.height, (cy + 1) << level);
+  u32 total = static_cast<u32>((x1 - x0) * (y1 - y0));
+
+  return total > 0 ? std::min(1.0, static_cast<double>(count) / total) : 1.0;
+}
+
+void ObstaclePyramid::refresh() {
+  if (dirtyRegions_.empty()) {
+    return;
+  }
+
+  std::vector<IntBox> regions;
+  regions.swap(dirtyRegions_);
+
+  for (const IntBox& region : regions) {
+    IntBox grown = region.expand(inflation_).intersection(bounds_);
+    if (grown.isEmpty()) {
+      continue;
+    }
+
+    auto [x0, y0] = cellOf(0, grown.ll);
+    auto [x1, y1] = cellOf(0, grown.ur);
+    rasterize(x0, y0, x1, y1);
+
+    for (int level = 1; level < levelCount(); ++level) {
+      x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+      aggregate(level, x0, y0, x1, y1);
+    }
+  }
+}
+
+void ObstaclePyramid::rasterize(int x0, int y0, int x1, int y1) {
+  Level& fine = levels_[0];
+
+  for (int layer = 0; layer < layerCount_; ++layer) {
+    for (int cy = y0; cy <= y1; ++cy) {
+      size_t row = cellIndex(fine, layer, 0, cy);
+      std::fill(fine.owner.begin() + row + x0, fine.owner.begin() + row + x1 + 1, kFree);
+    }
+  }
+
+  if (!board_) {
+    return;
+  }
+
+  // Items whose inflated box reaches a cell center inside the range
+  const i64 size = cellSize_;
+  const i64 half = size / 2;
+  IntBox rangeBox(
+    static_cast<int>(bounds_.ll.x + x0 * size), static_cast<int>(bounds_.ll.y + y0 * size),
+    static_cast<int>(bounds_.ll.x + (x1 + 1) * size), static_cast<int>(bounds_.ll.y + (y1 + 1) * size));
+
+  for (Item* item : board_->getShapeTree().queryRegion(rangeBox.expand(inflation_))) {
+    const std::vector<int>& nets = item->getNets();
+    int itemOwner = nets.size() == 1 ? nets[0] : kBlocked;
+
+    IntBox box = item->getBoundingBox().expand(inflation_);
+    int ix0 = static_cast<int>(std::max<i64>(x0, -floorDiv(-(box.ll.x - bounds_.ll.x - half), size)));
+    int iy0 = static_cast<int>(std::max<i64>(y0, -floorDiv(-(box.ll.y - bounds_.ll.y - half), size)));
+    int ix1 = static_cast<int>(std::min<i64>(x1, floorDiv(box.ur.x - bounds_.ll.x - half, size)));
+    int iy1 = static_cast<int>(std::min<i64>(y1, floorDiv(box.ur.y - bounds_.ll.y - half, size)));
+    if (ix0 > ix1 || iy0 > iy1) {
+      continue;
+    }
+
+    int firstLayer = std::max(0, item->firstLayer());
+    int lastLayer = std::min(layerCount_ - 1, item->lastLayer());
+    for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+      for (int cy = iy0; cy <= iy1; ++cy) {
+        size_t row = cellIndex(fine, layer, 0, cy);
+        for (int cx = ix0; cx <= ix1; ++cx) {
+          int& owner = fine.owner[row + cx];
+          owner = mergeOwner(owner, itemOwner);
+        }
+      }
+    }
+  }
+
+  for (int layer = 0; layer < layerCount_; ++layer) {
+    for (int cy = y0; cy <= y1; ++cy) {
+      size_t row = cellIndex(fine, layer, 0, cy);
+      for (int cx = x0; cx <= x1; ++cx) {
+        fine.blockedCount[row + cx] = fine.owner[row + cx] == kFree ? 0 : 1;
+      }
+    }
+  }
+}
+
+void ObstaclePyramid::aggregate(int level, int x0, int y0, int x1, int y1) {
+  Level& coarse = levels_[level];
+  const Level& below = levels_[level - 1];
+
+  for (int layer = 0; layer < layerCount_; ++layer) {
+    for (int cy = y0; cy <= y1; ++cy) {
+      for (int cx = x0; cx <= x1; ++cx) {
+        u32 count = 0;
+        int owner = kFree;
+
+        for (int dy = 0; dy < 2; ++dy) {
+          int by = 2 * cy + dy;
+          if (by >= below.height) break;
+          for (int dx = 0; dx < 2; ++dx) {
+            int bx = 2 * cx + dx;
+            if (bx >= below.width) break;
+            size_t idx = cellIndex(below, layer, bx, by);
+            count += below.blockedCount[idx];
+            owner = mergeOwner(owner, below.owner[idx]);
+          }
+        }
+
+        size_t idx = cellIndex(coarse, layer, cx, cy);
+        coarse.blockedCount[idx] = count;
+        coarse.owner[idx] = owner;
+      }
+    }
+  }
+}
+
+} // namespace freerouting
@@ -0,0 +1,293 @@
+#include "autoroute/OccupancyPyramid.h"
+#include "board/RoutingBoard.h"
+#include "board/RuleArea.h"
+#include <algorithm>
+
+namespace freerouting {
+
+namespace {
+
+// Floor division that rounds towards negative infinity
+i64 floorDiv(i64 a, i64 b) {
+  i64 q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+} // namespace
+
+OccupancyPyramid::OccupancyPyramid(const RoutingBoard* board, int cellSize, int inflation)
+  : board_(board),
+    cellSize_(std::max(1, cellSize)),
+    inflation_(std::max(0, inflation)),
+    layerCount_(board ? std::max(1, board->getLayers().count()) : 1) {
+
+  // Same extent as the obstacle pyramid: every item plus a routing margin
+  bounds_ = IntBox::empty();
+  if (board_) {
+    for (const auto& item : board_->getItems()) {
+      bounds_ = bounds_.unionWith(item->getBoundingBox());
+    }
+  }
+  if (bounds_.isEmpty()) {
+    bounds_ = IntBox(0, 0, cellSize_, cellSize_);
+  }
+  bounds_ = bounds_.expand(inflation_ + 4 * cellSize_);
+
+  int width = static_cast<int>((static_cast<i64>(bounds_.width()) + cellSize_ - 1) / cellSize_);
+  int height = static_cast<int>((static_cast<i64>(bounds_.height()) + cellSize_ - 1) / cellSize_);
+  do {
+    Level level;
+    level.width = std::max(1, width);
+    level.height = std::max(1, height);
+    level.nearOwner.assign(static_cast<size_t>(layerCount_) * level.width * level.height, kFree);
+    levels_.push_back(std::move(level));
+
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+  } while (static_cast<int>(levels_.size()) < kMaxLevels &&
+           std::max(levels_.back().width, levels_.back().height) > 4);
+
+  fullOwner_.assign(levels_[0].nearOwner.size(), kFree);
+  keepoutNear_.assign(levels_[0].nearOwner.size(), 0);
+
+  rasterizeKeepouts();
+  update(bounds_);
+}
+
+int OccupancyPyramid::cellX(int x) const {
+  return static_cast<int>(std::clamp<i64>(floorDiv(static_cast<i64>(x) - bounds_.ll.x, cellSize_),
+                                          0, levels_[0].width - 1));
+}
+
+int OccupancyPyramid::cellY(int y) const {
+  return static_cast<int>(std::clamp<i64>(floorDiv(static_cast<i64>(y) - bounds_.ll.y, cellSize_),
+                                          0, levels_[0].height - 1));
+}
+
+OccupancyPyramid::State OccupancyPyramid::probePoint(IntPoint point, int layer, int netNo,
+                                                     int reach) const {
+  probes_.fetch_add(1, std::memory_order_relaxed);
+  if (layer < 0 || layer >= layerCount_ || !bounds_.contains(point)) {
+    return State::Mixed;
+  }
+
+  const Level& fine = levels_[0];
+  size_t idx = cellIndex(fine, layer, cellX(point.x), cellY(point.y));
+  if (reach <= inflation_ && isClearFor(fine.nearOwner[idx], netNo)) {
+    empty_.fetch_add(1, std::memory_order_relaxed);
+    return State::Empty;
+  }
+  int owner = fullOwner_[idx];
+  if (owner != kFree && owner != netNo) {
+    full_.fetch_add(1, std::memory_order_relaxed);
+    return State::Full;
+  }
+  return State::Mixed;
+}
+
+OccupancyPyramid::State OccupancyPyramid::probeBox(const IntBox& box, int layer, int netNo,
+                                                   int reach) const {
+  probes_.fetch_add(1, std::memory_order_relaxed);
+  if (reach > inflation_ || layer < 0 || layer >= layerCount_ || !bounds_.contains(box)) {
+    return State::Mixed;
+  }
+
+  const int x0 = cellX(box.ll.x);
+  const int y0 = cellY(box.ll.y);
+  const int x1 = cellX(box.ur.x);
+  const int y1 = cellY(box.ur.y);
+
+  // From the top level down, only into cells that are not clear; a box
+  // along a crowded channel would visit too many, so it falls through
+  constexpr int kMaxVisits = 64;
+  int budget = kMaxVisits;
+  const int top = levelCount() - 1;
+  for (int cy = y0 >> top; cy <= (y1 >> top); ++cy) {
+    for (int cx = x0 >> top; cx <= (x1 >> top); ++cx) {
+      if (!isRangeClear(top, layer, cx, cy, x0, y0, x1, y1, netNo, budget)) {
+        return State::Mixed;
+      }
+    }
+  }
+  empty_.fetch_add(1, std::memory_order_relaxed);
+  return State::Empty;
+}
+
+bool OccupancyPyramid::isRangeClear(int level, int layer, int cx, int cy,
+                                    int x0, int y0, int x1, int y1,
+                                    int netNo, int& budget) const {
+  const Level& l = levels_[level];
+  if (isClearFor(l.nearOwner[cellIndex(l, layer, cx, cy)], netNo)) {
+    return true;
+  }
+  if (level == 0 || --budget < 0) {
+    return false;
+  }
+
+  const Level& below = levels_[level - 1];
+  const int shift = level - 1;
+  for (int by = std::max(2 * cy, y0 >> shift); by <= std::min({2 * cy + 1, y1 >> shift, below.height - 1}); ++by) {
+    for (int bx = std::max(2 * cx, x0 >> shift); bx <= std::min({2 * cx + 1, x1 >> shift, below.width - 1}); ++bx) {
+      if (!isRangeClear(level - 1, layer, bx, by, x0, y0, x1, y1, netNo, budget)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool OccupancyPyramid::isKeepoutFree(IntPoint point, int layer) const {
+  if (layer < 0 || layer >= layerCount_ || !bounds_.contains(point) ||
+      (board_ && board_->getRuleAreas().size() != ruleAreaCount_)) {
+    return false;
+  }
+  return keepoutNear_[cellIndex(levels_[0], layer, cellX(point.x), cellY(point.y))] == 0;
+}
+
+void OccupancyPyramid::update(const IntBox& region) {
+  // Cells are closed boxes, so copper exactly on a cell edge counts for
+  // both cells; the extra unit keeps that true after rounding
+  IntBox grown = region.expand(inflation_ + 1).intersection(bounds_);
+  if (grown.isEmpty()) {
+    return;
+  }
+
+  int x0 = cellX(grown.ll.x);
+  int y0 = cellY(grown.ll.y);
+  int x1 = cellX(grown.ur.x);
+  int y1 = cellY(grown.ur.y);
+  rasterize(x0, y0, x1, y1);
+
+  for (int level = 1; level < levelCount(); ++level) {
+    x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+    aggregate(level, x0, y0, x1, y1);
+  }
+}
+
+void OccupancyPyramid::rasterize(int x0, int y0, int x1, int y1) {
+  Level& fine = levels_[0];
+  for (int layer = 0; layer < layerCount_; ++layer) {
+    for (int cy = y0; cy <= y1; ++cy) {
+      size_t row = cellIndex(fine, layer, 0, cy);
+      std::fill(fine.nearOwner.begin() + row + x0, fine.nearOwner.begin() + row + x1 + 1, kFree);
+      std::fill(fullOwner_.begin() + row + x0, fullOwner_.begin() + row + x1 + 1, kFree);
+    }
+  }
+  if (!board_) {
+    return;
+  }
+
+  const i64 size = cellSize_;
+  IntBox rangeBox(
+    static_cast<int>(bounds_.ll.x + x0 * size), static_cast<int>(bounds_.ll.y + y0 * size),
+    static_cast<int>(bounds_.ll.x + (x1 + 1) * size), static_cast<int>(bounds_.ll.y + (y1 + 1) * size));
+
+  for (Item* item : board_->getShapeTree().queryRegion(rangeBox.expand(inflation_ + 1))) {
+    const std::vector<int>& nets = item->getNets();
+    // Copper of several nets is clear for each of them, so it can't be
+    // told apart from foreign copper here; copper of no net blocks all
+    const int owner = nets.size() == 1 ? nets[0] : kShared;
+    const int firstLayer = std::max(0, item->firstLayer());
+    const int lastLayer = std::min(layerCount_ - 1, item->lastLayer());
+
+    // Cells the inflated item touches
+    IntBox near = item->getBoundingBox().expand(inflation_ + 1);
+    int nx0 = static_cast<int>(std::max<i64>(x0, floorDiv(near.ll.x - bounds_.ll.x, size)));
+    int ny0 = static_cast<int>(std::max<i64>(y0, floorDiv(near.ll.y - bounds_.ll.y, size)));
+    int nx1 = static_cast<int>(std::min<i64>(x1, floorDiv(near.ur.x - bounds_.ll.x, size)));
+    int ny1 = static_cast<int>(std::min<i64>(y1, floorDiv(near.ur.y - bounds_.ll.y, size)));
+
+    // Cells the item itself covers completely
+    IntBox box = item->getBoundingBox();
+    int fx0 = static_cast<int>(std::max<i64>(x0, -floorDiv(-(box.ll.x - bounds_.ll.x), size)));
+    int fy0 = static_cast<int>(std::max<i64>(y0, -floorDiv(-(box.ll.y - bounds_.ll.y), size)));
+    int fx1 = static_cast<int>(std::min<i64>(x1, floorDiv(box.ur.x - bounds_.ll.x, size) - 1));
+    int fy1 = static_cast<int>(std::min<i64>(y1, floorDiv(box.ur.y - bounds_.ll.y, size) - 1));
+
+    for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+      for (int cy = ny0; cy <= ny1; ++cy) {
+        size_t row = cellIndex(fine, layer, 0, cy);
+        for (int cx = nx0; cx <= nx1; ++cx) {
+          int& cell = fine.nearOwner[row + cx];
+          cell = mergeOwner(cell, owner);
+        }
+      }
+      if (nets.size() > 1) {
+        continue;  // Not an obstacle for its own nets
+      }
+      for (int cy = fy0; cy <= fy1; ++cy) {
+        size_t row = cellIndex(fine, layer, 0, cy);
+        for (int cx = fx0; cx <= fx1; ++cx) {
+          int& cell = fullOwner_[row + cx];
+          cell = mergeOwner(cell, owner);
+        }
+      }
+    }
+  }
+}
+
+void OccupancyPyramid::aggregate(int level, int x0, int y0, int x1, int y1) {
+  Level& coarse = levels_[level];
+  const Level& below = levels_[level - 1];
+
+  for (int layer = 0; layer < layerCount_; ++layer) {
+    for (int cy = y0; cy <= y1; ++cy) {
+      for (int cx = x0; cx <= x1; ++cx) {
+        int owner = kFree;
+        for (int by = 2 * cy; by <= std::min(2 * cy + 1, below.height - 1); ++by) {
+          for (int bx = 2 * cx; bx <= std::min(2 * cx + 1, below.width - 1); ++bx) {
+            owner = mergeOwner(owner, below.nearOwner[cellIndex(below, layer, bx, by)]);
+          }
+        }
+        coarse.nearOwner[cellIndex(coarse, layer, cx, cy)] = owner;
+      }
+    }
+  }
+}
+
+void OccupancyPyramid::rasterizeKeepouts() {
+  if (!board_) {
+    return;
+  }
+
+  const Level& fine = levels_[0];
+  ruleAreaCount_ = board_->getRuleAreas().size();
+  for (const auto& area : board_->getRuleAreas()) {
+    if (!area->isProhibited(RuleArea::RestrictionType::Traces)) {
+      continue;
+    }
+    IntBox box = area->getBoundingBox().expand(1).intersection(bounds_);
+    if (box.isEmpty()) {
+      continue;
+    }
+    for (int layer = 0; layer < layerCount_; ++layer) {
+      if (!area->isOnLayer(layer)) {
+        continue;
+      }
+      for (int cy = cellY(box.ll.y); cy <= cellY(box.ur.y); ++cy) {
+        for (int cx = cellX(box.ll.x); cx <= cellX(box.ur.x); ++cx) {
+          keepoutNear_[cellIndex(fine, layer, cx, cy)] = 1;
+        }
+      }
+    }
+  }
+}
+
+OccupancyPyramid::Statistics OccupancyPyramid::getStatistics() const {
+  Statistics stats;
+  stats.probes = probes_.load(std::memory_order_relaxed);
+  stats.empty = empty_.load(std::memory_order_relaxed);
+  stats.full = full_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t OccupancyPyramid::memoryBytes() const {
+  size_t bytes = levels_.capacity() * sizeof(Level) + fullOwner_.capacity() * sizeof(int) +
+                 keepoutNear_.capacity() * sizeof(u8);
+  for (const Level& level : levels_) {
+    bytes += level.nearOwner.capacity() * sizeof(int);
+  }
+  return bytes;
+}
+
+} // namespace freerouting
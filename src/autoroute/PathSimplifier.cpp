@@ -0,0 +1,154 @@
+#include "autoroute/PathSimplifier.h"
+#include "board/RoutingBoard.h"
+#include "board/RuleArea.h"
+#include "core/Types.h"
+#include "geometry/CollisionDetector.h"
+#include <algorithm>
+
+namespace freerouting {
+
+namespace {
+
+// Shortcuts are tried this many points ahead at most, which bounds the
+// checks per run for long grid paths
+constexpr size_t kMaxLookahead = 32;
+
+bool isCollinear(IntPoint a, IntPoint b, IntPoint c) {
+  i64 cross = static_cast<i64>(b.x - a.x) * (c.y - b.y) -
+              static_cast<i64>(b.y - a.y) * (c.x - b.x);
+  return cross == 0;
+}
+
+} // namespace
+
+void PathSimplifier::mergeCollinear(std::vector<IntPoint>& points, std::vector<int>& layers) {
+  if (points.size() < 2 || layers.size() != points.size()) {
+    return;
+  }
+
+  std::vector<IntPoint> outPoints{points[0]};
+  std::vector<int> outLayers{layers[0]};
+  for (size_t i = 1; i < points.size(); ++i) {
+    // Same layer as the segment before means no via at the last point
+    bool sameLayer = layers[i] == outLayers.back();
+    if (sameLayer && points[i] == outPoints.back()) {
+      continue;
+    }
+    // A collinear point in the middle of a run only splits the trace; even a
+    // reversal leaves copper already covered by the longer segment. A zero
+    // length step before it is a layer change, so the point holds a via.
+    IntPoint before = outPoints.size() >= 2 ? outPoints[outPoints.size() - 2] : outPoints.back();
+    if (sameLayer && before != outPoints.back() &&
+        isCollinear(before, outPoints.back(), points[i])) {
+      outPoints.back() = points[i];
+      continue;
+    }
+    outPoints.push_back(points[i]);
+    outLayers.push_back(layers[i]);
+  }
+
+  points = std::move(outPoints);
+  layers = std::move(outLayers);
+}
+
+int PathSimplifier::countSegments(const std::vector<IntPoint>& points) {
+  int count = 0;
+  for (size_t i = 1; i < points.size(); ++i) {
+    if (points[i] != points[i - 1]) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void PathSimplifier::simplify(std::vector<IntPoint>& points, std::vector<int>& layers) {
+  stats_.segmentsIn += countSegments(points);
+  mergeCollinear(points, layers);
+
+  if (board_ && points.size() >= 3) {
+    std::vector<IntPoint> outPoints{points[0]};
+    std::vector<int> outLayers{layers[0]};
+
+    // Runs end where the layer changes, i.e. at vias
+    size_t first = 0;
+    while (first + 1 < points.size()) {
+      size_t last = first + 1;
+      while (last + 1 < points.size() && layers[last + 1] == layers[last]) {
+        ++last;
+      }
+      cutCorners(points, first, last, layers[last], outPoints, outLayers);
+      first = last;
+    }
+
+    points = std::move(outPoints);
+    layers = std::move(outLayers);
+    mergeCollinear(points, layers);
+  }
+
+  stats_.segmentsOut += countSegments(points);
+}
+
+void PathSimplifier::cutCorners(const std::vector<IntPoint>& points, size_t first, size_t last,
+                                int layer, std::vector<IntPoint>& outPoints,
+                                std::vector<int>& outLayers) {
+  if (last - first < 2) {
+    for (size_t i = first + 1; i <= last; ++i) {
+      outPoints.push_back(points[i]);
+      outLayers.push_back(layer);
+    }
+    return;
+  }
+
+  int halfWidth = layer < static_cast<int>(halfWidths_.size()) ? halfWidths_[layer] : 1250;
+  int clearance = board_->getClearanceMatrix().getValue(1, 1, layer, true);
+
+  // Every shortcut lies inside the run's bounding box
+  IntBox region = IntBox::fromPoint(points[first]);
+  for (size_t i = first + 1; i <= last; ++i) {
+    region = region.unionWith(IntBox::fromPoint(points[i]));
+  }
+  collectObstacles(region, layer, halfWidth + clearance);
+
+  size_t current = first;
+  while (current < last) {
+    size_t next = current + 1;
+    for (size_t j = std::min(last, current + kMaxLookahead); j > current + 1; --j) {
+      if (isSegmentClear(points[current], points[j])) {
+        stats_.cornersCut += static_cast<int>(j - current - 1);
+        next = j;
+        break;
+      }
+    }
+    outPoints.push_back(points[next]);
+    outLayers.push_back(layer);
+    current = next;
+  }
+}
+
+void PathSimplifier::collectObstacles(const IntBox& region, int layer, int margin) {
+  obstacles_.clear();
+
+  IntBox searchBox = region.expand(margin);
+  for (Item* item : board_->getShapeTree().findTraceObstacles(netNo_, searchBox, layer, layer)) {
+    obstacles_.push_back(item->getBoundingBox().expand(margin));
+  }
+
+  // Keepouts only need the trace itself to stay out
+  int halfWidth = layer < static_cast<int>(halfWidths_.size()) ? halfWidths_[layer] : 1250;
+  for (const auto& area : board_->getRuleAreas()) {
+    if (area->isOnLayer(layer) && area->affectsNet(netNo_) &&
+        area->isProhibited(RuleArea::RestrictionType::Traces)) {
+      IntBox box = area->getBoundingBox().expand(halfWidth);
+      if (box.intersects(searchBox)) {
+        obstacles_.push_back(box);
+      }
+    }
+  }
+}
+
+bool PathSimplifier::isSegmentClear(IntPoint a, IntPoint b) const {
+  return std::none_of(obstacles_.begin(), obstacles_.end(),
+                      [a, b](const IntBox& box) { return CollisionDetector::segmentBoxIntersect(a, b, box); });
+}
+
+} // namespace freerouting
@@ -0,0 +1,208 @@
+#include "autoroute/PinAccess.h"
+#include "board/DrillItem.h"
+#include "board/RoutingBoard.h"
+#include "board/RuleArea.h"
+#include "board/Trace.h"
+#include "geometry/CollisionDetector.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace freerouting {
+
+PinAccess::PinAccess(const RoutingBoard* board, int halfWidth, int clearance)
+  : board_(board), halfWidth_(halfWidth), clearance_(clearance), reach_(0) {
+  std::vector<const DrillItem*> pins;
+  for (const auto& item : board_->getItems()) {
+    if (const auto* drillItem = dynamic_cast<const DrillItem*>(item.get())) {
+      pins.push_back(drillItem);
+    }
+  }
+  analyze(pins);
+}
+
+const std::vector<PinAccess::StubEnd>& PinAccess::stubEnds(const DrillItem& item) {
+  IntBox box = item.getBoundingBox();
+  int halfX = (box.ur.x - box.ll.x) / 2;
+  int halfY = (box.ur.y - box.ll.y) / 2;
+  auto key = std::make_tuple(item.getPadstack(), halfX, halfY);
+
+  auto it = stubEnds_.find(key);
+  if (it != stubEnds_.end()) {
+    return it->second;
+  }
+
+  // Far enough past the pad edge for a trace to turn without touching it
+  int step = 2 * halfWidth_ + clearance_;
+  std::vector<StubEnd> ends;
+  for (int dy = -1; dy <= 1; ++dy) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      if (dx != 0 || dy != 0) {
+        ends.push_back({IntVector(dx * (halfX + step), dy * (halfY + step)), IntVector(dx, dy)});
+      }
+    }
+  }
+  reach_ = std::max(reach_, std::max(halfX, halfY) + 2 * step);
+  return stubEnds_.emplace(key, std::move(ends)).first->second;
+}
+
+const std::vector<PinAccess::AccessPoint>& PinAccess::get(const DrillItem& item) {
+  auto [it, inserted] = pins_.try_emplace(&item);
+  if (inserted) {
+    analyze({&item});
+  }
+  return it->second.points;
+}
+
+LayerMask PinAccess::accessLayers(const DrillItem& item) {
+  get(item);
+  return pins_[&item].layers;
+}
+
+const PinAccess::AccessPoint* PinAccess::nearest(const DrillItem& item, int layer, IntPoint target) {
+  const AccessPoint* best = nullptr;
+  double bestDistance = std::numeric_limits<double>::max();
+  for (const AccessPoint& access : get(item)) {
+    if (access.layer != layer) {
+      continue;
+    }
+    double distance = (access.point.toDouble() - target.toDouble()).lengthSquared();
+    if (distance < bestDistance) {
+      bestDistance = distance;
+      best = &access;
+    }
+  }
+  return best;
+}
+
+void PinAccess::analyze(const std::vector<const DrillItem*>& items) {
+  // Every stub of every pin, with the index queries for those the
+  // occupancy bitmap can't clear; the queries are answered in one batch
+  struct Stub {
+    const DrillItem* item;
+    IntPoint from;
+    IntPoint to;
+    IntVector direction;
+    int layer;
+    int netNo;
+    bool clear;
+  };
+  std::vector<Stub> stubs;
+  std::vector<ShapeTree::Query> queries;
+  std::vector<size_t> queriedStubs;
+  const OccupancyPyramid* occupancy = board_->findOccupancy();
+  const int margin = halfWidth_ + clearance_;
+
+  for (const DrillItem* item : items) {
+    PinEntry& entry = pins_[item];
+    entry.points.clear();
+    entry.layers = 0;
+    ++analyses_;
+    if (item->netCount() == 0) {
+      continue;
+    }
+
+    const int netNo = item->getNets()[0];
+    const IntPoint center = item->getCenter();
+    const std::vector<StubEnd>& ends = stubEnds(*item);
+    for (int layer = item->firstLayer(); layer <= item->lastLayer(); ++layer) {
+      for (const StubEnd& end : ends) {
+        IntPoint point = center + end.offset;
+        IntBox stubBox = IntBox::fromPoints(center, point);
+
+        // Most stubs point into open board, which the occupancy bitmap knows
+        if (!occupancy || occupancy->probeBox(stubBox, layer, netNo, margin) != OccupancyPyramid::State::Empty) {
+          queries.push_back(ShapeTree::traceObstacleQuery(netNo, stubBox.expand(margin), layer));
+          queriedStubs.push_back(stubs.size());
+        }
+        stubs.push_back({item, center, point, end.direction, layer, netNo, true});
+      }
+    }
+  }
+
+  board_->getShapeTree().forEachTraceObstacle(queries, [&](size_t q, Item* other) {
+    Stub& stub = stubs[queriedStubs[q]];
+    if (other == stub.item || !blocksStub(*other, stub.from, stub.to, stub.layer)) {
+      return false;
+    }
+    stub.clear = false;
+    return true;
+  });
+
+  for (const Stub& stub : stubs) {
+    if (stub.clear && isKeepoutClear(stub.from, stub.to, stub.layer, stub.netNo)) {
+      PinEntry& entry = pins_[stub.item];
+      entry.points.push_back({stub.to, stub.direction, stub.layer});
+      entry.layers |= layerBit(stub.layer);
+    }
+  }
+}
+
+// Same rules as the router's conflict checks: item boxes grown by half
+// width + clearance, exact segment distance between traces
+bool PinAccess::blocksStub(const Item& other, IntPoint from, IntPoint to, int layer) const {
+  if (const auto* trace = dynamic_cast<const Trace*>(&other)) {
+    return trace->getLayer() == layer &&
+           CollisionDetector::segmentDistance(from, to, trace->getStart(), trace->getEnd()) <
+             halfWidth_ + trace->getHalfWidth() + clearance_;
+  }
+  return CollisionDetector::segmentBoxIntersect(from, to, other.getBoundingBox().expand(halfWidth_ + clearance_));
+}
+
+bool PinAccess::isKeepoutClear(IntPoint from, IntPoint to, int layer, int netNo) const {
+  for (const auto& area : board_->getRuleAreas()) {
+    if (area->isOnLayer(layer) && area->affectsNet(netNo) &&
+        area->isProhibited(RuleArea::RestrictionType::Traces) &&
+        CollisionDetector::segmentBoxIntersect(from, to, area->getBoundingBox().expand(halfWidth_))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PinAccess::refresh() {
+  if (dirtyRegions_.empty()) {
+    return;
+  }
+
+  // A pin is affected if a changed item could reach one of its stubs
+  std::unordered_set<const Item*> done;
+  std::vector<const DrillItem*> affectedPins;
+  for (const IntBox& region : dirtyRegions_) {
+    IntBox affected = region.expand(reach_ + halfWidth_ + clearance_);
+    for (Item* item : board_->getShapeTree().queryRegion(affected, kAllLayers, ShapeTree::kDrillItems)) {
+      const auto* drillItem = dynamic_cast<const DrillItem*>(item);
+      if (drillItem && done.insert(drillItem).second) {
+        affectedPins.push_back(drillItem);
+      }
+    }
+  }
+  dirtyRegions_.clear();
+  analyze(affectedPins);
+}
+
+PinAccess::Statistics PinAccess::getStatistics() const {
+  Statistics stats;
+  stats.pins = static_cast<int>(pins_.size());
+  stats.analyses = analyses_;
+  stats.templates = static_cast<int>(stubEnds_.size());
+  for (const auto& [item, entry] : pins_) {
+    if (entry.layers == 0) {
+      ++stats.blockedPins;
+    }
+  }
+  return stats;
+}
+
+size_t PinAccess::memoryBytes() const {
+  size_t bytes = pins_.bucket_count() * sizeof(void*) + dirtyRegions_.capacity() * sizeof(IntBox);
+  for (const auto& [item, entry] : pins_) {
+    bytes += sizeof(entry) + sizeof(item) + entry.points.capacity() * sizeof(AccessPoint);
+  }
+  for (const auto& [key, ends] : stubEnds_) {
+    bytes += sizeof(key) + ends.capacity() * sizeof(StubEnd);
+  }
+  return bytes;
+}
+
+} // namespace freerouting
@@ -0,0 +1,288 @@
+#include "autoroute/ProximityField.h"
+#include "board/RoutingBoard.h"
+#include "core/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace freerouting {
+
+namespace {
+
+// Floor division that rounds towards negative infinity
+i64 floorDiv(i64 a, i64 b) {
+  i64 q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// Below this many cells a recompute is cheaper than starting threads
+constexpr size_t kParallelCells = size_t(1) << 18;
+
+// Run fn(layer) for every layer, across hardware threads when there are
+// enough cells of work
+template <typename Fn>
+void forEachLayer(const std::vector<int>& layers, size_t cells, Fn fn) {
+  parallelFor(layers.size(), cells < kParallelCells ? 1 : threadCount(),
+              [&](size_t i) { fn(layers[i]); });
+}
+
+} // namespace
+
+ProximityField::ProximityField(const RoutingBoard* board, int cellSize, int range)
+  : board_(board),
+    cellSize_(std::max(1, cellSize)),
+    range_(std::max(0, range)),
+    rangeCells_((std::max(0, range) + std::max(1, cellSize) - 1) / std::max(1, cellSize)),
+    layerCount_(board ? std::max(1, board->getLayers().count()) : 1) {
+
+  bounds_ = IntBox::empty();
+  if (board_) {
+    for (const auto& item : board_->getItems()) {
+      bounds_ = bounds_.unionWith(item->getBoundingBox());
+    }
+  }
+  if (bounds_.isEmpty()) {
+    bounds_ = IntBox(0, 0, cellSize_, cellSize_);
+  }
+  bounds_ = bounds_.expand(range_ + 2 * cellSize_);
+
+  width_ = std::max(1, static_cast<int>((static_cast<i64>(bounds_.width()) + cellSize_ - 1) / cellSize_));
+  height_ = std::max(1, static_cast<int>((static_cast<i64>(bounds_.height()) + cellSize_ - 1) / cellSize_));
+  layers_.resize(layerCount_);
+
+  std::vector<int> used = rasterize(0, 0, width_ - 1, height_ - 1, 0, layerCount_ - 1);
+  forEachLayer(used, used.size() * width_ * height_, [&](int layer) {
+    computeDistances(layer, 0, 0, width_ - 1, height_ - 1);
+  });
+}
+
+std::pair<int, int> ProximityField::cellOf(IntPoint point) const {
+  i64 cx = floorDiv(static_cast<i64>(point.x) - bounds_.ll.x, cellSize_);
+  i64 cy = floorDiv(static_cast<i64>(point.y) - bounds_.ll.y, cellSize_);
+  return {static_cast<int>(std::clamp<i64>(cx, 0, width_ - 1)),
+          static_cast<int>(std::clamp<i64>(cy, 0, height_ - 1))};
+}
+
+double ProximityField::distanceAt(IntPoint point, int layer) const {
+  if (layer < 0 || layer >= layerCount_ || layers_[layer].distance.empty()) {
+    return range_;
+  }
+  auto [cx, cy] = cellOf(point);
+  return std::min<double>(range_, layers_[layer].distance[cellIndex(cx, cy)] * cellSize_);
+}
+
+int ProximityField::nearestOwnerAt(IntPoint point, int layer) const {
+  if (layer < 0 || layer >= layerCount_ || layers_[layer].nearest.empty()) {
+    return kFree;
+  }
+  auto [cx, cy] = cellOf(point);
+  return layers_[layer].nearest[cellIndex(cx, cy)];
+}
+
+double ProximityField::costAt(IntPoint point, int layer, int netNo, double weight) const {
+  if (layer < 0 || layer >= layerCount_ || layers_[layer].nearest.empty()) {
+    return 0.0;
+  }
+  const LayerGrid& grid = layers_[layer];
+  auto [cx, cy] = cellOf(point);
+  size_t idx = cellIndex(cx, cy);
+  int owner = grid.nearest[idx];
+  if (owner == kFree || owner == netNo) {
+    return 0.0;
+  }
+  double distance = std::min<double>(range_, grid.distance[idx] * cellSize_);
+  return weight * (range_ - distance);
+}
+
+void ProximityField::refresh() {
+  if (dirtyRegions_.empty()) {
+    return;
+  }
+
+  std::vector<DirtyRegion> regions;
+  regions.swap(dirtyRegions_);
+
+  for (const DirtyRegion& region : regions) {
+    IntBox clipped = region.box.intersection(bounds_);
+    int firstLayer = std::max(0, region.firstLayer);
+    int lastLayer = std::min(layerCount_ - 1, region.lastLayer);
+    if (clipped.isEmpty() || firstLayer > lastLayer) {
+      continue;
+    }
+
+    auto [x0, y0] = cellOf(clipped.ll);
+    auto [x1, y1] = cellOf(clipped.ur);
+    std::vector<int> used = rasterize(x0, y0, x1, y1, firstLayer, lastLayer);
+
+    // Only cells within range of the change can see a different distance
+    int tx0 = std::max(0, x0 - rangeCells_);
+    int ty0 = std::max(0, y0 - rangeCells_);
+    int tx1 = std::min(width_ - 1, x1 + rangeCells_);
+    int ty1 = std::min(height_ - 1, y1 + rangeCells_);
+    size_t cells = used.size() * static_cast<size_t>(tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+    forEachLayer(used, cells, [&](int layer) {
+      computeDistances(layer, tx0, ty0, tx1, ty1);
+    });
+  }
+}
+
+std::vector<int> ProximityField::rasterize(int x0, int y0, int x1, int y1,
+                                           int firstLayer, int lastLayer) {
+  for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+    LayerGrid& grid = layers_[layer];
+    if (grid.owner.empty()) continue;
+    for (int cy = y0; cy <= y1; ++cy) {
+      size_t row = cellIndex(0, cy);
+      std::fill(grid.owner.begin() + row + x0, grid.owner.begin() + row + x1 + 1, kFree);
+    }
+  }
+
+  if (board_) {
+    IntBox rangeBox(
+      static_cast<int>(bounds_.ll.x + static_cast<i64>(x0) * cellSize_),
+      static_cast<int>(bounds_.ll.y + static_cast<i64>(y0) * cellSize_),
+      static_cast<int>(bounds_.ll.x + static_cast<i64>(x1 + 1) * cellSize_ - 1),
+      static_cast<int>(bounds_.ll.y + static_cast<i64>(y1 + 1) * cellSize_ - 1));
+
+    // Every cell an item's box touches holds copper
+    for (Item* item : board_->getShapeTree().queryRegion(rangeBox, layerRangeMask(firstLayer, lastLayer))) {
+      int itemFirst = std::max(firstLayer, item->firstLayer());
+      int itemLast = std::min(lastLayer, item->lastLayer());
+      IntBox box = item->getBoundingBox().intersection(rangeBox);
+      if (itemFirst > itemLast || box.isEmpty()) {
+        continue;
+      }
+
+      const std::vector<int>& nets = item->getNets();
+      int itemOwner = nets.size() == 1 ? nets[0] : kBlocked;
+      auto [ix0, iy0] = cellOf(box.ll);
+      auto [ix1, iy1] = cellOf(box.ur);
+
+      for (int layer = itemFirst; layer <= itemLast; ++layer) {
+        LayerGrid& grid = layers_[layer];
+        if (grid.owner.empty()) {
+          size_t cells = static_cast<size_t>(width_) * height_;
+          grid.owner.assign(cells, kFree);
+          grid.distance.assign(cells, static_cast<float>(rangeCells_));
+          grid.nearest.assign(cells, kFree);
+        }
+
+        for (int cy = iy0; cy <= iy1; ++cy) {
+          size_t row = cellIndex(0, cy);
+          for (int cx = ix0; cx <= ix1; ++cx) {
+            int& owner = grid.owner[row + cx];
+            owner = (owner == kFree || owner == itemOwner) ? itemOwner : kBlocked;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<int> used;
+  for (int layer = firstLayer; layer <= lastLayer; ++layer) {
+    if (!layers_[layer].owner.empty()) {
+      used.push_back(layer);
+    }
+  }
+  return used;
+}
+
+void ProximityField::computeDistances(int layer, int x0, int y0, int x1, int y1) {
+  LayerGrid& grid = layers_[layer];
+
+  // Copper up to range cells outside the target can still be the nearest
+  const int wx0 = std::max(0, x0 - rangeCells_);
+  const int wy0 = std::max(0, y0 - rangeCells_);
+  const int wx1 = std::min(width_ - 1, x1 + rangeCells_);
+  const int wy1 = std::min(height_ - 1, y1 + rangeCells_);
+  const int ww = wx1 - wx0 + 1;
+  const int wh = wy1 - wy0 + 1;
+  const i32 far = rangeCells_ + 1;  // Saturated "out of range" distance
+
+  std::vector<i32> vdist(static_cast<size_t>(ww) * wh);
+  std::vector<i32> vrow(static_cast<size_t>(ww) * wh);
+
+  // Pass 1: vertical distance to copper in the same column, as a forward and
+  // a backward sweep over whole rows (independent across x, so vectorizable)
+  for (int y = 0; y < wh; ++y) {
+    const int* owner = grid.owner.data() + cellIndex(wx0, wy0 + y);
+    i32* d = vdist.data() + static_cast<size_t>(y) * ww;
+    i32* r = vrow.data() + static_cast<size_t>(y) * ww;
+    const i32* dPrev = y > 0 ? d - ww : nullptr;
+    const i32* rPrev = y > 0 ? r - ww : nullptr;
+
+    for (int x = 0; x < ww; ++x) {
+      bool copper = owner[x] != kFree;
+      i32 carried = dPrev ? std::min(dPrev[x] + 1, far) : far;
+      d[x] = copper ? 0 : carried;
+      r[x] = copper ? wy0 + y : (dPrev ? rPrev[x] : -1);
+    }
+  }
+
+  for (int y = wh - 2; y >= 0; --y) {
+    i32* d = vdist.data() + static_cast<size_t>(y) * ww;
+    i32* r = vrow.data() + static_cast<size_t>(y) * ww;
+    const i32* dNext = d + ww;
+    const i32* rNext = r + ww;
+
+    for (int x = 0; x < ww; ++x) {
+      i32 carried = std::min(dNext[x] + 1, far);
+      bool closer = carried < d[x];
+      d[x] = closer ? carried : d[x];
+      r[x] = closer ? rNext[x] : r[x];
+    }
+  }
+
+  // Pass 2: exact 2D distance along each target row from the lower envelope
+  // of the parabolas (x - q)^2 + vdist(q)^2 (Felzenszwalb-Huttenlocher)
+  std::vector<int> sites(ww);
+  std::vector<double> bounds(ww + 1);
+
+  for (int y = y0; y <= y1; ++y) {
+    const i32* d = vdist.data() + static_cast<size_t>(y - wy0) * ww;
+    const i32* r = vrow.data() + static_cast<size_t>(y - wy0) * ww;
+    auto f = [d](int q) { return static_cast<double>(d[q]) * d[q]; };
+
+    int k = -1;
+    for (int q = 0; q < ww; ++q) {
+      if (d[q] >= far) continue;
+
+      double s = 0.0;
+      while (k >= 0) {
+        int v = sites[k];
+        s = ((f(q) + static_cast<double>(q) * q) - (f(v) + static_cast<double>(v) * v)) /
+            (2.0 * (q - v));
+        if (s > bounds[k]) break;
+        --k;
+      }
+
+      ++k;
+      sites[k] = q;
+      bounds[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+      bounds[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    int j = 0;
+    for (int x = x0; x <= x1; ++x) {
+      size_t out = cellIndex(x, y);
+      int lx = x - wx0;
+      double dist = std::numeric_limits<double>::infinity();
+      int q = 0;
+      if (k >= 0) {
+        while (j < k && bounds[j + 1] < lx) ++j;
+        q = sites[j];
+        dist = std::sqrt(static_cast<double>(lx - q) * (lx - q) + f(q));
+      }
+
+      if (dist > rangeCells_) {
+        grid.distance[out] = static_cast<float>(rangeCells_);
+        grid.nearest[out] = kFree;
+      } else {
+        grid.distance[out] = static_cast<float>(dist);
+        grid.nearest[out] = grid.owner[cellIndex(wx0 + q, r[q])];
+      }
+    }
+  }
+}
+
+} // namespace freerouting
@@ -39,8 +39,8 @@ PushAndShove::PushResult PushAndShove::tryPushObstacles(
     traceBox.ur.y + requiredClearance
   );
 
-  // Find all items in the conflict region
-  const auto& items = board_->getShapeTree().queryRegion(queryBox);
+  // Find all items in the conflict region on this layer
+  const auto& items = board_->getShapeTree().queryRegion(queryBox, layerBit(layer));
 
   // Categorize obstacles
   std::vector<Trace*> traceObstacles;
@@ -49,11 +49,6 @@ PushAndShove::PushResult PushAndShove::tryPushObstacles(
   for (Item* item : items) {
     if (!item) continue;
 
-    // Skip items on different layers
-    if (item->lastLayer() < layer || item->firstLayer() > layer) {
-      continue;
-    }
-
     // Skip items on the same net
     const auto& itemNets = item->getNets();
     if (std::find(itemNets.begin(), itemNets.end(), netNo) != itemNets.end()) {
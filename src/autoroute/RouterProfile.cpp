@@ -0,0 +1,166 @@
+#include "autoroute/RouterProfile.h"
+#include <fstream>
+#include <sstream>
+
+namespace freerouting {
+
+namespace {
+
+std::string trim(const std::string& s) {
+  size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+bool parseInt(const std::string& value, int minValue, int& out) {
+  try {
+    size_t used = 0;
+    int v = std::stoi(value, &used);
+    if (used != value.size() || v < minValue) {
+      return false;
+    }
+    out = v;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+bool parseDouble(const std::string& value, double minValue, double& out) {
+  try {
+    size_t used = 0;
+    double v = std::stod(value, &used);
+    if (used != value.size() || v < minValue) {
+      return false;
+    }
+    out = v;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+} // namespace
+
+bool RouterProfile::parse(const std::string& text, BatchAutorouter::Config& config,
+                          std::string& errorMsg) {
+  BatchAutorouter::Config result = config;
+  std::istringstream in(text);
+  std::string line;
+  int lineNo = 0;
+
+  while (std::getline(in, line)) {
+    ++lineNo;
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    line = trim(line);
+    if (line.empty()) {
+      continue;
+    }
+
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+      errorMsg = "line " + std::to_string(lineNo) + ": expected key = value";
+      return false;
+    }
+    std::string key = trim(line.substr(0, eq));
+    std::string value = trim(line.substr(eq + 1));
+
+    bool ok = true;
+    if (key == "max_passes") {
+      ok = parseInt(value, 1, result.maxPasses);
+    } else if (key == "start_ripup_costs") {
+      ok = parseInt(value, 0, result.startRipupCosts);
+    } else if (key == "via_cost") {
+      ok = parseDouble(value, 0.0, result.viaCost);
+    } else if (key == "trace_cost_preferred") {
+      ok = parseDouble(value, 0.0, result.traceCostPreferred);
+    } else if (key == "trace_cost_against") {
+      ok = parseDouble(value, 0.0, result.traceCostAgainst);
+    } else if (key == "max_iterations_base") {
+      ok = parseInt(value, 1, result.maxIterationsBase);
+    } else if (key == "max_iterations_per_connection") {
+      ok = parseInt(value, 0, result.maxIterationsPerConnection);
+    } else if (key == "proximity_cost_weight") {
+      ok = parseDouble(value, 0.0, result.proximityCostWeight);
+    } else if (key == "proximity_range") {
+      ok = parseInt(value, 0, result.proximityRange);
+    } else if (key == "connection_order") {
+      if (value == "size") {
+        result.connectionOrder = BatchAutorouter::Config::ConnectionOrder::NetSize;
+      } else if (value == "hilbert") {
+        result.connectionOrder = BatchAutorouter::Config::ConnectionOrder::Hilbert;
+      } else {
+        ok = false;
+      }
+    } else {
+      errorMsg = "line " + std::to_string(lineNo) + ": unknown key '" + key + "'";
+      return false;
+    }
+
+    if (!ok) {
+      errorMsg = "line " + std::to_string(lineNo) + ": invalid value '" + value + "' for " + key;
+      return false;
+    }
+  }
+
+  config = result;
+  return true;
+}
+
+std::string RouterProfile::format(const BatchAutorouter::Config& config,
+                                  const std::string& comment) {
+  std::ostringstream out;
+  std::istringstream commentLines(comment);
+  std::string line;
+  while (std::getline(commentLines, line)) {
+    out << "# " << line << "\n";
+  }
+
+  out << "max_passes = " << config.maxPasses << "\n";
+  out << "start_ripup_costs = " << config.startRipupCosts << "\n";
+  out << "via_cost = " << config.viaCost << "\n";
+  out << "trace_cost_preferred = " << config.traceCostPreferred << "\n";
+  out << "trace_cost_against = " << config.traceCostAgainst << "\n";
+  out << "max_iterations_base = " << config.maxIterationsBase << "\n";
+  out << "max_iterations_per_connection = " << config.maxIterationsPerConnection << "\n";
+  out << "proximity_cost_weight = " << config.proximityCostWeight << "\n";
+  out << "proximity_range = " << config.proximityRange << "\n";
+  out << "connection_order = "
+      << (config.connectionOrder == BatchAutorouter::Config::ConnectionOrder::Hilbert
+          ? "hilbert" : "size") << "\n";
+  return out.str();
+}
+
+bool RouterProfile::loadFromFile(const std::string& filename, BatchAutorouter::Config& config,
+                                 std::string& errorMsg) {
+  std::ifstream in(filename);
+  if (!in) {
+    errorMsg = "cannot open " + filename;
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  if (!parse(buffer.str(), config, errorMsg)) {
+    errorMsg = filename + ": " + errorMsg;
+    return false;
+  }
+  return true;
+}
+
+bool RouterProfile::saveToFile(const std::string& filename, const BatchAutorouter::Config& config,
+                               const std::string& comment) {
+  std::ofstream out(filename);
+  if (!out) {
+    return false;
+  }
+  out << format(config, comment);
+  return static_cast<bool>(out);
+}
+
+} // namespace freerouting
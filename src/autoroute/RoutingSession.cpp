@@ -0,0 +1,250 @@
+#include "autoroute/RoutingSession.h"
+#include "autoroute/AutorouteControl.h"
+#include "board/DrillItem.h"
+#include "board/RuleArea.h"
+#include "board/Trace.h"
+#include "datastructures/Stoppable.h"
+#include "geometry/CollisionDetector.h"
+#include <algorithm>
+#include <chrono>
+
+namespace freerouting {
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Half the larger side of a box: the radius of a round pad or via
+int radiusOf(const IntBox& box) {
+  return std::max(box.ur.x - box.ll.x, box.ur.y - box.ll.y) / 2;
+}
+
+} // namespace
+
+RoutingSession::RoutingSession(std::unique_ptr<RoutingBoard> board)
+  : board_(std::move(board)), engine_(board_.get()) {
+  // Converters may number items themselves; routes must not reuse their IDs,
+  // and new items are recognised by their IDs
+  int lastItemId = 0;
+  for (const auto& item : board_->getItems()) {
+    lastItemId = std::max(lastItemId, item->getId());
+  }
+  board_->reserveItemIds(lastItemId);
+}
+
+int RoutingSession::addItem(std::unique_ptr<Item> item) {
+  if (!item) {
+    return -1;
+  }
+  int itemId = item->getId();
+  board_->reserveItemIds(itemId);
+  board_->addItem(std::move(item));
+  boardChanged();
+  return itemId;
+}
+
+bool RoutingSession::removeItem(int itemId) {
+  if (!board_->removeItem(itemId)) {
+    return false;
+  }
+  boardChanged();
+  return true;
+}
+
+bool RoutingSession::moveItem(int itemId, IntVector offset) {
+  Item* item = board_->getItem(itemId);
+  if (!item) {
+    return false;
+  }
+
+  // The moved copy keeps the ID; it replaces the item in the spatial index
+  // and the rasters like any other edit
+  std::unique_ptr<Item> moved;
+  if (const Trace* trace = dynamic_cast<const Trace*>(item)) {
+    moved = std::make_unique<Trace>(
+      trace->getStart() + offset, trace->getEnd() + offset, trace->getLayer(),
+      trace->getHalfWidth(), trace->getNets(), trace->getClearanceClass(), itemId,
+      trace->getFixedState(), board_.get());
+  } else if (dynamic_cast<const DrillItem*>(item)) {
+    moved.reset(item->copy(itemId));
+    auto* drillItem = static_cast<DrillItem*>(moved.get());
+    drillItem->setCenter(drillItem->getCenter() + offset);
+  } else {
+    return false;
+  }
+
+  board_->removeItem(itemId);
+  board_->addItem(std::move(moved));
+  boardChanged();
+  return true;
+}
+
+RoutingSession::Result RoutingSession::routeConnection(int fromItemId, int toItemId,
+                                                       const Options& options) {
+  auto start = std::chrono::steady_clock::now();
+  Result result;
+
+  Item* from = board_->getItem(fromItemId);
+  Item* to = board_->getItem(toItemId);
+  if (!from || !to || from->netCount() == 0 || !to->containsNet(from->getNets()[0])) {
+    result.status = Status::InvalidItems;
+    return result;
+  }
+  int netNo = from->getNets()[0];
+
+  AutorouteControl control(board_->getLayers().count());
+  for (int i = 0; i < control.layerCount; ++i) {
+    control.traceHalfWidth[i] = options.traceHalfWidth;
+  }
+  // Interactive routes never move other copper
+  control.ripupAllowed = false;
+  control.pushAndShoveEnabled = false;
+  control.maxIterations = options.maxIterations;
+  control.gridFallbackEnabled = options.gridFallback;
+  control.simplifyPaths = options.simplifyPaths;
+  control.searchWindow = from->getBoundingBox().unionWith(to->getBoundingBox()).expand(options.margin);
+
+  // A Stoppable rather than a TimeLimit: the engine passes it on to the
+  // grid router, which does not look at a TimeLimit
+  DeadlineStoppable deadline(options.timeLimitMs);
+  engine_.clear();
+  engine_.initConnection(netNo, &deadline, nullptr);
+  engine_.initializeSearchTree(control.searchWindow);
+  result.windowItems = engine_.autorouteSearchTree ? engine_.autorouteSearchTree->size() : 0;
+
+  // New items go on the end of the board's list with increasing IDs
+  const int firstNewId = board_->peekNextItemId();
+  std::vector<Item*> startSet{from};
+  std::vector<Item*> destSet{to};
+  std::vector<Item*> rippedItems;
+  AutorouteEngine::AutorouteResult routed =
+    engine_.autorouteConnection(startSet, destSet, control, rippedItems);
+  result.searchMs = msSince(start);
+
+  const auto& items = board_->getItems();
+  for (auto it = items.rbegin(); it != items.rend() && (*it)->getId() >= firstNewId; ++it) {
+    result.newItemIds.push_back((*it)->getId());
+  }
+  std::reverse(result.newItemIds.begin(), result.newItemIds.end());
+
+  switch (routed) {
+    case AutorouteEngine::AutorouteResult::Routed:
+      result.status = Status::Routed;
+      break;
+    case AutorouteEngine::AutorouteResult::AlreadyConnected:
+      result.status = Status::AlreadyConnected;
+      break;
+    default:
+      result.status = Status::NotRouted;
+      break;
+  }
+
+  if (!result.newItemIds.empty()) {
+    auto validateStart = std::chrono::steady_clock::now();
+    result.conflicts = countConflicts(result.newItemIds);
+    result.validateMs = msSince(validateStart);
+
+    if (result.status != Status::Routed || (result.conflicts > 0 && options.rejectConflicts)) {
+      if (result.status == Status::Routed) {
+        result.status = Status::Conflict;
+      }
+      removeRoute(result);
+      result.newItemIds.clear();
+    } else {
+      boardChanged();
+    }
+  }
+
+  result.totalMs = msSince(start);
+  return result;
+}
+
+void RoutingSession::removeRoute(const Result& result) {
+  for (int itemId : result.newItemIds) {
+    board_->removeItem(itemId);
+  }
+  boardChanged();
+}
+
+int RoutingSession::countConflicts(const std::vector<int>& itemIds) const {
+  int conflicts = 0;
+  for (int itemId : itemIds) {
+    if (const Item* item = board_->getItem(itemId)) {
+      conflicts += countConflicts(*item);
+    }
+  }
+  return conflicts;
+}
+
+// Same rules as the router: the clearance between default classes, item
+// bounding boxes for pins and vias, exact segment distance between traces
+int RoutingSession::countConflicts(const Item& item) const {
+  if (item.netCount() == 0) {
+    return 0;
+  }
+  const int netNo = item.getNets()[0];
+  const Trace* trace = dynamic_cast<const Trace*>(&item);
+  const DrillItem* drillItem = dynamic_cast<const DrillItem*>(&item);
+  if (!trace && !drillItem) {
+    return 0;
+  }
+
+  int conflicts = 0;
+  for (int layer = item.firstLayer(); layer <= item.lastLayer(); ++layer) {
+    const int clearance = board_->getClearanceMatrix().getValue(1, 1, layer, true);
+    IntBox searchBox = item.getBoundingBox().expand(clearance);
+
+    for (Item* other : board_->getShapeTree().findTraceObstacles(netNo, searchBox, layer, layer)) {
+      const Trace* otherTrace = dynamic_cast<const Trace*>(other);
+      if (otherTrace && otherTrace->getLayer() != layer) {
+        continue;
+      }
+      bool conflict;
+      if (trace && otherTrace) {
+        conflict = CollisionDetector::segmentDistance(trace->getStart(), trace->getEnd(),
+                                                      otherTrace->getStart(), otherTrace->getEnd()) <
+                   trace->getHalfWidth() + otherTrace->getHalfWidth() + clearance;
+      } else if (trace) {
+        conflict = CollisionDetector::segmentBoxIntersect(
+          trace->getStart(), trace->getEnd(),
+          other->getBoundingBox().expand(trace->getHalfWidth() + clearance));
+      } else if (otherTrace) {
+        conflict = CollisionDetector::pointSegmentDistance(
+                     drillItem->getCenter(), otherTrace->getStart(), otherTrace->getEnd()) <
+                   radiusOf(item.getBoundingBox()) + otherTrace->getHalfWidth() + clearance;
+      } else {
+        conflict = item.getBoundingBox().expand(clearance).intersects(other->getBoundingBox());
+      }
+      if (conflict) {
+        ++conflicts;
+      }
+    }
+
+    auto restriction = trace ? RuleArea::RestrictionType::Traces : RuleArea::RestrictionType::Vias;
+    for (const auto& area : board_->getRuleAreas()) {
+      if (area->isOnLayer(layer) && area->affectsNet(netNo) && area->isProhibited(restriction) &&
+          area->getBoundingBox().intersects(item.getBoundingBox())) {
+        ++conflicts;
+      }
+    }
+  }
+  return conflicts;
+}
+
+const std::vector<IncompleteConnection>& RoutingSession::getIncompleteConnections() {
+  if (connectionsDirty_) {
+    board_->updateIncompleteConnections();
+    connectionsDirty_ = false;
+  }
+  return board_->getIncompleteConnections();
+}
+
+void RoutingSession::boardChanged() {
+  // Room generators cache rooms computed from the items
+  engine_.clearRoomGenerators();
+  connectionsDirty_ = true;
+}
+
+} // namespace freerouting
@@ -0,0 +1,247 @@
+#include "autoroute/RoutingWorkerPool.h"
+#include "board/BasicBoard.h"
+#include "datastructures/Stoppable.h"
+#include "datastructures/TimeLimit.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace freerouting {
+
+namespace {
+
+// Frames larger than this are treated as a corrupt stream
+constexpr u32 kMaxFrameBytes = 1u << 30;
+
+// How often the coordinator looks at the Stoppable while workers route
+constexpr int kPollMs = 100;
+
+// Time workers get to send what they have routed once a stop is requested;
+// they stop themselves at their job's time limit, but not for a stop
+// request, so after this they are killed
+constexpr int kStopGraceMs = 1000;
+
+bool sendAll(int fd, const u8* data, size_t size) {
+  while (size > 0) {
+    // No SIGPIPE if the other end has gone away; the error is returned instead
+    ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+bool receiveAll(int fd, u8* data, size_t size) {
+  while (size > 0) {
+    ssize_t received = recv(fd, data, size, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) {
+      return false;
+    }
+    data += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+} // namespace
+
+RoutingWorkerPool::~RoutingWorkerPool() {
+  stop();
+}
+
+int RoutingWorkerPool::start(int count) {
+  // Anything still buffered would otherwise be written by every worker too
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+
+  for (int i = 0; i < count; ++i) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+      break;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+      close(fds[0]);
+      close(fds[1]);
+      break;
+    }
+
+    if (pid == 0) {
+      close(fds[0]);
+      for (const Worker& worker : workers_) {
+        close(worker.fd);
+      }
+      serve(fds[1], *rules_, routing_);
+      _exit(0);
+    }
+
+    close(fds[1]);
+    workers_.push_back({pid, fds[0]});
+  }
+  return size();
+}
+
+void RoutingWorkerPool::stop() {
+  for (const Worker& worker : workers_) {
+    close(worker.fd);
+  }
+  for (const Worker& worker : workers_) {
+    int status = 0;
+    waitpid(worker.pid, &status, 0);
+  }
+  workers_.clear();
+}
+
+std::vector<TileOutcome> RoutingWorkerPool::run(const std::vector<TileJob>& jobs, Stoppable* stoppable) {
+  std::vector<TileOutcome> outcomes(jobs.size());
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    outcomes[i].jobId = jobs[i].jobId;
+  }
+
+  constexpr size_t kIdle = static_cast<size_t>(-1);
+  std::vector<size_t> running(workers_.size(), kIdle);  // Job index per worker
+  std::vector<bool> alive(workers_.size(), true);
+  size_t next = 0;
+
+  auto dispatch = [&](size_t w) {
+    if (next >= jobs.size() || (stoppable && stoppable->isStopRequested())) {
+      return;
+    }
+    std::vector<u8> payload = jobs[next].encode();
+    if (writeFrame(workers_[w].fd, payload)) {
+      bytesSent_ += payload.size();
+      running[w] = next++;
+    } else {
+      alive[w] = false;
+    }
+  };
+
+  for (size_t w = 0; w < workers_.size(); ++w) {
+    dispatch(w);
+  }
+
+  TimeLimit grace;
+  bool stopping = false;
+  while (true) {
+    if (!stopping && stoppable && stoppable->isStopRequested()) {
+      stopping = true;
+      grace = TimeLimit(kStopGraceMs);
+    }
+    if (stopping && grace.isExceeded()) {
+      // Abandon the jobs still running; they stay unrouted
+      for (size_t w = 0; w < workers_.size(); ++w) {
+        if (running[w] != kIdle) {
+          kill(workers_[w].pid, SIGKILL);
+          running[w] = kIdle;
+          alive[w] = false;
+        }
+      }
+    }
+
+    std::vector<pollfd> polls;
+    std::vector<size_t> polled;
+    for (size_t w = 0; w < workers_.size(); ++w) {
+      if (running[w] != kIdle) {
+        polls.push_back({workers_[w].fd, POLLIN, 0});
+        polled.push_back(w);
+      }
+    }
+    if (polls.empty()) {
+      break;
+    }
+
+    if (poll(polls.data(), polls.size(), kPollMs) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    for (size_t p = 0; p < polls.size(); ++p) {
+      if (polls[p].revents == 0) continue;
+      size_t w = polled[p];
+      size_t job = running[w];
+      running[w] = kIdle;
+
+      std::vector<u8> payload;
+      std::optional<TileOutcome> outcome;
+      if (readFrame(workers_[w].fd, payload)) {
+        outcome = TileOutcome::decode(payload);
+      }
+      if (outcome && outcome->jobId == jobs[job].jobId) {
+        outcomes[job] = std::move(*outcome);
+        dispatch(w);
+      } else {
+        // Worker died or sent garbage; its job stays unrouted
+        alive[w] = false;
+      }
+    }
+  }
+
+  // Drop dead workers so that later runs don't use them
+  std::vector<Worker> living;
+  for (size_t w = 0; w < workers_.size(); ++w) {
+    if (alive[w]) {
+      living.push_back(workers_[w]);
+    } else {
+      close(workers_[w].fd);
+      int status = 0;
+      waitpid(workers_[w].pid, &status, 0);
+    }
+  }
+  workers_ = std::move(living);
+
+  return outcomes;
+}
+
+void RoutingWorkerPool::serve(int fd, const BasicBoard& rules, const BatchAutorouter::Config& routing) {
+  std::vector<u8> payload;
+  while (readFrame(fd, payload)) {
+    std::optional<TileJob> job = TileJob::decode(payload);
+    if (!job) {
+      break;
+    }
+    TileOutcome outcome = job->route(rules, routing, nullptr);
+    if (!writeFrame(fd, outcome.encode())) {
+      break;
+    }
+  }
+  close(fd);
+}
+
+bool RoutingWorkerPool::writeFrame(int fd, const std::vector<u8>& payload) {
+  u8 header[4];
+  u32 size = static_cast<u32>(payload.size());
+  for (int i = 0; i < 4; ++i) {
+    header[i] = static_cast<u8>(size >> (8 * i));
+  }
+  return sendAll(fd, header, sizeof(header)) && sendAll(fd, payload.data(), payload.size());
+}
+
+bool RoutingWorkerPool::readFrame(int fd, std::vector<u8>& payload) {
+  u8 header[4];
+  if (!receiveAll(fd, header, sizeof(header))) {
+    return false;
+  }
+  u32 size = 0;
+  for (int i = 0; i < 4; ++i) {
+    size |= static_cast<u32>(header[i]) << (8 * i);
+  }
+  if (size > kMaxFrameBytes) {
+    return false;
+  }
+  payload.resize(size);
+  return receiveAll(fd, payload.data(), size);
+}
+
+} // namespace freerouting
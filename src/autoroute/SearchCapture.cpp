@@ -0,0 +1,165 @@
+#include "autoroute/SearchCapture.h"
+#include "board/RoutingBoard.h"
+#include "core/ByteCodec.h"
+#include <algorithm>
+#include <fstream>
+
+namespace freerouting {
+
+namespace {
+
+i16 clampLayer(int layer) {
+  return static_cast<i16>(std::clamp(layer, -1, 32767));
+}
+
+} // namespace
+
+void SearchCapture::begin(const RoutingBoard& board, int netNo, int passNo) {
+  netNo_ = netNo;
+  passNo_ = passNo;
+  layerCount_ = board.getLayers().count();
+  outcome_ = Outcome::NotFound;
+  records_.clear();
+  doorIds_.clear();
+
+  bounds_ = IntBox();
+  for (const auto& item : board.getItems()) {
+    IntBox box = item->getBoundingBox();
+    bounds_.ll.x = std::min(bounds_.ll.x, box.ll.x);
+    bounds_.ll.y = std::min(bounds_.ll.y, box.ll.y);
+    bounds_.ur.x = std::max(bounds_.ur.x, box.ur.x);
+    bounds_.ur.y = std::max(bounds_.ur.y, box.ur.y);
+
+    int net = item->netCount() > 0 ? item->getNets()[0] : -1;
+    records_.push_back({Kind::Obstacle, clampLayer(item->firstLayer()),
+                        clampLayer(item->lastLayer()), box, net});
+  }
+}
+
+void SearchCapture::addRoom(const IntBox& box, int layer, int roomId) {
+  records_.push_back({Kind::Room, clampLayer(layer), clampLayer(layer), box, roomId});
+}
+
+void SearchCapture::addObstacleRoom(const IntBox& box, int layer, int itemId) {
+  records_.push_back({Kind::ObstacleRoom, clampLayer(layer), clampLayer(layer), box, itemId});
+}
+
+void SearchCapture::addDoor(Kind kind, const void* door, const IntBox& box, int layer,
+                            double expansionValue, double sortingValue) {
+  records_.push_back({kind, clampLayer(layer), clampLayer(layer), box, doorId(door),
+                      static_cast<f32>(expansionValue), static_cast<f32>(sortingValue)});
+}
+
+void SearchCapture::addPathPoint(IntPoint point, int layer, const void* door) {
+  records_.push_back({Kind::PathPoint, clampLayer(layer), clampLayer(layer),
+                      IntBox(point, point), door ? doorId(door) : -1});
+}
+
+void SearchCapture::clearPath() {
+  std::erase_if(records_, [](const Record& r) { return r.kind == Kind::PathPoint; });
+}
+
+size_t SearchCapture::count(Kind kind) const {
+  return static_cast<size_t>(std::count_if(records_.begin(), records_.end(),
+    [kind](const Record& r) { return r.kind == kind; }));
+}
+
+int SearchCapture::doorId(const void* door) {
+  auto [it, inserted] = doorIds_.try_emplace(door, static_cast<int>(doorIds_.size()));
+  return it->second;
+}
+
+bool SearchCapture::writeToFile(const std::string& filename) const {
+  std::vector<u8> data;
+  data.reserve(40 + records_.size() * 33);
+
+  putValue<u32>(data, kMagic);
+  putValue<u32>(data, kVersion);
+  putValue<i32>(data, netNo_);
+  putValue<i32>(data, passNo_);
+  putValue<i32>(data, layerCount_);
+  putValue<i32>(data, bounds_.ll.x);
+  putValue<i32>(data, bounds_.ll.y);
+  putValue<i32>(data, bounds_.ur.x);
+  putValue<i32>(data, bounds_.ur.y);
+  putValue<u8>(data, static_cast<u8>(outcome_));
+  putValue<u32>(data, static_cast<u32>(records_.size()));
+
+  for (const Record& r : records_) {
+    putValue<u8>(data, static_cast<u8>(r.kind));
+    putValue<i16>(data, r.firstLayer);
+    putValue<i16>(data, r.lastLayer);
+    putValue<i32>(data, r.box.ll.x);
+    putValue<i32>(data, r.box.ll.y);
+    putValue<i32>(data, r.box.ur.x);
+    putValue<i32>(data, r.box.ur.y);
+    putValue<i32>(data, r.tag);
+    putValue<f32>(data, r.expansionValue);
+    putValue<f32>(data, r.sortingValue);
+  }
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    return false;
+  }
+  out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(out);
+}
+
+std::optional<SearchCapture> SearchCapture::readFromFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+  std::vector<u8> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  size_t pos = 0;
+  u32 magic = 0;
+  u32 version = 0;
+  if (!getValue(data, pos, magic) || magic != kMagic ||
+      !getValue(data, pos, version) || version != kVersion) {
+    return std::nullopt;
+  }
+
+  SearchCapture capture;
+  u8 outcome = 0;
+  u32 recordCount = 0;
+  bool ok = getValue(data, pos, capture.netNo_) &&
+            getValue(data, pos, capture.passNo_) &&
+            getValue(data, pos, capture.layerCount_) &&
+            getValue(data, pos, capture.bounds_.ll.x) &&
+            getValue(data, pos, capture.bounds_.ll.y) &&
+            getValue(data, pos, capture.bounds_.ur.x) &&
+            getValue(data, pos, capture.bounds_.ur.y) &&
+            getValue(data, pos, outcome) &&
+            getValue(data, pos, recordCount);
+  if (!ok) {
+    return std::nullopt;
+  }
+  capture.outcome_ = static_cast<Outcome>(outcome);
+
+  capture.records_.reserve(std::min<size_t>(recordCount, data.size() / 33));
+  for (u32 i = 0; i < recordCount; ++i) {
+    Record r{};
+    u8 kind = 0;
+    ok = getValue(data, pos, kind) &&
+         getValue(data, pos, r.firstLayer) &&
+         getValue(data, pos, r.lastLayer) &&
+         getValue(data, pos, r.box.ll.x) &&
+         getValue(data, pos, r.box.ll.y) &&
+         getValue(data, pos, r.box.ur.x) &&
+         getValue(data, pos, r.box.ur.y) &&
+         getValue(data, pos, r.tag) &&
+         getValue(data, pos, r.expansionValue) &&
+         getValue(data, pos, r.sortingValue);
+    if (!ok) {
+      return std::nullopt;
+    }
+    r.kind = static_cast<Kind>(kind);
+    capture.records_.push_back(r);
+  }
+
+  return capture;
+}
+
+} // namespace freerouting
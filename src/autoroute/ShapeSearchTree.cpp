@@ -36,11 +36,42 @@ void ShapeSearchTree::clear() {
 
   root = nullptr;
   leafCount = 0;
+  objectCount = 0;
 }
 
 void ShapeSearchTree::insert(SearchTreeObject* object) {
   if (!object) return;
 
+  std::vector<Leaf*> leaves;
+  makeLeaves(object, leaves);
+  for (Leaf* leaf : leaves) {
+    insertLeaf(leaf);
+  }
+}
+
+void ShapeSearchTree::insertAll(const std::vector<SearchTreeObject*>& objects) {
+  if (root) {
+    for (SearchTreeObject* object : objects) {
+      insert(object);
+    }
+    return;
+  }
+
+  std::vector<Leaf*> leaves;
+  leaves.reserve(objects.size());
+  for (SearchTreeObject* object : objects) {
+    if (object) {
+      makeLeaves(object, leaves);
+    }
+  }
+  if (leaves.empty()) return;
+
+  leafCount = static_cast<int>(leaves.size());
+  root = build(leaves.begin(), leaves.end());
+}
+
+void ShapeSearchTree::makeLeaves(SearchTreeObject* object, std::vector<Leaf*>& leaves) {
+  objectCount++;
   int shapeCount = object->treeShapeCount();
   for (int i = 0; i < shapeCount; ++i) {
     const Shape* shape = object->getTreeShape(i);
@@ -53,11 +84,42 @@ void ShapeSearchTree::insert(SearchTreeObject* object) {
     Leaf* leaf = new Leaf();
     leaf->object = object;
     leaf->shapeIndex = i;
+    leaf->layer = object->getShapeLayer(i);
     leaf->boundingBox = shape->getBoundingBox();
+    leaf->layers = layerBit(leaf->layer);
     leaf->parent = nullptr;
+    leaves.push_back(leaf);
+  }
+}
 
-    insertLeaf(leaf);
+ShapeSearchTree::TreeNode* ShapeSearchTree::build(std::vector<Leaf*>::iterator first,
+                                                  std::vector<Leaf*>::iterator last) {
+  if (last - first == 1) {
+    return *first;
+  }
+
+  // Split at the median center along the longer side of the leaves' box
+  IntBox bounds = (*first)->boundingBox;
+  for (auto it = first + 1; it != last; ++it) {
+    bounds = bounds.unionWith((*it)->boundingBox);
   }
+  bool splitX = bounds.width() >= bounds.height();
+  auto middle = first + (last - first) / 2;
+  std::nth_element(first, middle, last, [splitX](const Leaf* a, const Leaf* b) {
+    const IntBox& boxA = a->boundingBox;
+    const IntBox& boxB = b->boundingBox;
+    return splitX ? boxA.ll.x + boxA.ur.x < boxB.ll.x + boxB.ur.x
+                  : boxA.ll.y + boxA.ur.y < boxB.ll.y + boxB.ur.y;
+  });
+
+  InnerNode* node = new InnerNode();
+  node->firstChild = build(first, middle);
+  node->secondChild = build(middle, last);
+  node->firstChild->parent = node;
+  node->secondChild->parent = node;
+  node->boundingBox = bounds;
+  node->layers = node->firstChild->layers | node->secondChild->layers;
+  return node;
 }
 
 void ShapeSearchTree::insertLeaf(Leaf* leaf) {
@@ -76,6 +138,7 @@ void ShapeSearchTree::insertLeaf(Leaf* leaf) {
   IntBox newBounds = leafToReplace->boundingBox.unionWith(leaf->boundingBox);
   InnerNode* newNode = new InnerNode();
   newNode->boundingBox = newBounds;
+  newNode->layers = leafToReplace->layers | leaf->layers;
   newNode->parent = leafToReplace->parent;
 
   // Update parent pointers
@@ -97,6 +160,12 @@ void ShapeSearchTree::insertLeaf(Leaf* leaf) {
   if (root == leafToReplace) {
     root = newNode;
   }
+
+  // Ancestors above the new node gain the leaf's box and layer
+  for (TreeNode* node = newNode->parent; node; node = node->parent) {
+    node->boundingBox = node->boundingBox.unionWith(leaf->boundingBox);
+    node->layers |= leaf->layers;
+  }
 }
 
 ShapeSearchTree::Leaf* ShapeSearchTree::positionLocate(TreeNode* node, Leaf* newLeaf) {
@@ -132,14 +201,13 @@ void ShapeSearchTree::overlappingEntries(const IntBox& queryBox, int layer,
                                         std::vector<TreeEntry>& results) const {
   if (!root) return;
 
-  // Find overlapping leaves
+  // Find overlapping leaves on the layer
   std::vector<Leaf*> leaves;
-  findOverlaps(root, queryBox, leaves);
+  findOverlaps(root, queryBox, layer >= 0 ? layerBit(layer) : kAllLayers, leaves);
 
-  // Convert to TreeEntry and filter by layer
   for (Leaf* leaf : leaves) {
-    // Filter by layer if specified
-    if (layer >= 0 && leaf->object->getShapeLayer(leaf->shapeIndex) != layer) {
+    // Layers past the mask width share its top bit
+    if (layer >= 0 && leaf->layer != layer) {
       continue;
     }
 
@@ -152,12 +220,12 @@ void ShapeSearchTree::overlappingEntries(const IntBox& queryBox,
   overlappingEntries(queryBox, -1, results);  // -1 = all layers
 }
 
-void ShapeSearchTree::findOverlaps(TreeNode* node, const IntBox& queryBox,
+void ShapeSearchTree::findOverlaps(TreeNode* node, const IntBox& queryBox, LayerMask layers,
                                   std::vector<Leaf*>& leaves) const {
   if (!node) return;
 
-  // Check if node's bounding box intersects query box
-  if (!node->boundingBox.intersects(queryBox)) {
+  // Check if node's bounding box intersects query box on a wanted layer
+  if (!layersOverlap(node->layers, layers) || !node->boundingBox.intersects(queryBox)) {
     return;  // Prune this subtree
   }
 
@@ -167,8 +235,8 @@ void ShapeSearchTree::findOverlaps(TreeNode* node, const IntBox& queryBox,
   } else {
     // Recurse on children
     auto* inner = static_cast<InnerNode*>(node);
-    findOverlaps(inner->firstChild, queryBox, leaves);
-    findOverlaps(inner->secondChild, queryBox, leaves);
+    findOverlaps(inner->firstChild, queryBox, layers, leaves);
+    findOverlaps(inner->secondChild, queryBox, layers, leaves);
   }
 }
 
@@ -150,8 +150,21 @@ SimpleGridRouter::Result SimpleGridRouter::findPath(
       {gridSize, gridSize}, {gridSize, -gridSize}, {-gridSize, gridSize}, {-gridSize, -gridSize}
     };
 
-    for (auto& dir : dirs) {
-      IntPoint newPos(current.pos.x + dir[0], current.pos.y + dir[1]);
+    // Get clearance required (trace width + spacing)
+    int clearance = traceHalfWidth * 2;  // Full trace width as clearance
+
+    // Check endpoints only (grid guarantees path is straight line), all
+    // eight in one batch since they share index cells
+    // For better quality, should sample intermediate points, but too slow
+    IntPoint neighbourPos[8];
+    for (int d = 0; d < 8; ++d) {
+      neighbourPos[d] = IntPoint(current.pos.x + dirs[d][0], current.pos.y + dirs[d][1]);
+    }
+    std::vector<u8> blocked = board->hasObstaclesAt(neighbourPos, current.layer, netNo, clearance);
+
+    for (int d = 0; d < 8; ++d) {
+      const auto& dir = dirs[d];
+      IntPoint newPos = neighbourPos[d];
 
       // Check if this position is reasonable (simplified bounds check)
       const int maxDist = 1000000;  // 10cm in internal units
@@ -159,12 +172,7 @@ SimpleGridRouter::Result SimpleGridRouter::findPath(
         continue;
       }
 
-      // Get clearance required (trace width + spacing)
-      int clearance = traceHalfWidth * 2;  // Full trace width as clearance
-
-      // Check endpoint only (grid guarantees path is straight line)
-      // For better quality, should sample intermediate points, but too slow
-      if (board->hasObstacleAt(newPos, current.layer, netNo, clearance)) {
+      if (blocked[d]) {
         continue;  // Skip - endpoint has obstacle
       }
 
@@ -0,0 +1,339 @@
+#include "autoroute/TileJob.h"
+#include "board/RoutingBoard.h"
+#include "board/Pin.h"
+#include "board/Trace.h"
+#include "board/Via.h"
+#include "core/ByteCodec.h"
+#include "datastructures/Stoppable.h"
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+namespace freerouting {
+
+namespace {
+
+void putPoint(std::vector<u8>& out, IntPoint p) {
+  putValue<i32>(out, p.x);
+  putValue<i32>(out, p.y);
+}
+
+bool getPoint(const std::vector<u8>& in, size_t& pos, IntPoint& p) {
+  return getValue(in, pos, p.x) && getValue(in, pos, p.y);
+}
+
+std::vector<int> toNets(const std::vector<i32>& nets) {
+  return std::vector<int>(nets.begin(), nets.end());
+}
+
+} // namespace
+
+TileOutcome TileJob::route(const BasicBoard& rules, const BatchAutorouter::Config& routing,
+                           Stoppable* stoppable) const {
+  TileOutcome outcome;
+  outcome.jobId = jobId;
+
+  RoutingBoard board(rules.getLayers(), rules.getClearanceMatrix());
+  board.setNets(rules.getNets());
+
+  // Items keep their IDs, so the outcome refers to the snapshot's board
+  std::unordered_map<int, Item*> byId;
+  for (const ItemRecord& r : items) {
+    std::unique_ptr<Item> item;
+    FixedState fixed = static_cast<FixedState>(r.fixedState);
+    switch (r.kind) {
+      case ItemKind::Pin:
+        item = std::make_unique<Pin>(r.a, r.pinNumber, board.getPadstack(r.padstackName, r.fromLayer, r.toLayer),
+                                     toNets(r.nets), r.clearanceClass, r.id, r.componentNumber, fixed, &board);
+        break;
+      case ItemKind::Via:
+        item = std::make_unique<Via>(r.a, board.getPadstack(r.padstackName, r.fromLayer, r.toLayer),
+                                     toNets(r.nets), r.clearanceClass, r.id, fixed, r.attachAllowed, &board);
+        break;
+      case ItemKind::Trace:
+        item = std::make_unique<Trace>(r.a, r.b, r.layer, r.halfWidth, toNets(r.nets),
+                                       r.clearanceClass, r.id, fixed, &board);
+        break;
+    }
+    if (item) {
+      byId[r.id] = item.get();
+      board.addItem(std::move(item));
+    }
+  }
+  board.reserveItemIds(lastItemId);
+
+  for (const ConnectionRecord& c : connections) {
+    board.addIncompleteConnection(IncompleteConnection(byId[c.fromItemId], byId[c.toItemId], c.netNo));
+  }
+
+  DeadlineStoppable deadline(timeLimitMs, stoppable);
+  BatchAutorouter router(&board, routing);
+  router.runBatchLoop(&deadline);
+  outcome.boardItems = static_cast<u32>(board.itemCount());
+
+  // A route is kept only if everything it has to clear was in the snapshot
+  IntBox keepBox = window.expand(-keepMargin);
+  std::set<int> newNets;
+  std::set<int> leavingNets;
+  for (const auto& item : board.getItems()) {
+    if (item->getId() <= lastItemId) continue;
+    newNets.insert(item->getNets().begin(), item->getNets().end());
+    if (!keepBox.contains(item->getBoundingBox())) {
+      leavingNets.insert(item->getNets().begin(), item->getNets().end());
+    }
+  }
+
+  for (const ItemRecord& r : items) {
+    if (!board.getItem(r.id)) {
+      outcome.removedItemIds.push_back(r.id);
+    }
+  }
+
+  // Rip-ups can't be traced back to the route that caused them, so if any
+  // route is dropped, all of them are
+  if (!leavingNets.empty() && !outcome.removedItemIds.empty()) {
+    leavingNets = newNets;
+    outcome.removedItemIds.clear();
+  }
+  outcome.rejectedNets = static_cast<i32>(leavingNets.size());
+
+  auto kept = [&leavingNets](const std::vector<int>& nets) {
+    return std::none_of(nets.begin(), nets.end(),
+                        [&leavingNets](int netNo) { return leavingNets.count(netNo) > 0; });
+  };
+
+  for (const auto& item : board.getItems()) {
+    if (item->getId() <= lastItemId || !kept(item->getNets())) {
+      continue;
+    }
+    std::vector<i32> nets(item->getNets().begin(), item->getNets().end());
+    if (const Trace* trace = dynamic_cast<const Trace*>(item.get())) {
+      outcome.traces.push_back({trace->getStart(), trace->getEnd(), trace->getLayer(),
+                                trace->getHalfWidth(), nets, trace->getClearanceClass()});
+    } else if (const Via* via = dynamic_cast<const Via*>(item.get())) {
+      const Padstack* padstack = via->getPadstack();
+      outcome.vias.push_back({via->getCenter(), padstack->name, padstack->fromLayer(),
+                              padstack->toLayer(), nets, via->getClearanceClass(),
+                              via->isAttachAllowed()});
+    }
+  }
+
+  // Connections were added in job order
+  const auto& routed = board.getIncompleteConnections();
+  for (size_t i = 0; i < routed.size(); ++i) {
+    if (routed[i].isRouted() && kept({routed[i].getNetNumber()})) {
+      outcome.routedConnections.push_back(static_cast<i32>(i));
+    }
+  }
+  return outcome;
+}
+
+std::vector<u8> TileJob::encode() const {
+  std::vector<u8> data;
+  data.reserve(48 + items.size() * 64 + connections.size() * 12);
+
+  putValue<u32>(data, kMagic);
+  putValue<u32>(data, kVersion);
+  putValue<u32>(data, jobId);
+  putPoint(data, window.ll);
+  putPoint(data, window.ur);
+  putValue<i32>(data, keepMargin);
+  putValue<i32>(data, lastItemId);
+  putValue<i32>(data, timeLimitMs);
+
+  putValue<u32>(data, static_cast<u32>(items.size()));
+  for (const ItemRecord& r : items) {
+    putValue<u8>(data, static_cast<u8>(r.kind));
+    putValue<i32>(data, r.id);
+    putPoint(data, r.a);
+    putValues(data, r.nets);
+    putValue<i32>(data, r.clearanceClass);
+    putValue<u8>(data, r.fixedState);
+    if (r.kind == ItemKind::Trace) {
+      putPoint(data, r.b);
+      putValue<i32>(data, r.layer);
+      putValue<i32>(data, r.halfWidth);
+    } else {
+      putString(data, r.padstackName);
+      putValue<i32>(data, r.fromLayer);
+      putValue<i32>(data, r.toLayer);
+      putValue<i32>(data, r.pinNumber);
+      putValue<i32>(data, r.componentNumber);
+      putValue<u8>(data, r.attachAllowed ? 1 : 0);
+    }
+  }
+
+  putValue<u32>(data, static_cast<u32>(connections.size()));
+  for (const ConnectionRecord& c : connections) {
+    putValue<i32>(data, c.fromItemId);
+    putValue<i32>(data, c.toItemId);
+    putValue<i32>(data, c.netNo);
+  }
+  return data;
+}
+
+std::optional<TileJob> TileJob::decode(const std::vector<u8>& data) {
+  size_t pos = 0;
+  u32 magic = 0;
+  u32 version = 0;
+  if (!getValue(data, pos, magic) || magic != kMagic ||
+      !getValue(data, pos, version) || version != kVersion) {
+    return std::nullopt;
+  }
+
+  TileJob job;
+  u32 itemCount = 0;
+  bool ok = getValue(data, pos, job.jobId) &&
+            getPoint(data, pos, job.window.ll) &&
+            getPoint(data, pos, job.window.ur) &&
+            getValue(data, pos, job.keepMargin) &&
+            getValue(data, pos, job.lastItemId) &&
+            getValue(data, pos, job.timeLimitMs) &&
+            getValue(data, pos, itemCount);
+  if (!ok) {
+    return std::nullopt;
+  }
+
+  job.items.reserve(std::min<size_t>(itemCount, data.size() / 16));
+  for (u32 i = 0; i < itemCount; ++i) {
+    ItemRecord r;
+    u8 kind = 0;
+    ok = getValue(data, pos, kind) &&
+         getValue(data, pos, r.id) &&
+         getPoint(data, pos, r.a) &&
+         getValues(data, pos, r.nets) &&
+         getValue(data, pos, r.clearanceClass) &&
+         getValue(data, pos, r.fixedState);
+    if (!ok || kind < 1 || kind > 3) {
+      return std::nullopt;
+    }
+    r.kind = static_cast<ItemKind>(kind);
+    if (r.kind == ItemKind::Trace) {
+      ok = getPoint(data, pos, r.b) &&
+           getValue(data, pos, r.layer) &&
+           getValue(data, pos, r.halfWidth);
+    } else {
+      u8 attach = 0;
+      ok = getString(data, pos, r.padstackName) &&
+           getValue(data, pos, r.fromLayer) &&
+           getValue(data, pos, r.toLayer) &&
+           getValue(data, pos, r.pinNumber) &&
+           getValue(data, pos, r.componentNumber) &&
+           getValue(data, pos, attach);
+      r.attachAllowed = attach != 0;
+    }
+    if (!ok) {
+      return std::nullopt;
+    }
+    job.items.push_back(std::move(r));
+  }
+
+  u32 connectionCount = 0;
+  if (!getValue(data, pos, connectionCount) || connectionCount > (data.size() - pos) / 12) {
+    return std::nullopt;
+  }
+  job.connections.resize(connectionCount);
+  for (ConnectionRecord& c : job.connections) {
+    getValue(data, pos, c.fromItemId);
+    getValue(data, pos, c.toItemId);
+    getValue(data, pos, c.netNo);
+  }
+  return job;
+}
+
+std::vector<u8> TileOutcome::encode() const {
+  std::vector<u8> data;
+  data.reserve(40 + traces.size() * 40 + vias.size() * 48);
+
+  putValue<u32>(data, kMagic);
+  putValue<u32>(data, kVersion);
+  putValue<u32>(data, jobId);
+
+  putValue<u32>(data, static_cast<u32>(traces.size()));
+  for (const RoutedTrace& t : traces) {
+    putPoint(data, t.start);
+    putPoint(data, t.end);
+    putValue<i32>(data, t.layer);
+    putValue<i32>(data, t.halfWidth);
+    putValues(data, t.nets);
+    putValue<i32>(data, t.clearanceClass);
+  }
+
+  putValue<u32>(data, static_cast<u32>(vias.size()));
+  for (const RoutedVia& v : vias) {
+    putPoint(data, v.center);
+    putString(data, v.padstackName);
+    putValue<i32>(data, v.fromLayer);
+    putValue<i32>(data, v.toLayer);
+    putValues(data, v.nets);
+    putValue<i32>(data, v.clearanceClass);
+    putValue<u8>(data, v.attachAllowed ? 1 : 0);
+  }
+
+  putValues(data, routedConnections);
+  putValues(data, removedItemIds);
+  putValue<i32>(data, rejectedNets);
+  putValue<u32>(data, boardItems);
+  return data;
+}
+
+std::optional<TileOutcome> TileOutcome::decode(const std::vector<u8>& data) {
+  size_t pos = 0;
+  u32 magic = 0;
+  u32 version = 0;
+  if (!getValue(data, pos, magic) || magic != kMagic ||
+      !getValue(data, pos, version) || version != kVersion) {
+    return std::nullopt;
+  }
+
+  TileOutcome outcome;
+  u32 traceCount = 0;
+  if (!getValue(data, pos, outcome.jobId) || !getValue(data, pos, traceCount)) {
+    return std::nullopt;
+  }
+  for (u32 i = 0; i < traceCount; ++i) {
+    RoutedTrace t;
+    bool ok = getPoint(data, pos, t.start) &&
+              getPoint(data, pos, t.end) &&
+              getValue(data, pos, t.layer) &&
+              getValue(data, pos, t.halfWidth) &&
+              getValues(data, pos, t.nets) &&
+              getValue(data, pos, t.clearanceClass);
+    if (!ok) {
+      return std::nullopt;
+    }
+    outcome.traces.push_back(std::move(t));
+  }
+
+  u32 viaCount = 0;
+  if (!getValue(data, pos, viaCount)) {
+    return std::nullopt;
+  }
+  for (u32 i = 0; i < viaCount; ++i) {
+    RoutedVia v;
+    u8 attach = 0;
+    bool ok = getPoint(data, pos, v.center) &&
+              getString(data, pos, v.padstackName) &&
+              getValue(data, pos, v.fromLayer) &&
+              getValue(data, pos, v.toLayer) &&
+              getValues(data, pos, v.nets) &&
+              getValue(data, pos, v.clearanceClass) &&
+              getValue(data, pos, attach);
+    if (!ok) {
+      return std::nullopt;
+    }
+    v.attachAllowed = attach != 0;
+    outcome.vias.push_back(std::move(v));
+  }
+
+  bool ok = getValues(data, pos, outcome.routedConnections) &&
+            getValues(data, pos, outcome.removedItemIds) &&
+            getValue(data, pos, outcome.rejectedNets) &&
+            getValue(data, pos, outcome.boardItems);
+  if (!ok) {
+    return std::nullopt;
+  }
+  return outcome;
+}
+
+} // namespace freerouting
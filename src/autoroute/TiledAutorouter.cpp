@@ -0,0 +1,324 @@
+#include "autoroute/TiledAutorouter.h"
+#include "autoroute/RoutingWorkerPool.h"
+#include "board/Pin.h"
+#include "board/Trace.h"
+#include "board/Via.h"
+#include "core/Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <unordered_map>
+
+namespace freerouting {
+
+TiledAutorouter::TiledAutorouter(RoutingBoard* board, const Config& cfg)
+  : board_(board),
+    config_(cfg) {
+  config_.tileSize = std::max(1, config_.tileSize);
+  config_.halo = std::clamp(config_.halo, 0, config_.tileSize / 4);
+}
+
+int TiledAutorouter::clearanceMargin() const {
+  const ClearanceMatrix& clearance = board_->getClearanceMatrix();
+  int margin = 0;
+  for (int layer = 0; layer < board_->getLayers().count(); ++layer) {
+    margin = std::max(margin, clearance.maxValue(layer));
+  }
+  return margin;
+}
+
+std::vector<TiledAutorouter::Tile> TiledAutorouter::partition(
+    const std::vector<const IncompleteConnection*>& connections) const {
+
+  IntBox bounds;
+  for (const auto& item : board_->getItems()) {
+    bounds = bounds.unionWith(item->getBoundingBox());
+  }
+  if (bounds.isEmpty()) {
+    return {};
+  }
+
+  const i64 size = config_.tileSize;
+  const int tilesX = static_cast<int>((static_cast<i64>(bounds.ur.x) - bounds.ll.x) / size + 1);
+  const int tilesY = static_cast<int>((static_cast<i64>(bounds.ur.y) - bounds.ll.y) / size + 1);
+  const int margin = clearanceMargin();
+
+  std::vector<Tile> tiles;
+  std::unordered_map<i64, size_t> tileIndex;
+  for (const IncompleteConnection* conn : connections) {
+    IntBox box = conn->getFromItem()->getBoundingBox().unionWith(
+      conn->getToItem()->getBoundingBox());
+    i64 cx = (static_cast<i64>(box.ll.x) + box.ur.x) / 2;
+    i64 cy = (static_cast<i64>(box.ll.y) + box.ur.y) / 2;
+    int tx = static_cast<int>(std::clamp<i64>((cx - bounds.ll.x) / size, 0, tilesX - 1));
+    int ty = static_cast<int>(std::clamp<i64>((cy - bounds.ll.y) / size, 0, tilesY - 1));
+
+    IntBox core(static_cast<int>(bounds.ll.x + tx * size), static_cast<int>(bounds.ll.y + ty * size),
+                static_cast<int>(bounds.ll.x + (tx + 1) * size), static_cast<int>(bounds.ll.y + (ty + 1) * size));
+    IntBox window = core.expand(config_.halo);
+
+    // Routes are only kept clear of the window edge (see TileJob::route), so a
+    // connection reaching nearer to it is left for stitching straight away
+    if (!window.expand(-margin).contains(box)) {
+      continue;
+    }
+
+    i64 key = static_cast<i64>(ty) * tilesX + tx;
+    auto [it, added] = tileIndex.emplace(key, tiles.size());
+    if (added) {
+      tiles.push_back(Tile{tx, ty, window, {}});
+    }
+    tiles[it->second].connections.push_back(conn);
+  }
+  return tiles;
+}
+
+BatchAutorouter::Config TiledAutorouter::tileRouting() const {
+  // Tiles already run side by side, and capture files would clash
+  BatchAutorouter::Config routing = config_.routing;
+  routing.raceSearches = false;
+  routing.captureNetNo = -1;
+  return routing;
+}
+
+TileJob TiledAutorouter::makeJob(const Tile& tile, u32 jobId, int timeLimitMs) const {
+  TileJob job;
+  job.jobId = jobId;
+  job.window = tile.window;
+  job.keepMargin = clearanceMargin();
+  job.timeLimitMs = timeLimitMs;
+
+  for (const auto& item : board_->getItems()) {
+    job.lastItemId = std::max(job.lastItemId, item->getId());
+    if (!item->getBoundingBox().intersects(tile.window)) {
+      continue;
+    }
+
+    TileJob::ItemRecord r;
+    r.id = item->getId();
+    r.nets.assign(item->getNets().begin(), item->getNets().end());
+    r.clearanceClass = item->getClearanceClass();
+    r.fixedState = static_cast<u8>(item->getFixedState());
+    if (const Trace* trace = dynamic_cast<const Trace*>(item.get())) {
+      r.kind = TileJob::ItemKind::Trace;
+      r.a = trace->getStart();
+      r.b = trace->getEnd();
+      r.layer = trace->getLayer();
+      r.halfWidth = trace->getHalfWidth();
+    } else if (const DrillItem* drill = dynamic_cast<const DrillItem*>(item.get())) {
+      const Padstack* padstack = drill->getPadstack();
+      r.a = drill->getCenter();
+      r.padstackName = padstack ? padstack->name : "";
+      r.fromLayer = drill->firstLayer();
+      r.toLayer = drill->lastLayer();
+      r.componentNumber = drill->getComponentNumber();
+      if (const Pin* pin = dynamic_cast<const Pin*>(drill)) {
+        r.kind = TileJob::ItemKind::Pin;
+        r.pinNumber = pin->getPinNumber();
+      } else {
+        r.kind = TileJob::ItemKind::Via;
+        r.attachAllowed = static_cast<const Via*>(drill)->isAttachAllowed();
+      }
+    } else {
+      // The board loaders only create pins, vias and traces
+      continue;
+    }
+    job.items.push_back(std::move(r));
+  }
+
+  for (const IncompleteConnection* conn : tile.connections) {
+    job.connections.push_back({conn->getFromItem()->getId(), conn->getToItem()->getId(),
+                               conn->getNetNumber()});
+  }
+  return job;
+}
+
+std::vector<TileOutcome> TiledAutorouter::runJobs(const std::vector<TileJob>& jobs,
+                                                  Stoppable* stoppable) const {
+  const BatchAutorouter::Config routing = tileRouting();
+
+  std::vector<TileOutcome> outcomes(jobs.size());
+  parallelFor(jobs.size(), threadCount(config_.threads), [&](size_t i) {
+    outcomes[i] = jobs[i].route(*board_, routing, stoppable);
+  });
+  return outcomes;
+}
+
+void TiledAutorouter::merge(const Tile& tile, const TileJob& job, const TileOutcome& outcome) {
+  std::vector<std::unique_ptr<Item>> copper;
+  for (const auto& via : outcome.vias) {
+    const Padstack* padstack = board_->getPadstack(via.padstackName, via.fromLayer, via.toLayer);
+    copper.push_back(std::make_unique<Via>(
+      via.center, padstack, std::vector<int>(via.nets.begin(), via.nets.end()),
+      via.clearanceClass, board_->generateItemId(), FixedState::NotFixed, via.attachAllowed, board_));
+  }
+  for (const auto& trace : outcome.traces) {
+    copper.push_back(std::make_unique<Trace>(
+      trace.start, trace.end, trace.layer, trace.halfWidth,
+      std::vector<int>(trace.nets.begin(), trace.nets.end()),
+      trace.clearanceClass, board_->generateItemId(), FixedState::NotFixed, board_));
+  }
+
+  // Copper added after the snapshot (by another job) was not seen by this
+  // job's router; a net whose new copper comes near it is dropped
+  const int margin = clearanceMargin();
+  std::set<int> conflicting;
+  for (const auto& item : copper) {
+    for (int netNo : item->getNets()) {
+      for (const Item* other : board_->getShapeTree().findTraceObstacles(
+             netNo, item->getBoundingBox().expand(margin), item->firstLayer(), item->lastLayer())) {
+        if (other->getId() > job.lastItemId) {
+          conflicting.insert(netNo);
+        }
+      }
+    }
+  }
+
+  // Rip-ups can't be traced back to the route that caused them, so they are
+  // only applied if every route is kept; with a conflict, nothing is (the
+  // same rule as TileJob::route)
+  if (!conflicting.empty() && !outcome.removedItemIds.empty()) {
+    for (const auto& item : copper) {
+      conflicting.insert(item->getNets().begin(), item->getNets().end());
+    }
+    for (i32 index : outcome.routedConnections) {
+      if (index >= 0 && static_cast<size_t>(index) < tile.connections.size()) {
+        conflicting.insert(tile.connections[static_cast<size_t>(index)]->getNetNumber());
+      }
+    }
+  }
+  auto kept = [&conflicting](const std::vector<int>& nets) {
+    return std::none_of(nets.begin(), nets.end(),
+                        [&conflicting](int netNo) { return conflicting.count(netNo) > 0; });
+  };
+
+  if (conflicting.empty()) {
+    for (i32 itemId : outcome.removedItemIds) {
+      if (board_->removeItem(itemId)) {
+        ++stats_.rippedItems;
+      }
+    }
+  }
+
+  for (auto& item : copper) {
+    if (kept(item->getNets())) {
+      board_->addItem(std::move(item));
+    }
+  }
+
+  for (i32 index : outcome.routedConnections) {
+    if (index < 0 || static_cast<size_t>(index) >= tile.connections.size()) continue;
+    const IncompleteConnection* conn = tile.connections[static_cast<size_t>(index)];
+    if (!kept({conn->getNetNumber()})) continue;
+    board_->markConnectionRouted(conn->getFromItem(), conn->getToItem(), conn->getNetNumber());
+    ++stats_.tileConnectionsRouted;
+  }
+
+  stats_.rejectedNets += outcome.rejectedNets;
+  stats_.conflictNets += static_cast<int>(conflicting.size());
+  stats_.maxTileItems = std::max(stats_.maxTileItems, static_cast<size_t>(outcome.boardItems));
+}
+
+bool TiledAutorouter::run(Stoppable* stoppable) {
+  auto start = std::chrono::steady_clock::now();
+  stats_ = Statistics();
+  DeadlineStoppable deadline(config_.timeLimitMs > 0 ? config_.timeLimitMs : -1, stoppable);
+
+  // Merged copper must not reuse the IDs of items a loader numbered
+  // itself: jobs, merges and rip-ups find items by ID, and copper added
+  // since a job's snapshot is recognised by an ID above job.lastItemId
+  int lastItemId = 0;
+  for (const auto& item : board_->getItems()) {
+    lastItemId = std::max(lastItemId, item->getId());
+  }
+  board_->reserveItemIds(lastItemId);
+
+  std::vector<const IncompleteConnection*> pending;
+  for (const auto& conn : board_->getIncompleteConnections()) {
+    if (!conn.isRouted() && conn.getFromItem() && conn.getToItem()) {
+      pending.push_back(&conn);
+    }
+  }
+
+  std::vector<Tile> tiles = partition(pending);
+  stats_.tiles = static_cast<int>(tiles.size());
+  for (const Tile& tile : tiles) {
+    stats_.tileConnections += static_cast<int>(tile.connections.size());
+  }
+
+  std::unique_ptr<RoutingWorkerPool> pool;
+  if (config_.workerProcesses > 0 && !tiles.empty()) {
+    pool = std::make_unique<RoutingWorkerPool>(board_, tileRouting());
+    stats_.workers = pool->start(config_.workerProcesses);
+    if (stats_.workers == 0) {
+      pool.reset();
+    }
+  }
+
+  u32 nextJobId = 1;
+  for (int wave = 0; wave < 4; ++wave) {
+    if (deadline.isStopRequested()) {
+      break;
+    }
+    const int jobTimeLimit = config_.timeLimitMs > 0
+      ? static_cast<int>(std::max<long>(0, deadline.getRemainingMs()))
+      : -1;
+
+    // Snapshots are taken after the previous wave's merge, so each wave
+    // sees the copper of the ones before it
+    std::vector<const Tile*> waveTiles;
+    std::vector<TileJob> jobs;
+    for (const Tile& tile : tiles) {
+      if ((tile.tx % 2) + 2 * (tile.ty % 2) != wave) continue;
+      waveTiles.push_back(&tile);
+      jobs.push_back(makeJob(tile, nextJobId++, jobTimeLimit));
+    }
+    if (jobs.empty()) {
+      continue;
+    }
+
+    std::vector<TileOutcome> outcomes;
+    if (pool && pool->size() > 0) {
+      outcomes = pool->run(jobs, &deadline);
+    } else {
+      outcomes = runJobs(jobs, &deadline);
+    }
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      merge(*waveTiles[i], jobs[i], outcomes[i]);
+    }
+  }
+  if (pool) {
+    stats_.jobBytes = pool->getBytesSent();
+    pool->stop();
+  }
+
+  // Ripped-up copper leaves its net open where it was marked routed
+  // before; find the gaps again so stitching closes them
+  if (stats_.rippedItems > 0) {
+    board_->updateIncompleteConnections();
+  }
+
+  stats_.tileMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  stats_.stitchConnections = static_cast<int>(board_->incompleteConnectionCount());
+
+  if (progressDisplay_) {
+    progressDisplay_->message("Tiles: " + std::to_string(stats_.tileConnectionsRouted) + " of " +
+      std::to_string(stats_.tileConnections) + " connections routed in " +
+      std::to_string(stats_.tiles) + " tiles, " + std::to_string(stats_.stitchConnections) +
+      " left for stitching", true);
+  }
+
+  auto stitchStart = std::chrono::steady_clock::now();
+  BatchAutorouter stitcher(board_, config_.routing);
+  stitcher.setProgressDisplay(progressDisplay_);
+  bool completelyRouted = stitcher.runBatchLoop(&deadline);
+  stitchStats_ = stitcher.getLastPassStats();
+  stats_.stitchMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - stitchStart).count();
+
+  return completelyRouted;
+}
+
+} // namespace freerouting
@@ -0,0 +1,380 @@
+#include "autoroute/ViaMinimizer.h"
+#include "board/RoutingBoard.h"
+#include "board/RuleArea.h"
+#include "board/Trace.h"
+#include "board/Via.h"
+#include "core/Parallel.h"
+#include "geometry/CollisionDetector.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace freerouting {
+
+namespace {
+
+// Chains longer than this are left alone
+constexpr int kMaxChainTraces = 256;
+
+bool isMovable(const Item& item) {
+  return item.getFixedState() == FixedState::NotFixed && item.netCount() == 1;
+}
+
+bool endsAt(const Trace& trace, IntPoint point) {
+  return trace.getStart() == point || trace.getEnd() == point;
+}
+
+IntPoint otherEnd(const Trace& trace, IntPoint point) {
+  return trace.getStart() == point ? trace.getEnd() : trace.getStart();
+}
+
+bool byId(const Via* a, const Via* b) {
+  return a->getId() < b->getId();
+}
+
+} // namespace
+
+int ViaMinimizer::run() {
+  auto start = std::chrono::steady_clock::now();
+  stats_ = Statistics();
+
+  const size_t threads = threadCount(config_.threads);
+
+  for (int round = 0; round < config_.maxRounds; ++round) {
+    std::vector<const Via*> vias;
+    for (const auto& item : board_->getItems()) {
+      const Via* via = dynamic_cast<const Via*>(item.get());
+      if (via && isMovable(*via)) {
+        vias.push_back(via);
+      }
+    }
+    if (round == 0) {
+      stats_.viasBefore = static_cast<int>(vias.size());
+    }
+    ++stats_.rounds;
+
+    // Find and check candidates; the board is only read here
+    std::vector<std::vector<Change>> found(threads);
+    std::vector<int> conflicts(threads, 0);
+    parallelFor(vias.size(), threads, [&](size_t i, size_t t) {
+      std::vector<Change> changes;
+      findChanges(*vias[i], changes);
+      for (Change& change : changes) {
+        if (isClear(change)) {
+          found[t].push_back(std::move(change));
+        } else {
+          ++conflicts[t];
+        }
+      }
+    });
+
+    std::vector<Change> changes;
+    for (size_t t = 0; t < threads; ++t) {
+      stats_.conflicts += conflicts[t];
+      std::move(found[t].begin(), found[t].end(), std::back_inserter(changes));
+    }
+    stats_.candidates += static_cast<int>(changes.size()) +
+                         std::accumulate(conflicts.begin(), conflicts.end(), 0);
+    std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+      return std::lexicographical_compare(a.vias.begin(), a.vias.end(), b.vias.begin(), b.vias.end(),
+                                          byId);
+    });
+
+    // Apply in order; a change near one already applied was checked against
+    // a board that no longer exists, so it waits for the next round
+    int removed = 0;
+    std::vector<IntBox> applied;
+    for (const Change& change : changes) {
+      bool nearApplied = std::any_of(applied.begin(), applied.end(), [&change](const IntBox& box) {
+        return box.intersects(change.region);
+      });
+      if (nearApplied || !apply(change)) {
+        continue;
+      }
+      applied.push_back(change.region);
+      removed += static_cast<int>(change.vias.size());
+    }
+
+    stats_.viasRemoved += removed;
+    if (removed == 0) {
+      break;
+    }
+  }
+
+  stats_.durationMs = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  return stats_.viasRemoved;
+}
+
+std::optional<ViaMinimizer::ViaLinks> ViaMinimizer::linksOf(const Via& via) const {
+  const Padstack* padstack = via.getPadstack();
+  if (!padstack) {
+    return std::nullopt;
+  }
+
+  ViaLinks links;
+  links.byLayer.resize(static_cast<size_t>(board_->getLayers().count()));
+
+  IntPoint center = via.getCenter();
+  IntBox box = via.getBoundingBox();
+  int netNo = via.getNets().front();
+  for (Item* item : board_->getShapeTree().findItemsByNet(netNo, box)) {
+    if (item == &via || item->lastLayer() < padstack->fromLayer() ||
+        item->firstLayer() > padstack->toLayer()) {
+      continue;
+    }
+    const Trace* trace = dynamic_cast<const Trace*>(item);
+    if (!trace) {
+      return std::nullopt;  // Stacked on a pin or another via
+    }
+    if (endsAt(*trace, center)) {
+      links.byLayer[static_cast<size_t>(trace->getLayer())].push_back(trace);
+    } else if (CollisionDetector::segmentBoxIntersect(trace->getStart(), trace->getEnd(),
+                                                      box.expand(trace->getHalfWidth()))) {
+      return std::nullopt;  // Connects to the pad off center
+    }
+  }
+  return links;
+}
+
+std::optional<const Via*> ViaMinimizer::followChain(const Via& from, const Trace& first,
+                                                    std::vector<const Trace*>& chain) const {
+  const int layer = first.getLayer();
+  const int netNo = from.getNets().front();
+  const Trace* current = &first;
+  IntPoint point = otherEnd(first, from.getCenter());
+
+  while (static_cast<int>(chain.size()) < kMaxChainTraces) {
+    if (!isMovable(*current)) {
+      return std::nullopt;
+    }
+    chain.push_back(current);
+
+    const Trace* nextTrace = nullptr;
+    const Via* endVia = nullptr;
+    int links = 0;
+    for (Item* item : board_->getShapeTree().findItemsOnLayer(layer, IntBox::fromPoint(point))) {
+      if (item == current || !item->containsNet(netNo)) {
+        continue;
+      }
+      if (const Trace* trace = dynamic_cast<const Trace*>(item)) {
+        if (endsAt(*trace, point)) {
+          nextTrace = trace;
+          ++links;
+        } else if (CollisionDetector::pointSegmentDistance(point, trace->getStart(), trace->getEnd()) <=
+                   trace->getHalfWidth() + current->getHalfWidth()) {
+          return std::nullopt;  // Branch in the middle of another trace
+        }
+      } else if (const Via* via = dynamic_cast<const Via*>(item); via && via->getCenter() == point) {
+        endVia = via;
+        ++links;
+      } else {
+        return std::nullopt;  // Pin, or via off the chain's end
+      }
+    }
+
+    if (links != 1) {
+      return std::nullopt;  // Dead end or branch
+    }
+    if (endVia) {
+      if (endVia == &from || !isMovable(*endVia)) {
+        return std::nullopt;
+      }
+      return endVia;
+    }
+    if (std::find(chain.begin(), chain.end(), nextTrace) != chain.end()) {
+      return std::nullopt;  // Loop
+    }
+    point = otherEnd(*nextTrace, point);
+    current = nextTrace;
+  }
+  return std::nullopt;
+}
+
+void ViaMinimizer::findChanges(const Via& via, std::vector<Change>& changes) const {
+  std::optional<ViaLinks> firstLinks = linksOf(via);
+  if (!firstLinks) {
+    return;
+  }
+
+  // The layers a via's traces are on, if exactly two
+  auto twoLayers = [](const ViaLinks& links, int& a, int& b) {
+    a = b = -1;
+    for (size_t layer = 0; layer < links.byLayer.size(); ++layer) {
+      if (links.byLayer[layer].empty()) continue;
+      if (a < 0) {
+        a = static_cast<int>(layer);
+      } else if (b < 0) {
+        b = static_cast<int>(layer);
+      } else {
+        return false;
+      }
+    }
+    return b >= 0;
+  };
+
+  int first = -1;
+  int second = -1;
+  if (!twoLayers(*firstLinks, first, second)) {
+    return;
+  }
+
+  for (int outside : {first, second}) {
+    const int chainLayer = outside == first ? second : first;
+    const auto& chainStart = firstLinks->byLayer[static_cast<size_t>(chainLayer)];
+    if (chainStart.size() != 1) {
+      continue;
+    }
+
+    Change change;
+    change.netNo = via.getNets().front();
+    change.layer = outside;
+    change.vias.push_back(&via);
+
+    // Up to two chains, ending at a via whose other side is back on the
+    // outside layer
+    const Via* at = &via;
+    const Trace* leg = chainStart.front();
+    bool found = false;
+    for (int chains = 0; chains < 2 && !found; ++chains) {
+      std::optional<const Via*> end = followChain(*at, *leg, change.traces);
+      if (!end) {
+        break;
+      }
+      const Via* endVia = *end;
+      if (std::find(change.vias.begin(), change.vias.end(), endVia) != change.vias.end()) {
+        break;
+      }
+      change.vias.push_back(endVia);
+
+      std::optional<ViaLinks> endLinks = linksOf(*endVia);
+      int a = -1;
+      int b = -1;
+      if (!endLinks || !twoLayers(*endLinks, a, b)) {
+        break;
+      }
+      const int legLayer = leg->getLayer();
+      if (endLinks->byLayer[static_cast<size_t>(legLayer)].size() != 1) {
+        break;
+      }
+      const int beyond = a == legLayer ? b : a;
+      if (beyond == outside) {
+        found = true;
+      } else if (endLinks->byLayer[static_cast<size_t>(beyond)].size() == 1) {
+        at = endVia;
+        leg = endLinks->byLayer[static_cast<size_t>(beyond)].front();
+      } else {
+        break;
+      }
+    }
+
+    // Each run is found from both ends; keep it from the lower ID only
+    if (!found || change.vias.front()->getId() > change.vias.back()->getId()) {
+      continue;
+    }
+    if (std::any_of(change.traces.begin(), change.traces.end(), [&](const Trace* trace) {
+          return touchesOthers(*trace, change.traces, change.vias);
+        })) {
+      continue;
+    }
+
+    int clearance = board_->getClearanceMatrix().getValue(1, 1, outside, true);
+    change.region = IntBox::empty();
+    for (const Trace* trace : change.traces) {
+      change.region = change.region.unionWith(
+        trace->getBoundingBox().expand(clearance));
+    }
+    std::sort(change.vias.begin(), change.vias.end(), byId);
+    changes.push_back(std::move(change));
+  }
+}
+
+bool ViaMinimizer::touchesOthers(const Trace& trace, const std::vector<const Trace*>& chain,
+                                 const std::vector<const Via*>& vias) const {
+  const int netNo = trace.getNets().front();
+  for (Item* item : board_->getShapeTree().findItemsOnLayer(trace.getLayer(), trace.getBoundingBox())) {
+    if (!item->containsNet(netNo) ||
+        std::find(chain.begin(), chain.end(), item) != chain.end() ||
+        std::find(vias.begin(), vias.end(), item) != vias.end()) {
+      continue;
+    }
+    if (const Trace* other = dynamic_cast<const Trace*>(item)) {
+      if (CollisionDetector::segmentDistance(trace.getStart(), trace.getEnd(),
+                                             other->getStart(), other->getEnd()) <=
+          trace.getHalfWidth() + other->getHalfWidth()) {
+        return true;
+      }
+    } else if (CollisionDetector::segmentBoxIntersect(trace.getStart(), trace.getEnd(),
+                                                      item->getBoundingBox().expand(trace.getHalfWidth()))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ViaMinimizer::isClear(const Change& change) const {
+  const int layer = change.layer;
+  const int clearance = board_->getClearanceMatrix().getValue(1, 1, layer, true);
+
+  for (const Trace* trace : change.traces) {
+    const int halfWidth = trace->getHalfWidth();
+    IntBox searchBox = trace->getBoundingBox().expand(clearance);
+
+    for (Item* item : board_->getShapeTree().findTraceObstacles(change.netNo, searchBox, layer, layer)) {
+      if (const Trace* other = dynamic_cast<const Trace*>(item)) {
+        if (CollisionDetector::segmentDistance(trace->getStart(), trace->getEnd(),
+                                               other->getStart(), other->getEnd()) <
+            halfWidth + other->getHalfWidth() + clearance) {
+          return false;
+        }
+      } else if (CollisionDetector::segmentBoxIntersect(trace->getStart(), trace->getEnd(),
+                                                        item->getBoundingBox().expand(halfWidth + clearance))) {
+        return false;
+      }
+    }
+
+    for (const auto& area : board_->getRuleAreas()) {
+      if (area->isOnLayer(layer) && area->affectsNet(change.netNo) &&
+          area->isProhibited(RuleArea::RestrictionType::Traces) &&
+          CollisionDetector::segmentBoxIntersect(trace->getStart(), trace->getEnd(),
+                                                 area->getBoundingBox().expand(halfWidth))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool ViaMinimizer::apply(const Change& change) {
+  // Everything is checked before the board is touched, by address rather
+  // than ID, so that nothing but these items can be removed
+  std::vector<Item*> removed;
+  for (const Via* via : change.vias) {
+    removed.push_back(board_->findItem(via));
+  }
+  for (const Trace* trace : change.traces) {
+    removed.push_back(board_->findItem(trace));
+  }
+  if (std::find(removed.begin(), removed.end(), nullptr) != removed.end()) {
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Trace>> moved;
+  for (const Trace* trace : change.traces) {
+    moved.push_back(std::make_unique<Trace>(
+      trace->getStart(), trace->getEnd(), change.layer, trace->getHalfWidth(),
+      trace->getNets(), trace->getClearanceClass(), board_->generateItemId(),
+      FixedState::NotFixed, board_));
+  }
+
+  for (Item* item : removed) {
+    board_->removeItem(item);
+  }
+  for (auto& trace : moved) {
+    board_->addItem(std::move(trace));
+  }
+  stats_.tracesMoved += static_cast<int>(change.traces.size());
+  return true;
+}
+
+} // namespace freerouting
@@ -0,0 +1,63 @@
+#include "board/ContactIndex.h"
+#include "board/DrillItem.h"
+#include "board/Trace.h"
+#include <algorithm>
+
+namespace freerouting {
+
+std::vector<ContactIndex::Contact> ContactIndex::contactsOf(const Item& item) {
+  std::vector<Contact> contacts;
+  if (const auto* trace = dynamic_cast<const Trace*>(&item)) {
+    contacts.push_back({trace->getStart(), trace->getLayer()});
+    if (trace->getEnd() != trace->getStart()) {
+      contacts.push_back({trace->getEnd(), trace->getLayer()});
+    }
+  } else if (const auto* drillItem = dynamic_cast<const DrillItem*>(&item)) {
+    for (int layer = drillItem->firstLayer(); layer <= drillItem->lastLayer(); ++layer) {
+      contacts.push_back({drillItem->getCenter(), layer});
+    }
+  }
+  return contacts;
+}
+
+void ContactIndex::insert(Item* item) {
+  for (const Contact& contact : contactsOf(*item)) {
+    contacts_[contact].push_back(item);
+  }
+}
+
+void ContactIndex::remove(Item* item) {
+  for (const Contact& contact : contactsOf(*item)) {
+    auto it = contacts_.find(contact);
+    if (it == contacts_.end()) {
+      continue;
+    }
+    std::erase(it->second, item);
+    if (it->second.empty()) {
+      contacts_.erase(it);
+    }
+  }
+}
+
+std::span<Item* const> ContactIndex::at(IntPoint point, int layer) const {
+  auto it = contacts_.find(Contact{point, layer});
+  if (it == contacts_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+std::vector<Item*> ContactIndex::touching(const Item& item, int netNo) const {
+  std::vector<Item*> result;
+  for (const Contact& contact : contactsOf(item)) {
+    for (Item* other : at(contact.point, contact.layer)) {
+      if (other != &item && other->containsNet(netNo) &&
+          std::find(result.begin(), result.end(), other) == result.end()) {
+        result.push_back(other);
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace freerouting
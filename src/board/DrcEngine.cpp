@@ -44,10 +44,22 @@ std::vector<DrcViolation> DrcEngine::checkClearances() {
 
   const auto& items = board_->getItems();
 
+  // Layer masks once per item, so the pair loop tests overlap with one AND
+  std::vector<LayerMask> layerMasks;
+  layerMasks.reserve(items.size());
+  for (const auto& item : items) {
+    layerMasks.push_back(item ? item->layerMask() : 0);
+  }
+
   // Check all pairs of items for clearance violations
   // This is O(n^2) but will be optimized with spatial indexing in Phase 12
   for (size_t i = 0; i < items.size(); ++i) {
     for (size_t j = i + 1; j < items.size(); ++j) {
+      // Skip if items are on different layers with no overlap
+      if (!layersOverlap(layerMasks[i], layerMasks[j])) {
+        continue;
+      }
+
       Item* item1 = items[i].get();
       Item* item2 = items[j].get();
 
@@ -60,19 +72,6 @@ std::vector<DrcViolation> DrcEngine::checkClearances() {
         continue;
       }
 
-      // Skip if items are on different layers with no overlap
-      bool layerOverlap = false;
-      for (int layer = item1->firstLayer(); layer <= item1->lastLayer(); ++layer) {
-        if (item2->isOnLayer(layer)) {
-          layerOverlap = true;
-          break;
-        }
-      }
-
-      if (!layerOverlap) {
-        continue;
-      }
-
       // Check clearance
       checkClearanceBetweenItems(item1, item2, violations);
     }
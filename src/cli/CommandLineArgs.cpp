@@ -35,8 +35,8 @@ bool CommandLineArgs::parse(int argc, const char* argv[],
       }
       try {
         args.maxPasses = std::stoi(argv[++i]);
-        if (args.maxPasses < 1) {
-          errorMsg = "Max passes must be at least 1";
+        if (args.maxPasses < 1 || args.maxPasses > 1000) {
+          errorMsg = "Max passes must be between 1 and 1000";
           return false;
         }
       } catch (...) {
@@ -73,6 +73,138 @@ bool CommandLineArgs::parse(int argc, const char* argv[],
         errorMsg = "Invalid number for time limit";
         return false;
       }
+    } else if (arg == "--order") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      args.connectionOrder = argv[++i];
+      if (args.connectionOrder != "size" && args.connectionOrder != "hilbert") {
+        errorMsg = "Connection order must be 'size' or 'hilbert'";
+        return false;
+      }
+    } else if (arg == "--profile") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      args.profileFile = argv[++i];
+    } else if (arg == "--proximity-weight") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      try {
+        args.proximityWeight = std::stod(argv[++i]);
+        if (args.proximityWeight < 0) {
+          errorMsg = "Proximity weight cannot be negative";
+          return false;
+        }
+      } catch (...) {
+        errorMsg = "Invalid number for proximity weight";
+        return false;
+      }
+    } else if (arg == "--capture-search") {
+      // NET[:PASS[:INDEX]]
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      std::string spec = argv[++i];
+      try {
+        size_t first = spec.find(':');
+        args.captureNet = std::stoi(spec.substr(0, first));
+        if (first != std::string::npos) {
+          size_t second = spec.find(':', first + 1);
+          args.capturePass = std::stoi(spec.substr(first + 1, second - first - 1));
+          if (second != std::string::npos) {
+            args.captureConnection = std::stoi(spec.substr(second + 1));
+          }
+        }
+      } catch (...) {
+        errorMsg = "Invalid capture spec (expected NET[:PASS[:INDEX]]): " + spec;
+        return false;
+      }
+      if (args.captureNet < 0 || args.capturePass < 1 || args.captureConnection < 0) {
+        errorMsg = "Invalid capture spec: " + spec;
+        return false;
+      }
+    } else if (arg == "--capture-file") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      args.captureFile = argv[++i];
+    } else if (arg == "--tile-size") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      try {
+        args.tileSizeMm = std::stod(argv[++i]);
+        if (args.tileSizeMm < 0) {
+          errorMsg = "Tile size cannot be negative";
+          return false;
+        }
+      } catch (...) {
+        errorMsg = "Invalid number for tile size";
+        return false;
+      }
+    } else if (arg == "--tile-halo") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      try {
+        args.tileHaloMm = std::stod(argv[++i]);
+        if (args.tileHaloMm < 0) {
+          errorMsg = "Tile halo cannot be negative";
+          return false;
+        }
+      } catch (...) {
+        errorMsg = "Invalid number for tile halo";
+        return false;
+      }
+    } else if (arg == "--workers") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      try {
+        args.workerProcesses = std::stoi(argv[++i]);
+        if (args.workerProcesses < 0) {
+          errorMsg = "Worker count cannot be negative";
+          return false;
+        }
+      } catch (...) {
+        errorMsg = "Invalid number for workers";
+        return false;
+      }
+    } else if (arg == "--max-memory") {
+      if (i + 1 >= argc) {
+        errorMsg = "Missing argument for " + arg;
+        return false;
+      }
+      try {
+        args.maxMemoryMb = std::stod(argv[++i]);
+        if (args.maxMemoryMb < 0) {
+          errorMsg = "Memory limit cannot be negative";
+          return false;
+        }
+      } catch (...) {
+        errorMsg = "Invalid number for memory limit";
+        return false;
+      }
+    } else if (arg == "--race-searches") {
+      args.raceSearches = true;
+    } else if (arg == "--assign-layers") {
+      args.assignLayers = true;
+    } else if (arg == "--no-simplify") {
+      args.simplifyPaths = false;
+    } else if (arg == "--no-pin-access") {
+      args.usePinAccess = false;
+    } else if (arg == "--no-occupancy-filter") {
+      args.useOccupancyFilter = false;
     } else if (arg == "--no-optimize") {
       args.optimize = false;
     } else if (arg == "--remove-existing" || arg == "--clear-routes") {
@@ -136,10 +268,25 @@ void CommandLineArgs::printUsage(const char* programName) {
   std::cout << "  -v, --version           Show version information\n";
   std::cout << "  -i, --input FILE        Input file (KiCad .kicad_pcb)\n";
   std::cout << "  -o, --output FILE       Output file (default: input file with _routed suffix)\n";
-  std::cout << "  -p, --passes N          Maximum routing passes (default: 10)\n";
+  std::cout << "  -p, --passes N          Maximum routing passes, 1-1000 (default: 10, or the profile's)\n";
   std::cout << "  -t, --threads N         Number of threads (default: auto-detect)\n";
   std::cout << "  --time-limit N          Time limit in seconds (default: no limit)\n";
   std::cout << "  --remove-existing       Remove all existing traces/vias before routing\n";
+  std::cout << "  --order size|hilbert    Net order within a priority tier (default: size)\n";
+  std::cout << "  --proximity-weight W    Cost for routing near other nets' copper (default: 0 = off)\n";
+  std::cout << "  --profile FILE          Load tuned router parameters (from freerouting-autotune)\n";
+  std::cout << "  --assign-layers         Give each connection a layer pair before each pass\n";
+  std::cout << "  --tile-size MM          Route tile by tile in parallel, then between tiles (default: off)\n";
+  std::cout << "  --tile-halo MM          Margin around each tile seen by its router (default: 5)\n";
+  std::cout << "  --workers N             Route tiles in N worker processes instead of threads\n";
+  std::cout << "  --max-memory MB         Evict rebuildable caches to stay under MB (default: no limit)\n";
+  std::cout << "  --race-searches         Run search engines concurrently on connections that failed before\n";
+  std::cout << "  --capture-search NET[:PASS[:INDEX]]\n";
+  std::cout << "                          Record one maze search of a net (default pass 1, first search)\n";
+  std::cout << "  --capture-file FILE     Search capture output (default: search.frsc)\n";
+  std::cout << "  --no-simplify           Insert routes exactly as found (no segment merging)\n";
+  std::cout << "  --no-pin-access         Start searches from pin centers on the pins' first layer\n";
+  std::cout << "  --no-occupancy-filter   Check every conflict against the spatial index\n";
   std::cout << "  --no-optimize           Skip route optimization\n";
   std::cout << "  --no-drc                Skip design rule checking\n";
   std::cout << "  --stop-on-drc-error     Stop if DRC errors are found\n";
@@ -176,8 +323,8 @@ bool CommandLineArgs::validate(std::string& errorMsg) const {
     return false;
   }
 
-  // Check max passes
-  if (maxPasses < 1 || maxPasses > 1000) {
+  // Check max passes (0 = not given, so the profile's or the default applies)
+  if (maxPasses != 0 && (maxPasses < 1 || maxPasses > 1000)) {
     errorMsg = "Max passes must be between 1 and 1000";
     return false;
   }
@@ -98,15 +98,9 @@ void DsnBoardConverter::addWiring(RoutingBoard* board, const DsnDesign& dsn) {
     const DsnPadstack* padstackDef = dsn.findPadstack(dsnVia.padstackName);
     if (!padstackDef) continue;
 
-    // Create padstack
-    Padstack* padstack = new Padstack(
-      dsnVia.padstackName,
-      board->generateItemId(),
-      0,  // from layer (will be set based on padstack def)
-      board->getLayers().count() - 1,  // to layer
-      true,  // attachAllowed
-      false  // placedAbsolute
-    );
+    // Shared padstack (layers will be set based on padstack def)
+    const Padstack* padstack = board->getPadstack(
+      dsnVia.padstackName, 0, board->getLayers().count() - 1);
 
     // Convert position to internal units
     IntPoint pos(
@@ -254,14 +248,8 @@ void DsnBoardConverter::addComponents(RoutingBoard* board, const DsnDesign& dsn)
 
       // Create a simple padstack for the pin
       // For now, use a generic padstack - could enhance by parsing actual padstack shapes
-      Padstack* padstack = new Padstack(
-        imagePin.padstackName,
-        board->generateItemId(),
-        0,  // all layers
-        board->getLayers().count() - 1,
-        true,  // attach allowed
-        false  // not absolute
-      );
+      const Padstack* padstack = board->getPadstack(
+        imagePin.padstackName, 0, board->getLayers().count() - 1);  // all layers
 
       // Create the pin
       int itemId = board->generateItemId();
@@ -9,6 +9,10 @@
 #include "board/RouteOptimizer.h"
 #include "board/DrcEngine.h"
 #include "autoroute/BatchAutorouter.h"
+#include "autoroute/TiledAutorouter.h"
+#include "autoroute/RouterProfile.h"
+#include "autoroute/ViaMinimizer.h"
+#include "core/MemoryBudget.h"
 #include "visualization/CongestionHeatmap.h"
 #include "visualization/BoardRenderer.h"
 #include <iostream>
@@ -29,6 +33,9 @@ constexpr int kErrorRouting = 3;
 constexpr int kErrorDrc = 4;
 constexpr int kErrorOutput = 5;
 
+// Routing passes when neither --passes nor a profile sets them
+constexpr int kDefaultMaxPasses = 10;
+
 // Log message at specified verbosity level
 void log(int verbosity, int minLevel, const std::string& message) {
   if (verbosity >= minLevel) {
@@ -114,7 +121,6 @@ int main(int argc, const char* argv[]) {
     log(args.verbosity, 1, "Output: " + args.outputFile);
   }
 
-  log(args.verbosity, 2, "Max passes: " + std::to_string(args.maxPasses));
   log(args.verbosity, 2, "Threads: " + std::to_string(args.maxThreads));
 
   if (args.timeLimit > 0) {
@@ -144,7 +150,7 @@ int main(int argc, const char* argv[]) {
 
     std::unique_ptr<RoutingBoard> board;
     ClearanceMatrix clearanceMatrix = ClearanceMatrix::createDefault(LayerStructure({Layer("F.Cu", true)}), 2000);
-    std::optional<KiCadPcb> pcbOpt;  // Keep KiCad data for output
+    std::shared_ptr<KiCadPcb> pcbData;  // Keep KiCad data for output (board shares its footprints)
 
     // Detect file format and load accordingly
     if (isDsnFile(args.inputFile)) {
@@ -181,15 +187,21 @@ int main(int argc, const char* argv[]) {
 
     } else {
       // KiCad format
-      log(args.verbosity, 2, "  Parsing KiCad PCB file...");
-      pcbOpt = KiCadPcbReader::readFromFile(args.inputFile);
+      // Footprint graphics are only drawn by the visualizer; skip them otherwise
+      KiCadLoadProfile profile = (args.visualize || args.visualizeOnly)
+        ? KiCadLoadProfile::Full
+        : KiCadLoadProfile::RoutingOnly;
+      log(args.verbosity, 2, std::string("  Parsing KiCad PCB file (") +
+          (profile == KiCadLoadProfile::Full ? "full" : "routing-only") + ")...");
+      auto pcbOpt = KiCadPcbReader::readFromFile(args.inputFile, profile);
 
       if (!pcbOpt.has_value()) {
         std::cerr << "Error: Failed to parse PCB file" << std::endl;
         return kErrorInput;
       }
 
-      KiCadPcb& pcb = *pcbOpt;
+      pcbData = std::make_shared<KiCadPcb>(std::move(*pcbOpt));
+      KiCadPcb& pcb = *pcbData;
 
       if (!pcb.isValid()) {
         std::cerr << "Error: Invalid PCB structure (missing layers or paper size)" << std::endl;
@@ -207,8 +219,12 @@ int main(int argc, const char* argv[]) {
 
       // Convert KiCad data to RoutingBoard
       log(args.verbosity, 1, "Converting to routing board...");
-      auto [kicadBoard, kicadClearance] = KiCadBoardConverter::createRoutingBoard(pcb);
+      auto convertStart = std::chrono::steady_clock::now();
+      auto [kicadBoard, kicadClearance] = KiCadBoardConverter::createRoutingBoard(pcbData);
       board = std::move(kicadBoard);
+      auto convertMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - convertStart).count();
+      log(args.verbosity, 2, "  Converted in " + std::to_string(convertMs) + " ms");
       clearanceMatrix = *kicadClearance;
       // Update clearance matrix to point to board's layer structure (not the temporary one)
       clearanceMatrix.setLayerStructure(&board->getLayers());
@@ -301,7 +317,39 @@ int main(int argc, const char* argv[]) {
 
     // Create batch autorouter configuration
     BatchAutorouter::Config config;
-    config.maxPasses = args.maxPasses;
+    config.maxPasses = kDefaultMaxPasses;
+
+    // Profile first so that explicit flags override it
+    if (!args.profileFile.empty()) {
+      std::string profileError;
+      if (!RouterProfile::loadFromFile(args.profileFile, config, profileError)) {
+        std::cerr << "Error: Invalid router profile: " << profileError << std::endl;
+        return kErrorArgs;
+      }
+      log(args.verbosity, 1, "  Router profile: " + args.profileFile);
+    }
+
+    if (args.maxPasses > 0) {
+      config.maxPasses = args.maxPasses;
+    }
+    if (args.connectionOrder == "hilbert") {
+      config.connectionOrder = BatchAutorouter::Config::ConnectionOrder::Hilbert;
+    } else if (args.connectionOrder == "size") {
+      config.connectionOrder = BatchAutorouter::Config::ConnectionOrder::NetSize;
+    }
+    if (args.proximityWeight >= 0.0) {
+      config.proximityCostWeight = args.proximityWeight;
+    }
+    config.assignLayers = args.assignLayers;
+    config.simplifyPaths = args.simplifyPaths;
+    config.usePinAccess = args.usePinAccess;
+    config.useOccupancyFilter = args.useOccupancyFilter;
+    // Racing needs a second thread
+    config.raceSearches = args.raceSearches && args.maxThreads != 1;
+    config.captureNetNo = args.captureNet;
+    config.capturePass = args.capturePass;
+    config.captureConnection = args.captureConnection;
+    config.captureFile = args.captureFile;
     // Note: BatchAutorouter doesn't expose thread count control yet
     // It will use internal threading strategies
 
@@ -311,14 +359,62 @@ int main(int argc, const char* argv[]) {
     // Set up progress display if verbose output is enabled
     ProgressDisplay progressDisplay(args.verbosity >= 1, true);
     if (args.verbosity >= 1) {
-      progressDisplay.init(static_cast<int>(connectionCount), args.maxPasses);
+      progressDisplay.init(static_cast<int>(connectionCount), config.maxPasses);
       autorouter.setProgressDisplay(&progressDisplay);
     }
 
     log(args.verbosity, 2, "  Max passes: " + std::to_string(config.maxPasses));
+    log(args.verbosity, 2, std::string("  Connection order: ") +
+        (config.connectionOrder == BatchAutorouter::Config::ConnectionOrder::Hilbert ? "hilbert" : "size"));
+    log(args.verbosity, 2, "  Proximity cost weight: " + std::to_string(config.proximityCostWeight));
+    if (config.raceSearches) {
+      log(args.verbosity, 2, "  Racing search engines from pass " + std::to_string(config.raceFromPass));
+    }
+    if (config.captureNetNo >= 0) {
+      log(args.verbosity, 1, "  Capturing search " + std::to_string(config.captureConnection) +
+          " of net " + std::to_string(config.captureNetNo) + " in pass " +
+          std::to_string(config.capturePass) + " to " + config.captureFile);
+    }
+
+    if (args.maxMemoryMb > 0.0) {
+      MemoryBudget::instance().setLimit(static_cast<size_t>(args.maxMemoryMb * 1024.0 * 1024.0));
+      log(args.verbosity, 2, "  Cache memory limit: " + std::to_string(args.maxMemoryMb) + " MB");
+    }
 
     // Run routing batch loop (in main thread)
-    bool completelyRouted = autorouter.runBatchLoop(nullptr);
+    bool completelyRouted = false;
+    BatchAutorouter::PassStatistics stats;
+    if (args.tileSizeMm > 0.0) {
+      TiledAutorouter::Config tiledConfig;
+      tiledConfig.tileSize = static_cast<int>(args.tileSizeMm * 10000.0);
+      tiledConfig.halo = static_cast<int>(args.tileHaloMm * 10000.0);
+      tiledConfig.threads = args.maxThreads;
+      tiledConfig.workerProcesses = args.workerProcesses;
+      tiledConfig.timeLimitMs = args.timeLimit * 1000;
+      tiledConfig.routing = config;
+
+      TiledAutorouter tiledAutorouter(board.get(), tiledConfig);
+      if (args.verbosity >= 1) {
+        tiledAutorouter.setProgressDisplay(&progressDisplay);
+      }
+      completelyRouted = tiledAutorouter.run(nullptr);
+      stats = tiledAutorouter.getLastPassStats();
+
+      const auto& tileStats = tiledAutorouter.getStatistics();
+      log(args.verbosity, 2, "  Tiles: " + std::to_string(tileStats.tiles) +
+          ", largest " + std::to_string(tileStats.maxTileItems) + " items, " +
+          std::to_string(tileStats.rejectedNets) + " nets left their window, " +
+          std::to_string(tileStats.conflictNets) + " conflicted");
+      if (tileStats.workers > 0) {
+        log(args.verbosity, 2, "  Workers: " + std::to_string(tileStats.workers) + ", " +
+            std::to_string(tileStats.jobBytes / 1024) + " KB of tile jobs sent");
+      }
+      log(args.verbosity, 2, "  Tile routing: " + std::to_string(tileStats.tileMs) +
+          " ms, stitching: " + std::to_string(tileStats.stitchMs) + " ms");
+    } else {
+      completelyRouted = autorouter.runBatchLoop(nullptr);
+      stats = autorouter.getLastPassStats();
+    }
 
     // Show routing summary
     if (args.verbosity >= 1) {
@@ -327,10 +423,44 @@ int main(int argc, const char* argv[]) {
 
     log(args.verbosity, 1, "Routing completed");
     log(args.verbosity, 2, completelyRouted ? "  All connections routed" : "  Some connections incomplete");
-    const auto& stats = autorouter.getLastPassStats();
     log(args.verbosity, 1, "  Items routed: " + std::to_string(stats.itemsRouted));
     log(args.verbosity, 1, "  Items failed: " + std::to_string(stats.itemsFailed));
     log(args.verbosity, 1, "  Time: " + std::to_string(stats.passDurationMs) + " ms");
+    log(args.verbosity, 1, "  Connections searched: " + std::to_string(stats.connectionsAttempted));
+    log(args.verbosity, 1, "  Per-connection time: " +
+        std::to_string(stats.averageConnectionTimeMs()) + " ms avg, " +
+        std::to_string(stats.maxConnectionTimeMs) + " ms max");
+    if (stats.pathSegmentsFound > 0) {
+      log(args.verbosity, 2, "  Path segments: " + std::to_string(stats.pathSegmentsInserted) +
+          " inserted of " + std::to_string(stats.pathSegmentsFound) + " found");
+    }
+    if (stats.tailsRemoved > 0) {
+      log(args.verbosity, 2, "  Dangling traces and vias removed: " + std::to_string(stats.tailsRemoved));
+    }
+    MemoryBudget::Statistics memoryStats = MemoryBudget::instance().getStatistics();
+    log(args.verbosity, 2, "  Cache memory: " + std::to_string(memoryStats.peakBytes / 1024) +
+        " KB peak, " + std::to_string(memoryStats.evictions) + " evictions (" +
+        std::to_string(memoryStats.bytesEvicted / 1024) + " KB)");
+    if (const PinAccess* pinAccess = board->findPinAccess()) {
+      PinAccess::Statistics accessStats = pinAccess->getStatistics();
+      log(args.verbosity, 2, "  Pin access: " + std::to_string(accessStats.pins) + " pins, " +
+          std::to_string(accessStats.blockedPins) + " boxed in, " +
+          std::to_string(accessStats.analyses) + " analyses over " +
+          std::to_string(accessStats.templates) + " pad shapes");
+    }
+    const ShapeTree& shapeTree = board->getShapeTree();
+    log(args.verbosity, 2, "  Spatial index: " + std::to_string(shapeTree.getCellSize() / 10) +
+        " um base cells, " + std::to_string(shapeTree.levelCount()) + " levels, " +
+        std::to_string(shapeTree.itemReferenceCount()) + " references for " +
+        std::to_string(shapeTree.size()) + " items");
+    if (const OccupancyPyramid* occupancy = board->findOccupancy()) {
+      OccupancyPyramid::Statistics occupancyStats = occupancy->getStatistics();
+      log(args.verbosity, 2, "  Occupancy filter: " +
+          std::to_string(static_cast<int>(occupancyStats.hitRate() * 100.0 + 0.5)) + "% of " +
+          std::to_string(occupancyStats.probes) + " probes answered (" +
+          std::to_string(occupancyStats.empty) + " empty, " +
+          std::to_string(occupancyStats.full) + " full)");
+    }
 
     // Step 2.5: Generate congestion heatmap if requested
     if (args.generateHeatmap) {
@@ -397,6 +527,17 @@ int main(int argc, const char* argv[]) {
     if (args.optimize) {
       log(args.verbosity, 1, "Optimizing routes...");
 
+      // Move via-to-via chains onto one layer where that frees the vias
+      ViaMinimizer::Config viaConfig;
+      viaConfig.threads = args.maxThreads;
+      ViaMinimizer viaMinimizer(board.get(), viaConfig);
+      viaMinimizer.run();
+      const auto& viaStats = viaMinimizer.getStatistics();
+      log(args.verbosity, 2, "  Vias removed: " + std::to_string(viaStats.viasRemoved) + " of " +
+          std::to_string(viaStats.viasBefore) + " in " + std::to_string(viaStats.durationMs) + " ms (" +
+          std::to_string(static_cast<int>(viaStats.viasRemovedPerSecond())) + " per second), " +
+          std::to_string(viaStats.conflicts) + " candidates blocked");
+
       // Get all traces from board
       std::vector<Trace*> traces;
       for (const auto& itemPtr : board->getItems()) {
@@ -409,7 +550,7 @@ int main(int argc, const char* argv[]) {
       double wireLengthBefore = RouteOptimizer::calculateWireLengthMetric(traces);
 
       // Find and merge collinear traces
-      auto mergeablePairs = RouteOptimizer::findMergeableTracePairs(traces);
+      auto mergeablePairs = RouteOptimizer::findMergeableTracePairs(traces, board->getContactIndex());
       log(args.verbosity, 2, "  Found " + std::to_string(mergeablePairs.size()) + " mergeable trace pairs");
 
       // Calculate wire length after (if we merged)
@@ -462,10 +603,10 @@ int main(int argc, const char* argv[]) {
     log(args.verbosity, 1, "Converting routing results...");
 
     // For DSN files, need to create a minimal KiCad PCB from board
-    if (!pcbOpt.has_value()) {
+    if (!pcbData) {
       // Create minimal KiCad PCB structure from board
-      pcbOpt = KiCadPcb();
-      KiCadPcb& pcb = *pcbOpt;
+      pcbData = std::make_shared<KiCadPcb>();
+      KiCadPcb& pcb = *pcbData;
 
       // Set basic properties
       pcb.version = KiCadVersion(20221018, "freerouting-cpp");  // KiCad 7.0 format
@@ -480,16 +621,16 @@ int main(int argc, const char* argv[]) {
       KiCadBoardConverter::updateKiCadPcbFromBoard(pcb, *board);
     } else {
       // Update existing KiCad PCB with routing results
-      KiCadBoardConverter::updateKiCadPcbFromBoard(*pcbOpt, *board);
+      KiCadBoardConverter::updateKiCadPcbFromBoard(*pcbData, *board);
     }
 
-    log(args.verbosity, 2, "  Output segments: " + std::to_string(pcbOpt->segments.size()));
-    log(args.verbosity, 2, "  Output vias: " + std::to_string(pcbOpt->vias.size()));
+    log(args.verbosity, 2, "  Output segments: " + std::to_string(pcbData->segments.size()));
+    log(args.verbosity, 2, "  Output vias: " + std::to_string(pcbData->vias.size()));
 
     // Step 6: Write output file
     log(args.verbosity, 1, "Writing output file...");
 
-    if (!KiCadPcbWriter::writeToFile(*pcbOpt, args.outputFile)) {
+    if (!KiCadPcbWriter::writeToFile(*pcbData, args.outputFile)) {
       std::cerr << "Error: Failed to write output file" << std::endl;
       return kErrorOutput;
     }
@@ -0,0 +1,452 @@
+// Offline autotuner for router parameters
+//
+// Usage: freerouting-autotune [options] BOARD...
+//
+// Samples parameter sets around the defaults (or a --base profile) and
+// routes every board of the corpus with each. Evaluations run in parallel,
+// one forked process each, so a crashing or runaway configuration cannot
+// take the tuner down. Configurations are raced: the corpus is worked
+// through board by board and after each board the sets that are clearly
+// worse are dropped; on a board where some set has already completed every
+// connection, evaluations running much longer than it are killed, since
+// they can no longer win.
+//
+// Sets are ranked by completion rate (mean over boards) first, then by
+// total routing time. The winner is written as a profile for --profile.
+
+#include "autoroute/BatchAutorouter.h"
+#include "autoroute/RouterProfile.h"
+#include "board/RoutingBoard.h"
+#include "io/KiCadPcbReader.h"
+#include "io/KiCadBoardConverter.h"
+#include "io/DsnReader.h"
+#include "io/DsnBoardConverter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace freerouting;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::vector<std::string> boards;
+  std::string outputFile = "tuned.profile";
+  std::string baseProfile;
+  int candidates = 16;
+  int jobs = 0;                 // 0 = hardware concurrency
+  unsigned seed = 1;
+  double timeLimit = 300.0;     // Seconds per evaluation
+  double raceFactor = 2.0;      // Kill when slower than this times a complete run
+  double tolerance = 0.01;      // Completion difference that counts as a tie
+  double timeSlack = 1.5;       // Drop tied sets slower than this times the leader
+};
+
+// What a child process reports back through its pipe
+struct Evaluation {
+  bool ok = false;
+  bool killed = false;
+  int connections = 0;
+  int remaining = 0;
+  double seconds = 0.0;
+
+  double completion() const {
+    if (!ok) return 0.0;
+    return connections > 0 ? 1.0 - static_cast<double>(remaining) / connections : 1.0;
+  }
+};
+
+struct Candidate {
+  int id = 0;
+  BatchAutorouter::Config config;
+  std::vector<Evaluation> evaluations;
+  bool alive = true;
+  std::string droppedReason;
+
+  double meanCompletion() const {
+    if (evaluations.empty()) return 0.0;
+    double sum = 0.0;
+    for (const auto& e : evaluations) sum += e.completion();
+    return sum / evaluations.size();
+  }
+
+  double totalSeconds() const {
+    double sum = 0.0;
+    for (const auto& e : evaluations) sum += e.seconds;
+    return sum;
+  }
+};
+
+// Completion first, then time
+bool ranksBefore(const Candidate& a, const Candidate& b, double tolerance) {
+  double ca = a.meanCompletion();
+  double cb = b.meanCompletion();
+  if (std::abs(ca - cb) > tolerance) {
+    return ca > cb;
+  }
+  return a.totalSeconds() < b.totalSeconds();
+}
+
+bool isDsnFile(const std::string& filename) {
+  std::string lower = filename;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  return lower.ends_with(".dsn");
+}
+
+// Runs in the child: load, route, count what is left
+Evaluation routeBoard(const std::string& filename, const BatchAutorouter::Config& config) {
+  Evaluation result;
+  std::unique_ptr<RoutingBoard> board;
+  ClearanceMatrix clearanceMatrix = ClearanceMatrix::createDefault(LayerStructure({Layer("F.Cu", true)}), 2000);
+
+  if (isDsnFile(filename)) {
+    auto dsn = DsnReader::readFromFile(filename);
+    if (!dsn) return result;
+    auto [dsnBoard, dsnClearance] = DsnBoardConverter::createRoutingBoard(*dsn);
+    board = std::move(dsnBoard);
+    clearanceMatrix = dsnClearance;
+  } else {
+    auto pcb = KiCadPcbReader::readFromFile(filename, KiCadLoadProfile::RoutingOnly);
+    if (!pcb || !pcb->isValid()) return result;
+    auto [kicadBoard, kicadClearance] = KiCadBoardConverter::createRoutingBoard(*pcb);
+    board = std::move(kicadBoard);
+    clearanceMatrix = *kicadClearance;
+  }
+  if (!board) return result;
+  clearanceMatrix.setLayerStructure(&board->getLayers());
+  board->setClearanceMatrix(&clearanceMatrix);
+  board->updateIncompleteConnections();
+
+  // Same loop as BatchAutorouter::runBatchLoop, driven here so the queue of
+  // the first pass can be kept as the connection count. Completion is what
+  // the router itself reports, as the CLI does.
+  auto start = Clock::now();
+  BatchAutorouter autorouter(board.get(), config);
+  bool more = true;
+  for (int pass = 1; more && pass <= config.maxPasses; ++pass) {
+    more = autorouter.autoroutePass(pass, nullptr);
+    if (pass == 1) {
+      result.connections = autorouter.getLastPassStats().itemsQueued;
+    }
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.remaining = more ? autorouter.getLastPassStats().itemsFailed : 0;
+  result.ok = true;
+  return result;
+}
+
+struct RunningEvaluation {
+  pid_t pid;
+  int fd;
+  size_t candidate;
+  Clock::time_point start;
+};
+
+RunningEvaluation startEvaluation(const std::string& board, const Candidate& candidate, size_t index) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return {-1, -1, index, Clock::now()};
+  }
+
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Child: the router logs freely, keep it off the terminal
+    close(fds[0]);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (devNull >= 0) {
+      dup2(devNull, STDOUT_FILENO);
+      dup2(devNull, STDERR_FILENO);
+    }
+    Evaluation e = routeBoard(board, candidate.config);
+    ssize_t written = write(fds[1], &e, sizeof(e));
+    _exit(written == static_cast<ssize_t>(sizeof(e)) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  if (pid < 0) {
+    close(fds[0]);
+  }
+  return {pid, pid < 0 ? -1 : fds[0], index, Clock::now()};
+}
+
+// Evaluate the live candidates on one board, jobs at a time
+void raceBoard(const std::string& board, std::vector<Candidate>& candidates, const Options& opt) {
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (candidates[i].alive) pending.push_back(i);
+  }
+  std::reverse(pending.begin(), pending.end());
+
+  std::vector<RunningEvaluation> running;
+  double bestCompleteSeconds = -1.0;  // Fastest run that routed everything
+
+  while (!pending.empty() || !running.empty()) {
+    while (!pending.empty() && static_cast<int>(running.size()) < opt.jobs) {
+      size_t index = pending.back();
+      pending.pop_back();
+      RunningEvaluation r = startEvaluation(board, candidates[index], index);
+      if (r.pid < 0) {
+        Evaluation failed;
+        candidates[index].evaluations.push_back(failed);
+        continue;
+      }
+      running.push_back(r);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    for (size_t i = 0; i < running.size();) {
+      RunningEvaluation& r = running[i];
+      double elapsed = std::chrono::duration<double>(Clock::now() - r.start).count();
+      int status = 0;
+      pid_t done = waitpid(r.pid, &status, WNOHANG);
+
+      Evaluation e;
+      bool finished = false;
+      if (done == r.pid) {
+        if (read(r.fd, &e, sizeof(e)) != static_cast<ssize_t>(sizeof(e))) {
+          e = Evaluation();  // Crashed
+        }
+        finished = true;
+      } else {
+        bool overLimit = elapsed > opt.timeLimit;
+        bool outRaced = bestCompleteSeconds >= 0.0 &&
+                        elapsed > opt.raceFactor * bestCompleteSeconds + 1.0;
+        if (overLimit || outRaced) {
+          kill(r.pid, SIGKILL);
+          waitpid(r.pid, &status, 0);
+          e.killed = true;
+          e.seconds = elapsed;
+          if (outRaced) {
+            candidates[r.candidate].alive = false;
+            candidates[r.candidate].droppedReason = "out-raced on " + board;
+          }
+          finished = true;
+        }
+      }
+
+      if (!finished) {
+        ++i;
+        continue;
+      }
+
+      close(r.fd);
+      if (e.ok && e.remaining == 0 &&
+          (bestCompleteSeconds < 0.0 || e.seconds < bestCompleteSeconds)) {
+        bestCompleteSeconds = e.seconds;
+      }
+      candidates[r.candidate].evaluations.push_back(e);
+      running.erase(running.begin() + static_cast<long>(i));
+    }
+  }
+}
+
+// Drop the sets that can no longer be expected to win
+void eliminate(std::vector<Candidate>& candidates, const Options& opt) {
+  const Candidate* leader = nullptr;
+  for (const auto& c : candidates) {
+    if (c.alive && (!leader || ranksBefore(c, *leader, opt.tolerance))) {
+      leader = &c;
+    }
+  }
+  if (!leader) return;
+
+  double leaderCompletion = leader->meanCompletion();
+  double leaderSeconds = leader->totalSeconds();
+  for (auto& c : candidates) {
+    if (!c.alive || &c == leader) continue;
+    if (c.meanCompletion() < leaderCompletion - opt.tolerance) {
+      c.alive = false;
+      c.droppedReason = "lower completion";
+    } else if (c.meanCompletion() <= leaderCompletion &&
+               c.totalSeconds() > opt.timeSlack * leaderSeconds + 1.0) {
+      c.alive = false;
+      c.droppedReason = "slower at equal completion";
+    }
+  }
+}
+
+// Log-uniform sample in [lo, hi]
+double logUniform(std::mt19937& rng, double lo, double hi) {
+  std::uniform_real_distribution<double> dist(std::log(lo), std::log(hi));
+  return std::exp(dist(rng));
+}
+
+BatchAutorouter::Config sampleConfig(std::mt19937& rng, const BatchAutorouter::Config& base) {
+  BatchAutorouter::Config c = base;
+  c.maxPasses = std::uniform_int_distribution<int>(2, 2 * std::max(2, base.maxPasses))(rng);
+  c.startRipupCosts = static_cast<int>(logUniform(rng, 25.0, 800.0));
+  c.viaCost = std::round(logUniform(rng, 20.0, 500.0));
+  c.traceCostPreferred = 1.0;
+  c.traceCostAgainst = std::round(logUniform(rng, 1.0, 4.0) * 100.0) / 100.0;
+  c.maxIterationsBase = static_cast<int>(logUniform(rng, 10000.0, 200000.0)) / 1000 * 1000;
+  c.maxIterationsPerConnection = static_cast<int>(logUniform(rng, 500.0, 20000.0)) / 100 * 100;
+  return c;
+}
+
+std::string describe(const BatchAutorouter::Config& c) {
+  std::ostringstream out;
+  out << "passes=" << c.maxPasses << " ripup=" << c.startRipupCosts
+      << " via=" << c.viaCost << " against=" << c.traceCostAgainst
+      << " iter=" << c.maxIterationsBase << "+" << c.maxIterationsPerConnection;
+  return out.str();
+}
+
+void printStandings(const std::vector<Candidate>& candidates) {
+  std::cout << "  " << std::setw(4) << "id" << std::setw(12) << "completion"
+            << std::setw(10) << "time(s)" << "  parameters\n";
+  for (const auto& c : candidates) {
+    std::cout << "  " << std::setw(4) << c.id
+              << std::setw(11) << std::fixed << std::setprecision(1) << c.meanCompletion() * 100.0 << "%"
+              << std::setw(10) << std::setprecision(2) << c.totalSeconds()
+              << "  " << describe(c.config);
+    if (!c.alive) std::cout << "  [dropped: " << c.droppedReason << "]";
+    std::cout << "\n";
+  }
+}
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options] BOARD...\n"
+            << "  -o FILE               Output profile (default: tuned.profile)\n"
+            << "  --base FILE           Profile to start from (default: router defaults)\n"
+            << "  --candidates N        Parameter sets to try, including the base (default: 16)\n"
+            << "  -j, --jobs N          Parallel evaluations (default: CPU count)\n"
+            << "  --seed N              Random seed (default: 1)\n"
+            << "  --time-limit SEC      Limit per evaluation (default: 300)\n"
+            << "  --race-factor F       Kill runs slower than F times a complete run (default: 2)\n"
+            << "  --tolerance T         Completion difference treated as a tie (default: 0.01)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    try {
+      if (arg == "-h" || arg == "--help") {
+        return false;
+      } else if (arg == "-o") {
+        const char* v = next(); if (!v) return false; opt.outputFile = v;
+      } else if (arg == "--base") {
+        const char* v = next(); if (!v) return false; opt.baseProfile = v;
+      } else if (arg == "--candidates") {
+        const char* v = next(); if (!v) return false; opt.candidates = std::stoi(v);
+      } else if (arg == "-j" || arg == "--jobs") {
+        const char* v = next(); if (!v) return false; opt.jobs = std::stoi(v);
+      } else if (arg == "--seed") {
+        const char* v = next(); if (!v) return false; opt.seed = static_cast<unsigned>(std::stoul(v));
+      } else if (arg == "--time-limit") {
+        const char* v = next(); if (!v) return false; opt.timeLimit = std::stod(v);
+      } else if (arg == "--race-factor") {
+        const char* v = next(); if (!v) return false; opt.raceFactor = std::stod(v);
+      } else if (arg == "--tolerance") {
+        const char* v = next(); if (!v) return false; opt.tolerance = std::stod(v);
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "Unknown option: " << arg << "\n";
+        return false;
+      } else {
+        opt.boards.push_back(arg);
+      }
+    } catch (...) {
+      std::cerr << "Invalid value for " << arg << "\n";
+      return false;
+    }
+  }
+  return !opt.boards.empty() && opt.candidates >= 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (opt.jobs <= 0) {
+    opt.jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+
+  // The CLI's defaults, optionally overridden by a base profile
+  BatchAutorouter::Config base;
+  base.maxPasses = 10;
+  if (!opt.baseProfile.empty()) {
+    std::string error;
+    if (!RouterProfile::loadFromFile(opt.baseProfile, base, error)) {
+      std::cerr << "Error: " << error << "\n";
+      return 1;
+    }
+  }
+
+  std::mt19937 rng(opt.seed);
+  std::vector<Candidate> candidates(static_cast<size_t>(opt.candidates));
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    candidates[i].id = static_cast<int>(i);
+    candidates[i].config = i == 0 ? base : sampleConfig(rng, base);
+  }
+
+  std::cout << "Tuning " << candidates.size() << " parameter sets on "
+            << opt.boards.size() << " board(s), " << opt.jobs << " jobs\n";
+
+  auto tuneStart = Clock::now();
+  for (const auto& board : opt.boards) {
+    size_t alive = std::count_if(candidates.begin(), candidates.end(),
+                                 [](const Candidate& c) { return c.alive; });
+    std::cout << "\n" << board << ": " << alive << " sets\n";
+
+    raceBoard(board, candidates, opt);
+    eliminate(candidates, opt);
+    printStandings(candidates);
+  }
+
+  const Candidate* winner = nullptr;
+  for (const auto& c : candidates) {
+    if (c.alive && (!winner || ranksBefore(c, *winner, opt.tolerance))) {
+      winner = &c;
+    }
+  }
+  if (!winner) {
+    std::cerr << "Error: no parameter set survived\n";
+    return 1;
+  }
+
+  const Candidate& baseline = candidates[0];
+  std::ostringstream comment;
+  comment << std::fixed << std::setprecision(1)
+          << "Tuned by freerouting-autotune on " << opt.boards.size() << " board(s), "
+          << candidates.size() << " sets, seed " << opt.seed << "\n"
+          << "Completion " << winner->meanCompletion() * 100.0 << "%, "
+          << std::setprecision(2) << winner->totalSeconds() << "s routing";
+  if (baseline.alive && winner != &baseline) {
+    comment << std::setprecision(1) << " (base: " << baseline.meanCompletion() * 100.0 << "%, "
+            << std::setprecision(2) << baseline.totalSeconds() << "s)";
+  } else if (!baseline.alive) {
+    comment << " (base dropped: " << baseline.droppedReason << ")";
+  }
+
+  if (!RouterProfile::saveToFile(opt.outputFile, winner->config, comment.str())) {
+    std::cerr << "Error: Failed to write " << opt.outputFile << "\n";
+    return 1;
+  }
+
+  double tuneSeconds = std::chrono::duration<double>(Clock::now() - tuneStart).count();
+  std::cout << "\nBest: set " << winner->id << " (" << describe(winner->config) << ")\n"
+            << comment.str() << "\n"
+            << "Wrote " << opt.outputFile << " after " << std::setprecision(1)
+            << tuneSeconds << "s\n";
+  return 0;
+}
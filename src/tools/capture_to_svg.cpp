@@ -0,0 +1,326 @@
+// Renders a maze search capture (written with --capture-search) as SVG
+//
+// Usage: freerouting-capture-svg CAPTURE.frsc OUT.svg [--layer N]
+//
+// Board items are drawn grey (the routed net green), rooms created by the
+// search as blue outlines, obstacle rooms it entered in orange, queued
+// doors as small grey dots and expanded doors coloured by expansion order
+// (blue = early, red = late). The path found is drawn on top. A summary,
+// including how well DestinationDistance estimated the remaining cost
+// along the path, is printed and embedded in the SVG.
+
+#include "autoroute/SearchCapture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace freerouting;
+
+namespace {
+
+using Kind = SearchCapture::Kind;
+using Record = SearchCapture::Record;
+
+struct Summary {
+  size_t rooms = 0;
+  size_t obstacleRooms = 0;
+  size_t queued = 0;
+  size_t expanded = 0;
+  size_t pathPoints = 0;
+  double pathLength = 0.0;    // Board units, along the waypoints
+  double airline = 0.0;       // Board units, first to last waypoint
+  int estimatedDoors = 0;     // Path doors with an expansion record
+  double estimateRatio = 0.0; // Mean estimate / actual remaining cost
+  double worstOverestimate = 0.0;
+  std::map<int, size_t> expandedPerLayer;
+};
+
+bool onLayer(const Record& r, int layer) {
+  return layer < 0 || (r.firstLayer <= layer && layer <= r.lastLayer);
+}
+
+const char* outcomeName(SearchCapture::Outcome outcome) {
+  switch (outcome) {
+    case SearchCapture::Outcome::MazeSearch: return "maze search";
+    case SearchCapture::Outcome::GridFallback: return "grid fallback";
+    default: return "not found";
+  }
+}
+
+// Blue -> cyan -> yellow -> red as t goes 0..1
+std::string rampColor(double t) {
+  t = std::clamp(t, 0.0, 1.0);
+  double r, g, b;
+  if (t < 1.0 / 3.0) {
+    double u = t * 3.0;
+    r = 0.0; g = u; b = 1.0;
+  } else if (t < 2.0 / 3.0) {
+    double u = (t - 1.0 / 3.0) * 3.0;
+    r = u; g = 1.0; b = 1.0 - u;
+  } else {
+    double u = (t - 2.0 / 3.0) * 3.0;
+    r = 1.0; g = 1.0 - u; b = 0.0;
+  }
+  char buf[8];
+  std::snprintf(buf, sizeof(buf), "#%02x%02x%02x",
+                static_cast<int>(r * 255), static_cast<int>(g * 255), static_cast<int>(b * 255));
+  return buf;
+}
+
+IntPoint center(const IntBox& box) {
+  return IntPoint((box.ll.x + box.ur.x) / 2, (box.ll.y + box.ur.y) / 2);
+}
+
+Summary summarize(const SearchCapture& capture) {
+  Summary s;
+  const auto& records = capture.getRecords();
+
+  // Last expansion record of each door (a door section is expanded once)
+  std::map<int, const Record*> expandedDoor;
+  double finalCost = 0.0;
+  std::vector<const Record*> path;
+
+  for (const Record& r : records) {
+    switch (r.kind) {
+      case Kind::Room: ++s.rooms; break;
+      case Kind::ObstacleRoom: ++s.obstacleRooms; break;
+      case Kind::DoorQueued: ++s.queued; break;
+      case Kind::DoorExpanded:
+        ++s.expanded;
+        ++s.expandedPerLayer[r.firstLayer];
+        expandedDoor[r.tag] = &r;
+        finalCost = std::max(finalCost, static_cast<double>(r.expansionValue));
+        break;
+      case Kind::PathPoint:
+        path.push_back(&r);
+        break;
+      default: break;
+    }
+  }
+
+  s.pathPoints = path.size();
+  for (size_t i = 1; i < path.size(); ++i) {
+    double dx = path[i]->box.ll.x - path[i - 1]->box.ll.x;
+    double dy = path[i]->box.ll.y - path[i - 1]->box.ll.y;
+    s.pathLength += std::sqrt(dx * dx + dy * dy);
+  }
+  if (path.size() >= 2) {
+    double dx = path.back()->box.ll.x - path.front()->box.ll.x;
+    double dy = path.back()->box.ll.y - path.front()->box.ll.y;
+    s.airline = std::sqrt(dx * dx + dy * dy);
+  }
+
+  // The destination door's expansion value is the true cost of the path,
+  // so for each door on it the true remaining cost is known
+  if (!path.empty() && path.back()->tag >= 0 && expandedDoor.count(path.back()->tag)) {
+    finalCost = expandedDoor[path.back()->tag]->expansionValue;
+  }
+  double ratioSum = 0.0;
+  for (const Record* p : path) {
+    auto it = expandedDoor.find(p->tag);
+    if (p->tag < 0 || it == expandedDoor.end()) {
+      continue;
+    }
+    double estimate = it->second->sortingValue - it->second->expansionValue;
+    double actual = finalCost - it->second->expansionValue;
+    if (actual <= 0.0) {
+      continue;
+    }
+    ratioSum += estimate / actual;
+    s.worstOverestimate = std::max(s.worstOverestimate, estimate / actual);
+    ++s.estimatedDoors;
+  }
+  if (s.estimatedDoors > 0) {
+    s.estimateRatio = ratioSum / s.estimatedDoors;
+  }
+
+  return s;
+}
+
+std::string summaryText(const SearchCapture& capture, const Summary& s) {
+  std::ostringstream out;
+  out << "Net " << capture.getNetNo() << ", pass " << capture.getPassNo()
+      << ": " << outcomeName(capture.getOutcome()) << "\n";
+  out << "  Rooms created:      " << s.rooms << "\n";
+  out << "  Obstacle rooms:     " << s.obstacleRooms << "\n";
+  out << "  Doors queued:       " << s.queued << "\n";
+  out << "  Doors expanded:     " << s.expanded << "\n";
+  out << "  Path waypoints:     " << s.pathPoints << "\n";
+  if (s.pathPoints > 0) {
+    out << "  Expanded per waypoint: " << (static_cast<double>(s.expanded) / s.pathPoints) << "\n";
+    out << "  Path length:        " << (s.pathLength / 10000.0) << "mm (airline "
+        << (s.airline / 10000.0) << "mm)\n";
+  }
+  if (s.estimatedDoors > 0) {
+    out << "  Distance estimate / actual remaining cost along path: mean "
+        << s.estimateRatio << ", max " << s.worstOverestimate
+        << " (> 1 overestimates)\n";
+  }
+  for (const auto& [layer, count] : s.expandedPerLayer) {
+    out << "  Layer " << layer << ": " << count << " expanded\n";
+  }
+  return out.str();
+}
+
+bool writeSvg(const SearchCapture& capture, const Summary& summary,
+              const std::string& filename, int layer) {
+  const auto& records = capture.getRecords();
+
+  // View the part of the board the search touched, with a margin
+  IntBox view;
+  for (const Record& r : records) {
+    if (r.kind == Kind::Obstacle || !onLayer(r, layer)) {
+      continue;
+    }
+    view.ll.x = std::min(view.ll.x, r.box.ll.x);
+    view.ll.y = std::min(view.ll.y, r.box.ll.y);
+    view.ur.x = std::max(view.ur.x, r.box.ur.x);
+    view.ur.y = std::max(view.ur.y, r.box.ur.y);
+  }
+  if (view.ll.x > view.ur.x) {
+    view = capture.getBounds();
+  }
+  int margin = std::max(20000, (view.ur.x - view.ll.x) / 10);
+  view = IntBox(view.ll.x - margin, view.ll.y - margin, view.ur.x + margin, view.ur.y + margin);
+
+  double viewWidth = std::max(1, view.ur.x - view.ll.x);
+  double viewHeight = std::max(1, view.ur.y - view.ll.y);
+  double scale = 1200.0 / viewWidth;
+  int svgWidth = 1200;
+  int svgHeight = static_cast<int>(viewHeight * scale) + 1;
+
+  auto sx = [&](int x) { return (x - view.ll.x) * scale; };
+  auto sy = [&](int y) { return (y - view.ll.y) * scale; };
+  auto visible = [&](const IntBox& b) {
+    return b.ur.x >= view.ll.x && b.ll.x <= view.ur.x && b.ur.y >= view.ll.y && b.ll.y <= view.ur.y;
+  };
+  auto rect = [&](std::ostream& out, const IntBox& b, const std::string& style) {
+    out << "  <rect x=\"" << sx(b.ll.x) << "\" y=\"" << sy(b.ll.y)
+        << "\" width=\"" << std::max(0.5, (b.ur.x - b.ll.x) * scale)
+        << "\" height=\"" << std::max(0.5, (b.ur.y - b.ll.y) * scale)
+        << "\" " << style << "/>\n";
+  };
+
+  std::ofstream out(filename);
+  if (!out) {
+    return false;
+  }
+
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  out << "<svg width=\"" << svgWidth << "\" height=\"" << svgHeight
+      << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+  out << "  <title>Search capture - net " << capture.getNetNo() << ", pass "
+      << capture.getPassNo() << (layer >= 0 ? ", layer " + std::to_string(layer) : "") << "</title>\n";
+  out << "  <desc>\n" << summaryText(capture, summary) << "  </desc>\n";
+  out << "  <rect width=\"100%\" height=\"100%\" fill=\"#101010\"/>\n";
+
+  // Board items
+  for (const Record& r : records) {
+    if (r.kind != Kind::Obstacle || !onLayer(r, layer) || !visible(r.box)) {
+      continue;
+    }
+    bool ownNet = r.tag == capture.getNetNo();
+    rect(out, r.box, ownNet ? "fill=\"#2e8b57\" opacity=\"0.7\""
+                            : "fill=\"#808080\" opacity=\"0.35\"");
+  }
+
+  // Rooms
+  for (const Record& r : records) {
+    if (!onLayer(r, layer)) {
+      continue;
+    }
+    if (r.kind == Kind::Room) {
+      rect(out, r.box, "fill=\"none\" stroke=\"#4a90d9\" stroke-width=\"0.6\" opacity=\"0.6\"");
+    } else if (r.kind == Kind::ObstacleRoom) {
+      rect(out, r.box, "fill=\"none\" stroke=\"#ff9900\" stroke-width=\"0.8\" stroke-dasharray=\"3,2\"");
+    }
+  }
+
+  // Doors: queued first, then expanded in expansion order
+  for (const Record& r : records) {
+    if (r.kind == Kind::DoorQueued && onLayer(r, layer)) {
+      IntPoint c = center(r.box);
+      out << "  <circle cx=\"" << sx(c.x) << "\" cy=\"" << sy(c.y)
+          << "\" r=\"1.2\" fill=\"#b0b0b0\" opacity=\"0.5\"/>\n";
+    }
+  }
+  size_t expandedIndex = 0;
+  for (const Record& r : records) {
+    if (r.kind != Kind::DoorExpanded) {
+      continue;
+    }
+    double t = summary.expanded > 1 ? static_cast<double>(expandedIndex) / (summary.expanded - 1) : 0.0;
+    ++expandedIndex;
+    if (!onLayer(r, layer)) {
+      continue;
+    }
+    IntPoint c = center(r.box);
+    out << "  <circle cx=\"" << sx(c.x) << "\" cy=\"" << sy(c.y) << "\" r=\"2.5\" fill=\""
+        << rampColor(t) << "\"><title>expansion " << r.expansionValue
+        << ", sorting " << r.sortingValue << "</title></circle>\n";
+  }
+
+  // Path
+  std::vector<const Record*> path;
+  for (const Record& r : records) {
+    if (r.kind == Kind::PathPoint) {
+      path.push_back(&r);
+    }
+  }
+  if (!path.empty()) {
+    out << "  <polyline fill=\"none\" stroke=\"#ff3030\" stroke-width=\"2.5\" points=\"";
+    for (const Record* p : path) {
+      out << sx(p->box.ll.x) << "," << sy(p->box.ll.y) << " ";
+    }
+    out << "\"/>\n";
+    for (const Record* p : path) {
+      out << "  <circle cx=\"" << sx(p->box.ll.x) << "\" cy=\"" << sy(p->box.ll.y)
+          << "\" r=\"3\" fill=\"#ff3030\"><title>layer " << p->firstLayer << "</title></circle>\n";
+    }
+  }
+
+  out << "</svg>\n";
+  return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " CAPTURE.frsc OUT.svg [--layer N]\n";
+    return 1;
+  }
+
+  int layer = -1;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--layer" && i + 1 < argc) {
+      layer = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  auto capture = SearchCapture::readFromFile(argv[1]);
+  if (!capture) {
+    std::cerr << "Error: " << argv[1] << " is not a readable search capture\n";
+    return 1;
+  }
+
+  Summary summary = summarize(*capture);
+  std::cout << summaryText(*capture, summary);
+
+  if (!writeSvg(*capture, summary, argv[2], layer)) {
+    std::cerr << "Error: Failed to write " << argv[2] << "\n";
+    return 1;
+  }
+  std::cout << "Wrote " << argv[2] << "\n";
+  return 0;
+}
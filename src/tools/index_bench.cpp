@@ -0,0 +1,137 @@
+// Spatial index benchmark
+//
+// Usage: freerouting-index-bench [--fixed-cell MM] [--rounds N] BOARD
+//
+// Loads a board and compares its spatial index (the hierarchical grid the
+// board builds) with a single-level grid of fixed cells over the same
+// items: cells and item references held, and time for one clearance query
+// around every item.
+
+#include "board/RoutingBoard.h"
+#include "io/KiCadPcbReader.h"
+#include "io/KiCadBoardConverter.h"
+#include "io/DsnReader.h"
+#include "io/DsnBoardConverter.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace freerouting;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string board;
+  double fixedCellMm = 1.0;  // Cell size of the comparison grid
+  int rounds = 5;            // Query rounds; the average is reported
+};
+
+bool isDsnFile(const std::string& filename) {
+  return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".dsn") == 0;
+}
+
+// Time a clearance query around every item, averaged over the rounds
+double timeQueries(const ShapeTree& tree, const std::vector<Item*>& items, int rounds, size_t& found) {
+  found = 0;
+  auto start = Clock::now();
+  for (int round = 0; round < rounds; ++round) {
+    for (const Item* item : items) {
+      found += tree.queryRegion(item->getBoundingBox().expand(5000), item->layerMask()).size();
+    }
+  }
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / rounds;
+}
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options] BOARD\n\n"
+            << "Options:\n"
+            << "  --fixed-cell MM      Cell size of the fixed grid compared with (default: 1)\n"
+            << "  --rounds N           Query rounds to average over (default: 5)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    try {
+      if (arg == "-h" || arg == "--help") {
+        return false;
+      } else if (arg == "--fixed-cell") {
+        const char* v = next(); if (!v) return false; opt.fixedCellMm = std::stod(v);
+      } else if (arg == "--rounds") {
+        const char* v = next(); if (!v) return false; opt.rounds = std::max(1, std::stoi(v));
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "Unknown option: " << arg << "\n";
+        return false;
+      } else {
+        opt.board = arg;
+      }
+    } catch (...) {
+      std::cerr << "Invalid value for " << arg << "\n";
+      return false;
+    }
+  }
+  return !opt.board.empty() && opt.fixedCellMm > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<RoutingBoard> board;
+  ClearanceMatrix clearanceMatrix = ClearanceMatrix::createDefault(LayerStructure({Layer("F.Cu", true)}), 2000);
+  if (isDsnFile(opt.board)) {
+    auto dsn = DsnReader::readFromFile(opt.board);
+    if (dsn) {
+      auto [dsnBoard, dsnClearance] = DsnBoardConverter::createRoutingBoard(*dsn);
+      board = std::move(dsnBoard);
+      clearanceMatrix = dsnClearance;
+    }
+  } else {
+    auto pcb = KiCadPcbReader::readFromFile(opt.board, KiCadLoadProfile::RoutingOnly);
+    if (pcb && pcb->isValid()) {
+      auto [kicadBoard, kicadClearance] = KiCadBoardConverter::createRoutingBoard(*pcb);
+      board = std::move(kicadBoard);
+      clearanceMatrix = *kicadClearance;
+    }
+  }
+  if (!board) {
+    std::cerr << "Error: cannot load " << opt.board << "\n";
+    return 1;
+  }
+  clearanceMatrix.setLayerStructure(&board->getLayers());
+  board->setClearanceMatrix(&clearanceMatrix);
+
+  std::vector<Item*> items;
+  ShapeTree fixed(static_cast<int>(opt.fixedCellMm * 10000.0), ShapeTree::Grid::Fixed);
+  for (const auto& item : board->getItems()) {
+    items.push_back(item.get());
+    fixed.insert(item.get());
+  }
+
+  const ShapeTree& tree = board->getShapeTree();
+  size_t treeFound = 0;
+  size_t fixedFound = 0;
+  double treeMs = timeQueries(tree, items, opt.rounds, treeFound);
+  double fixedMs = timeQueries(fixed, items, opt.rounds, fixedFound);
+  std::cout << opt.board << ": " << items.size() << " items\n"
+            << std::fixed << std::setprecision(2)
+            << "  Spatial index: base cell " << tree.getCellSize() / 10000.0 << " mm, "
+            << tree.levelCount() << " levels, " << tree.cellCount() << " cells, "
+            << tree.itemReferenceCount() << " references, " << treeMs << " ms per "
+            << items.size() << " queries\n"
+            << "  Fixed " << opt.fixedCellMm << " mm grid: " << fixed.cellCount() << " cells, "
+            << fixed.itemReferenceCount() << " references, " << fixedMs << " ms"
+            << (treeFound == fixedFound ? "" : " (results differ!)") << "\n";
+  return 0;
+}
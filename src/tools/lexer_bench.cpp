@@ -0,0 +1,124 @@
+// S-expression lexer throughput benchmark
+//
+// Usage: freerouting-lexer-bench [--rounds N] FILE...
+//
+// Reads each file (.kicad_pcb, .dsn or any S-expression text) into memory
+// and reports the lexer's throughput in GB/s, best of N rounds, for two
+// ways of going through it: every token read (a full parse), and the top
+// level list skipped unread (what the routing-only load profile does with
+// the sections it drops).
+
+#include "io/SExprLexer.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace freerouting;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::vector<std::string> files;
+  int rounds = 5;
+};
+
+// Best time of the rounds, in ms
+template<typename FN>
+double bestOf(int rounds, FN&& fn) {
+  double best = 0.0;
+  for (int round = 0; round < rounds; ++round) {
+    auto start = Clock::now();
+    fn();
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    best = round == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+double gbPerSecond(size_t bytes, double ms) {
+  return ms > 0.0 ? static_cast<double>(bytes) / (ms * 1.0e6) : 0.0;
+}
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options] FILE...\n\n"
+            << "Options:\n"
+            << "  --rounds N           Rounds per file; the best is reported (default: 5)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    try {
+      if (arg == "-h" || arg == "--help") {
+        return false;
+      } else if (arg == "--rounds") {
+        if (i + 1 >= argc) return false;
+        opt.rounds = std::max(1, std::stoi(argv[++i]));
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "Unknown option: " << arg << "\n";
+        return false;
+      } else {
+        opt.files.push_back(arg);
+      }
+    } catch (...) {
+      std::cerr << "Invalid value for " << arg << "\n";
+      return false;
+    }
+  }
+  return !opt.files.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  int failed = 0;
+  for (const std::string& filename : opt.files) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+      std::cerr << "Error: cannot read " << filename << "\n";
+      ++failed;
+      continue;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+
+    size_t tokens = 0;
+    double tokenMs = bestOf(opt.rounds, [&] {
+      SExprLexer lexer(text);
+      tokens = 0;
+      while (lexer.nextToken().type != SExprTokenType::EndOfFile) {
+        ++tokens;
+      }
+    });
+    size_t skipped = 0;
+    double skipMs = bestOf(opt.rounds, [&] {
+      SExprLexer lexer(text);
+      if (lexer.nextToken().type == SExprTokenType::LeftParen) {
+        lexer.skipBalanced();
+      }
+      skipped = lexer.getOffset();
+    });
+
+    std::cout << filename << ": " << std::fixed << std::setprecision(2)
+              << static_cast<double>(text.size()) / 1.0e6 << " MB\n"
+              << "  Tokens: " << tokens << " in " << tokenMs << " ms ("
+              << gbPerSecond(text.size(), tokenMs) << " GB/s)\n"
+              << "  Skip:   " << skipped << " bytes in " << skipMs << " ms ("
+              << gbPerSecond(skipped, skipMs) << " GB/s)\n";
+  }
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+// Latency benchmark for interactive routing (RoutingSession)
+//
+// Usage: freerouting-session-bench [options] BOARD
+//
+// Loads a board into a session and routes its incomplete connections one
+// call at a time, as an editor's "route this connection now" would, then
+// reports the latency distribution of the calls. Routes stay on the board
+// unless --undo is given, so later calls see the copper of earlier ones.
+// Each connection is also used for an edit: its start item is moved by a
+// small offset and back, and the latency of those edits is reported too.
+
+#include "autoroute/RoutingSession.h"
+#include "board/RoutingBoard.h"
+#include "io/KiCadPcbReader.h"
+#include "io/KiCadBoardConverter.h"
+#include "io/DsnReader.h"
+#include "io/DsnBoardConverter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace freerouting;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string board;
+  int connections = 0;      // 0 = all
+  bool undo = false;        // Take each route off again
+  RoutingSession::Options routing;
+};
+
+bool isDsnFile(const std::string& filename) {
+  return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".dsn") == 0;
+}
+
+// Value below which a fraction p of the sorted samples lie
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+  return sorted[std::min(sorted.size(), std::max<size_t>(index, 1)) - 1];
+}
+
+void printLatency(const char* name, std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  std::cout << std::fixed << std::setprecision(2)
+            << "  " << name << ": " << samples.size() << " calls, p50 " << percentile(samples, 0.50)
+            << " ms, p99 " << percentile(samples, 0.99)
+            << " ms, max " << (samples.empty() ? 0.0 : samples.back()) << " ms\n";
+}
+
+void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options] BOARD\n\n"
+            << "Options:\n"
+            << "  -n N                 Route at most N connections (default: all)\n"
+            << "  --undo               Take each route off again after timing it\n"
+            << "  --margin MM          Search window margin (default: 5)\n"
+            << "  --time-limit MS      Deadline per call (default: 50)\n"
+            << "  --iterations N       Maze search budget per call (default: 20000)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    try {
+      if (arg == "-h" || arg == "--help") {
+        return false;
+      } else if (arg == "-n") {
+        const char* v = next(); if (!v) return false; opt.connections = std::stoi(v);
+      } else if (arg == "--undo") {
+        opt.undo = true;
+      } else if (arg == "--margin") {
+        const char* v = next(); if (!v) return false;
+        opt.routing.margin = static_cast<int>(std::stod(v) * 10000.0);
+      } else if (arg == "--time-limit") {
+        const char* v = next(); if (!v) return false; opt.routing.timeLimitMs = std::stoi(v);
+      } else if (arg == "--iterations") {
+        const char* v = next(); if (!v) return false; opt.routing.maxIterations = std::stoi(v);
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "Unknown option: " << arg << "\n";
+        return false;
+      } else {
+        opt.board = arg;
+      }
+    } catch (...) {
+      std::cerr << "Invalid value for " << arg << "\n";
+      return false;
+    }
+  }
+  return !opt.board.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<RoutingBoard> board;
+  ClearanceMatrix clearanceMatrix = ClearanceMatrix::createDefault(LayerStructure({Layer("F.Cu", true)}), 2000);
+  if (isDsnFile(opt.board)) {
+    auto dsn = DsnReader::readFromFile(opt.board);
+    if (dsn) {
+      auto [dsnBoard, dsnClearance] = DsnBoardConverter::createRoutingBoard(*dsn);
+      board = std::move(dsnBoard);
+      clearanceMatrix = dsnClearance;
+    }
+  } else {
+    auto pcb = KiCadPcbReader::readFromFile(opt.board, KiCadLoadProfile::RoutingOnly);
+    if (pcb && pcb->isValid()) {
+      auto [kicadBoard, kicadClearance] = KiCadBoardConverter::createRoutingBoard(*pcb);
+      board = std::move(kicadBoard);
+      clearanceMatrix = *kicadClearance;
+    }
+  }
+  if (!board) {
+    std::cerr << "Error: cannot load " << opt.board << "\n";
+    return 1;
+  }
+  clearanceMatrix.setLayerStructure(&board->getLayers());
+  board->setClearanceMatrix(&clearanceMatrix);
+
+  auto loadStart = Clock::now();
+  RoutingSession session(std::move(board));
+  std::vector<std::pair<int, int>> connections;
+  for (const auto& conn : session.getIncompleteConnections()) {
+    if (conn.getFromItem() && conn.getToItem()) {
+      connections.emplace_back(conn.getFromItem()->getId(), conn.getToItem()->getId());
+    }
+  }
+  if (opt.connections > 0 && connections.size() > static_cast<size_t>(opt.connections)) {
+    connections.resize(static_cast<size_t>(opt.connections));
+  }
+  double setupMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+
+  std::cout << opt.board << ": " << session.getBoard().itemCount() << " items, "
+            << connections.size() << " connections (session set up in "
+            << std::fixed << std::setprecision(1) << setupMs << " ms)\n";
+
+  std::vector<double> routeMs;
+  std::vector<double> searchMs;
+  std::vector<double> editMs;
+  int routed = 0;
+  int conflicts = 0;
+  int notRouted = 0;
+  size_t windowItems = 0;
+  const IntVector nudge(1000, 0);  // 0.1mm
+
+  for (const auto& [fromId, toId] : connections) {
+    RoutingSession::Result result = session.routeConnection(fromId, toId, opt.routing);
+    routeMs.push_back(result.totalMs);
+    searchMs.push_back(result.searchMs);
+    windowItems += static_cast<size_t>(result.windowItems);
+    switch (result.status) {
+      case RoutingSession::Status::Routed: ++routed; break;
+      case RoutingSession::Status::Conflict: ++conflicts; break;
+      default: ++notRouted; break;
+    }
+    if (opt.undo) {
+      session.removeRoute(result);
+    }
+
+    for (IntVector offset : {nudge, IntVector(-nudge.x, -nudge.y)}) {
+      auto editStart = Clock::now();
+      session.moveItem(fromId, offset);
+      editMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - editStart).count());
+    }
+  }
+
+  std::cout << "  Routed " << routed << ", rejected for clearance " << conflicts
+            << ", not routed " << notRouted << "\n";
+  if (!connections.empty()) {
+    std::cout << "  Items searched per call: " << windowItems / connections.size() << " of "
+              << session.getBoard().itemCount() << "\n";
+  }
+  printLatency("routeConnection", routeMs);
+  printLatency("  search", searchMs);
+  printLatency("moveItem", editMs);
+  return 0;
+}
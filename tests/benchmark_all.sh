@@ -6,6 +6,8 @@ CPP_CLI="./build/freerouting-cli"
 JAVA_JAR="freerouting.app/integrations/KiCad/kicad-freerouting/plugins/jar/freerouting-2.1.0.jar"
 OUTPUT_DIR="/tmp/full_benchmark_results"
 TIMEOUT_SECONDS=300
+CPP_ORDER="${CPP_ORDER:-size}"  # Net order within a priority tier: size or hilbert
+PERF_STAT="${PERF_STAT:-0}"     # Set to 1 to record LLC misses with perf stat
 
 mkdir -p "$OUTPUT_DIR/cpp" "$OUTPUT_DIR/java"
 
@@ -18,8 +20,19 @@ echo "$(date)"
 echo "==================================================================="
 echo ""
 echo "Found ${#DSN_FILES[@]} DSN files to test"
+echo "C++ connection order: $CPP_ORDER"
 echo ""
 
+CPP_PREFIX=""
+if [ "$PERF_STAT" = "1" ]; then
+  if command -v perf > /dev/null 2>&1; then
+    CPP_PREFIX="perf stat -x, -e LLC-loads,LLC-load-misses -o"
+  else
+    echo "perf not found - LLC miss counts disabled"
+    PERF_STAT=0
+  fi
+fi
+
 # Results arrays
 declare -a NAMES
 declare -a CPP_TIMES
@@ -27,6 +40,8 @@ declare -a CPP_SUCCESS
 declare -a CPP_SEGMENTS
 declare -a CPP_VIAS
 declare -a CPP_DRC
+declare -a CPP_CONN_MS
+declare -a CPP_LLC_MISSES
 declare -a JAVA_TIMES
 declare -a JAVA_SUCCESS
 declare -a JAVA_SEGMENTS
@@ -50,7 +65,12 @@ for dsn_file in "${DSN_FILES[@]}"; do
   echo "[C++] Running freerouting-cpp..."
   CPP_OUTPUT="$OUTPUT_DIR/cpp/${NAME}_routed.kicad_pcb"
   START=$(date +%s.%N)
-  timeout $TIMEOUT_SECONDS $CPP_CLI --passes 10 -o "$CPP_OUTPUT" "$dsn_file" > "$OUTPUT_DIR/cpp/${NAME}_log.txt" 2>&1
+  CPP_PERF_FILE="$OUTPUT_DIR/cpp/${NAME}_perf.csv"
+  if [ "$PERF_STAT" = "1" ]; then
+    timeout $TIMEOUT_SECONDS $CPP_PREFIX "$CPP_PERF_FILE" $CPP_CLI --passes 10 --order "$CPP_ORDER" -o "$CPP_OUTPUT" "$dsn_file" > "$OUTPUT_DIR/cpp/${NAME}_log.txt" 2>&1
+  else
+    timeout $TIMEOUT_SECONDS $CPP_CLI --passes 10 --order "$CPP_ORDER" -o "$CPP_OUTPUT" "$dsn_file" > "$OUTPUT_DIR/cpp/${NAME}_log.txt" 2>&1
+  fi
   CPP_STATUS=$?
   END=$(date +%s.%N)
   CPP_TIME=$(echo "$END - $START" | bc)
@@ -62,6 +82,8 @@ for dsn_file in "${DSN_FILES[@]}"; do
     CPP_SEGMENTS+=("0")
     CPP_VIAS+=("0")
     CPP_DRC+=("?")
+    CPP_CONN_MS+=("?")
+    CPP_LLC_MISSES+=("?")
   elif [ $CPP_STATUS -ne 0 ]; then
     echo "[C++] FAILED with exit code $CPP_STATUS"
     CPP_TIMES+=("FAILED")
@@ -69,6 +91,8 @@ for dsn_file in "${DSN_FILES[@]}"; do
     CPP_SEGMENTS+=("0")
     CPP_VIAS+=("0")
     CPP_DRC+=("?")
+    CPP_CONN_MS+=("?")
+    CPP_LLC_MISSES+=("?")
   else
     echo "[C++] Completed in ${CPP_TIME}s"
     CPP_TIMES+=("$CPP_TIME")
@@ -85,6 +109,15 @@ for dsn_file in "${DSN_FILES[@]}"; do
 
     CPP_DRC_COUNT=$(grep "Violations:" "$OUTPUT_DIR/cpp/${NAME}_log.txt" | grep -oP '\d+' | head -1 || echo "?")
     CPP_DRC+=("$CPP_DRC_COUNT")
+
+    CPP_CONN=$(grep "Per-connection time:" "$OUTPUT_DIR/cpp/${NAME}_log.txt" | grep -oP '[\d.]+(?= ms avg)' | head -1)
+    CPP_CONN_MS+=("${CPP_CONN:-?}")
+
+    CPP_LLC="?"
+    if [ "$PERF_STAT" = "1" ] && [ -f "$CPP_PERF_FILE" ]; then
+      CPP_LLC=$(grep "LLC-load-misses" "$CPP_PERF_FILE" | cut -d, -f1)
+    fi
+    CPP_LLC_MISSES+=("${CPP_LLC:-?}")
   fi
 
   # Java Test
@@ -189,6 +222,13 @@ for i in "${!NAMES[@]}"; do
     "${NAME:0:40}" "${CPP_T:0:12}" "${JAVA_T:0:12}" "$CPP_S" "$JAVA_S" "$SPEEDUP"
 done
 
+echo ""
+printf "%-40s %16s %16s\n" "Test Name (C++, order=$CPP_ORDER)" "Conn avg (ms)" "LLC misses"
+printf "%-40s %16s %16s\n" "----------------------------------------" "----------------" "----------------"
+for i in "${!NAMES[@]}"; do
+  printf "%-40s %16s %16s\n" "${NAMES[$i]:0:40}" "${CPP_CONN_MS[$i]}" "${CPP_LLC_MISSES[$i]}"
+done
+
 echo ""
 echo "==================================================================="
 echo "DETAILED RESULTS"
@@ -1,5 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include "autoroute/BatchAutorouter.h"
+#include "autoroute/RouterProfile.h"
+#include "autoroute/TiledAutorouter.h"
+#include "autoroute/RoutingWorkerPool.h"
+#include "autoroute/RoutingSession.h"
 #include "autoroute/AutorouteAttemptState.h"
 #include "autoroute/AutorouteAttemptResult.h"
 #include "autoroute/TaskState.h"
@@ -7,9 +11,15 @@
 #include "autoroute/Connection.h"
 #include "autoroute/ItemAutorouteInfo.h"
 #include "board/RoutingBoard.h"
+#include "board/Pin.h"
+#include "board/Trace.h"
+#include "board/Via.h"
 #include "board/LayerStructure.h"
+#include "geometry/CollisionDetector.h"
+#include "io/KiCadBoardConverter.h"
 #include "rules/ClearanceMatrix.h"
 #include "datastructures/Stoppable.h"
+#include <set>
 
 using namespace freerouting;
 
@@ -292,3 +302,600 @@ TEST_CASE("BatchAutorouter - Max passes limit", "[autoroute][batch][router]") {
 
   REQUIRE(router.getCurrentPass() <= config.maxPasses);
 }
+
+TEST_CASE("BatchAutorouter - Default connection order", "[autoroute][batch][router]") {
+  BatchAutorouter::Config config;
+
+  REQUIRE(config.connectionOrder == BatchAutorouter::Config::ConnectionOrder::NetSize);
+}
+
+TEST_CASE("BatchAutorouter - Hilbert order pass with no items", "[autoroute][batch][router]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+
+  BatchAutorouter::Config config;
+  config.connectionOrder = BatchAutorouter::Config::ConnectionOrder::Hilbert;
+
+  BatchAutorouter router(&board, config);
+  SimpleStoppable stoppable;
+
+  REQUIRE_FALSE(router.autoroutePass(1, &stoppable));
+
+  const auto& stats = router.getLastPassStats();
+  REQUIRE(stats.connectionsAttempted == 0);
+  REQUIRE(stats.averageConnectionTimeMs() == 0.0);
+}
+
+TEST_CASE("BatchAutorouter - Hilbert order sorts by tier, layer, then curve index", "[autoroute][batch][router]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+
+  // One short trace per item layer, stacked at a corner of a 10mm board
+  auto addNet = [&](int netNo, IntPoint corner, std::vector<int> itemLayers) {
+    std::vector<int> ids;
+    for (size_t i = 0; i < itemLayers.size(); ++i) {
+      IntPoint start(corner.x, corner.y + static_cast<int>(i) * 200);
+      int id = board.generateItemId();
+      board.addItem(std::make_unique<Trace>(start, IntPoint(start.x + 100, start.y), itemLayers[i], 100,
+                                            std::vector<int>{netNo}, 0, id, FixedState::NotFixed, &board));
+      ids.push_back(id);
+    }
+    return std::make_pair(netNo, ids);
+  };
+
+  const IntPoint lowerLeft(0, 0);
+  const IntPoint upperRight(100000, 100000);
+  const IntPoint lowerRight(100000, 0);
+
+  // The curve starts at the lower left corner, passes the upper right
+  // quadrant and ends at the lower right corner
+  std::vector<std::pair<int, std::vector<int>>> nets = {
+    addNet(6, lowerRight, {0, 0}),
+    addNet(5, lowerLeft, {0, 1, 1}),   // 3 items: second tier, mostly on B.Cu
+    addNet(4, lowerLeft, {0, 0}),
+    addNet(3, upperRight, {0, 0}),
+    addNet(2, lowerLeft, {1, 1}),
+    addNet(1, lowerRight, {0, 0, 0}),  // 3 items: second tier
+  };
+
+  BatchAutorouter::Config config;
+  config.connectionOrder = BatchAutorouter::Config::ConnectionOrder::Hilbert;
+  BatchAutorouter router(&board, config);
+  router.sortNetsForRouting(nets);
+
+  std::vector<int> order;
+  for (const auto& net : nets) {
+    order.push_back(net.first);
+  }
+  REQUIRE(order == std::vector<int>{4, 3, 6, 2, 1, 5});
+}
+
+TEST_CASE("BatchAutorouter - Removes dangling traces and vias", "[autoroute][batch][router]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  const Padstack* pad = board.getPadstack("pad", 0, 1);
+  for (IntPoint center : {IntPoint(0, 0), IntPoint(40000, 0)}) {
+    board.addItem(std::make_unique<Pin>(center, 1, pad, std::vector<int>{1}, 0,
+                                        board.generateItemId(), 0, FixedState::SystemFixed, &board));
+  }
+  auto addTrace = [&](IntPoint a, IntPoint b, int layer, FixedState fixedState) {
+    board.addItem(std::make_unique<Trace>(a, b, layer, 1250, std::vector<int>{1}, 0,
+                                          board.generateItemId(), fixedState, &board));
+  };
+
+  // The route between the pins, ending on one of them off center
+  addTrace(IntPoint(0, 0), IntPoint(20000, 0), 0, FixedState::NotFixed);
+  addTrace(IntPoint(20000, 0), IntPoint(40300, 0), 0, FixedState::NotFixed);
+  // A branch off its middle through a via to nowhere: each removal leaves
+  // the item before it dangling
+  addTrace(IntPoint(10000, 0), IntPoint(10000, 10000), 0, FixedState::NotFixed);
+  board.addItem(std::make_unique<Via>(IntPoint(10000, 10000), board.getPadstack("via", 0, 1),
+                                      std::vector<int>{1}, 0, board.generateItemId(),
+                                      FixedState::NotFixed, true, &board));
+  addTrace(IntPoint(10000, 10000), IntPoint(20000, 10000), 1, FixedState::NotFixed);
+  // Dangling, but fixed by the user
+  addTrace(IntPoint(40000, 0), IntPoint(40000, 20000), 1, FixedState::UserFixed);
+
+  BatchAutorouter router(&board);
+  SimpleStoppable stoppable;
+  router.runBatchLoop(&stoppable);
+
+  REQUIRE(router.getLastPassStats().tailsRemoved == 3);
+  REQUIRE(board.itemCount() == 5);
+  REQUIRE(board.getContactIndex().at(IntPoint(10000, 10000), 1).empty());
+  REQUIRE(board.getContactIndex().at(IntPoint(20000, 0), 0).size() == 2);
+}
+
+TEST_CASE("BatchAutorouter - Keeps a via whose traces end off center", "[autoroute][batch][router]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(std::make_unique<Pin>(IntPoint(0, 0), 1, board.getPadstack("pad", 0, 0),
+                                      std::vector<int>{1}, 0, board.generateItemId(), 0,
+                                      FixedState::SystemFixed, &board));
+  board.addItem(std::make_unique<Pin>(IntPoint(40000, 0), 1, board.getPadstack("pad", 1, 1),
+                                      std::vector<int>{1}, 0, board.generateItemId(), 0,
+                                      FixedState::SystemFixed, &board));
+
+  // Pin to via on F.Cu, via to pin on B.Cu; both thin traces end on the
+  // via's pad, further from its center than their half width
+  const IntPoint center(20000, 0);
+  board.addItem(std::make_unique<Via>(center, board.getPadstack("via", 0, 1),
+                                      std::vector<int>{1}, 0, board.generateItemId(),
+                                      FixedState::NotFixed, true, &board));
+  const IntBox viaPad = board.getItems().back()->getBoundingBox();
+  board.addItem(std::make_unique<Trace>(IntPoint(0, 0), IntPoint(viaPad.ll.x + 100, 0), 0, 100,
+                                        std::vector<int>{1}, 0, board.generateItemId(),
+                                        FixedState::NotFixed, &board));
+  board.addItem(std::make_unique<Trace>(IntPoint(center.x, viaPad.ur.y - 100), IntPoint(40000, 0), 1, 100,
+                                        std::vector<int>{1}, 0, board.generateItemId(),
+                                        FixedState::NotFixed, &board));
+
+  BatchAutorouter router(&board);
+  SimpleStoppable stoppable;
+  router.runBatchLoop(&stoppable);
+
+  REQUIRE(router.getLastPassStats().tailsRemoved == 0);
+  REQUIRE(board.itemCount() == 5);
+}
+
+TEST_CASE("TiledAutorouter - Routes inside tiles, then between them", "[autoroute][batch][tiled]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  Nets nets;
+  nets.addNet(Net("A", 1, 1, nullptr));
+  nets.addNet(Net("B", 1, 2, nullptr));
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.setNets(&nets);
+  const Padstack* pad = board.getPadstack("pad", 0, 1);
+  auto addPin = [&](IntPoint center, int netNo) {
+    auto pin = std::make_unique<Pin>(center, 1, pad, std::vector<int>{netNo}, 0,
+                                     board.generateItemId(), 0, FixedState::SystemFixed, &board);
+    Item* item = pin.get();
+    board.addItem(std::move(pin));
+    return item;
+  };
+
+  // Net A within the first 10mm tile, net B across three tiles
+  Item* a1 = addPin(IntPoint(20000, 20000), 1);
+  Item* a2 = addPin(IntPoint(60000, 20000), 1);
+  Item* b1 = addPin(IntPoint(20000, 60000), 2);
+  Item* b2 = addPin(IntPoint(250000, 60000), 2);
+  board.addIncompleteConnection(IncompleteConnection(a1, a2, 1));
+  board.addIncompleteConnection(IncompleteConnection(b1, b2, 2));
+
+  TiledAutorouter::Config config;
+  config.tileSize = 100000;
+  config.halo = 10000;
+  config.threads = 2;
+  config.routing.maxPasses = 2;
+
+  TiledAutorouter router(&board, config);
+  SimpleStoppable stoppable;
+  router.run(&stoppable);
+  const auto& stats = router.getStatistics();
+
+  REQUIRE(stats.tiles == 1);
+  REQUIRE(stats.tileConnections == 1);
+  REQUIRE(stats.tileConnectionsRouted + stats.stitchConnections == 2);
+  REQUIRE(stats.maxTileItems < board.itemCount());
+
+  // Net A's copper came back from the tile board and stays in its window
+  int netACopper = 0;
+  for (const auto& item : board.getItems()) {
+    if (item->isRoutable() && item->containsNet(1)) {
+      ++netACopper;
+      REQUIRE(IntBox(-10000, -10000, 110000, 110000).contains(item->getBoundingBox()));
+    }
+  }
+  REQUIRE(netACopper > 0);
+  REQUIRE(board.getIncompleteConnections()[0].isRouted());
+}
+
+TEST_CASE("TiledAutorouter - Removes copper a tile ripped up", "[autoroute][batch][tiled]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  Nets nets;
+  nets.addNet(Net("A", 1, 1, nullptr));
+  nets.addNet(Net("B", 1, 2, nullptr));
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.setNets(&nets);
+  const Padstack* pad = board.getPadstack("pad", 0, 0);
+  auto addPin = [&](IntPoint center, int netNo) {
+    auto pin = std::make_unique<Pin>(center, 1, pad, std::vector<int>{netNo}, 0,
+                                     board.generateItemId(), 0, FixedState::SystemFixed, &board);
+    Item* item = pin.get();
+    board.addItem(std::move(pin));
+    return item;
+  };
+
+  // Net A's pins on either side of a routed net B trace that runs far past
+  // the tile window, on a single layer: the tile can only route A by
+  // ripping up its copy of the trace
+  Item* a1 = addPin(IntPoint(20000, 50000), 1);
+  Item* a2 = addPin(IntPoint(80000, 50000), 1);
+  addPin(IntPoint(50000, -200000), 2);
+  addPin(IntPoint(50000, 300000), 2);
+  const int wallId = board.generateItemId();
+  board.addItem(std::make_unique<Trace>(IntPoint(50000, -200000), IntPoint(50000, 300000), 0, 1250,
+                                        std::vector<int>{2}, 0, wallId, FixedState::NotFixed, &board));
+  board.addIncompleteConnection(IncompleteConnection(a1, a2, 1));
+
+  TiledAutorouter::Config config;
+  config.tileSize = 100000;
+  config.halo = 10000;
+  config.threads = 1;
+  config.routing.maxPasses = 2;
+
+  TiledAutorouter router(&board, config);
+  SimpleStoppable stoppable;
+  router.run(&stoppable);
+  const auto& stats = router.getStatistics();
+
+  REQUIRE(stats.tileConnectionsRouted == 1);
+  REQUIRE(stats.rippedItems == 1);
+  REQUIRE(board.getItem(wallId) == nullptr);
+  // Net B is open again and goes to stitching
+  REQUIRE(stats.stitchConnections == 1);
+
+  // Whatever stitching did, no net B trace crosses net A's
+  for (const auto& item : board.getItems()) {
+    const auto* a = dynamic_cast<const Trace*>(item.get());
+    if (!a || !a->containsNet(1)) continue;
+    for (const auto& other : board.getItems()) {
+      const auto* b = dynamic_cast<const Trace*>(other.get());
+      if (!b || !b->containsNet(2)) continue;
+      CAPTURE(a->getId(), b->getId());
+      REQUIRE(CollisionDetector::segmentDistance(a->getStart(), a->getEnd(), b->getStart(), b->getEnd()) >=
+              a->getHalfWidth() + b->getHalfWidth());
+    }
+  }
+}
+
+TEST_CASE("TiledAutorouter - Keeps item IDs unique on a converted board", "[autoroute][batch][tiled]") {
+  KiCadPcb pcb;
+  pcb.layers.addLayer(Layer("F.Cu", true));
+  pcb.layers.addLayer(Layer("B.Cu", true));
+  pcb.nets.addNet(Net("A", 1, 1, nullptr));
+  pcb.nets.addNet(Net("B", 1, 2, nullptr));
+
+  // One two-pad net in each of two neighbouring 10mm tiles, so the second
+  // wave routes with the first wave's copper on the board
+  for (int netNo = 1; netNo <= 2; ++netNo) {
+    KiCadFootprint footprint{};
+    footprint.x = 2.0 + (netNo - 1) * 11.0;
+    footprint.y = 5.0;
+    for (int p = 0; p < 2; ++p) {
+      KiCadPad pad{};
+      pad.x = p * 4.0;
+      pad.sizeX = 1.0;
+      pad.sizeY = 1.0;
+      pad.netNumber = netNo;
+      footprint.pads.push_back(pad);
+    }
+    pcb.footprints.push_back(footprint);
+  }
+
+  auto [board, clearance] = KiCadBoardConverter::createRoutingBoard(pcb);
+  board->setNets(&pcb.nets);
+  board->updateIncompleteConnections();
+  REQUIRE(board->incompleteConnectionCount() == 2);
+
+  TiledAutorouter::Config config;
+  config.tileSize = 100000;
+  config.halo = 10000;
+  config.threads = 1;
+  config.routing.maxPasses = 2;
+
+  TiledAutorouter router(board.get(), config);
+  SimpleStoppable stoppable;
+  router.run(&stoppable);
+
+  REQUIRE(router.getStatistics().tiles == 2);
+  REQUIRE(router.getStatistics().tileConnectionsRouted == 2);
+
+  // Merged copper took new IDs and every pad is still there
+  std::set<int> ids;
+  int pins = 0;
+  for (const auto& item : board->getItems()) {
+    CAPTURE(item->getId());
+    REQUIRE(ids.insert(item->getId()).second);
+    if (dynamic_cast<const Pin*>(item.get())) {
+      ++pins;
+    }
+  }
+  REQUIRE(pins == 4);
+  REQUIRE(board->incompleteConnectionCount() == 0);
+}
+
+TEST_CASE("TileJob - Binary round trip", "[autoroute][batch][tiled]") {
+  TileJob job;
+  job.jobId = 7;
+  job.window = IntBox(-100, -200, 300000, 400000);
+  job.keepMargin = 2000;
+  job.lastItemId = 42;
+  job.timeLimitMs = 1500;
+
+  TileJob::ItemRecord pin;
+  pin.kind = TileJob::ItemKind::Pin;
+  pin.id = 3;
+  pin.a = IntPoint(10, -20);
+  pin.padstackName = "pad";
+  pin.fromLayer = 0;
+  pin.toLayer = 1;
+  pin.pinNumber = 2;
+  pin.componentNumber = 5;
+  pin.nets = {1, 4};
+  pin.fixedState = static_cast<u8>(FixedState::SystemFixed);
+  job.items.push_back(pin);
+
+  TileJob::ItemRecord trace;
+  trace.kind = TileJob::ItemKind::Trace;
+  trace.id = 9;
+  trace.a = IntPoint(0, 0);
+  trace.b = IntPoint(5000, 0);
+  trace.layer = 1;
+  trace.halfWidth = 1250;
+  trace.nets = {4};
+  job.items.push_back(trace);
+  job.connections.push_back({3, 9, 4});
+
+  auto decoded = TileJob::decode(job.encode());
+  REQUIRE(decoded.has_value());
+  REQUIRE(decoded->jobId == 7);
+  REQUIRE(decoded->window == job.window);
+  REQUIRE(decoded->lastItemId == 42);
+  REQUIRE(decoded->timeLimitMs == 1500);
+  REQUIRE(decoded->items.size() == 2);
+  REQUIRE(decoded->items[0].padstackName == "pad");
+  REQUIRE(decoded->items[0].nets == std::vector<i32>{1, 4});
+  REQUIRE(decoded->items[0].componentNumber == 5);
+  REQUIRE(decoded->items[1].kind == TileJob::ItemKind::Trace);
+  REQUIRE(decoded->items[1].b == IntPoint(5000, 0));
+  REQUIRE(decoded->items[1].halfWidth == 1250);
+  REQUIRE(decoded->connections.size() == 1);
+  REQUIRE(decoded->connections[0].netNo == 4);
+
+  TileOutcome outcome;
+  outcome.jobId = 7;
+  outcome.traces.push_back({IntPoint(1, 2), IntPoint(3, 4), 0, 1250, {4}, 0});
+  outcome.vias.push_back({IntPoint(3, 4), "via", 0, 1, {4}, 0, true});
+  outcome.routedConnections = {0};
+  outcome.removedItemIds = {11, 12};
+  outcome.boardItems = 17;
+
+  auto decodedOutcome = TileOutcome::decode(outcome.encode());
+  REQUIRE(decodedOutcome.has_value());
+  REQUIRE(decodedOutcome->traces.size() == 1);
+  REQUIRE(decodedOutcome->traces[0].end == IntPoint(3, 4));
+  REQUIRE(decodedOutcome->vias[0].padstackName == "via");
+  REQUIRE(decodedOutcome->vias[0].attachAllowed);
+  REQUIRE(decodedOutcome->removedItemIds == std::vector<i32>{11, 12});
+  REQUIRE(decodedOutcome->boardItems == 17);
+
+  // Truncated or foreign data is rejected
+  auto data = job.encode();
+  data.resize(data.size() - 3);
+  REQUIRE_FALSE(TileJob::decode(data).has_value());
+  REQUIRE_FALSE(TileJob::decode(outcome.encode()).has_value());
+}
+
+TEST_CASE("RoutingWorkerPool - Routes jobs in worker processes", "[autoroute][batch][tiled]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  Nets nets;
+  nets.addNet(Net("A", 1, 1, nullptr));
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.setNets(&nets);
+
+  TileJob job;
+  job.window = IntBox(0, 0, 100000, 100000);
+  job.lastItemId = 2;
+  for (int i = 0; i < 2; ++i) {
+    TileJob::ItemRecord pin;
+    pin.id = i + 1;
+    pin.a = IntPoint(20000 + 40000 * i, 50000);
+    pin.padstackName = "pad";
+    pin.toLayer = 1;
+    pin.nets = {1};
+    pin.fixedState = static_cast<u8>(FixedState::SystemFixed);
+    job.items.push_back(pin);
+  }
+  job.connections.push_back({1, 2, 1});
+
+  BatchAutorouter::Config routing;
+  routing.maxPasses = 2;
+  TileOutcome local = job.route(board, routing, nullptr);
+
+  std::vector<TileJob> jobs;
+  for (u32 id = 1; id <= 3; ++id) {
+    jobs.push_back(job);
+    jobs.back().jobId = id;
+  }
+
+  RoutingWorkerPool pool(&board, routing);
+  REQUIRE(pool.start(2) == 2);
+  auto outcomes = pool.run(jobs, nullptr);
+  REQUIRE(pool.getBytesSent() > 0);
+  pool.stop();
+  REQUIRE(pool.size() == 0);
+
+  REQUIRE(outcomes.size() == 3);
+  for (u32 i = 0; i < 3; ++i) {
+    REQUIRE(outcomes[i].jobId == i + 1);
+    REQUIRE(outcomes[i].routedConnections == local.routedConnections);
+    REQUIRE(outcomes[i].traces.size() == local.traces.size());
+    REQUIRE(outcomes[i].vias.size() == local.vias.size());
+  }
+
+  // A job whose time is up comes back without routes
+  TileJob late = job;
+  late.timeLimitMs = 0;
+  REQUIRE(pool.start(1) == 1);
+  auto lateOutcomes = pool.run({late}, nullptr);
+  pool.stop();
+  REQUIRE(lateOutcomes.size() == 1);
+  REQUIRE(lateOutcomes[0].routedConnections.empty());
+
+  // Once stop is requested, no more jobs are sent
+  SimpleStoppable stoppable;
+  stoppable.requestStop();
+  REQUIRE(pool.start(1) == 1);
+  auto stoppedOutcomes = pool.run(jobs, &stoppable);
+  pool.stop();
+  REQUIRE(stoppedOutcomes.size() == 3);
+  REQUIRE(stoppedOutcomes[0].routedConnections.empty());
+}
+
+TEST_CASE("RouterProfile - Parse and format", "[autoroute][batch][profile]") {
+  SECTION("Round trip") {
+    BatchAutorouter::Config config;
+    config.maxPasses = 7;
+    config.startRipupCosts = 150;
+    config.viaCost = 60.0;
+    config.traceCostAgainst = 2.5;
+    config.maxIterationsBase = 40000;
+    config.maxIterationsPerConnection = 1200;
+    config.connectionOrder = BatchAutorouter::Config::ConnectionOrder::Hilbert;
+
+    std::string text = RouterProfile::format(config, "tuned\nsecond line");
+    REQUIRE(text.starts_with("# tuned\n# second line\n"));
+
+    BatchAutorouter::Config loaded;
+    std::string error;
+    REQUIRE(RouterProfile::parse(text, loaded, error));
+    REQUIRE(loaded.maxPasses == 7);
+    REQUIRE(loaded.startRipupCosts == 150);
+    REQUIRE(loaded.viaCost == 60.0);
+    REQUIRE(loaded.traceCostPreferred == 1.0);
+    REQUIRE(loaded.traceCostAgainst == 2.5);
+    REQUIRE(loaded.maxIterationsBase == 40000);
+    REQUIRE(loaded.maxIterationsPerConnection == 1200);
+    REQUIRE(loaded.connectionOrder == BatchAutorouter::Config::ConnectionOrder::Hilbert);
+  }
+
+  SECTION("Partial profile keeps other values") {
+    BatchAutorouter::Config config;
+    std::string error;
+    REQUIRE(RouterProfile::parse("  via_cost = 40   # cheaper vias\n\n", config, error));
+    REQUIRE(config.viaCost == 40.0);
+    REQUIRE(config.startRipupCosts == BatchAutorouter::Config().startRipupCosts);
+  }
+
+  SECTION("Errors leave the config unchanged") {
+    BatchAutorouter::Config config;
+    std::string error;
+    REQUIRE_FALSE(RouterProfile::parse("via_cost = 40\nmax_passes = -1\n", config, error));
+    REQUIRE(error.find("line 2") != std::string::npos);
+    REQUIRE(config.viaCost == BatchAutorouter::Config().viaCost);
+
+    REQUIRE_FALSE(RouterProfile::parse("no_such_key = 1\n", config, error));
+    REQUIRE(error.find("no_such_key") != std::string::npos);
+
+    REQUIRE_FALSE(RouterProfile::parse("connection_order = random\n", config, error));
+    REQUIRE_FALSE(RouterProfile::parse("via_cost 40\n", config, error));
+  }
+}
+
+TEST_CASE("RoutingSession - Routes one connection and takes edits", "[autoroute][session]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  Nets nets;
+  nets.addNet(Net("A", 1, 1, nullptr));
+  nets.addNet(Net("B", 1, 2, nullptr));
+
+  // Items numbered by hand, as the KiCad converter does
+  auto board = std::make_unique<RoutingBoard>(layers, clearanceMatrix);
+  board->setNets(&nets);
+  const Padstack* pad = board->getPadstack("pad", 0, 1);
+  auto addPin = [&](IntPoint center, int netNo, int itemId) {
+    board->addItem(std::make_unique<Pin>(center, 1, pad, std::vector<int>{netNo}, 0,
+                                         itemId, 0, FixedState::SystemFixed, board.get()));
+  };
+  addPin(IntPoint(20000, 20000), 1, 10);
+  addPin(IntPoint(60000, 20000), 1, 11);
+  addPin(IntPoint(20000, 300000), 2, 12);  // Far outside the window
+  addPin(IntPoint(60000, 300000), 2, 13);
+
+  RoutingSession session(std::move(board));
+  REQUIRE(session.getIncompleteConnections().size() == 2);
+
+  RoutingSession::Result result = session.routeConnection(10, 11);
+  REQUIRE(result.status == RoutingSession::Status::Routed);
+  REQUIRE_FALSE(result.newItemIds.empty());
+  REQUIRE(result.conflicts == 0);
+  REQUIRE(result.windowItems < 4);
+  for (int itemId : result.newItemIds) {
+    REQUIRE(itemId > 13);
+    REQUIRE(session.getBoard().getItem(itemId)->containsNet(1));
+  }
+
+  SECTION("Undo") {
+    session.removeRoute(result);
+    REQUIRE(session.getBoard().itemCount() == 4);
+  }
+
+  SECTION("Edits") {
+    REQUIRE(session.moveItem(12, IntVector(0, -5000)));
+    const auto* moved = dynamic_cast<const Pin*>(session.getBoard().getItem(12));
+    REQUIRE(moved != nullptr);
+    REQUIRE(moved->getCenter() == IntPoint(20000, 295000));
+    REQUIRE(session.getBoard().getShapeTree().queryRegion(IntBox::fromPoint(IntPoint(20000, 295000))).size() == 1);
+
+    REQUIRE(session.removeItem(13));
+    REQUIRE_FALSE(session.removeItem(13));
+    for (const auto& connection : session.getIncompleteConnections()) {
+      REQUIRE(connection.getNetNumber() != 2);
+    }
+  }
+
+  SECTION("Invalid items") {
+    REQUIRE(session.routeConnection(10, 12).status == RoutingSession::Status::InvalidItems);
+    REQUIRE(session.routeConnection(10, 99).status == RoutingSession::Status::InvalidItems);
+  }
+}
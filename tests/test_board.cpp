@@ -355,6 +355,43 @@ TEST_CASE("BasicBoard item management", "[board][basicboard]") {
     REQUIRE(net2Items.size() == 1);
   }
 
+  SECTION("Drill items share board-owned padstacks") {
+    BasicBoard board(layers, clearance);
+
+    const Padstack* via01 = board.getPadstack("via", 0, 1);
+    REQUIRE(via01->fromLayer() == 0);
+    REQUIRE(via01->toLayer() == 1);
+    REQUIRE(board.getPadstack("via", 0, 1) == via01);
+    REQUIRE(board.getPadstack("via", 1, 1) != via01);
+    REQUIRE(board.getPadstack("pad", 0, 1) != via01);
+
+    std::vector<int> nets = {1};
+    auto first = std::make_unique<Via>(IntPoint(0, 0), via01, nets, 1, board.generateItemId(),
+                                       FixedState::NotFixed, true, &board);
+    auto second = std::make_unique<Via>(IntPoint(500, 0), board.getPadstack("via", 0, 1), nets, 1,
+                                        board.generateItemId(), FixedState::NotFixed, true, &board);
+    REQUIRE(first->getPadstack() == second->getPadstack());
+  }
+
+  SECTION("Removed items free their pool slot for reuse") {
+    BasicBoard board(layers, clearance);
+    std::vector<int> nets = {1};
+
+    auto trace = std::make_unique<Trace>(IntPoint(0, 0), IntPoint(100, 100), 0, 125, nets, 1,
+                                         board.generateItemId(), FixedState::NotFixed, &board);
+    const Item* slot = trace.get();
+    int traceId = trace->getId();
+    board.addItem(std::move(trace));
+    size_t live = SlabPool<Trace>::liveCount();
+
+    board.removeItem(traceId);
+    REQUIRE(SlabPool<Trace>::liveCount() == live - 1);
+
+    auto reused = std::make_unique<Trace>(IntPoint(0, 0), IntPoint(200, 0), 1, 125, nets, 1,
+                                          board.generateItemId(), FixedState::NotFixed, &board);
+    REQUIRE(reused.get() == slot);
+  }
+
   SECTION("Get items by layer") {
     BasicBoard board(layers, clearance);
 
@@ -5,9 +5,11 @@
 #include "autoroute/CompleteFreeSpaceExpansionRoom.h"
 #include "autoroute/IncompleteFreeSpaceExpansionRoom.h"
 #include "autoroute/TargetItemExpansionDoor.h"
+#include "autoroute/ShapeSearchTree.h"
 #include "geometry/IntBox.h"
 #include "geometry/Circle.h"
 #include "board/Trace.h"
+#include "board/Via.h"
 #include "board/BasicBoard.h"
 #include "board/LayerStructure.h"
 #include "rules/ClearanceMatrix.h"
@@ -287,3 +289,75 @@ TEST_CASE("TargetItemExpansionDoor - Reset", "[expansion][target]") {
   // Verify reset
   REQUIRE_FALSE(door.getMazeSearchElement(0).isOccupied);
 }
+
+// ============================================================================
+// ShapeSearchTree Tests
+// ============================================================================
+
+TEST_CASE("ShapeSearchTree - Multi-layer items have an entry per layer", "[expansion][tree]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("In1.Cu", true));
+  layers.addLayer(Layer("In2.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+  BasicBoard board(layers, clearanceMatrix);
+
+  Via via(IntPoint(0, 0), board.getPadstack("via", 0, 3), std::vector<int>{1}, 0, 1,
+          FixedState::NotFixed, true, &board);
+  Via blindVia(IntPoint(5000, 0), board.getPadstack("blind", 1, 2), std::vector<int>{1}, 0, 2,
+               FixedState::NotFixed, true, &board);
+  Trace trace(IntPoint(-5000, 0), IntPoint(10000, 0), 3, 100,
+              std::vector<int>{2}, 0, 3, FixedState::NotFixed, &board);
+
+  REQUIRE(via.treeShapeCount() == 4);
+  REQUIRE(via.getShapeLayer(3) == 3);
+  REQUIRE(via.getTreeShape(0) == via.getTreeShape(3));
+  REQUIRE(trace.treeShapeCount() == 1);
+  REQUIRE(trace.getShapeLayer(0) == 3);
+
+  ShapeSearchTree tree;
+  tree.insert(&via);
+  tree.insert(&blindVia);
+  tree.insert(&trace);
+  REQUIRE(tree.size() == 3);
+  REQUIRE(tree.entryCount() == 7);
+
+  IntBox everywhere(-20000, -20000, 20000, 20000);
+  auto onLayer = [&](int layer) {
+    std::vector<TreeEntry> entries;
+    tree.overlappingEntries(everywhere, layer, entries);
+    std::vector<SearchTreeObject*> objects;
+    for (const TreeEntry& entry : entries) {
+      REQUIRE(entry.object->getShapeLayer(entry.shapeIndex) == layer);
+      objects.push_back(entry.object);
+    }
+    return objects;
+  };
+
+  REQUIRE(onLayer(0) == std::vector<SearchTreeObject*>{&via});
+  REQUIRE(onLayer(1).size() == 2);
+  REQUIRE(onLayer(2).size() == 2);
+  REQUIRE(onLayer(3).size() == 2);
+
+  // Boxes still prune on each layer
+  std::vector<TreeEntry> entries;
+  tree.overlappingEntries(IntBox(4000, -1000, 6000, 1000), 0, entries);
+  REQUIRE(entries.empty());
+  tree.overlappingEntries(IntBox(4000, -1000, 6000, 1000), 1, entries);
+  REQUIRE(entries.size() == 1);
+  REQUIRE(entries[0].object == &blindVia);
+
+  // A bulk-built tree answers the same
+  ShapeSearchTree bulkTree;
+  bulkTree.insertAll({&trace, &blindVia, &via});
+  REQUIRE(bulkTree.size() == 3);
+  REQUIRE(bulkTree.entryCount() == 7);
+  for (int layer = 0; layer < 4; ++layer) {
+    std::vector<TreeEntry> bulkEntries;
+    bulkTree.overlappingEntries(everywhere, layer, bulkEntries);
+    REQUIRE(bulkEntries.size() == onLayer(layer).size());
+  }
+}
@@ -4,6 +4,10 @@
 #include "geometry/IntBox.h"
 #include "geometry/IntOctagon.h"
 #include "geometry/Side.h"
+#include "geometry/HilbertCurve.h"
+#include "geometry/MortonCode.h"
+#include <cstdlib>
+#include <vector>
 
 using namespace freerouting;
 using Catch::Approx;
@@ -389,3 +393,80 @@ TEST_CASE("IntOctagon operations", "[geometry][intoctagon]") {
     REQUIRE(translated.topY == 65);
   }
 }
+
+TEST_CASE("HilbertCurve index", "[geometry][hilbert]") {
+  SECTION("Order 1 visits quadrants in U shape") {
+    REQUIRE(HilbertCurve::index(0, 0, 1) == 0);
+    REQUIRE(HilbertCurve::index(0, 1, 1) == 1);
+    REQUIRE(HilbertCurve::index(1, 1, 1) == 2);
+    REQUIRE(HilbertCurve::index(1, 0, 1) == 3);
+  }
+
+  SECTION("Consecutive indices are neighbouring cells") {
+    constexpr int order = 4;
+    constexpr u32 n = 1u << order;
+    std::vector<std::pair<u32, u32>> cells(n * n);
+    std::vector<bool> seen(n * n, false);
+
+    for (u32 x = 0; x < n; ++x) {
+      for (u32 y = 0; y < n; ++y) {
+        u64 d = HilbertCurve::index(x, y, order);
+        REQUIRE(d < n * n);
+        REQUIRE_FALSE(seen[d]);
+        seen[d] = true;
+        cells[d] = {x, y};
+      }
+    }
+
+    for (size_t d = 1; d < cells.size(); ++d) {
+      int dx = std::abs(static_cast<int>(cells[d].first) - static_cast<int>(cells[d - 1].first));
+      int dy = std::abs(static_cast<int>(cells[d].second) - static_cast<int>(cells[d - 1].second));
+      REQUIRE(dx + dy == 1);
+    }
+  }
+
+  SECTION("Board points scale onto the curve") {
+    IntBox bounds(-1000, -1000, 1000, 1000);
+
+    REQUIRE(HilbertCurve::indexInBox(IntPoint(-1000, -1000), bounds) == 0);
+    // Points outside the bounds are clamped to the edge
+    REQUIRE(HilbertCurve::indexInBox(IntPoint(-5000, -5000), bounds) == 0);
+    REQUIRE(HilbertCurve::indexInBox(IntPoint(0, 0), IntBox::empty()) == 0);
+
+    // Nearby points get nearby indices compared to the far corner
+    u64 a = HilbertCurve::indexInBox(IntPoint(-990, -990), bounds);
+    u64 b = HilbertCurve::indexInBox(IntPoint(-980, -990), bounds);
+    u64 far = HilbertCurve::indexInBox(IntPoint(990, -990), bounds);
+    REQUIRE((a > b ? a - b : b - a) < (a > far ? a - far : far - a));
+  }
+}
+
+TEST_CASE("MortonCode index", "[geometry][morton]") {
+  SECTION("Bits of x and y interleave") {
+    REQUIRE(MortonCode::index(0, 0) == 0);
+    REQUIRE(MortonCode::index(1, 0) == 1);
+    REQUIRE(MortonCode::index(0, 1) == 2);
+    REQUIRE(MortonCode::index(3, 3) == 15);
+    REQUIRE(MortonCode::index(0xffffffffu, 0) == 0x5555555555555555ULL);
+    REQUIRE(MortonCode::index(0xffffffffu, 0xffffffffu) == ~0ULL);
+  }
+
+  SECTION("Aligned blocks are contiguous runs") {
+    // The 4x4 block at (4, 8) holds codes [base, base + 16)
+    u64 base = MortonCode::index(4, 8);
+    for (u32 x = 4; x < 8; ++x) {
+      for (u32 y = 8; y < 12; ++y) {
+        u64 d = MortonCode::index(x, y);
+        REQUIRE(d >= base);
+        REQUIRE(d < base + 16);
+      }
+    }
+  }
+
+  SECTION("Board points are relative to the bounds") {
+    IntBox bounds(-1000, -1000, 1000, 1000);
+    REQUIRE(MortonCode::indexInBox(IntPoint(-1000, -1000), bounds) == 0);
+    REQUIRE(MortonCode::indexInBox(IntPoint(-5000, -999), bounds) == 2);
+    REQUIRE(MortonCode::indexInBox(IntPoint(-998, -1000), bounds) == 4);
+  }
+}
@@ -1,9 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_range.hpp>
 #include "io/SExprLexer.h"
 #include "io/SExprParser.h"
 #include "io/KiCadPcb.h"
 #include "io/KiCadPcbReader.h"
 #include "io/KiCadPcbWriter.h"
+#include "io/KiCadBoardConverter.h"
 
 using namespace freerouting;
 
@@ -87,6 +89,38 @@ TEST_CASE("SExprLexer tokenization", "[io][sexpr][lexer]") {
     REQUIRE(t1.type == SExprTokenType::String);
     REQUIRE(t1.value == "line1\nline2\ttab");
   }
+
+  SECTION("Tokens across 64-byte blocks") {
+    // Padding moves each token across every offset of a block boundary
+    size_t pad = GENERATE(range(size_t{50}, size_t{70}));
+    CAPTURE(pad);
+    std::string input = std::string(pad, ' ') + "(atom_" + std::string(pad, 'x') +
+                        " \"q\\\"" + std::string(pad, 's') + "\" -1.5e3\n\t# note\n)";
+    SExprLexer lexer(input);
+
+    auto t1 = lexer.nextToken();
+    REQUIRE(t1.type == SExprTokenType::LeftParen);
+    REQUIRE(t1.offset == pad);
+
+    auto t2 = lexer.nextToken();
+    REQUIRE(t2.type == SExprTokenType::Symbol);
+    REQUIRE(t2.value == "atom_" + std::string(pad, 'x'));
+
+    auto t3 = lexer.nextToken();
+    REQUIRE(t3.type == SExprTokenType::String);
+    REQUIRE(t3.value == "q\"" + std::string(pad, 's'));
+
+    auto t4 = lexer.nextToken();
+    REQUIRE(t4.type == SExprTokenType::Number);
+    REQUIRE(t4.value == "-1.5e3");
+
+    auto t5 = lexer.nextToken();
+    REQUIRE(t5.type == SExprTokenType::RightParen);
+    REQUIRE(lexer.location(t5.offset).line == 3);
+    REQUIRE(lexer.location(t5.offset).column == 1);
+
+    REQUIRE(lexer.nextToken().type == SExprTokenType::EndOfFile);
+  }
 }
 
 TEST_CASE("SExprParser parsing", "[io][sexpr][parser]") {
@@ -149,6 +183,26 @@ TEST_CASE("SExprParser parsing", "[io][sexpr][parser]") {
     REQUIRE(nodes[1]->isListWithKeyword("second"));
     REQUIRE(nodes[2]->isListWithKeyword("third"));
   }
+
+  SECTION("Skip filter") {
+    SExprLexer lexer("(root (keep 1) (drop (a \")(\") # )\n b) (head \"x\" 2 (c (d)) e) (keep 3))");
+    SExprParser parser(lexer, [](std::string_view kw, int depth) {
+      if (kw == "drop") return SExprSkip::Whole;
+      if (kw == "head" && depth == 1) return SExprSkip::HeadOnly;
+      return SExprSkip::None;
+    });
+
+    auto node = parser.parse();
+    REQUIRE(node != nullptr);
+    REQUIRE(node->childCount() == 4);
+    REQUIRE(node->getChild(1)->isListWithKeyword("keep"));
+    REQUIRE(node->getChild(2)->isListWithKeyword("head"));
+    REQUIRE(node->getChild(2)->childCount() == 3);
+    REQUIRE(node->getChild(2)->getChild(1)->asString() == "x");
+    REQUIRE(node->getChild(3)->isListWithKeyword("keep"));
+    REQUIRE(node->getChild(3)->getChild(1)->asInt() == 3);
+    REQUIRE(lexer.getLine() == 2);
+  }
 }
 
 TEST_CASE("KiCadPcb structure", "[io][kicad]") {
@@ -496,3 +550,110 @@ TEST_CASE("KiCad PCB board items round-trip", "[io][kicad][boarditems][roundtrip
   REQUIRE(pcbRead->segments.size() == 1);
   REQUIRE(pcbRead->vias.size() == 1);
 }
+
+TEST_CASE("KiCad PCB routing-only load profile", "[io][kicad][reader]") {
+  std::string pcbContent = R"(
+(kicad_pcb (version 20221018) (generator pcbnew)
+  (general (thickness 1.6))
+  (paper "A4")
+  (layers
+    (0 "F.Cu" signal)
+    (31 "B.Cu" signal))
+  (title_block (title "Skip (me) too"))
+  (net 0 "")
+  (net 1 "GND")
+  (gr_line (start 0 0) (end 100 0) (layer "Edge.Cuts") (width 0.1))
+  (footprint "Resistor_SMD:R_0805" (at 50.0 50.0) (layer "F.Cu")
+    (fp_text reference "R1" (at 0 0) (layer "F.SilkS") (effects (font (size 1 1))))
+    (fp_text value "10K" (at 0 0) (layer "F.Fab"))
+    (fp_line (start -1 -1) (end 1 -1) (layer "F.SilkS") (width 0.12))
+    (pad "1" smd rect (at -1 0) (size 1 1.2) (layers "F.Cu") (net 1 "GND"))
+    (model "${KICAD6_3DMODEL_DIR}/R_0805.wrl" (at (xyz 0 0 0))))
+  (segment (start 10 10) (end 20 10) (width 0.25) (layer "B.Cu") (net 1))
+)
+  )";
+
+  auto full = KiCadPcbReader::readFromString(pcbContent);
+  auto routing = KiCadPcbReader::readFromString(pcbContent, KiCadLoadProfile::RoutingOnly);
+  REQUIRE(full.has_value());
+  REQUIRE(routing.has_value());
+  REQUIRE(routing->isValid());
+
+  REQUIRE(routing->layers.count() == full->layers.count());
+  REQUIRE(routing->nets.count() == full->nets.count());
+  REQUIRE(routing->segments.size() == 1);
+  REQUIRE(routing->segments[0].layer == 1);
+  REQUIRE(routing->footprints.size() == 1);
+
+  const auto& fp = routing->footprints[0];
+  REQUIRE(fp.reference == "R1");
+  REQUIRE(fp.value == "10K");
+  REQUIRE(fp.pads.size() == 1);
+  REQUIRE(fp.pads[0].netNumber == 1);
+  REQUIRE(fp.pads[0].sizeY == 1.2);
+
+  // Graphics only in the full profile
+  REQUIRE(full->footprints[0].fpLines.size() == 1);
+  REQUIRE(fp.fpLines.empty());
+}
+
+TEST_CASE("KiCad board conversion numbers items in file order", "[io][kicad][converter]") {
+  auto pcb = std::make_shared<KiCadPcb>();
+  pcb->layers.addLayer(Layer("F.Cu", true));
+  pcb->layers.addLayer(Layer("B.Cu", true));
+  pcb->nets.addNet(Net("GND", 1, 1, nullptr));
+
+  // Enough segments to convert in parallel chunks
+  for (int i = 0; i < 5000; ++i) {
+    KiCadSegment segment{};
+    segment.startX = i * 0.5;
+    segment.endX = i * 0.5 + 0.5;
+    segment.width = 0.25;
+    segment.layer = i % 2;
+    segment.netNumber = 1;
+    pcb->segments.push_back(segment);
+  }
+  KiCadVia via{};
+  via.x = 1.0;
+  via.layersTo = 1;
+  via.netNumber = 1;
+  pcb->vias.push_back(via);
+  for (int i = 0; i < 3; ++i) {
+    KiCadFootprint footprint{};
+    footprint.x = 10.0 * i;
+    footprint.y = 20.0;
+    for (int p = 0; p < 2; ++p) {
+      KiCadPad pad{};
+      pad.x = p * 2.0;
+      pad.netNumber = 1;
+      footprint.pads.push_back(pad);
+    }
+    pcb->footprints.push_back(footprint);
+  }
+
+  auto [board, clearance] = KiCadBoardConverter::createRoutingBoard(std::shared_ptr<const KiCadPcb>(pcb));
+  const auto& items = board->getItems();
+  REQUIRE(items.size() == 5000 + 1 + 6);
+  bool numbered = true;
+  for (size_t i = 0; i < items.size(); ++i) {
+    numbered = numbered && items[i]->getId() == static_cast<int>(i + 1);
+  }
+  REQUIRE(numbered);
+  REQUIRE(dynamic_cast<const Trace*>(items[4999].get()) != nullptr);
+  REQUIRE(dynamic_cast<const Via*>(items[5000].get()) != nullptr);
+
+  // Routed copper is numbered after them
+  REQUIRE(board->generateItemId() == static_cast<int>(items.size()) + 1);
+
+  // Pads by footprint, numbered within it
+  const auto* pin = dynamic_cast<const Pin*>(items[5004].get());
+  REQUIRE(pin != nullptr);
+  REQUIRE(pin->getComponentNumber() == 2);
+  REQUIRE(pin->getPinNumber() == 1);
+  REQUIRE(pin->getCenter() == IntPoint(120000, 200000));
+
+  // Every item is in the shape tree; footprints are the parsed ones
+  REQUIRE(board->getShapeTree().size() == items.size());
+  REQUIRE(board->getShapeTree().queryRegion(IntBox::fromPoint(IntPoint(120000, 200000))).size() == 1);
+  REQUIRE(board->getFootprints().get() == &pcb->footprints);
+}
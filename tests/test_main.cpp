@@ -2,6 +2,12 @@
 #include "core/Types.h"
 #include "core/FixedPoint.h"
 #include "core/Arena.h"
+#include "core/LayerMask.h"
+#include "core/SlabPool.h"
+#include "core/MemoryBudget.h"
+#include "core/Parallel.h"
+#include <atomic>
+#include <stdexcept>
 
 using namespace freerouting;
 
@@ -26,6 +32,22 @@ TEST_CASE("Types are defined correctly", "[types]") {
   }
 }
 
+TEST_CASE("LayerMask helpers", "[types][layermask]") {
+  REQUIRE(layerBit(0) == 1);
+  REQUIRE(layerBit(5) == 32);
+  REQUIRE(layerBit(-1) == 0);
+  REQUIRE(layerRangeMask(2, 4) == 0b11100);
+  REQUIRE(layerRangeMask(0, 63) == kAllLayers);
+  REQUIRE(layerRangeMask(3, 2) == 0);
+
+  // Layers past the mask width share the top bit
+  REQUIRE(layerBit(70) == layerBit(63));
+  REQUIRE(layersOverlap(layerRangeMask(65, 66), layerBit(63)));
+
+  REQUIRE(layersOverlap(layerRangeMask(0, 3), layerRangeMask(3, 7)));
+  REQUIRE_FALSE(layersOverlap(layerRangeMask(0, 2), layerRangeMask(3, 7)));
+}
+
 TEST_CASE("FixedPoint basic operations", "[fixedpoint]") {
   SECTION("Construction from integer") {
     auto fp = FixedPoint::fromInt(42);
@@ -146,3 +168,202 @@ TEST_CASE("Arena allocator", "[arena]") {
     REQUIRE(threadArena == nullptr);
   }
 }
+
+namespace {
+
+struct PooledThing {
+  FR_SLAB_ALLOCATED(PooledThing)
+
+  double value[3];
+};
+
+} // namespace
+
+TEST_CASE("SlabPool allocator", "[slabpool]") {
+  SECTION("Objects of a type are carved from one slab") {
+    size_t liveBefore = SlabPool<PooledThing>::liveCount();
+    auto a = std::make_unique<PooledThing>();
+    auto b = std::make_unique<PooledThing>();
+
+    REQUIRE(SlabPool<PooledThing>::liveCount() == liveBefore + 2);
+    REQUIRE(SlabPool<PooledThing>::slabCount() >= 1);
+    REQUIRE(reinterpret_cast<uintptr_t>(a.get()) % alignof(PooledThing) == 0);
+
+    // Bump allocation: consecutive objects are adjacent
+    auto distance = reinterpret_cast<char*>(b.get()) - reinterpret_cast<char*>(a.get());
+    REQUIRE(static_cast<size_t>(distance < 0 ? -distance : distance) == sizeof(PooledThing));
+  }
+
+  SECTION("Freed slots are reused first") {
+    auto a = std::make_unique<PooledThing>();
+    PooledThing* freed = a.get();
+    size_t live = SlabPool<PooledThing>::liveCount();
+    a.reset();
+    REQUIRE(SlabPool<PooledThing>::liveCount() == live - 1);
+
+    auto b = std::make_unique<PooledThing>();
+    REQUIRE(b.get() == freed);
+  }
+
+  SECTION("Addresses stay stable as slabs are added") {
+    std::vector<std::unique_ptr<PooledThing>> things;
+    things.push_back(std::make_unique<PooledThing>());
+    PooledThing* first = things.front().get();
+    first->value[0] = 42.0;
+
+    size_t slabsBefore = SlabPool<PooledThing>::slabCount();
+    for (size_t i = 0; i < SlabPool<PooledThing>::slabObjects() + 1; ++i) {
+      things.push_back(std::make_unique<PooledThing>());
+    }
+
+    REQUIRE(SlabPool<PooledThing>::slabCount() > slabsBefore);
+    REQUIRE(things.front().get() == first);
+    REQUIRE(first->value[0] == 42.0);
+  }
+
+  SECTION("Slabs freed back to the pool are released") {
+    std::vector<std::unique_ptr<PooledThing>> things;
+    for (size_t i = 0; i < 6 * SlabPool<PooledThing>::slabObjects(); ++i) {
+      things.push_back(std::make_unique<PooledThing>());
+    }
+    size_t slabsAtPeak = SlabPool<PooledThing>::slabCount();
+    REQUIRE(slabsAtPeak >= 6);
+
+    things.clear();
+    // The thread keeps a batch of slots and the slab it bumps through
+    REQUIRE(SlabPool<PooledThing>::slabCount() <= slabsAtPeak - 4);
+  }
+
+  SECTION("Threads allocate and free in their own caches") {
+    size_t liveBefore = SlabPool<PooledThing>::liveCount();
+    std::vector<std::unique_ptr<PooledThing>> kept(4000);
+
+    // Each object is freed on another thread than the one it came from
+    parallelFor(kept.size(), 4, [&](size_t i) {
+      kept[i] = std::make_unique<PooledThing>();
+      kept[i]->value[0] = static_cast<double>(i);
+    });
+    REQUIRE(SlabPool<PooledThing>::liveCount() == liveBefore + kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+      REQUIRE(kept[i]->value[0] == static_cast<double>(i));
+    }
+
+    parallelFor(kept.size(), 4, [&](size_t i) {
+      kept[kept.size() - 1 - i].reset();
+    });
+    REQUIRE(SlabPool<PooledThing>::liveCount() == liveBefore);
+  }
+}
+
+namespace {
+
+struct FakeCache : MemoryBudget::Cache {
+  bool evicted = false;
+  void evict() override { evicted = true; }
+};
+
+struct Blob {
+  explicit Blob(size_t bytes) : data(bytes) {}
+  size_t memoryBytes() const { return data.capacity(); }
+  std::vector<char> data;
+};
+
+} // namespace
+
+TEST_CASE("MemoryBudget eviction", "[memorybudget]") {
+  MemoryBudget& budget = MemoryBudget::instance();
+  budget.setLimit(0);
+  budget.resetStatistics();
+
+  SECTION("Least recently used caches go first, at their next use") {
+    FakeCache a, b, c;
+    budget.update(&a, 100, 10.0);
+    budget.update(&b, 100, 10.0);
+    budget.update(&c, 100, 10.0);
+    REQUIRE_FALSE(budget.use(&a));  // a is now the most recent
+
+    // Unlimited: nothing is picked
+    REQUIRE(budget.getStatistics().peakBytes >= 300);
+
+    budget.setLimit(250);
+    REQUIRE_FALSE(a.evicted);
+    REQUIRE_FALSE(b.evicted);  // Only marked so far
+
+    REQUIRE(budget.use(&b));
+    REQUIRE(b.evicted);
+    REQUIRE_FALSE(budget.use(&a));
+    REQUIRE_FALSE(budget.use(&c));
+
+    auto stats = budget.getStatistics();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.bytesEvicted == 100);
+
+    budget.remove(&a);
+    budget.remove(&c);
+  }
+
+  SECTION("Caches that are slow to rebuild are kept") {
+    FakeCache cheap, costly, growing;
+    budget.update(&cheap, 100, 1.0);
+    budget.update(&costly, 100, 1000.0);
+    budget.setLimit(250);
+
+    // The cache going over the limit is never picked itself
+    budget.update(&growing, 100, 0.0);
+    REQUIRE(budget.use(&cheap));
+    REQUIRE_FALSE(budget.use(&costly));
+    REQUIRE_FALSE(budget.use(&growing));
+
+    budget.remove(&costly);
+    budget.remove(&growing);
+  }
+
+  SECTION("BudgetedCache drops its object and is rebuilt") {
+    BudgetedCache<Blob> first;
+    BudgetedCache<Blob> second;
+    budget.setLimit(1500);
+
+    first.emplace(1000);
+    second.emplace(1000);
+    REQUIRE(budget.getStatistics().usedBytes >= 2000);
+
+    second.use();
+    REQUIRE(second);
+    first.use();
+    REQUIRE_FALSE(first);
+
+    first.emplace(1000);  // Rebuilt on demand
+    REQUIRE(first);
+    REQUIRE(first->memoryBytes() == 1000);
+  }
+
+  budget.setLimit(0);
+}
+
+TEST_CASE("parallelFor", "[parallel]") {
+  SECTION("Every index runs once, on a worker in range") {
+    std::vector<std::atomic<int>> runs(1000);
+    std::atomic<bool> workersInRange{true};
+    parallelFor(runs.size(), 4, [&](size_t i, size_t worker) {
+      ++runs[i];
+      if (worker >= 4) workersInRange = false;
+    });
+    REQUIRE(workersInRange);
+    for (size_t i = 0; i < runs.size(); ++i) {
+      CAPTURE(i);
+      REQUIRE(runs[i] == 1);
+    }
+  }
+
+  SECTION("One thread runs in order on the caller") {
+    std::vector<size_t> order;
+    parallelFor(5, 1, [&](size_t i) { order.push_back(i); });
+    REQUIRE(order == std::vector<size_t>{0, 1, 2, 3, 4});
+  }
+
+  SECTION("An exception reaches the caller") {
+    REQUIRE_THROWS_AS(parallelFor(1000, 4, [](size_t i) {
+      if (i == 10) throw std::runtime_error("task failed");
+    }), std::runtime_error);
+  }
+}
@@ -3,11 +3,22 @@
 #include "autoroute/Connection.h"
 #include "autoroute/IncompleteConnection.h"
 #include "autoroute/PathFinder.h"
+#include "autoroute/ObstaclePyramid.h"
+#include "autoroute/OccupancyPyramid.h"
+#include "autoroute/MultiResolutionGridRouter.h"
+#include "autoroute/ProximityField.h"
+#include "autoroute/PinAccess.h"
+#include "autoroute/SearchCapture.h"
+#include "autoroute/LayerAssignment.h"
+#include "autoroute/PathSimplifier.h"
+#include "autoroute/ViaMinimizer.h"
 #include "board/RoutingBoard.h"
 #include "board/Trace.h"
 #include "board/Via.h"
 #include "board/Pin.h"
+#include "board/RouteOptimizer.h"
 #include "rules/ClearanceMatrix.h"
+#include <cstdio>
 
 using namespace freerouting;
 
@@ -300,6 +311,61 @@ TEST_CASE("RoutingBoard - Incomplete connections", "[routing][board]") {
   REQUIRE(board.incompleteConnectionCount() == 0);
 }
 
+TEST_CASE("RoutingBoard - Contact index drives connectivity", "[routing][board]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  Nets nets;
+  nets.addNet(Net("A", 1, 1, nullptr));
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.setNets(&nets);
+  const Padstack* pad = board.getPadstack("pad", 0, 1);
+  for (IntPoint center : {IntPoint(0, 0), IntPoint(40000, 0)}) {
+    board.addItem(std::make_unique<Pin>(center, 1, pad, std::vector<int>{1}, 0,
+                                        board.generateItemId(), 0, FixedState::SystemFixed, &board));
+  }
+  board.updateIncompleteConnections();
+  REQUIRE(board.incompleteConnectionCount() == 1);
+
+  // Two collinear halves on the back layer join the pins
+  auto addTrace = [&](IntPoint a, IntPoint b) {
+    auto trace = std::make_unique<Trace>(a, b, 1, 1250, std::vector<int>{1}, 0,
+                                         board.generateItemId(), FixedState::NotFixed, &board);
+    Trace* item = trace.get();
+    board.addItem(std::move(trace));
+    return item;
+  };
+  Trace* first = addTrace(IntPoint(0, 0), IntPoint(20000, 0));
+  Trace* second = addTrace(IntPoint(20000, 0), IntPoint(40000, 0));
+
+  const ContactIndex& contacts = board.getContactIndex();
+  REQUIRE(contacts.at(IntPoint(20000, 0), 1).size() == 2);
+  REQUIRE(contacts.at(IntPoint(20000, 0), 0).empty());
+  REQUIRE(contacts.at(IntPoint(0, 0), 0).size() == 1);
+  REQUIRE(contacts.at(IntPoint(0, 0), 1).size() == 2);
+  REQUIRE(contacts.touching(*first, 1).size() == 2);
+  REQUIRE(contacts.touching(*first, 2).empty());
+
+  board.updateIncompleteConnections();
+  REQUIRE(board.incompleteConnectionCount() == 0);
+
+  std::vector<Trace*> traces{first, second};
+  auto pairs = RouteOptimizer::findMergeableTracePairs(traces, contacts);
+  REQUIRE(pairs == RouteOptimizer::findMergeableTracePairs(traces));
+  REQUIRE(pairs.size() == 1);
+
+  REQUIRE(board.removeItem(second));
+  REQUIRE(contacts.at(IntPoint(20000, 0), 1).size() == 1);
+  REQUIRE(contacts.at(IntPoint(40000, 0), 1).size() == 1);
+  board.updateIncompleteConnections();
+  REQUIRE(board.incompleteConnectionCount() == 1);
+}
+
 // ============================================================================
 // PathFinder Tests
 // ============================================================================
@@ -372,3 +438,716 @@ TEST_CASE("PathFinder - Path with obstacles", "[routing][pathfinder]") {
   // Full implementation would handle this better
   REQUIRE(!result.points.empty());
 }
+
+// ============================================================================
+// ObstaclePyramid Tests
+// ============================================================================
+
+namespace {
+
+std::unique_ptr<Trace> makeTrace(RoutingBoard& board, IntPoint a, IntPoint b,
+                                 int layer, int net) {
+  return std::make_unique<Trace>(
+    a, b, layer, 1250, std::vector<int>{net}, 0, board.generateItemId(),
+    FixedState::NotFixed, &board);
+}
+
+} // namespace
+
+TEST_CASE("ObstaclePyramid - Net-aware blocking", "[routing][pyramid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(100000, 0), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(0, 100000), IntPoint(1000, 100000), 1, 3));
+
+  ObstaclePyramid pyramid(&board, 1000, 500);
+  REQUIRE(pyramid.levelCount() > 1);
+
+  auto [cx, cy] = pyramid.cellOf(0, IntPoint(50000, 0));
+  REQUIRE(pyramid.blockedFraction(0, 0, cx, cy, 1) == 1.0);
+  REQUIRE(pyramid.blockedFraction(0, 0, cx, cy, 2) == 0.0);
+  REQUIRE(pyramid.blockedFraction(0, 1, cx, cy, 1) == 0.0);
+
+  // Coarse cells over the trace are partly blocked
+  auto [qx, qy] = pyramid.cellOf(3, IntPoint(50000, 0));
+  double fraction = pyramid.blockedFraction(3, 0, qx, qy, 1);
+  REQUIRE(fraction > 0.0);
+  REQUIRE(fraction < 1.0);
+}
+
+TEST_CASE("ObstaclePyramid - Follows board changes", "[routing][pyramid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(1000, 0), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(100000, 100000), IntPoint(101000, 100000), 0, 2));
+
+  ObstaclePyramid* pyramid = &board.getObstaclePyramid(1000, 500);
+  auto [cx, cy] = pyramid->cellOf(0, IntPoint(50000, 50000));
+  REQUIRE(pyramid->blockedFraction(0, 0, cx, cy, 1) == 0.0);
+
+  auto trace = makeTrace(board, IntPoint(40000, 50000), IntPoint(60000, 50000), 0, 3);
+  int traceId = trace->getId();
+  board.addItem(std::move(trace));
+
+  // Same parameters return the shared pyramid, refreshed in place
+  REQUIRE(&board.getObstaclePyramid(1000, 500) == pyramid);
+  REQUIRE(pyramid->blockedFraction(0, 0, cx, cy, 1) == 1.0);
+  REQUIRE(pyramid->blockedFraction(pyramid->levelCount() - 1, 0, 0, 0, 1) > 0.0);
+
+  board.removeItem(traceId);
+  board.getObstaclePyramid(1000, 500);
+  REQUIRE(pyramid->blockedFraction(0, 0, cx, cy, 1) == 0.0);
+}
+
+// ============================================================================
+// ProximityField Tests
+// ============================================================================
+
+TEST_CASE("ProximityField - Distance to nearest copper", "[routing][proximity]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  // Trace copper spans y = -1250..1250
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(100000, 0), 0, 2));
+
+  ProximityField field(&board, 500, 10000);
+
+  for (int y : {2000, 4000, 8000}) {
+    REQUIRE(std::abs(field.distanceAt(IntPoint(50000, y), 0) - (y - 1250)) <= 500.0);
+  }
+  REQUIRE(field.distanceAt(IntPoint(50000, 20000), 0) == 10000.0);
+  REQUIRE(field.distanceAt(IntPoint(50000, 2000), 1) == 10000.0);
+
+  // Past the end of the trace the nearest copper is its corner
+  double expected = std::hypot(110000.0 - 101250.0, 5000.0 - 1250.0);
+  REQUIRE(std::abs(field.distanceAt(IntPoint(110000, 5000), 0) - expected) <= 1000.0);
+
+  REQUIRE(field.nearestOwnerAt(IntPoint(50000, 4000), 0) == 2);
+  REQUIRE(field.nearestOwnerAt(IntPoint(50000, 20000), 0) == ProximityField::kFree);
+
+  // Only other nets pay, and the cost falls off with distance
+  REQUIRE(field.costAt(IntPoint(50000, 2000), 0, 2, 1.0) == 0.0);
+  double near = field.costAt(IntPoint(50000, 2000), 0, 1, 1.0);
+  double far = field.costAt(IntPoint(50000, 8000), 0, 1, 1.0);
+  REQUIRE(near > far);
+  REQUIRE(far > 0.0);
+  REQUIRE(field.costAt(IntPoint(50000, 20000), 0, 1, 1.0) == 0.0);
+}
+
+TEST_CASE("ProximityField - Local refresh matches full rebuild", "[routing][proximity]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(200000, 0), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(0, 200000), IntPoint(200000, 200000), 1, 3));
+  auto diagonal = makeTrace(board, IntPoint(20000, 20000), IntPoint(80000, 180000), 0, 4);
+  int diagonalId = diagonal->getId();
+  board.addItem(std::move(diagonal));
+
+  ProximityField* field = &board.getProximityField(1000, 8000);
+
+  board.removeItem(diagonalId);
+  board.addItem(makeTrace(board, IntPoint(150000, 30000), IntPoint(150000, 170000), 0, 5));
+  board.addItem(makeTrace(board, IntPoint(100000, 100000), IntPoint(120000, 100000), 1, 6));
+
+  // Same parameters return the shared field, refreshed in place
+  REQUIRE(&board.getProximityField(1000, 8000) == field);
+  REQUIRE_FALSE(field->hasDirtyRegions());
+
+  ProximityField fresh(&board, 1000, 8000);
+  REQUIRE(fresh.getBounds() == field->getBounds());
+
+  for (int layer = 0; layer < 2; ++layer) {
+    for (int y = -5000; y <= 205000; y += 2500) {
+      for (int x = -5000; x <= 205000; x += 2500) {
+        IntPoint p(x, y);
+        REQUIRE(field->distanceAt(p, layer) == fresh.distanceAt(p, layer));
+        REQUIRE(field->nearestOwnerAt(p, layer) == fresh.nearestOwnerAt(p, layer));
+      }
+    }
+  }
+}
+
+// ============================================================================
+// PinAccess Tests
+// ============================================================================
+
+TEST_CASE("PinAccess - Stubs avoid other nets and follow edits", "[routing][pinaccess]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  const Padstack* pad = board.getPadstack("pad", 0, 1);
+  auto addPin = [&](IntPoint center, int netNo) {
+    auto pin = std::make_unique<Pin>(center, 1, pad, std::vector<int>{netNo}, 0,
+                                     board.generateItemId(), 0, FixedState::SystemFixed, &board);
+    const Pin* item = pin.get();
+    board.addItem(std::move(pin));
+    return item;
+  };
+
+  // Pads are 1000 wide; the neighbour of another net is 4000 to the east
+  const Pin* pin = addPin(IntPoint(0, 0), 1);
+  addPin(IntPoint(4000, 0), 2);
+
+  PinAccess* access = &board.getPinAccess(1000, 500);
+  auto hasDirection = [&](int layer, int dx) {
+    for (const auto& point : access->get(*pin)) {
+      if (point.layer == layer && point.direction.x == dx) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  REQUIRE(access->accessLayers(*pin) == (layerBit(0) | layerBit(1)));
+  REQUIRE_FALSE(hasDirection(0, 1));
+  REQUIRE(hasDirection(0, -1));
+  REQUIRE(hasDirection(1, -1));
+
+  // Copper of the pin's own net does not block it
+  board.addItem(makeTrace(board, IntPoint(0, 3000), IntPoint(0, 10000), 0, 1));
+  // A foreign trace west of the pin on the front layer, then two more
+  // north and south of it, leave only the back layer
+  board.addItem(makeTrace(board, IntPoint(-3000, -10000), IntPoint(-3000, 10000), 0, 3));
+  REQUIRE(&board.getPinAccess(1000, 500) == access);
+  REQUIRE_FALSE(access->hasDirtyRegions());
+  REQUIRE_FALSE(hasDirection(0, -1));
+  REQUIRE(hasDirection(0, 0));
+  REQUIRE(hasDirection(1, -1));
+
+  auto north = makeTrace(board, IntPoint(-10000, 3000), IntPoint(10000, 3000), 0, 3);
+  int northId = north->getId();
+  board.addItem(std::move(north));
+  board.addItem(makeTrace(board, IntPoint(-10000, -3000), IntPoint(10000, -3000), 0, 3));
+  board.getPinAccess(1000, 500);
+  REQUIRE(access->accessLayers(*pin) == layerBit(1));
+  REQUIRE(access->nearest(*pin, 0, IntPoint(-10000, 0)) == nullptr);
+
+  const PinAccess::AccessPoint* nearest = access->nearest(*pin, 1, IntPoint(-10000, 0));
+  REQUIRE(nearest != nullptr);
+  REQUIRE(nearest->direction == IntVector(-1, 0));
+  REQUIRE(nearest->point == IntPoint(-3000, 0));
+
+  board.removeItem(northId);
+  board.getPinAccess(1000, 500);
+  REQUIRE(access->accessLayers(*pin) == (layerBit(0) | layerBit(1)));
+  REQUIRE(hasDirection(0, 0));
+
+  PinAccess::Statistics stats = access->getStatistics();
+  REQUIRE(stats.pins == 2);
+  REQUIRE(stats.templates == 1);
+  REQUIRE(stats.analyses > stats.pins);
+}
+
+// ============================================================================
+// OccupancyPyramid Tests
+// ============================================================================
+
+TEST_CASE("OccupancyPyramid - Agrees with the spatial index", "[routing][occupancy]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(100000, 0), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(0, 100000), IntPoint(1000, 100000), 1, 3));
+
+  OccupancyPyramid* occupancy = &board.getOccupancy(1000, 500);
+  REQUIRE(occupancy->levelCount() > 1);
+
+  using State = OccupancyPyramid::State;
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 0), 0, 1, 500) == State::Full);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 0), 0, 2, 500) == State::Empty);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 0), 1, 1, 500) == State::Empty);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 50000), 0, 1, 500) == State::Empty);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 1600), 0, 1, 500) == State::Mixed);
+  // Reaching farther than the inflation is never settled as empty
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 50000), 0, 1, 600) == State::Mixed);
+
+  // A long box over open board, and one that crosses the trace
+  REQUIRE(occupancy->probeBox(IntBox(0, 20000, 100000, 30000), 0, 1, 500) == State::Empty);
+  REQUIRE(occupancy->probeBox(IntBox(50000, -20000, 51000, 20000), 0, 1, 500) == State::Mixed);
+
+  // Conclusive answers match the index everywhere
+  for (int y = -5000; y <= 5000; y += 250) {
+    for (int x = 95000; x <= 105000; x += 250) {
+      IntPoint point(x, y);
+      IntBox searchBox = IntBox::fromPoint(point).expand(500);
+      bool blocked = !board.getShapeTree().findTraceObstacles(1, searchBox, 0, 0).empty();
+      State state = occupancy->probePoint(point, 0, 1, 500);
+      if (state == State::Empty) {
+        REQUIRE_FALSE(blocked);
+      } else if (state == State::Full) {
+        REQUIRE(blocked);
+      }
+    }
+  }
+
+  // Item changes are applied at once
+  auto trace = makeTrace(board, IntPoint(40000, 50000), IntPoint(60000, 50000), 0, 3);
+  Trace* added = trace.get();
+  board.addItem(std::move(trace));
+  REQUIRE(&board.getOccupancy(1000, 500) == occupancy);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 50000), 0, 1, 500) == State::Full);
+  REQUIRE(board.hasObstacleAt(IntPoint(50000, 50000), 0, 1, 500));
+
+  board.removeItem(added);
+  REQUIRE(occupancy->probePoint(IntPoint(50000, 50000), 0, 1, 500) == State::Empty);
+  REQUIRE_FALSE(board.hasObstacleAt(IntPoint(50000, 50000), 0, 1, 500));
+
+  OccupancyPyramid::Statistics stats = occupancy->getStatistics();
+  REQUIRE(stats.probes > stats.empty + stats.full);
+  REQUIRE(stats.hitRate() > 0.0);
+}
+
+// ============================================================================
+// MultiResolutionGridRouter Tests
+// ============================================================================
+
+TEST_CASE("MultiResolutionGridRouter - Open board", "[routing][multigrid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(0, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(400000, 0), IntPoint(400000, 0), 0, 1));
+
+  ObstaclePyramid pyramid(&board, 4000, 2000);
+  MultiResolutionGridRouter router(pyramid);
+
+  MultiResolutionGridRouter::Endpoint start{IntPoint(0, 0), IntBox::fromPoint(IntPoint(0, 0)), 0, 0};
+  MultiResolutionGridRouter::Endpoint goal{IntPoint(400000, 0), IntBox::fromPoint(IntPoint(400000, 0)), 0, 0};
+
+  auto result = router.findPath(start, goal, 1);
+
+  REQUIRE(result.found);
+  REQUIRE(result.levelsSearched > 1);  // Long connection starts coarse
+  REQUIRE(result.pathPoints.front() == start.point);
+  REQUIRE(result.pathPoints.back() == goal.point);
+  REQUIRE(result.pathPoints.size() == result.pathLayers.size());
+  // Straight runs are merged into a handful of segments
+  REQUIRE(result.pathPoints.size() <= 5);
+}
+
+TEST_CASE("MultiResolutionGridRouter - Stops when requested", "[routing][multigrid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(0, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(400000, 0), IntPoint(400000, 0), 0, 1));
+
+  ObstaclePyramid pyramid(&board, 4000, 2000);
+  SimpleStoppable stoppable;
+  MultiResolutionGridRouter::Config config;
+  config.stoppable = &stoppable;
+  MultiResolutionGridRouter router(pyramid, config);
+
+  MultiResolutionGridRouter::Endpoint start{IntPoint(0, 0), IntBox::fromPoint(IntPoint(0, 0)), 0, 0};
+  MultiResolutionGridRouter::Endpoint goal{IntPoint(400000, 0), IntBox::fromPoint(IntPoint(400000, 0)), 0, 0};
+
+  REQUIRE(router.findPath(start, goal, 1).found);
+
+  stoppable.requestStop();
+  auto result = router.findPath(start, goal, 1);
+  REQUIRE_FALSE(result.found);
+  REQUIRE(result.cellsExpanded == 0);
+}
+
+TEST_CASE("MultiResolutionGridRouter - Detours around foreign copper", "[routing][multigrid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(0, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(200000, 0), IntPoint(200000, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(100000, -60000), IntPoint(100000, 60000), 0, 2));
+
+  ObstaclePyramid pyramid(&board, 4000, 2000);
+  MultiResolutionGridRouter router(pyramid);
+
+  MultiResolutionGridRouter::Endpoint start{IntPoint(0, 0), IntBox::fromPoint(IntPoint(0, 0)), 0, 0};
+  MultiResolutionGridRouter::Endpoint goal{IntPoint(200000, 0), IntBox::fromPoint(IntPoint(200000, 0)), 0, 0};
+
+  auto result = router.findPath(start, goal, 1);
+
+  REQUIRE(result.found);
+  bool passesWallEnd = false;
+  for (const IntPoint& point : result.pathPoints) {
+    if (std::abs(point.y) > 60000) {
+      passesWallEnd = true;
+    }
+  }
+  REQUIRE(passesWallEnd);
+
+  // The wall's own net goes straight through
+  auto ownNet = router.findPath(start, goal, 2);
+  REQUIRE(ownNet.found);
+  for (const IntPoint& point : ownNet.pathPoints) {
+    REQUIRE(std::abs(point.y) < 20000);
+  }
+}
+
+TEST_CASE("MultiResolutionGridRouter - Changes layer when blocked", "[routing][multigrid]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(0, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(200000, 0), IntPoint(200000, 0), 0, 1));
+  // Wall across the whole board on the top layer only
+  board.addItem(makeTrace(board, IntPoint(100000, -400000), IntPoint(100000, 400000), 0, 2));
+
+  ObstaclePyramid pyramid(&board, 4000, 2000);
+  MultiResolutionGridRouter router(pyramid);
+
+  MultiResolutionGridRouter::Endpoint start{IntPoint(0, 0), IntBox::fromPoint(IntPoint(0, 0)), 0, 0};
+  MultiResolutionGridRouter::Endpoint goal{IntPoint(200000, 0), IntBox::fromPoint(IntPoint(200000, 0)), 0, 0};
+
+  auto result = router.findPath(start, goal, 1);
+
+  REQUIRE(result.found);
+  bool usesBottom = false;
+  for (int layer : result.pathLayers) {
+    if (layer == 1) usesBottom = true;
+  }
+  REQUIRE(usesBottom);
+  REQUIRE(result.pathLayers.front() == 0);
+  REQUIRE(result.pathLayers.back() == 0);
+}
+
+TEST_CASE("LayerAssignment - Spreads a crowded row over layers", "[routing][layerassign]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("L1", true));
+  layers.addLayer(Layer("L2", true));
+  layers.addLayer(Layer("L3", true));
+  layers.addLayer(Layer("L4", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(0, 0), 0, 1));
+  board.addItem(makeTrace(board, IntPoint(200000, 0), IntPoint(200000, 0), 0, 1));
+
+  // Horizontal layers are 0 and 2, vertical 1 and 3
+  auto pairs = LayerAssignment::candidatePairs(board, true);
+  REQUIRE(pairs.size() == 4);
+  for (const auto& pair : pairs) {
+    REQUIRE(pair.horizontal % 2 == 0);
+    REQUIRE(pair.vertical % 2 == 1);
+  }
+
+  // Eight straight connections in one tile row; a layer holds about four
+  std::vector<LayerAssignment::Connection> connections;
+  for (int i = 0; i < 8; ++i) {
+    connections.push_back({10 + i, 100 + 2 * i, 101 + 2 * i,
+                           IntPoint(0, 0), IntPoint(200000, 0), 0, 3, 0, 3});
+  }
+
+  LayerAssignment assignment;
+  assignment.solve(board, connections);
+  const auto& stats = assignment.getStatistics();
+
+  REQUIRE_FALSE(assignment.isEmpty());
+  REQUIRE(stats.initialOverflow > 0);
+  REQUIRE(stats.finalOverflow == 0);
+
+  int onLayer0 = 0;
+  int onLayer2 = 0;
+  for (const auto& connection : connections) {
+    auto pair = assignment.pairFor(connection.toItemId, connection.fromItemId, connection.netNo);
+    REQUIRE(pair.isValid());
+    onLayer0 += pair.horizontal == 0 ? 1 : 0;
+    onLayer2 += pair.horizontal == 2 ? 1 : 0;
+  }
+  REQUIRE(onLayer0 + onLayer2 == 8);
+  REQUIRE(onLayer0 <= 4);
+  REQUIRE(onLayer2 <= 4);
+
+  // Unknown connection of a known net gets the net's pair
+  REQUIRE(assignment.pairFor(1, 2, 10).isValid());
+  REQUIRE_FALSE(assignment.pairFor(1, 2, 99).isValid());
+}
+
+// ============================================================================
+// SearchCapture Tests
+// ============================================================================
+
+TEST_CASE("SearchCapture - Binary round trip", "[routing][capture]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(100000, 0), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(0, 50000), IntPoint(100000, 50000), 1, 3));
+
+  SearchCapture capture;
+  capture.begin(board, 3, 2);
+  REQUIRE(capture.count(SearchCapture::Kind::Obstacle) == 2);
+
+  int doorA = 0;
+  int doorB = 0;
+  capture.addRoom(IntBox(0, 1000, 100000, 49000), 0, 1);
+  capture.addDoor(SearchCapture::Kind::DoorQueued, &doorA, IntBox(10, 10, 20, 20), 0, 0.0, 500.0);
+  capture.addDoor(SearchCapture::Kind::DoorExpanded, &doorA, IntBox(10, 10, 20, 20), 0, 0.0, 500.0);
+  capture.addDoor(SearchCapture::Kind::DoorExpanded, &doorB, IntBox(30, 30, 40, 40), 0, 250.5, 400.0);
+  capture.addPathPoint(IntPoint(15, 15), 0, &doorA);
+  capture.addPathPoint(IntPoint(35, 35), 0, &doorB);
+  capture.setOutcome(SearchCapture::Outcome::MazeSearch);
+
+  std::string path = "test_search_capture.frsc";
+  REQUIRE(capture.writeToFile(path));
+  auto loaded = SearchCapture::readFromFile(path);
+  std::remove(path.c_str());
+
+  REQUIRE(loaded.has_value());
+  REQUIRE(loaded->getNetNo() == 3);
+  REQUIRE(loaded->getPassNo() == 2);
+  REQUIRE(loaded->getLayerCount() == 2);
+  REQUIRE(loaded->getOutcome() == SearchCapture::Outcome::MazeSearch);
+  REQUIRE(loaded->getBounds() == capture.getBounds());
+  REQUIRE(loaded->getRecords().size() == capture.getRecords().size());
+
+  const auto& records = loaded->getRecords();
+  const auto& expanded = records[records.size() - 3];
+  REQUIRE(expanded.kind == SearchCapture::Kind::DoorExpanded);
+  REQUIRE(expanded.expansionValue == 250.5f);
+  REQUIRE(expanded.box == IntBox(30, 30, 40, 40));
+
+  // Door ids tie path points to their expansion records
+  REQUIRE(records[records.size() - 2].tag == records[records.size() - 5].tag);
+  REQUIRE(records.back().tag == expanded.tag);
+
+  // Trace on layer 1 keeps its net and layer range
+  REQUIRE(records[1].tag == 3);
+  REQUIRE(records[1].firstLayer == 1);
+  REQUIRE(records[1].lastLayer == 1);
+
+  capture.clearPath();
+  REQUIRE(capture.count(SearchCapture::Kind::PathPoint) == 0);
+  REQUIRE_FALSE(SearchCapture::readFromFile("does_not_exist.frsc").has_value());
+}
+
+TEST_CASE("PathSimplifier - Merges straight runs and cuts clear corners", "[routing][simplify]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+
+  // Straight runs collapse, the via point stays
+  std::vector<IntPoint> points = {IntPoint(0, 0), IntPoint(10000, 0), IntPoint(10000, 0),
+                                  IntPoint(20000, 0), IntPoint(20000, 0), IntPoint(20000, 10000),
+                                  IntPoint(20000, 20000)};
+  std::vector<int> pathLayers = {0, 0, 0, 0, 1, 1, 1};
+  REQUIRE(PathSimplifier::countSegments(points) == 4);
+
+  PathSimplifier::mergeCollinear(points, pathLayers);
+  REQUIRE(points == std::vector<IntPoint>{IntPoint(0, 0), IntPoint(20000, 0),
+                                          IntPoint(20000, 0), IntPoint(20000, 20000)});
+  REQUIRE(pathLayers == std::vector<int>{0, 0, 1, 1});
+
+  // An L on an empty board becomes one diagonal
+  PathSimplifier simplifier(&board, 1, std::vector<int>{1250, 1250});
+  std::vector<IntPoint> corner = {IntPoint(0, 0), IntPoint(50000, 0), IntPoint(100000, 0),
+                                  IntPoint(100000, 100000)};
+  std::vector<int> cornerLayers = {0, 0, 0, 0};
+  simplifier.simplify(corner, cornerLayers);
+  REQUIRE(corner == std::vector<IntPoint>{IntPoint(0, 0), IntPoint(100000, 100000)});
+  REQUIRE(simplifier.getStatistics().segmentsIn == 3);
+  REQUIRE(simplifier.getStatistics().segmentsOut == 1);
+
+  // Another net's trace across the diagonal keeps the corner; copper on the
+  // other layer or of the same net does not
+  board.addItem(makeTrace(board, IntPoint(50000, 50000), IntPoint(52000, 52000), 0, 2));
+  board.addItem(makeTrace(board, IntPoint(30000, 30000), IntPoint(32000, 32000), 1, 3));
+  board.addItem(makeTrace(board, IntPoint(70000, 70000), IntPoint(72000, 72000), 0, 1));
+
+  corner = {IntPoint(0, 0), IntPoint(100000, 0), IntPoint(100000, 100000)};
+  cornerLayers = {0, 0, 0};
+  simplifier.simplify(corner, cornerLayers);
+  REQUIRE(corner.size() == 3);
+
+  corner = {IntPoint(0, 0), IntPoint(0, 100000), IntPoint(100000, 100000)};
+  cornerLayers = {1, 1, 1};
+  simplifier.simplify(corner, cornerLayers);
+  REQUIRE(corner.size() == 3);  // Layer 1 obstacle at (30000, 30000)
+
+  corner = {IntPoint(60000, 0), IntPoint(100000, 0), IntPoint(100000, 40000)};
+  cornerLayers = {0, 0, 0};
+  simplifier.simplify(corner, cornerLayers);
+  REQUIRE(corner.size() == 2);
+}
+
+TEST_CASE("ViaMinimizer - Moves via-to-via chains onto one layer", "[routing][vias]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("In1.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+  auto addVia = [&board](IntPoint center, int net) {
+    board.addItem(std::make_unique<Via>(center, board.getPadstack("via", 0, 2),
+                                        std::vector<int>{net}, 0, board.generateItemId(),
+                                        FixedState::NotFixed, true, &board));
+  };
+  auto countVias = [&board]() {
+    int count = 0;
+    for (const auto& item : board.getItems()) {
+      count += dynamic_cast<const Via*>(item.get()) ? 1 : 0;
+    }
+    return count;
+  };
+
+  // Net 1, pair: F.Cu to a via, B.Cu between the vias, F.Cu again
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(20000, 0), 0, 1));
+  addVia(IntPoint(20000, 0), 1);
+  board.addItem(makeTrace(board, IntPoint(20000, 0), IntPoint(50000, 10000), 2, 1));
+  board.addItem(makeTrace(board, IntPoint(50000, 10000), IntPoint(80000, 0), 2, 1));
+  addVia(IntPoint(80000, 0), 1);
+  board.addItem(makeTrace(board, IntPoint(80000, 0), IntPoint(100000, 0), 0, 1));
+
+  // Net 2, triple: F.Cu, In1.Cu, B.Cu, F.Cu
+  board.addItem(makeTrace(board, IntPoint(0, 200000), IntPoint(20000, 200000), 0, 2));
+  addVia(IntPoint(20000, 200000), 2);
+  board.addItem(makeTrace(board, IntPoint(20000, 200000), IntPoint(50000, 200000), 1, 2));
+  addVia(IntPoint(50000, 200000), 2);
+  board.addItem(makeTrace(board, IntPoint(50000, 200000), IntPoint(80000, 200000), 2, 2));
+  addVia(IntPoint(80000, 200000), 2);
+  board.addItem(makeTrace(board, IntPoint(80000, 200000), IntPoint(100000, 200000), 0, 2));
+
+  // Net 3, pair blocked by net 4 crossing on F.Cu
+  board.addItem(makeTrace(board, IntPoint(0, 400000), IntPoint(20000, 400000), 0, 3));
+  addVia(IntPoint(20000, 400000), 3);
+  board.addItem(makeTrace(board, IntPoint(20000, 400000), IntPoint(80000, 400000), 2, 3));
+  addVia(IntPoint(80000, 400000), 3);
+  board.addItem(makeTrace(board, IntPoint(80000, 400000), IntPoint(100000, 400000), 0, 3));
+  board.addItem(makeTrace(board, IntPoint(50000, 380000), IntPoint(50000, 420000), 0, 4));
+
+  // Net 5, pair whose chain has a branch to another pad
+  board.addItem(makeTrace(board, IntPoint(0, 600000), IntPoint(20000, 600000), 0, 5));
+  addVia(IntPoint(20000, 600000), 5);
+  board.addItem(makeTrace(board, IntPoint(20000, 600000), IntPoint(80000, 600000), 2, 5));
+  board.addItem(makeTrace(board, IntPoint(50000, 600000), IntPoint(50000, 640000), 2, 5));
+  addVia(IntPoint(80000, 600000), 5);
+  board.addItem(makeTrace(board, IntPoint(80000, 600000), IntPoint(100000, 600000), 0, 5));
+
+  REQUIRE(countVias() == 9);
+
+  ViaMinimizer::Config config;
+  config.threads = 2;
+  ViaMinimizer minimizer(&board, config);
+  REQUIRE(minimizer.run() == 5);
+
+  const auto& stats = minimizer.getStatistics();
+  REQUIRE(stats.viasBefore == 9);
+  REQUIRE(stats.viasRemoved == 5);
+  REQUIRE(stats.tracesMoved == 4);
+  REQUIRE(stats.conflicts >= 1);
+  REQUIRE(countVias() == 4);
+
+  // Net 1 and 2 copper is all on F.Cu now; net 3 and 5 are untouched
+  for (const auto& item : board.getItems()) {
+    const Trace* trace = dynamic_cast<const Trace*>(item.get());
+    if (!trace) continue;
+    if (trace->containsNet(1) || trace->containsNet(2)) {
+      REQUIRE(trace->getLayer() == 0);
+    }
+    if (trace->containsNet(3) && trace->getStart() == IntPoint(20000, 400000)) {
+      REQUIRE(trace->getLayer() == 2);
+    }
+  }
+}
+
+TEST_CASE("ViaMinimizer - Removes the chain's own items when IDs repeat", "[routing][vias]") {
+  LayerStructure layers;
+  layers.addLayer(Layer("F.Cu", true));
+  layers.addLayer(Layer("B.Cu", true));
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  RoutingBoard board(layers, clearanceMatrix);
+
+  // Pads numbered by a loader that did not reserve their IDs, so the
+  // routed copper after them starts at 1 again
+  for (int id = 1; id <= 6; ++id) {
+    board.addItem(std::make_unique<Pin>(IntPoint(id * 20000, 300000), id, board.getPadstack("pad", 0, 0),
+                                        std::vector<int>{2}, 0, id, 1, FixedState::SystemFixed, &board));
+  }
+  board.addItem(makeTrace(board, IntPoint(0, 0), IntPoint(20000, 0), 0, 1));
+  board.addItem(std::make_unique<Via>(IntPoint(20000, 0), board.getPadstack("via", 0, 1),
+                                      std::vector<int>{1}, 0, board.generateItemId(),
+                                      FixedState::NotFixed, true, &board));
+  board.addItem(makeTrace(board, IntPoint(20000, 0), IntPoint(80000, 0), 1, 1));
+  board.addItem(std::make_unique<Via>(IntPoint(80000, 0), board.getPadstack("via", 0, 1),
+                                      std::vector<int>{1}, 0, board.generateItemId(),
+                                      FixedState::NotFixed, true, &board));
+  board.addItem(makeTrace(board, IntPoint(80000, 0), IntPoint(100000, 0), 0, 1));
+
+  ViaMinimizer minimizer(&board, ViaMinimizer::Config{});
+  REQUIRE(minimizer.run() == 2);
+
+  int pins = 0;
+  for (const auto& item : board.getItems()) {
+    pins += dynamic_cast<const Pin*>(item.get()) ? 1 : 0;
+    REQUIRE(dynamic_cast<const Via*>(item.get()) == nullptr);
+    if (const Trace* trace = dynamic_cast<const Trace*>(item.get())) {
+      REQUIRE(trace->getLayer() == 0);
+    }
+  }
+  REQUIRE(pins == 6);
+}
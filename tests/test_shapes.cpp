@@ -357,6 +357,155 @@ TEST_CASE("SpatialIndex - Clear", "[shapes][spatial]") {
   REQUIRE(result.empty());
 }
 
+TEST_CASE("SpatialIndex - Hierarchical levels match the fixed grid", "[shapes][spatial]") {
+  SpatialIndex<int> index(100);
+  SpatialIndex<int> fixed(100, SpatialIndex<int>::Grid::Fixed);
+
+  // A long item goes to a coarse level instead of a row of small cells
+  int longItem = 0;
+  index.insert(&longItem, IntBox(0, 0, 100000, 50));
+  fixed.insert(&longItem, IntBox(0, 0, 100000, 50));
+  REQUIRE(index.itemReferenceCount() <= 4);
+  REQUIRE(fixed.itemReferenceCount() > 1000);
+
+  // Enough small items on a 10x10 pitch to tune the base cell size
+  std::vector<int> items(2000);
+  for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+    items[i] = i + 1;
+    IntBox box(i % 50 * 10, i / 50 * 10, i % 50 * 10 + 4, i / 50 * 10 + 4);
+    index.insert(&items[i], box);
+    fixed.insert(&items[i], box);
+  }
+  REQUIRE(index.size() == items.size() + 1);
+  REQUIRE(index.getCellSize() != 100);
+  REQUIRE(index.levelCount() > 1);
+
+  auto sorted = [](std::vector<int*> result) {
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  for (const IntBox& region : {IntBox(0, 0, 0, 0), IntBox(-50, -50, 25, 25),
+                               IntBox(101, 37, 233, 302), IntBox(400, 0, 100000, 10),
+                               IntBox(-1000, -1000, 200000, 200000)}) {
+    REQUIRE(sorted(index.query(region)) == sorted(fixed.query(region)));
+  }
+
+  index.remove(&longItem, IntBox(0, 0, 100000, 50));
+  REQUIRE(index.query(IntBox(50000, 0, 50001, 1)).empty());
+  REQUIRE(index.size() == items.size());
+}
+
+TEST_CASE("SpatialIndex - Filters on packed nets and kinds", "[shapes][spatial]") {
+  using Index = SpatialIndex<int>;
+  Index index(100);
+
+  // Enough items for several kernel blocks per cell
+  std::vector<int> items(300);
+  for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+    items[i] = i;
+    i32 net = i % 3 == 0 ? Index::kSeveralNets : i % 5;
+    index.insert(&items[i], IntBox(i, 0, i + 10, 10), layerBit(i % 2), net, i % 4 == 0 ? 1 : 2);
+  }
+
+  auto values = [](const std::vector<int*>& result) {
+    std::vector<int> sorted;
+    for (int* item : result) {
+      sorted.push_back(*item);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+  };
+  auto expected = [&](const IntBox& region, auto&& passes) {
+    std::vector<int> result;
+    for (int i : items) {
+      if (IntBox(i, 0, i + 10, 10).intersects(region) && passes(i)) {
+        result.push_back(i);
+      }
+    }
+    return result;
+  };
+
+  IntBox region(50, 5, 250, 8);
+  Index::Filter filter;
+  filter.layers = layerBit(1);
+  filter.kinds = 2;
+  REQUIRE(values(index.query(region, filter)) ==
+          expected(region, [](int i) { return i % 2 == 1 && i % 4 != 0; }));
+
+  // Entries on several nets pass both net tests
+  filter = Index::Filter();
+  filter.net = 2;
+  filter.netTest = Index::NetTest::Same;
+  REQUIRE(values(index.query(region, filter)) ==
+          expected(region, [](int i) { return i % 3 == 0 || i % 5 == 2; }));
+
+  filter.netTest = Index::NetTest::Other;
+  REQUIRE(values(index.query(region, filter)) ==
+          expected(region, [](int i) { return i % 3 == 0 || i % 5 != 2; }));
+
+  // No item is on net 0
+  filter.net = 0;
+  filter.netTest = Index::NetTest::Same;
+  REQUIRE(index.query(region, filter).empty());
+
+  // Layers above 31 are in the other half of the stored mask
+  int high = 1000;
+  index.insert(&high, IntBox(100, 0, 110, 10), layerBit(40));
+  filter = Index::Filter();
+  filter.layers = layerBit(40);
+  REQUIRE(index.query(region, filter) == std::vector<int*>{&high});
+}
+
+TEST_CASE("SpatialIndex - Batch queries match single queries", "[shapes][spatial]") {
+  using Index = SpatialIndex<int>;
+  Index index(100);
+
+  // A grid of small items on two layers and nets, and a few long ones
+  std::vector<int> items(2100);
+  for (int i = 0; i < 2000; ++i) {
+    items[i] = i;
+    int x = i % 50 * 40;
+    int y = i / 50 * 40;
+    index.insert(&items[i], IntBox(x, y, x + 15, y + 15), layerBit(i % 2), 1 + i % 3);
+  }
+  for (int i = 2000; i < 2100; ++i) {
+    items[i] = i;
+    index.insert(&items[i], IntBox(0, (i - 2000) * 16, 2000, (i - 2000) * 16 + 5), layerBit(0), 4);
+  }
+
+  // Probes as a grid router makes them: a raster of small boxes
+  std::vector<Index::Query> queries;
+  for (int y = -40; y < 1700; y += 23) {
+    for (int x = -40; x < 2100; x += 31) {
+      Index::Query query{IntBox(x, y, x + 20, y + 20), Index::Filter()};
+      query.filter.layers = layerBit((x + y) / 10 % 2);
+      query.filter.net = 1 + x % 4;
+      query.filter.netTest = Index::NetTest::Other;
+      queries.push_back(query);
+    }
+  }
+
+  std::vector<std::vector<int*>> batched(queries.size());
+  index.forEachMatch(std::span<const Index::Query>(queries), [&](size_t q, const Index::Entry& entry) {
+    batched[q].push_back(entry.item);
+    return false;
+  });
+  std::vector<u8> any = index.anyMatch(queries);
+
+  size_t hits = 0;
+  bool allMatch = true;
+  for (size_t q = 0; q < queries.size(); ++q) {
+    std::vector<int*> single = index.query(queries[q].region, queries[q].filter);
+    std::sort(single.begin(), single.end());
+    std::sort(batched[q].begin(), batched[q].end());
+    allMatch = allMatch && batched[q] == single && any[q] == (single.empty() ? 0 : 1);
+    hits += single.empty() ? 0 : 1;
+  }
+  REQUIRE(allMatch);
+  REQUIRE(hits > 0);
+  REQUIRE(hits < queries.size());
+}
+
 // ============================================================================
 // ShapeTree Tests
 // ============================================================================
@@ -427,6 +576,48 @@ TEST_CASE("ShapeTree - Find obstacles", "[shapes][shapetree]") {
   REQUIRE(obstacles[0]->getId() == 2);
 }
 
+TEST_CASE("ShapeTree - Layer mask filtering", "[shapes][shapetree]") {
+  LayerStructure layers;
+  for (int i = 0; i < 16; ++i) {
+    layers.addLayer(Layer("L" + std::to_string(i), true));
+  }
+
+  std::vector<std::string> classNames = {"default"};
+  ClearanceMatrix clearanceMatrix(1, layers, classNames);
+
+  BasicBoard board(layers, clearanceMatrix);
+  ShapeTree tree(1000);
+
+  auto top = std::make_unique<Trace>(
+    IntPoint(0, 0), IntPoint(100, 0), 0, 5,
+    std::vector<int>{1}, 0, 1, FixedState::NotFixed, &board
+  );
+  auto inner = std::make_unique<Trace>(
+    IntPoint(0, 0), IntPoint(100, 0), 7, 5,
+    std::vector<int>{2}, 0, 2, FixedState::NotFixed, &board
+  );
+  auto via = std::make_unique<Via>(
+    IntPoint(50, 0), board.getPadstack("via", 0, 15),
+    std::vector<int>{3}, 0, 3, FixedState::NotFixed, true, &board
+  );
+  REQUIRE(via->layerMask() == layerRangeMask(0, 15));
+
+  tree.insert(top.get());
+  tree.insert(inner.get());
+  tree.insert(via.get());
+
+  IntBox region(-10, -10, 110, 10);
+  REQUIRE(tree.queryRegion(region).size() == 3);
+  REQUIRE(tree.queryRegion(region, layerBit(0)).size() == 2);
+  REQUIRE(tree.queryRegion(region, layerBit(7)).size() == 2);
+  REQUIRE(tree.queryRegion(region, layerBit(3)).size() == 1);
+  REQUIRE(tree.findItemsOnLayer(3, region).front()->getId() == 3);
+
+  // A net 4 trace on layers 6..8 is blocked by the inner trace and the via
+  REQUIRE(tree.findTraceObstacles(4, region, 6, 8).size() == 2);
+  REQUIRE(tree.findTraceObstacles(4, region, 1, 5).size() == 1);
+}
+
 // ============================================================================
 // CollisionDetector Tests
 // ============================================================================